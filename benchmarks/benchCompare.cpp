@@ -0,0 +1,172 @@
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const double DEFAULT_TOLERANCE = 10.0;
+// half width of the 95% interval of the median rank, 1.96 / 2
+const double MEDIAN_Z = 0.98;
+
+/**
+ * @brief The median of the repetitions of a benchmark and its 95% confidence interval, in nanoseconds.
+ */
+struct BenchStatistics {
+    double median;
+    double low;
+    double high;
+    std::size_t repetitions;
+};
+
+double toNanoseconds(double time, const QString &unit) {
+    if (unit == "us") return time * 1e3;
+    if (unit == "ms") return time * 1e6;
+    if (unit == "s") return time * 1e9;
+    return time;
+}
+
+/**
+ * @brief Distribution free interval of the median, from the ranks of a binomial(n, 1/2) around n / 2.
+ * @param samples : The times of the repetitions, sorted in place.
+ * @return The statistics of the samples.
+ */
+BenchStatistics summarize(std::vector<double> &samples) {
+    std::sort(samples.begin(), samples.end());
+    const std::size_t n = samples.size();
+
+    BenchStatistics stats;
+    stats.repetitions = n;
+    stats.median = n % 2 ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+
+    double spread = MEDIAN_Z * std::sqrt(double(n));
+    long low = std::lround(std::floor(n / 2.0 - spread));
+    long high = std::lround(std::ceil(n / 2.0 + spread));
+    stats.low = samples[std::clamp(low, 1L, long(n)) - 1];
+    stats.high = samples[std::clamp(high, 1L, long(n)) - 1];
+    return stats;
+}
+
+/**
+ * @brief Read the repetitions of each benchmark of a Google Benchmark JSON file, the aggregates are ignored.
+ * @param link : The JSON file written with --benchmark_out_format=json.
+ * @param results : Receives the statistics of each benchmark by name.
+ * @return False if the file can't be read.
+ */
+bool readResults(const char *link, std::map<std::string, BenchStatistics> &results) {
+    QFile file(link);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::cerr << "Can't open file \"" << link << "\"\n";
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (document.isNull()) {
+        std::cerr << "Invalid JSON in \"" << link << "\" : " << error.errorString().toStdString() << "\n";
+        return false;
+    }
+
+    std::map<std::string, std::vector<double>> samples;
+    for (const QJsonValue &value : document.object().value("benchmarks").toArray()) {
+        QJsonObject run = value.toObject();
+        if (run.value("run_type").toString() == "aggregate" || run.value("error_occurred").toBool()) continue;
+        std::string name = run.value("run_name").toString(run.value("name").toString()).toStdString();
+        samples[name].push_back(toNanoseconds(run.value("real_time").toDouble(), run.value("time_unit").toString()));
+    }
+
+    for (auto &[name, times] : samples) results[name] = summarize(times);
+    return true;
+}
+
+std::string formatTime(double ns) {
+    const char *units[] = { "ns", "us", "ms", "s" };
+    int u = 0;
+    while (ns >= 1000.0 && u < 3) {
+        ns /= 1000.0;
+        u++;
+    }
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(ns < 10.0 ? 3 : ns < 100.0 ? 2 : 1) << ns << " " << units[u];
+    return text.str();
+}
+
+}
+
+/**
+ * @brief Compare a benchmark run with a baseline, both written by MeshViewerBench in JSON.
+ * A benchmark regresses when its median is slower than the tolerance and the confidence intervals of the
+ * medians don't overlap, so the noise of a single repetition doesn't fail the comparison.
+ * Usage : BenchCompare baseline.json current.json [tolerance %]
+ * @return EXIT_FAILURE if a benchmark regresses or a file can't be read.
+ */
+int main(int argc, char *argv[]) {
+    if (argc < 3 || argc > 4) {
+        std::cerr << "Usage : " << argv[0] << " baseline.json current.json [tolerance %]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    double tolerance = argc == 4 ? std::atof(argv[3]) : DEFAULT_TOLERANCE;
+    if (tolerance <= 0.0) {
+        std::cerr << "Invalid tolerance " << argv[3] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::map<std::string, BenchStatistics> baseline, current;
+    if (!readResults(argv[1], baseline) || !readResults(argv[2], current)) return EXIT_FAILURE;
+
+    std::size_t width = 9;
+    for (const auto &entry : current) width = std::max(width, entry.first.size());
+
+    std::cout << std::left << std::setw(width) << "Benchmark" << std::right
+              << std::setw(14) << "Baseline" << std::setw(14) << "Current" << std::setw(10) << "Delta" << "  Status\n"
+              << std::string(width + 46, '-') << "\n";
+
+    int regressions = 0, improvements = 0, missing = 0;
+    for (const auto &[name, now] : current) {
+        std::cout << std::left << std::setw(width) << name << std::right;
+        auto it = baseline.find(name);
+        if (it == baseline.end()) {
+            std::cout << std::setw(14) << "-" << std::setw(14) << formatTime(now.median) << std::setw(10) << "-" << "  new\n";
+            continue;
+        }
+
+        const BenchStatistics &before = it->second;
+        double delta = 100.0 * (now.median - before.median) / before.median;
+        const char *status = "ok";
+        if (delta > tolerance && now.low > before.high) {
+            status = "REGRESSION";
+            regressions++;
+        } else if (delta < -tolerance && now.high < before.low) {
+            status = "faster";
+            improvements++;
+        } else if (std::abs(delta) > tolerance) {
+            status = "noisy";
+        }
+
+        std::ostringstream deltaText;
+        deltaText << std::showpos << std::fixed << std::setprecision(1) << delta << "%";
+        std::cout << std::setw(14) << formatTime(before.median) << std::setw(14) << formatTime(now.median)
+                  << std::setw(10) << deltaText.str() << "  " << status << "\n";
+    }
+    for (const auto &entry : baseline) {
+        if (current.find(entry.first) == current.end()) missing++;
+    }
+
+    std::cout << "\n" << current.size() << " benchmarks, tolerance " << tolerance << "% : "
+              << regressions << " regressed, " << improvements << " faster";
+    if (missing > 0) std::cout << ", " << missing << " of the baseline not run";
+    std::cout << std::endl;
+
+    return regressions > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#ifndef BENCHMESHES_H
+#define BENCHMESHES_H
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "vertex.h"
+#include "triangle.h"
+
+/**
+ * @brief Synthetic geometry used by the benchmarks, so they don't depend on large data files.
+ */
+struct BenchMesh
+{
+    std::vector<Vertex> vertices;
+    std::vector<Triangle> faces;
+};
+
+/**
+ * @brief Build a UV sphere of radius 1 centered at the origin.
+ * @param rings : Number of rings, the sphere has 4 * rings * rings triangles.
+ * @return The sphere vertices and faces.
+ */
+inline BenchMesh makeBenchSphere(int rings) {
+    BenchMesh mesh;
+    const int sectors = 2 * rings;
+    const float pi = 3.14159265358979f;
+
+    mesh.vertices.reserve((rings + 1) * sectors);
+    mesh.faces.reserve(2 * rings * sectors);
+
+    for (int r = 0; r <= rings; r++) {
+        float phi = pi * r / rings;
+        for (int s = 0; s < sectors; s++) {
+            float theta = 2.0f * pi * s / sectors;
+            mesh.vertices.push_back(Vertex(std::sin(phi) * std::cos(theta), std::sin(phi) * std::sin(theta), std::cos(phi)));
+        }
+    }
+
+    for (int r = 0; r < rings; r++) {
+        for (int s = 0; s < sectors; s++) {
+            unsigned int a = r * sectors + s, b = r * sectors + (s + 1) % sectors;
+            unsigned int c = a + sectors, d = b + sectors;
+            mesh.faces.push_back(Triangle(a, c, b));
+            mesh.faces.push_back(Triangle(b, c, d));
+        }
+    }
+
+    return mesh;
+}
+
+/**
+ * @brief Build a flat grid in the z = 0 plane, each cell is split in 2 triangles by its diagonal.
+ * @param cells : Number of cells per side, the grid has 2 * cells * cells triangles.
+ * @return The grid vertices and faces, the triangles 2 * i and 2 * i + 1 share the diagonal of the cell i.
+ */
+inline BenchMesh makeBenchGrid(int cells) {
+    BenchMesh mesh;
+    const int side = cells + 1;
+
+    mesh.vertices.reserve(side * side);
+    mesh.faces.reserve(2 * cells * cells);
+
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) mesh.vertices.push_back(Vertex(float(x) / cells, float(y) / cells, 0.0f));
+    }
+
+    for (int y = 0; y < cells; y++) {
+        for (int x = 0; x < cells; x++) {
+            unsigned int a = y * side + x, b = a + 1, c = a + side, d = c + 1;
+            mesh.faces.push_back(Triangle(a, b, d));
+            mesh.faces.push_back(Triangle(a, d, c));
+        }
+    }
+
+    return mesh;
+}
+
+/**
+ * @brief Draw a random point cloud, like a terrain scan : spread in the unit square with a small height.
+ * @param count : Number of points.
+ * @return The points, always the same for a given count.
+ */
+inline std::vector<Vertex> makeBenchCloud(int count) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> plane(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> height(0.0f, 0.1f);
+
+    std::vector<Vertex> points;
+    points.reserve(count);
+    for (int i = 0; i < count; i++) {
+        float x = plane(rng), y = plane(rng);
+        points.push_back(Vertex(x, y, height(rng)));
+    }
+    return points;
+}
+
+#endif // BENCHMESHES_H
@@ -0,0 +1,30 @@
+# Run the hot path benchmarks and compare them with a baseline, called by the BenchmarkRegression test.
+# A missing baseline is recorded from this run, so the first run of a machine always passes.
+# Variables : BENCH, COMPARE, BASELINE, OUTPUT, FILTER, REPETITIONS, TOLERANCE
+
+execute_process(
+    COMMAND ${BENCH}
+        --benchmark_filter=${FILTER}
+        --benchmark_repetitions=${REPETITIONS}
+        --benchmark_out=${OUTPUT}
+        --benchmark_out_format=json
+    RESULT_VARIABLE result
+    OUTPUT_QUIET
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "MeshViewerBench failed (${result})")
+endif()
+
+if(NOT EXISTS ${BASELINE})
+    execute_process(COMMAND ${CMAKE_COMMAND} -E copy ${OUTPUT} ${BASELINE})
+    message(STATUS "No baseline, this run is recorded in ${BASELINE}")
+    return()
+endif()
+
+execute_process(
+    COMMAND ${COMPARE} ${BASELINE} ${OUTPUT} ${TOLERANCE}
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Benchmarks slower than ${BASELINE}")
+endif()
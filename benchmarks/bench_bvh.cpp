@@ -0,0 +1,65 @@
+#include <benchmark/benchmark.h>
+#include <random>
+
+#include "bvh.h"
+#include "benchMeshes.h"
+
+static std::vector<Ray> makeRays(std::size_t count) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<Ray> rays;
+    rays.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        QVector3D origin(dist(rng) * 4.0f, dist(rng) * 4.0f, 4.0f);
+        QVector3D target(dist(rng) * 0.8f, dist(rng) * 0.8f, dist(rng) * 0.8f);
+        rays.push_back(Ray(origin, (target - origin).normalized()));
+    }
+    return rays;
+}
+
+static void BM_BVHBuild(benchmark::State &state) {
+    BenchMesh mesh = makeBenchSphere(state.range(0));
+
+    for (auto _ : state) {
+        BVH bvh;
+        bvh.build(mesh.vertices, mesh.faces);
+        benchmark::DoNotOptimize(bvh.getNodes().data());
+    }
+
+    state.counters["faces"] = mesh.faces.size();
+    state.counters["faces/s"] = benchmark::Counter(mesh.faces.size(), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_BVHBuild)->Arg(64)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_BVHRaySingle(benchmark::State &state) {
+    BenchMesh mesh = makeBenchSphere(state.range(0));
+    BVH bvh;
+    bvh.build(mesh.vertices, mesh.faces);
+    std::vector<Ray> rays = makeRays(16384);
+
+    for (auto _ : state) {
+        for (const Ray &ray : rays) {
+            RayHit hit;
+            bvh.intersect(ray, hit);
+            benchmark::DoNotOptimize(hit);
+        }
+    }
+
+    state.counters["rays/s"] = benchmark::Counter(rays.size(), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_BVHRaySingle)->Arg(64)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_BVHRayBatch(benchmark::State &state) {
+    BenchMesh mesh = makeBenchSphere(state.range(0));
+    BVH bvh;
+    bvh.build(mesh.vertices, mesh.faces);
+    std::vector<Ray> rays = makeRays(262144);
+    std::vector<RayHit> hits;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bvh.intersect(rays, hits));
+    }
+
+    state.counters["rays/s"] = benchmark::Counter(rays.size(), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_BVHRayBatch)->Arg(64)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,61 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+#include "mesh.h"
+#include "benchMeshes.h"
+
+// Sphere whose vertices and faces are shuffled, like a point cloud triangulated in any order
+static BenchMesh makeShuffledSphere(int rings) {
+    BenchMesh mesh = makeBenchSphere(rings);
+    std::mt19937 rng(99);
+
+    std::vector<unsigned int> remap(mesh.vertices.size());
+    std::iota(remap.begin(), remap.end(), 0);
+    std::shuffle(remap.begin(), remap.end(), rng);
+
+    std::vector<Vertex> vertices(mesh.vertices);
+    for (std::size_t i = 0; i < remap.size(); i++) vertices[remap[i]] = mesh.vertices[i];
+    mesh.vertices = std::move(vertices);
+
+    for (auto &f : mesh.faces) {
+        for (auto &v : f.idVertices) v = remap[v];
+    }
+    std::shuffle(mesh.faces.begin(), mesh.faces.end(), rng);
+    return mesh;
+}
+
+// Mesh construction sews the faces and computes the normals, both walk the vertices through the faces
+static void BM_MeshBuild(benchmark::State &state) {
+    BenchMesh shuffled = makeShuffledSphere(state.range(0));
+    Mesh ordered(shuffled.vertices, shuffled.faces);
+    ordered.spatialReorder(static_cast<SpatialOrder>(state.range(1)));
+
+    std::vector<Triangle> faces;
+    for (const auto &f : ordered.getFaces()) faces.push_back(Triangle(f.idVertices[0], f.idVertices[1], f.idVertices[2]));
+
+    for (auto _ : state) {
+        Mesh mesh(ordered.getVertices(), faces);
+        benchmark::DoNotOptimize(mesh.getFaces().data());
+    }
+
+    state.counters["faces/s"] = benchmark::Counter(faces.size(), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_MeshBuild)->ArgsProduct({ { 256, 1024 }, { 0, 1, 2 } })->ArgNames({ "rings", "order" })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_SpatialReorder(benchmark::State &state) {
+    BenchMesh shuffled = makeShuffledSphere(state.range(0));
+    Mesh source(shuffled.vertices, shuffled.faces);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        Mesh mesh(source);
+        state.ResumeTiming();
+        mesh.spatialReorder(static_cast<SpatialOrder>(state.range(1)));
+        benchmark::DoNotOptimize(mesh.getFaces().data());
+    }
+
+    state.counters["faces/s"] = benchmark::Counter(shuffled.faces.size(), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_SpatialReorder)->ArgsProduct({ { 256, 1024 }, { 1, 2 } })->ArgNames({ "rings", "order" })->Unit(benchmark::kMillisecond)->UseRealTime();
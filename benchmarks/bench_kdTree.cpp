@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+#include <random>
+
+#include "generator.h"
+#include "kdTree.h"
+#include "normalEstimator.h"
+
+// a scan-like cloud over [-1, 1]^2, the queries are points of the cloud moved a little
+static const GeneratedMesh &benchCloud(std::size_t count) {
+    static std::size_t cachedCount = 0;
+    static GeneratedMesh cloud;
+    if (cachedCount != count) {
+        cloud = Generator::pointCloud(count, CloudDistribution::UNIFORM, 1);
+        cachedCount = count;
+    }
+    return cloud;
+}
+
+static std::vector<QVector3D> makeQueries(const std::vector<QVector3D> &points, std::size_t count) {
+    std::mt19937 rng(99);
+    std::uniform_int_distribution<std::size_t> pick(0, points.size() - 1);
+    std::uniform_real_distribution<float> offset(-0.001f, 0.001f);
+    std::vector<QVector3D> queries(count);
+    for (auto &q : queries) q = points[pick(rng)] + QVector3D(offset(rng), offset(rng), offset(rng));
+    return queries;
+}
+
+static void BM_KDTreeBuild(benchmark::State &state) {
+    const GeneratedMesh &cloud = benchCloud(state.range(0));
+
+    for (auto _ : state) {
+        KDTree tree;
+        tree.build(cloud.positions);
+        benchmark::DoNotOptimize(tree.size());
+    }
+
+    state.counters["points/s"] = benchmark::Counter(state.range(0), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_KDTreeBuild)->Arg(1000000)->Arg(10000000)->ArgName("points")->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_KDTreeKnn(benchmark::State &state) {
+    const GeneratedMesh &cloud = benchCloud(state.range(0));
+    KDTree tree;
+    tree.build(cloud.positions);
+    std::vector<QVector3D> queries = makeQueries(cloud.positions, 1 << 18);
+    std::vector<unsigned int> neighbors;
+
+    for (auto _ : state) {
+        tree.knn(queries, state.range(1), neighbors);
+        benchmark::DoNotOptimize(neighbors.data());
+    }
+
+    state.counters["queries/s"] = benchmark::Counter(queries.size(), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_KDTreeKnn)->ArgsProduct({ { 1000000, 10000000 }, { 1, 8, 32 } })->ArgNames({ "points", "k" })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// about 30 points per ball at 10M points
+static void BM_KDTreeRadius(benchmark::State &state) {
+    const GeneratedMesh &cloud = benchCloud(state.range(0));
+    KDTree tree;
+    tree.build(cloud.positions);
+    std::vector<QVector3D> queries = makeQueries(cloud.positions, 1 << 18);
+    std::vector<std::size_t> start;
+    std::vector<unsigned int> neighbors;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tree.radius(queries, 0.001f, start, neighbors));
+    }
+
+    state.counters["queries/s"] = benchmark::Counter(queries.size(), benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["found"] = double(neighbors.size()) / queries.size();
+}
+BENCHMARK(BM_KDTreeRadius)->Arg(1000000)->Arg(10000000)->ArgName("points")->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_PointNormals(benchmark::State &state) {
+    const GeneratedMesh &cloud = benchCloud(state.range(0));
+    NormalEstimationOptions options;
+    options.orient = state.range(1) != 0;
+
+    for (auto _ : state) {
+        std::vector<QVector3D> normals = NormalEstimator::estimate(cloud.positions, options);
+        benchmark::DoNotOptimize(normals.data());
+    }
+
+    state.counters["points/s"] = benchmark::Counter(state.range(0), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_PointNormals)->ArgsProduct({ { 100000, 1000000 }, { 0, 1 } })->ArgNames({ "points", "orient" })->Unit(benchmark::kMillisecond)->UseRealTime();
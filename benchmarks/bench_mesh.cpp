@@ -0,0 +1,306 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "generator.h"
+#include "mesh.h"
+#include "smoother.h"
+#include "benchMeshes.h"
+
+namespace {
+
+// gives the benchmarks the protected geometry passes, like the tests do
+class MeshBenchAccess : public Mesh {
+public:
+    using Mesh::Mesh;
+    using Mesh::computeNormals;
+    using Mesh::edgeFlip;
+    using Mesh::edgeSplit;
+    using Mesh::triangulate;
+
+    using Mesh::vertices;
+};
+
+const char *EXTENSIONS[] = { ".off", ".obj", ".txt" };
+
+// a file of the system temporary directory, unique per benchmark and scale
+std::string benchPath(const char *name, long long scale, int format) {
+    std::string file = std::string("meshviewer_") + name + "_" + std::to_string(scale) + EXTENSIONS[format];
+    return (std::filesystem::temp_directory_path() / file).string();
+}
+
+int saveFormat(const Mesh &mesh, const char *link, int format) {
+    if (format == 0) return mesh.saveOFF(link);
+    if (format == 1) return mesh.saveOBJ(link);
+    return mesh.saveTXT(link);
+}
+
+int loadFormat(Mesh &mesh, const char *link, int format) {
+    if (format == 0) return mesh.loadOFF(link);
+    if (format == 1) return mesh.loadOBJ(link);
+    return mesh.loadTXT(link);
+}
+
+void writeCloud(const char *link, const std::vector<Vertex> &points) {
+    std::ofstream file(link);
+    file << points.size() << "\n";
+    for (const auto &p : points) file << p.position.x() << " " << p.position.y() << " " << p.position.z() << "\n";
+}
+
+}
+
+// file loading, parsing and sewing of a sphere, format 0 is OFF, 1 is OBJ
+static void BM_Load(benchmark::State &state) {
+    const int format = state.range(1);
+    BenchMesh sphere = makeBenchSphere(state.range(0));
+    std::string link = benchPath("load", state.range(0), format);
+    if (saveFormat(Mesh(sphere.vertices, sphere.faces), link.c_str(), format) != MeshError::OK) {
+        state.SkipWithError("Can't write the input file");
+        return;
+    }
+
+    for (auto _ : state) {
+        Mesh mesh;
+        if (loadFormat(mesh, link.c_str(), format) != MeshError::OK) {
+            state.SkipWithError("Can't load the input file");
+            break;
+        }
+        benchmark::DoNotOptimize(mesh.getFaces().data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(link));
+    state.counters["faces/s"] = benchmark::Counter(sphere.faces.size(), benchmark::Counter::kIsIterationInvariantRate);
+    std::remove(link.c_str());
+}
+BENCHMARK(BM_Load)->ArgsProduct({ { 64, 256, 1024 }, { 0, 1 } })->ArgNames({ "rings", "format" })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// format 2 writes the vertices only, as a point cloud
+static void BM_Save(benchmark::State &state) {
+    const int format = state.range(1);
+    BenchMesh sphere = makeBenchSphere(state.range(0));
+    Mesh mesh(sphere.vertices, sphere.faces);
+    std::string link = benchPath("save", state.range(0), format);
+
+    for (auto _ : state) {
+        if (saveFormat(mesh, link.c_str(), format) != MeshError::OK) {
+            state.SkipWithError("Can't write the output file");
+            break;
+        }
+    }
+
+    if (std::filesystem::exists(link)) state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(link));
+    std::remove(link.c_str());
+}
+BENCHMARK(BM_Save)->ArgsProduct({ { 64, 256, 1024 }, { 0, 1, 2 } })->ArgNames({ "rings", "format" })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// parsing of a point cloud without the triangulation
+static void BM_LoadPoints(benchmark::State &state) {
+    std::string link = benchPath("points", state.range(0), 2);
+    writeCloud(link.c_str(), makeBenchCloud(state.range(0)));
+
+    for (auto _ : state) {
+        Mesh mesh;
+        if (mesh.loadPoints(link.c_str()) != MeshError::OK) {
+            state.SkipWithError("Can't load the input file");
+            break;
+        }
+        benchmark::DoNotOptimize(mesh.getVertices().data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(link));
+    state.counters["points/s"] = benchmark::Counter(state.range(0), benchmark::Counter::kIsIterationInvariantRate);
+    std::remove(link.c_str());
+}
+BENCHMARK(BM_LoadPoints)->RangeMultiplier(10)->Range(10000, 1000000)->ArgName("points")->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// parsing and Delaunay triangulation of a point cloud
+static void BM_LoadTXT(benchmark::State &state) {
+    std::string link = benchPath("delaunay", state.range(0), 2);
+    writeCloud(link.c_str(), makeBenchCloud(state.range(0)));
+
+    for (auto _ : state) {
+        Mesh mesh;
+        if (mesh.loadTXT(link.c_str()) != MeshError::OK) {
+            state.SkipWithError("Can't load the input file");
+            break;
+        }
+        benchmark::DoNotOptimize(mesh.getFaces().data());
+    }
+
+    state.counters["points/s"] = benchmark::Counter(state.range(0), benchmark::Counter::kIsIterationInvariantRate);
+    std::remove(link.c_str());
+}
+BENCHMARK(BM_LoadTXT)->Arg(1000)->Arg(4000)->Arg(16000)->ArgName("points")->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// the incremental insertion alone : walk to the point and Bowyer-Watson cavity, without the parsing and the filter
+static void BM_Insert(benchmark::State &state) {
+    std::vector<QVector3D> points;
+    for (const Vertex &v : makeBenchCloud(state.range(0))) points.push_back(v.position);
+
+    for (auto _ : state) {
+        MeshBenchAccess mesh;
+        mesh.triangulate(points);
+        benchmark::DoNotOptimize(mesh.getFaces().data());
+    }
+
+    state.counters["points/s"] = benchmark::Counter(points.size(), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_Insert)->Arg(1000)->Arg(4000)->Arg(16000)->ArgName("points")->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_Sew(benchmark::State &state) {
+    BenchMesh sphere = makeBenchSphere(state.range(0));
+    Mesh mesh(sphere.vertices, sphere.faces);
+
+    for (auto _ : state) {
+        mesh.sew();
+        benchmark::DoNotOptimize(mesh.getFaces().data());
+    }
+
+    state.counters["faces/s"] = benchmark::Counter(sphere.faces.size(), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_Sew)->RangeMultiplier(4)->Range(64, 1024)->ArgName("rings")->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_ComputeNormals(benchmark::State &state) {
+    BenchMesh sphere = makeBenchSphere(state.range(0));
+    MeshBenchAccess mesh(sphere.vertices, sphere.faces);
+
+    for (auto _ : state) {
+        mesh.computeNormals();
+        benchmark::DoNotOptimize(mesh.getVertices().data());
+    }
+
+    state.counters["faces/s"] = benchmark::Counter(sphere.faces.size(), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_ComputeNormals)->RangeMultiplier(4)->Range(64, 1024)->ArgName("rings")->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// one level from a sphere, the output faces are counted
+static void BM_Subdivide(benchmark::State &state) {
+    BenchMesh sphere = makeBenchSphere(state.range(0));
+    Mesh source(sphere.vertices, sphere.faces);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        Mesh mesh(source);
+        state.ResumeTiming();
+        if (state.range(1) == 0) mesh.subdivideLoop();
+        else mesh.subdivideSqrt3();
+        benchmark::DoNotOptimize(mesh.getFaces().data());
+    }
+
+    std::size_t faces = sphere.faces.size() * (state.range(1) == 0 ? 4 : 3);
+    state.counters["faces/s"] = benchmark::Counter(faces, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_Subdivide)->ArgsProduct({ { 64, 256, 1024 }, { 0, 1 } })->ArgNames({ "rings", "sqrt3" })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 10 iterations on the one-ring index built once, Taubin does 2 steps per iteration
+static void BM_Smooth(benchmark::State &state) {
+    BenchMesh sphere = makeBenchSphere(state.range(0));
+    Mesh mesh(sphere.vertices, sphere.faces);
+    SmoothingOptions options;
+    options.method = state.range(1) == 0 ? SmoothingMethod::LAPLACIAN : SmoothingMethod::TAUBIN;
+    Smoother smoother(mesh);
+
+    for (auto _ : state) {
+        smoother.smooth(options);
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["vertices/s"] = benchmark::Counter(sphere.vertices.size() * options.iterations, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_Smooth)->ArgsProduct({ { 64, 256, 1024 }, { 0, 1 } })->ArgNames({ "rings", "taubin" })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// both walk all the vertices, the viewer calls them at each load to frame the camera
+static void BM_Bounds(benchmark::State &state) {
+    BenchMesh sphere = makeBenchSphere(state.range(0));
+    Mesh mesh(sphere.vertices, sphere.faces);
+
+    for (auto _ : state) {
+        QVector3D center = mesh.getCenter();
+        float radius = mesh.getBoundingRadius();
+        benchmark::DoNotOptimize(center);
+        benchmark::DoNotOptimize(radius);
+    }
+
+    state.counters["vertices/s"] = benchmark::Counter(sphere.vertices.size(), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_Bounds)->RangeMultiplier(4)->Range(64, 1024)->ArgName("rings")->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// flips the diagonal of every cell of a grid, the mesh is copied back before each pass
+static void BM_EdgeFlip(benchmark::State &state) {
+    BenchMesh grid = makeBenchGrid(state.range(0));
+    MeshBenchAccess source(grid.vertices, grid.faces);
+    const int cells = grid.faces.size() / 2;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        MeshBenchAccess mesh(source);
+        state.ResumeTiming();
+        for (int c = 0; c < cells; c++) mesh.edgeFlip(2 * c, 2 * c + 1);
+        benchmark::DoNotOptimize(mesh.getFaces().data());
+    }
+
+    state.counters["flips/s"] = benchmark::Counter(cells, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_EdgeFlip)->RangeMultiplier(4)->Range(16, 256)->ArgName("cells")->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// splits the diagonal of the first cell, only the adjacency and normals of its faces are patched
+static void BM_EdgeSplit(benchmark::State &state) {
+    BenchMesh grid = makeBenchGrid(state.range(0));
+    MeshBenchAccess source(grid.vertices, grid.faces);
+    source.vertices.push_back(Vertex(0.5f / state.range(0), 0.5f / state.range(0), 0.0f));
+    const int p = source.vertices.size() - 1;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        MeshBenchAccess mesh(source);
+        state.ResumeTiming();
+        mesh.edgeSplit(p, 0, 1);
+        benchmark::DoNotOptimize(mesh.getFaces().data());
+    }
+
+    state.counters["faces"] = grid.faces.size();
+}
+BENCHMARK(BM_EdgeSplit)->RangeMultiplier(4)->Range(16, 256)->ArgName("cells")->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// synthetic inputs at production sizes, generated on all the threads
+static void BM_GenerateIcosphere(benchmark::State &state) {
+    std::size_t faces = 0;
+    for (auto _ : state) {
+        GeneratedMesh sphere = Generator::icosphere(state.range(0));
+        faces = sphere.indices.size() / 3;
+        benchmark::DoNotOptimize(sphere.positions.data());
+    }
+
+    state.counters["faces/s"] = benchmark::Counter(faces, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_GenerateIcosphere)->DenseRange(6, 10, 2)->ArgName("levels")->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_GenerateCloud(benchmark::State &state) {
+    for (auto _ : state) {
+        GeneratedMesh cloud = Generator::pointCloud(state.range(0), static_cast<CloudDistribution>(state.range(1)), 1);
+        benchmark::DoNotOptimize(cloud.positions.data());
+    }
+
+    state.counters["points/s"] = benchmark::Counter(state.range(0), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_GenerateCloud)->ArgsProduct({ { 1000000, 10000000 }, { 0, 1 } })->ArgNames({ "points", "distribution" })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// the exact duplicates only, then a voxel grid of 200 x 200 cells over the cloud
+static void BM_PointFilter(benchmark::State &state) {
+    GeneratedMesh cloud = Generator::pointCloud(state.range(0), CloudDistribution::UNIFORM, 1);
+    PointFilterOptions options;
+    if (state.range(1) == 1) options.voxelSize = 0.01f;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<QVector3D> points = cloud.positions;
+        state.ResumeTiming();
+        PointFilter::filter(points, options);
+        benchmark::DoNotOptimize(points.data());
+    }
+
+    state.counters["points/s"] = benchmark::Counter(state.range(0), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_PointFilter)->ArgsProduct({ { 1000000, 10000000 }, { 0, 1 } })->ArgNames({ "points", "voxels" })->Unit(benchmark::kMillisecond)->UseRealTime();
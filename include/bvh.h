@@ -0,0 +1,142 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include <atomic>
+#include <QVector3D>
+
+#include "vertex.h"
+#include "triangle.h"
+
+/**
+ * @brief A ray, defined by its origin, its direction and a maximum distance.
+ */
+struct Ray
+{
+    Ray();
+    Ray(const QVector3D &o, const QVector3D &d, float maxDistance = 1e30f);
+
+    QVector3D origin;
+    QVector3D direction;
+    float tMax;
+};
+
+/**
+ * @brief Result of a ray intersection, face is -1 if nothing has been hit.
+ */
+struct RayHit
+{
+    RayHit();
+
+    int face;
+    float t;
+    float u;
+    float v;
+};
+
+/**
+ * @brief A node of the BVH, 32 bytes so two siblings share a cache line.
+ * Inner nodes have count == 0 and leftFirst is the index of the left child (the right one follows it).
+ * Leaves have count > 0 and leftFirst is the index of their first triangle.
+ */
+struct BVHNode
+{
+    float boundsMin[3];
+    unsigned int leftFirst;
+    float boundsMax[3];
+    unsigned int count;
+
+    bool isLeaf() const { return count > 0; }
+};
+
+/**
+ * @brief The BVH class, a bounding volume hierarchy over the faces of a mesh.
+ * The tree is built with a binned SAH and stored in a flat array, the triangles are
+ * stored as structure of arrays in leaf order for the intersection loops.
+ */
+class BVH
+{
+public:
+    BVH();
+
+    /**
+     * @brief Build the hierarchy, the top levels are split on several threads.
+     * @param vertices : The vertices of the mesh.
+     * @param faces : The faces of the mesh.
+     */
+    void build(const std::vector<Vertex> &vertices, const std::vector<Triangle> &faces);
+
+    /**
+     * @brief Clear the hierarchy.
+     */
+    void clear();
+
+    bool isEmpty() const;
+    const std::vector<BVHNode> &getNodes() const;
+    std::size_t faceCount() const;
+
+    /**
+     * @brief Find the closest triangle hit by a ray.
+     * @param ray : The tested ray.
+     * @param hit : The closest hit, updated only if a closer triangle is found.
+     * @return True if a triangle has been hit, else false.
+     */
+    bool intersect(const Ray &ray, RayHit &hit) const;
+
+    /**
+     * @brief Intersect a batch of rays, the batch is split between several threads.
+     * @param rays : The tested rays.
+     * @param hits : The closest hit of each ray, resized to the number of rays.
+     * @return The number of rays who hit a triangle.
+     */
+    std::size_t intersect(const std::vector<Ray> &rays, std::vector<RayHit> &hits) const;
+
+protected:
+
+    /**
+     * @brief Recursively split a node, the subtrees are built in parallel until the depth limit.
+     * @param nodeIndex : The index of the node to split.
+     * @param depth : The depth of the node.
+     * @param nodesUsed : Counter of the allocated nodes, shared by the building threads.
+     */
+    void subdivide(unsigned int nodeIndex, int depth, std::atomic<unsigned int> &nodesUsed);
+
+    /**
+     * @brief Compute the bounds of the triangles of a node.
+     * @param nodeIndex : The index of the node.
+     */
+    void updateNodeBounds(unsigned int nodeIndex);
+
+    /**
+     * @brief Find the best split of a node with a binned SAH.
+     * @param node : The splitted node.
+     * @param axis : The axis of the best split.
+     * @param splitPos : The position of the best split.
+     * @return The SAH cost of the best split.
+     */
+    float findBestSplit(const BVHNode &node, int &axis, float &splitPos) const;
+
+    /**
+     * @brief Intersect the triangles of a leaf.
+     * @param node : The tested leaf.
+     * @param ray : The tested ray.
+     * @param hit : The closest hit, updated if a triangle is closer.
+     */
+    void intersectLeaf(const BVHNode &node, const Ray &ray, RayHit &hit) const;
+
+    std::vector<BVHNode> nodes;
+    int parallelDepth;
+
+    // triangle indices of the mesh, in leaf order
+    std::vector<unsigned int> triIndices;
+    std::vector<QVector3D> centroids;
+    std::vector<QVector3D> triMin;
+    std::vector<QVector3D> triMax;
+
+    // triangle data in leaf order (vertex 0 and edges), as structure of arrays
+    std::vector<float> v0x, v0y, v0z;
+    std::vector<float> e1x, e1y, e1z;
+    std::vector<float> e2x, e2y, e2z;
+};
+
+#endif // BVH_H
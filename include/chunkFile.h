@@ -0,0 +1,126 @@
+#ifndef CHUNKFILE_H
+#define CHUNKFILE_H
+
+#include <cstdint>
+#include <vector>
+#include <QFile>
+
+#include "vertexCompression.h"
+
+/**
+ * @brief Header of a chunk file, stored in the first page.
+ * The chunk pages follow, each one holds the packed vertices then the 16 bits indices of a chunk.
+ * The chunk and node tables are stored after the last page.
+ */
+struct ChunkFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t chunkCount;
+    std::uint32_t nodeCount;
+    std::uint32_t maxChunkVertices;
+    std::uint32_t maxChunkIndices;
+    std::uint32_t padding;
+    std::uint64_t vertexCount;
+    std::uint64_t faceCount;
+    std::uint64_t tableOffset;
+    float boundsMin[3];
+    float boundsMax[3];
+    float quantizationOffset[3];
+    float quantizationScale[3];
+};
+
+/**
+ * @brief Entry of the chunk table, where the data of a chunk is and what it covers.
+ */
+struct ChunkRecord
+{
+    std::uint64_t offset;
+    std::uint32_t vertexCount;
+    std::uint32_t indexCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    float center[3];
+    float radius;
+    float coneAxis[3];
+    float coneCutoff;
+};
+
+/**
+ * @brief Node of the chunk hierarchy, the root is the last node.
+ * The children of a leaf are chunks, the ones of an inner node are nodes.
+ */
+struct ChunkNode
+{
+    float boundsMin[3];
+    float boundsMax[3];
+    std::uint32_t first;
+    std::uint32_t count;
+    std::uint32_t leaf;
+    std::uint32_t padding;
+};
+
+/**
+ * @brief The ChunkFile class, a paged file of mesh chunks read through a memory mapping.
+ * Only the tables are loaded, the chunk pages are read by the system when they are touched.
+ */
+class ChunkFile
+{
+public:
+    ChunkFile();
+    ~ChunkFile();
+
+    /**
+     * @brief Build a chunk file from a .off or .obj file, without loading the whole mesh.
+     * The vertices and faces are streamed to temporary files mapped in memory, the faces are bucketed
+     * by the Morton code of their centroid then runs of consecutive buckets are split in chunks.
+     * A bucket too large to be loaded is split on more bits of the code, or in slices if its faces share a code.
+     * @param input : The mesh file.
+     * @param output : The chunk file.
+     * @param maxChunkFaces : The maximum number of faces of a chunk.
+     * @return MeshError::OK if the function terminates correctly, other else.
+     */
+    static int build(const char *input, const char *output, unsigned int maxChunkFaces = 2048);
+
+    /**
+     * @brief Map a chunk file and read its tables.
+     * Every record has to be inside the file and every node has to point inside the tables.
+     * @param link
+     * @return MeshError::OK if the function terminates correctly, MeshError::FORMAT for a corrupted file, other else.
+     */
+    int open(const char *link);
+
+    /**
+     * @brief Unmap and close the file.
+     */
+    void close();
+
+    bool isOpen() const;
+    const ChunkFileHeader &getHeader() const;
+    const std::vector<ChunkRecord> &getChunks() const;
+    const std::vector<ChunkNode> &getNodes() const;
+    Quantization getQuantization() const;
+
+    /**
+     * @brief Get the packed vertices of a chunk, inside the mapping.
+     * @param chunk : The index of the chunk.
+     * @return The first vertex.
+     */
+    const PackedVertex *chunkVertices(unsigned int chunk) const;
+
+    /**
+     * @brief Get the indices of a chunk, inside the mapping.
+     * @param chunk : The index of the chunk.
+     * @return The first index.
+     */
+    const std::uint16_t *chunkIndices(unsigned int chunk) const;
+
+protected:
+    QFile file;
+    const uchar *data;
+    ChunkFileHeader header;
+    std::vector<ChunkRecord> chunks;
+    std::vector<ChunkNode> nodes;
+};
+
+#endif // CHUNKFILE_H
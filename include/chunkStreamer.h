@@ -0,0 +1,90 @@
+#ifndef CHUNKSTREAMER_H
+#define CHUNKSTREAMER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "chunkFile.h"
+#include "chunks.h"
+
+/**
+ * @brief The ChunkStreamer class, keeps the visible chunks of a chunk file resident in a fixed number of slots.
+ * A loader thread reads the requested chunks from the mapping, the least recently used chunks are evicted.
+ */
+class ChunkStreamer
+{
+public:
+    /**
+     * @brief A chunk read by the loader thread, to be copied in its slot.
+     */
+    struct LoadedChunk {
+        unsigned int chunk;
+        unsigned int slot;
+        std::vector<PackedVertex> vertices;
+        std::vector<std::uint16_t> indices;
+    };
+
+    /**
+     * @param file : The opened chunk file, it must outlive the streamer.
+     * @param slotCount : The number of chunks resident at the same time.
+     */
+    ChunkStreamer(const ChunkFile &file, std::size_t slotCount);
+    ~ChunkStreamer();
+
+    /**
+     * @brief Find the visible chunks through the hierarchy and request the missing ones, the nearest first.
+     * The previous requests not started yet are replaced.
+     * @param frustum : The camera frustum, in the space of the chunk file.
+     * @param cameraPosition : The position of the camera, in the space of the chunk file.
+     * @param visible : Receives the visible chunks, from the nearest to the furthest.
+     * @return The number of visible chunks being streamed, the ones that can't get a slot are not counted.
+     */
+    std::size_t update(const Frustum &frustum, const QVector3D &cameraPosition, std::vector<unsigned int> &visible);
+
+    /**
+     * @brief Take the chunks read by the loader thread and give them a slot.
+     * The least recently used chunk is evicted when no slot is free, never a chunk visible in the last update.
+     * @param maxCount : The maximum number of taken chunks.
+     * @return The chunks to copy in their slot.
+     */
+    std::vector<LoadedChunk> takeLoaded(std::size_t maxCount);
+
+    /**
+     * @brief Get the slot of a chunk.
+     * @param chunk : The index of the chunk.
+     * @return The slot, -1 if the chunk is not resident.
+     */
+    int slotOf(unsigned int chunk) const;
+
+    std::size_t getSlotCount() const;
+    std::size_t getResidentCount() const;
+
+protected:
+    void loaderLoop();
+
+    const ChunkFile &file;
+    std::size_t slotCount;
+    std::uint64_t frame;
+
+    std::vector<int> chunkSlots; // slot of each chunk, -1 if not resident
+    std::vector<std::uint64_t> lastUsed;
+    std::list<unsigned int> lru; // resident chunks, the most recently used first
+    std::vector<std::list<unsigned int>::iterator> lruPosition;
+    std::vector<unsigned int> freeSlots;
+
+    // shared with the loader thread
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::deque<unsigned int> requests;
+    std::deque<LoadedChunk> loaded;
+    std::vector<unsigned char> inFlight; // requested, being read or loaded but not taken
+    bool stopping;
+    std::thread loader;
+};
+
+#endif // CHUNKSTREAMER_H
@@ -0,0 +1,92 @@
+#ifndef CHUNKS_H
+#define CHUNKS_H
+
+#include <array>
+#include <vector>
+#include <QVector3D>
+#include <QVector4D>
+#include <QMatrix4x4>
+
+#include "vertex.h"
+#include "triangle.h"
+
+/**
+ * @brief A group of spatially close faces drawn together, with its bounds and its normal cone.
+ */
+struct Chunk
+{
+    /**
+     * @brief Check if all the faces of the chunk are seen from behind.
+     * @param cameraPosition : The position of the camera.
+     * @return True if the chunk can be culled.
+     */
+    bool isBackFacing(const QVector3D &cameraPosition) const;
+
+    std::size_t firstIndex; // in the index buffer
+    unsigned int indexCount;
+    int baseVertex;
+
+    QVector3D boundsMin;
+    QVector3D boundsMax;
+    QVector3D center;
+    float radius;
+    QVector3D coneAxis;
+    float coneCutoff; // sine of the cone half angle, above 1 if the cone can't be used
+};
+
+/**
+ * @brief The Frustum class, the 6 planes of a view projection, the normals point inside.
+ */
+class Frustum
+{
+public:
+    explicit Frustum(const QMatrix4x4 &viewProjection);
+
+    /**
+     * @brief Check if a box is at least partly inside the frustum, conservative near the corners.
+     * @param min : The minimum corner of the box.
+     * @param max : The maximum corner of the box.
+     * @return False if the box is outside one of the planes.
+     */
+    bool intersects(const QVector3D &min, const QVector3D &max) const;
+
+protected:
+    std::array<QVector4D, 6> planes;
+};
+
+/**
+ * @brief The ChunkPartition class, splits the faces of a mesh in chunks and culls them.
+ */
+class ChunkPartition
+{
+public:
+    /**
+     * @brief Split the faces by median cuts along the largest axis until the chunks are small enough.
+     * Inside a chunk the faces keep their relative order, so the vertex cache order is preserved.
+     * @param vertices : The vertices of the mesh.
+     * @param faces : The faces of the mesh.
+     * @param maxFaces : The maximum number of faces of a chunk.
+     * @param faceOrder : Receives the faces grouped by chunk.
+     * @return The chunks, their first index is relative to the reordered faces and their base vertex is 0.
+     */
+    static std::vector<Chunk> build(const std::vector<Vertex> &vertices, const std::vector<Triangle> &faces,
+                                    unsigned int maxFaces, std::vector<unsigned int> &faceOrder);
+
+    /**
+     * @brief Cull a range of chunks against the frustum and, optionally, with their normal cone.
+     * The chunks are tested on several threads.
+     * @param chunks : The chunks.
+     * @param first : The first tested chunk.
+     * @param count : The number of tested chunks.
+     * @param frustum : The camera frustum.
+     * @param cameraPosition : The position of the camera.
+     * @param coneCulling : True to cull the chunks seen from behind, only valid for closed meshes.
+     * @param visible : Receives 1 for each visible chunk of the range, else 0.
+     * @return The number of culled chunks.
+     */
+    static std::size_t cull(const std::vector<Chunk> &chunks, std::size_t first, std::size_t count,
+                            const Frustum &frustum, const QVector3D &cameraPosition, bool coneCulling,
+                            std::vector<unsigned char> &visible);
+};
+
+#endif // CHUNKS_H
@@ -1,11 +1,27 @@
 #ifndef EDGEKEYHASH_H
 #define EDGEKEYHASH_H
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <utility>
 
 struct EdgeKeyHash {
     size_t operator()(const std::pair<int,int>& p) const noexcept;
 };
 
+// a position reduced to integers, its cell on a grid or the bits of its coordinates
+using PositionKey = std::array<std::int64_t, 3>;
+
+struct PositionKeyHash {
+    size_t operator()(const PositionKey& k) const noexcept;
+};
+
+/**
+ * @brief Get the key of a coordinate compared exactly.
+ * @param value : The coordinate.
+ * @return The bits of the coordinate, the same for -0 and +0.
+ */
+std::int64_t coordinateBits(float value);
+
 #endif // EDGEKEYHASH_H
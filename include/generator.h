@@ -0,0 +1,91 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <cstdint>
+#include <vector>
+#include <QVector3D>
+
+#include "mesh.h"
+
+/**
+ * @brief The CloudDistribution enum, how the points of a generated cloud are spread in the xy plane.
+ */
+enum class CloudDistribution {
+    UNIFORM=0,
+    CLUSTERED=1,
+    COLLINEAR=2,  // exactly on a line, a triangulation has no face
+    COCIRCULAR=3, // on a circle, the worst case of the in-circle test
+    GRID=4        // on a square lattice, each cell is 4 cocircular points
+};
+
+/**
+ * @brief A generated mesh or point cloud, kept as flat arrays so it stays compact at a large scale.
+ */
+struct GeneratedMesh
+{
+    std::vector<QVector3D> positions;
+    std::vector<unsigned int> indices; // 3 per triangle, empty for a point cloud
+};
+
+/**
+ * @brief The Generator class, builds synthetic meshes and point clouds of any size.
+ * Every element is computed from its index and the seed only, so the result is the same for
+ * any number of threads and the generation is split between all of them.
+ */
+class Generator
+{
+public:
+    /**
+     * @brief Subdivide an icosahedron and project it on the unit sphere, the mesh is closed.
+     * @param levels : Number of subdivisions, the sphere has 20 * 4^levels triangles.
+     * @return The sphere.
+     */
+    static GeneratedMesh icosphere(unsigned int levels);
+
+    /**
+     * @brief Build a closed torus around the z axis.
+     * @param rings : Number of sections around the z axis.
+     * @param sides : Number of vertices of each section, the torus has 2 * rings * sides triangles.
+     * @param majorRadius : Distance from the center to the center of the tube.
+     * @param minorRadius : Radius of the tube.
+     * @return The torus.
+     */
+    static GeneratedMesh torus(unsigned int rings, unsigned int sides, float majorRadius = 1.0f, float minorRadius = 0.35f);
+
+    /**
+     * @brief Build a grid over [-1, 1]^2 whose height is a fractal value noise.
+     * @param cells : Number of cells per side, the grid has 2 * cells * cells triangles.
+     * @param amplitude : Maximal height of the terrain.
+     * @param seed : The seed of the noise.
+     * @return The terrain.
+     */
+    static GeneratedMesh terrain(unsigned int cells, float amplitude, std::uint64_t seed);
+
+    /**
+     * @brief Draw a point cloud over [-1, 1]^2 with a small height, like a terrain scan.
+     * The degenerate distributions are exact in floating point, to stress the Delaunay predicates.
+     * @param count : Number of points.
+     * @param distribution : How the points are spread.
+     * @param seed : The seed of the points, GRID doesn't use it.
+     * @return The cloud, without indices.
+     */
+    static GeneratedMesh pointCloud(std::size_t count, CloudDistribution distribution, std::uint64_t seed);
+
+    /**
+     * @brief Build a mesh from generated geometry, the faces are sewed and the normals computed.
+     * @param generated : The generated geometry, a cloud gives a point cloud mesh.
+     * @return The mesh.
+     */
+    static Mesh toMesh(const GeneratedMesh &generated);
+
+    /**
+     * @brief Write generated geometry without building a mesh, the text is formatted by all the threads.
+     * The format follows the extension : .off, .obj, or .txt for the points only.
+     * @param generated : The generated geometry.
+     * @param link : The output file.
+     * @return MeshError::OK if the function terminates correctly, MeshError::FORMAT for an unknown extension, MeshError::SAVE else.
+     */
+    static int save(const GeneratedMesh &generated, const char *link);
+};
+
+#endif // GENERATOR_H
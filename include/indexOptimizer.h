@@ -0,0 +1,64 @@
+#ifndef INDEXOPTIMIZER_H
+#define INDEXOPTIMIZER_H
+
+#include <vector>
+
+#include "vertex.h"
+
+/**
+ * @brief Statistics of a FIFO post-transform vertex cache replaying an index buffer.
+ */
+struct CacheStatistics
+{
+    float acmr; // average cache miss ratio, vertex shader invocations per triangle
+    float atvr; // average transformed vertex ratio, invocations per referenced vertex
+};
+
+/**
+ * @brief The IndexOptimizer class, reorders triangle lists for the GPU.
+ * The faces are sorted for the post-transform cache (Tipsify) then clusters of faces are sorted
+ * to reduce the overdraw, the vertices finally follow their first use for the fetch locality.
+ * All the functions work on triangle lists of 3 indices per face.
+ */
+class IndexOptimizer
+{
+public:
+    /**
+     * @brief Replay the indices in a software FIFO cache, like the GPU post-transform cache.
+     * @param indices : The triangle list.
+     * @param vertexCount : The number of vertices referenced by the indices.
+     * @param cacheSize : The number of entries of the cache.
+     * @return The ACMR and the ATVR of the indices.
+     */
+    static CacheStatistics simulateVertexCache(const std::vector<unsigned int> &indices, std::size_t vertexCount, unsigned int cacheSize = 16);
+
+    /**
+     * @brief Order the faces for the post-transform cache with the Tipsify algorithm.
+     * @param indices : The triangle list.
+     * @param vertexCount : The number of vertices referenced by the indices.
+     * @param cacheSize : The number of entries of the targeted cache.
+     * @return The old index of each face in the new order.
+     */
+    static std::vector<unsigned int> optimizeVertexCache(const std::vector<unsigned int> &indices, std::size_t vertexCount, unsigned int cacheSize = 16);
+
+    /**
+     * @brief Split the faces in clusters and draw first the clusters facing outward, which hide the others.
+     * A cluster ends where the cache restarts or where its ACMR is close enough to the whole one.
+     * @param indices : The triangle list, already ordered for the cache.
+     * @param vertices : The vertices referenced by the indices.
+     * @param cacheSize : The number of entries of the targeted cache.
+     * @param threshold : The ACMR increase allowed to get smaller clusters.
+     * @return The old index of each face in the new order.
+     */
+    static std::vector<unsigned int> optimizeOverdraw(const std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices, unsigned int cacheSize = 16, float threshold = 1.05f);
+
+    /**
+     * @brief Order the vertices by their first use in the indices, the unused ones are put at the end.
+     * @param indices : The triangle list.
+     * @param vertexCount : The number of vertices.
+     * @return The old index of each vertex in the new order.
+     */
+    static std::vector<unsigned int> optimizeVertexFetch(const std::vector<unsigned int> &indices, std::size_t vertexCount);
+};
+
+#endif // INDEXOPTIMIZER_H
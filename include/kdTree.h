@@ -0,0 +1,96 @@
+#ifndef KDTREE_H
+#define KDTREE_H
+
+#include <limits>
+#include <vector>
+#include <QVector3D>
+
+#include "vertex.h"
+
+/**
+ * @brief The KDTree class, a nearest neighbor index over the positions of a point cloud or of the vertices of a mesh.
+ * The tree is implicit: the node [first, last) holds its median point at mid, its children are [first, mid) and
+ * [mid + 1, last), and the nodes of at most a leaf size are scanned. Only the split axis of each median is stored,
+ * the points are kept in tree order as structure of arrays so a leaf is a contiguous scan.
+ */
+class KDTree
+{
+public:
+    static constexpr unsigned int NO_POINT = std::numeric_limits<unsigned int>::max();
+
+    KDTree();
+
+    /**
+     * @brief Build the tree with median partitions, the top levels are split on several threads.
+     * @param points : The indexed points, the queries return their indices.
+     */
+    void build(const std::vector<QVector3D> &points);
+    void build(const std::vector<Vertex> &vertices);
+
+    void clear();
+    bool isEmpty() const;
+    std::size_t size() const;
+
+    /**
+     * @brief Find the closest points of a position.
+     * @param position : The query position.
+     * @param k : The number of neighbors.
+     * @param neighbors : Receives the indices of the min(k, size) closest points, from the closest.
+     * @param squaredDistances : If set, receives their squared distances.
+     */
+    void knn(const QVector3D &position, std::size_t k, std::vector<unsigned int> &neighbors, std::vector<float> *squaredDistances = nullptr) const;
+
+    /**
+     * @brief Find the closest points of a batch of positions, the batch is split between several threads.
+     * @param positions : The query positions.
+     * @param k : The number of neighbors.
+     * @param neighbors : Receives k indices per query, from the closest, NO_POINT after the last point if the tree has less than k.
+     * @param squaredDistances : If set, receives k squared distances per query, infinite after the last point.
+     */
+    void knn(const std::vector<QVector3D> &positions, std::size_t k, std::vector<unsigned int> &neighbors, std::vector<float> *squaredDistances = nullptr) const;
+
+    /**
+     * @brief Find the points in a ball.
+     * @param position : The center of the ball.
+     * @param radius : The radius of the ball, the points on the sphere are included.
+     * @param neighbors : Receives the indices of the points, in no particular order.
+     */
+    void radius(const QVector3D &position, float radius, std::vector<unsigned int> &neighbors) const;
+
+    /**
+     * @brief Find the points in the balls of a batch of positions, the batch is split between several threads.
+     * @param positions : The centers of the balls.
+     * @param radius : The radius of the balls.
+     * @param start : Receives the offsets of the results, the points of the query q are neighbors[start[q], start[q + 1]).
+     * The offsets are 64-bit, large balls can find more than 4G points in total.
+     * @param neighbors : Receives the indices of the points.
+     * @return The total number of points found.
+     */
+    std::size_t radius(const std::vector<QVector3D> &positions, float radius, std::vector<std::size_t> &start, std::vector<unsigned int> &neighbors) const;
+
+protected:
+    /**
+     * @brief Split the node [first, last) at its median, then its children, in parallel until the depth limit.
+     * @param first : The first point of the node.
+     * @param last : The end of the node.
+     * @param boundsMin : The lower corner of the cell of the node, its longest side is split.
+     * @param boundsMax : The upper corner of the cell of the node.
+     * @param depth : The depth of the node.
+     */
+    void split(std::size_t first, std::size_t last, QVector3D boundsMin, QVector3D boundsMax, int depth);
+
+    // during the build, the points with their index move together
+    struct Entry {
+        float position[3];
+        unsigned int index;
+    };
+    std::vector<Entry> entries;
+    int parallelDepth;
+
+    // the points in tree order, as structure of arrays
+    std::vector<float> px, py, pz;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned char> axes; // split axis of the node whose median is at this position
+};
+
+#endif // KDTREE_H
@@ -4,6 +4,8 @@
 #include <QMainWindow>
 #include <QGraphicsScene>
 
+#include "pointFilter.h"
+
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class MainWindow;
@@ -27,6 +29,7 @@ public:
     void onSaveClicked();
     void onLoadTexAction();
     void onDeleteTexAction();
+    void onSaveTraceAction();
     void updateTextureDisplay(QImage currentTexture);
 
 private:
@@ -34,8 +37,15 @@ private:
     void handleMeshError(int err);
     void handleTextureMessage(QString filename);
 
+    /**
+     * @brief Show the rolling frame statistics of the profiler.
+     */
+    void updateStatistics();
+
     Ui::MainWindow *ui;
     QTimer *errorTimer;
+    QTimer *statsTimer;
     QGraphicsScene *scene;
+    PointFilterOptions pointFilter;
 };
 #endif // MAINWINDOW_H
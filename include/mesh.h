@@ -1,11 +1,16 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include <array>
 #include <vector>
-#include <QOpenGLFunctions>
+#include <QVector3D>
 
 #include "vertex.h"
 #include "triangle.h"
+#include "indexOptimizer.h"
+#include "spatialSort.h"
+#include "pointFilter.h"
+#include "normalEstimator.h"
 
 /**
  * @brief The MeshError enum who returns error int type.
@@ -18,18 +23,52 @@ enum MeshError {
     UNKNOWN
 };
 
+/**
+ * @brief The vertices and faces changed by the local edits since the last clear.
+ * A face past the end of the faces has been removed, its slot must be cleared.
+ */
+struct DirtyRegion
+{
+    std::vector<unsigned int> vertices;
+    std::vector<unsigned int> faces;
+
+    bool isEmpty() const;
+    void addVertex(unsigned int vertex);
+    void addFace(unsigned int face);
+
+    /**
+     * @brief Sort the indices and remove the repeated ones, each edit adds its own.
+     */
+    void compact();
+};
+
 /**
  * @brief The Mesh class, used for mesh loading and processing.
  */
-class Mesh : public QOpenGLFunctions
+class Mesh
 {
 public:
     Mesh();
 
+    /**
+     * @brief Build a mesh from its vertices and faces, the faces are sewed and the normals computed.
+     * @param vertices : The vertices of the mesh.
+     * @param faces : The faces of the mesh.
+     * @param texCoords : True if the vertices have texture coordinates.
+     */
+    Mesh(std::vector<Vertex> vertices, std::vector<Triangle> faces, bool texCoords = false);
+
     const std::vector<Vertex> &getVertices() const;
+    const std::vector<Triangle> &getFaces() const;
     const std::vector<unsigned int> getIndices() const;
     const bool &hasTexture() const;
 
+    /**
+     * @brief Check if every edge of the mesh is shared by 2 faces, the mesh must have been sewed.
+     * @return True if the mesh has no boundary.
+     */
+    bool isClosed() const;
+
     /**
      * @brief Clear vertices and triangles vectors.
      */
@@ -43,9 +82,10 @@ public:
     /**
      * @brief Loading function who handle the file type
      * @param link
+     * @param order : The space filling curve used to reorder the vertices and the faces before the sewing.
      * @return MeshError::OK if the function terminates correctly, other else.
      */
-    int loadFile(const char* link);
+    int loadFile(const char* link, SpatialOrder order = SpatialOrder::NONE);
 
     /**
      * @brief Loading .off file function.
@@ -62,12 +102,73 @@ public:
     int loadOBJ(const char* link);
 
     /**
-     * @brief Loading .txt file function.
+     * @brief Loading .txt file function, the points go through the point filter before the triangulation.
      * @param link
      * @return MeshError::OK if the function terminates correctly, other else.
      */
     int loadTXT(const char* link);
 
+    /**
+     * @brief Load the points of a .txt file without triangulating them, the mesh is a point cloud.
+     * @param link
+     * @param order : The space filling curve used to reorder the points.
+     * @return MeshError::OK if the function terminates correctly, other else.
+     */
+    int loadPoints(const char* link, SpatialOrder order = SpatialOrder::NONE);
+
+    /**
+     * @brief Load a .off or .txt file in double, then move it around the center of its box before the conversion to float.
+     * Georeferenced coordinates keep their small steps, the points of a .txt file are then filtered and triangulated.
+     * @param link
+     * @param origin : Receives the center removed from the positions.
+     * @return MeshError::OK if the function terminates correctly, other else.
+     */
+    int loadCentered(const char* link, std::array<double, 3> &origin);
+
+    /**
+     * @brief Set the filter of the points triangulated by loadTXT and triangulatePoints.
+     * @param options : The cells of the duplicates and of the voxels, the exact duplicates are removed by default.
+     */
+    void setPointFilter(const PointFilterOptions &options);
+
+    /**
+     * @brief Get the points before and after the filter of the last triangulation.
+     */
+    const PointFilterStatistics &getPointFilterStatistics() const;
+
+    /**
+     * @brief Build the Delaunay triangulation of a point cloud, the points go through the point filter first.
+     * @return MeshError::OK if the function terminates correctly, MeshError::FORMAT if the mesh already has faces.
+     */
+    int triangulatePoints();
+
+    /**
+     * @brief Check if the mesh only has vertices, as loaded by loadPoints.
+     * @return True if the mesh has vertices and no face.
+     */
+    bool isPointCloud() const;
+
+    /**
+     * @brief Estimate the normals of a point cloud from the plane of the nearest neighbors of each point, with consistent signs.
+     * The cloud can then be lit without a triangulation, which computes the normals of its faces instead.
+     * @param options : The number of neighbors and the orientation.
+     * @return MeshError::OK if the function terminates correctly, MeshError::FORMAT if the mesh isn't a point cloud.
+     */
+    int estimatePointNormals(const NormalEstimationOptions &options = NormalEstimationOptions());
+
+    /**
+     * @brief Set the normals of a point cloud estimated elsewhere, like on a NormalEstimationJob.
+     * @param normals : One normal per point.
+     * @return MeshError::OK, MeshError::FORMAT if the mesh isn't a point cloud or the sizes differ.
+     */
+    int setPointNormals(const std::vector<QVector3D> &normals);
+
+    /**
+     * @brief Check if the points of a point cloud have estimated normals.
+     * @return True after estimatePointNormals, until the mesh is cleared.
+     */
+    bool hasPointNormals() const;
+
     /**
      * @brief Loading function who handle the file type
      * @param link
@@ -118,16 +219,175 @@ public:
      */
     void deNormalize();
 
+    /**
+     * @brief Reorder the vertices and the faces, the indices and the adjacency are remapped.
+     * @param vertexOrder : The old index of each new vertex, empty to keep the vertices order.
+     * @param faceOrder : The old index of each new face, empty to keep the faces order.
+     */
+    void reorder(const std::vector<unsigned int> &vertexOrder, const std::vector<unsigned int> &faceOrder);
+
+    /**
+     * @brief Reorder the faces for the vertex cache and the overdraw, then the vertices in first use order.
+     * @param before : If not null, receives the cache statistics of the previous order.
+     * @param after : If not null, receives the cache statistics of the new order.
+     */
+    void optimizeIndices(CacheStatistics *before = nullptr, CacheStatistics *after = nullptr);
+
+    /**
+     * @brief Sort the vertices along a space filling curve, then the faces by their centroid.
+     * Close elements are close in memory, which helps the cache of all the geometry passes.
+     * @param order : The space filling curve, SpatialOrder::NONE does nothing.
+     */
+    void spatialReorder(SpatialOrder order);
+
+    /**
+     * @brief Merge the vertices at the same position, like the corners split by the OBJ loader.
+     * The merged vertex keeps the texture coordinates of the first one, the faces left degenerate are removed,
+     * then the mesh is sewed and its normals computed.
+     * @param tolerance : Vertices in the same cell of this size are merged, 0 merges the exact positions only.
+     * @return The number of removed vertices.
+     */
+    std::size_t weld(float tolerance = 0.0f);
+
+    /**
+     * @brief Compute the normals of each vertex.
+     */
+    void computeNormals();
+
+    /**
+     * @brief Split an edge and the faces on its sides at a new vertex, the mesh must have been sewed.
+     * The local edits only patch the adjacency of the faces they change and the normals of their vertices.
+     * @param face : A face of the edge.
+     * @param edge : The edge in the face, from its vertex edge to the next one.
+     * @param position : The position of the new vertex, its texture coordinates are interpolated along the edge.
+     * @return The index of the new vertex, -1 if the face doesn't exist or isn't sewed.
+     */
+    int splitEdge(unsigned int face, int edge, const QVector3D &position);
+
+    /**
+     * @brief Replace an edge by the other diagonal of its 2 faces.
+     * @param face : A face of the edge.
+     * @param edge : The edge in the face.
+     * @return False for a boundary edge, or if the other diagonal is already an edge.
+     */
+    bool flipEdge(unsigned int face, int edge);
+
+    /**
+     * @brief Merge the 2 vertices of an edge at its middle and remove its faces.
+     * The last faces are moved in the freed slots, the removed vertex is kept unused.
+     * @param face : A face of the edge.
+     * @param edge : The edge in the face.
+     * @return The index of the kept vertex, -1 if the collapse would make the mesh non-manifold.
+     */
+    int collapseEdge(unsigned int face, int edge);
+
+    /**
+     * @brief Split a face in 3 at a new vertex.
+     * @param face : The face.
+     * @param position : The position of the new vertex, inside the face.
+     * @return The index of the new vertex, -1 if the face doesn't exist or isn't sewed.
+     */
+    int insertVertex(unsigned int face, const QVector3D &position);
+
+    /**
+     * @brief Get the part of the mesh changed by the local edits, to upload only this part to the GPU.
+     * @return The indices changed since the last clear, in the order of the edits.
+     */
+    const DirtyRegion &getDirtyRegion() const;
+    void clearDirtyRegion();
+
+    /**
+     * @brief Move the vertices, the faces are kept and the normals computed again.
+     * All the vertices are marked dirty.
+     * @param positions : One position per vertex, nothing is done for another size.
+     */
+    void setPositions(const std::vector<QVector3D> &positions);
+
+    /**
+     * @brief Move the vertices with normals computed elsewhere, like on a SmoothingJob, the faces are kept.
+     * All the vertices are marked dirty.
+     * @param positions : One position per vertex.
+     * @param normals : One normal per vertex, nothing is done if one of the sizes differs.
+     */
+    void setPositions(const std::vector<QVector3D> &positions, const std::vector<QVector3D> &normals);
+
+    /**
+     * @brief Refine the mesh with Loop subdivision, each face is split in 4 and the vertices are smoothed.
+     * The mesh must have been sewed, the adjacency of the new faces comes from the old one without sewing again.
+     * @param levels : The number of subdivisions, each one multiplies the faces by 4.
+     */
+    void subdivideLoop(int levels = 1);
+
+    /**
+     * @brief Refine the mesh with sqrt(3) subdivision, each face is split in 3 at its center and the old edges are flipped.
+     * The faces grow 3 times per level instead of 4, the boundary edges are kept and their vertices don't move.
+     * @param levels : The number of subdivisions.
+     */
+    void subdivideSqrt3(int levels = 1);
+
 protected:
 
+    /**
+     * @brief Get the faces around a vertex by walking the adjacency, the mesh must have been sewed.
+     * @param face : A face of the vertex.
+     * @param vertex : The vertex.
+     * @param boundary : If not null, receives true if the faces don't make a closed fan.
+     * @return The faces, starting with face.
+     */
+    std::vector<unsigned int> facesAround(unsigned int face, unsigned int vertex, bool *boundary = nullptr) const;
+
+    /**
+     * @brief Set the neighbor of a face across one of its edges.
+     * @param face : The face, nothing is done for Triangle::NO_NEIGHBOR.
+     * @param a : The first vertex of the edge in the face.
+     * @param b : The second vertex of the edge in the face.
+     * @param neighbor : The new neighbor.
+     */
+    void setNeighbor(unsigned int face, unsigned int a, unsigned int b, unsigned int neighbor);
+
+    /**
+     * @brief Remove a face, the last face takes its slot and its neighbors are updated.
+     * No other face must still refer to the removed face.
+     * @param face : The face.
+     * @return The old index of the moved face.
+     */
+    unsigned int removeFace(unsigned int face);
+
+    /**
+     * @brief Recompute the normals of the vertices of some faces, from all the faces around them.
+     * @param touched : The faces, they are marked dirty with their vertices.
+     */
+    void updateNormals(const std::vector<unsigned int> &touched);
+
+    /**
+     * @brief Get the faces of each vertex, in increasing order.
+     * @param first : Receives the start of the faces of each vertex, with one more entry for the end.
+     * @param faceList : Receives the faces.
+     */
+    void vertexFaces(std::vector<unsigned int> &first, std::vector<unsigned int> &faceList) const;
+
+    /**
+     * @brief Get the edge of the neighbor across an edge, when the 2 faces refer to each other.
+     * @param face : The face, it must have been sewed.
+     * @param edge : The edge in the face.
+     * @return The edge in the neighbor, -1 for a boundary or a non-manifold edge.
+     */
+    int twinEdge(unsigned int face, int edge) const;
+
+    /**
+     * @brief Split an edge at an existing vertex, see splitEdge.
+     * @return The new faces, then the old ones.
+     */
+    std::vector<unsigned int> splitEdgeAt(unsigned int face, int edge, unsigned int vertex);
+
     /**
      * @brief Function who find the neighbor of a triangle.
      * @param triIndex : Indice of the first triangle.
      * @param a : First point of the edge.
      * @param b : Second point of the edge.
-     * @return The indice of the neighbor, else -1.
+     * @return The indice of the neighbor, else Triangle::NO_NEIGHBOR.
      */
-    int findNeighbor(unsigned int triIndex, unsigned int a, unsigned int b) const;
+    unsigned int findNeighbor(unsigned int triIndex, unsigned int a, unsigned int b) const;
 
     /**
      * @brief Compute the area of a face.
@@ -136,11 +396,6 @@ protected:
      */
     float faceArea(int faceIndex) const;
 
-    /**
-     * @brief Compute the normals of each vertex.
-     */
-    void computeNormals();
-
     /**
      * @brief Split a triangle by 3.
      * @param p : The point inside the triangle all the 3 triangles will contain this point.
@@ -156,7 +411,7 @@ protected:
     void edgeFlip(int t1, int t2);
 
     /**
-     * @brief Split the common edge between 2 triangles.
+     * @brief Split the common edge between 2 sewed triangles, only their adjacency and normals are updated.
      * @param p : The indice of the point inside the edge.
      * @param t1 : The indice of the first triangle.
      * @param t2 : the indice if the second triangle.
@@ -180,15 +435,6 @@ protected:
      */
     int pointInTriangle(int p, int triIndex) const;
 
-    /**
-     * @brief Insert a point inside a mesh.
-     * @param x : X coordinate of the point.
-     * @param y : Y coordinate of the point.
-     * @param z : Z coordinate of the point.
-     * @return The index of the new point if the point is inserted, else -1.
-     */
-    int insert(float x, float y, float z);
-
     /**
      * @brief Check if 2 triangles are locally de Delaunay.
      * @param t1 : The indice of the first triangle.
@@ -208,30 +454,29 @@ protected:
     bool isInCircumcircleNorm(int a, int b, int c, int d) const;
 
     /**
-     * @brief Performs the Lawsons' algorithm on he whole mesh.
-     */
-    void lawsonAlgorithm();
-
-    /**
-     * @brief Performs the Lawsons' algorithm locally in the incident faces around a point.
-     * @param p : The indice of the point where the algorithm starts.
-     */
-    void lawsonLocalUpdate(int p);
-
-    /**
-     * @brief Initialize a super bounding triangle, useful for the construction of the Delaunay mesh.
+     * @brief Read the points of a .txt file, the numbers are parsed on several threads.
+     * @param link
+     * @param points : Receives the points.
+     * @return MeshError::OK if the function terminates correctly, other else.
      */
-    void initializeSuperTriangle();
+    static int readPoints(const char* link, std::vector<QVector3D> &points);
 
     /**
-     * @brief Remove the super bounding triangle and reconnect correctly the mesh.
+     * @brief Replace the mesh by the Delaunay triangulation of points in the xy plane, inserted one by one along a Hilbert curve.
+     * The duplicated points stay as vertices without faces.
+     * @param points : The points.
      */
-    void removeSuperTriangle();
+    void triangulate(const std::vector<QVector3D> &points);
 
     std::vector<Vertex> vertices;
     std::vector<Triangle> faces;
     float normCoeff;
     bool hasTexCoords;
+    SpatialOrder loadOrder;
+    PointFilterOptions pointFilter;
+    PointFilterStatistics pointFilterStatistics;
+    bool pointNormals;
+    DirtyRegion dirty;
 };
 
 #endif // MESH_H
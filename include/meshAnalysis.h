@@ -0,0 +1,104 @@
+#ifndef MESHANALYSIS_H
+#define MESHANALYSIS_H
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mesh.h"
+
+/**
+ * @brief Topology and quality figures of a mesh, computed from its faces only.
+ */
+struct MeshStatistics
+{
+    std::size_t vertices = 0;
+    std::size_t faces = 0;
+    std::size_t edges = 0;            // undirected edges between 2 different vertices
+    std::size_t components = 0;       // groups of faces connected by their vertices
+    std::size_t isolatedVertices = 0; // used by no face, a point cloud has only these
+    std::size_t boundaryEdges = 0;    // edges of a single face
+    std::size_t boundaryLoops = 0;    // loops touching at a vertex are counted once
+    std::size_t nonManifoldEdges = 0; // edges of more than 2 faces
+    std::size_t degenerateFaces = 0;  // repeated vertex or zero area
+    long long eulerCharacteristic = 0; // V - E + F over the vertices used by the faces
+
+    bool isClosedManifold() const;
+};
+
+/**
+ * @brief The MeshAnalysis class, statistics pass run on all the threads before processing a mesh.
+ * The components and the boundary loops are found with a lock-free union-find, the edges with a per-vertex sort,
+ * so the pass is near-linear and doesn't need the faces to be sewed.
+ */
+class MeshAnalysis
+{
+public:
+    /**
+     * @brief Compute the statistics of a mesh.
+     * @param mesh : The mesh to analyze.
+     * @return The counts, all 0 for an empty mesh.
+     */
+    static MeshStatistics analyze(const Mesh &mesh);
+
+    /**
+     * @brief Compute the statistics of a copy of the geometry of a mesh.
+     * @param positions : The positions of the vertices.
+     * @param faces : The vertex ids of the faces.
+     * @return The counts, all 0 for an empty mesh.
+     */
+    static MeshStatistics analyze(const std::vector<QVector3D> &positions, const std::vector<std::array<unsigned int, 3>> &faces);
+
+    /**
+     * @brief Label the connected components of a mesh, the faces sharing a vertex have the same label.
+     * @param mesh : The mesh to label.
+     * @param faceLabels : Receives the component of each face, numbered from 0 in the order of their smallest vertex.
+     * @return The number of components.
+     */
+    static std::size_t labelComponents(const Mesh &mesh, std::vector<unsigned int> &faceLabels);
+
+    /**
+     * @brief Describe the statistics on one line, for the tools and the interface.
+     * @param statistics : The statistics to describe.
+     * @return The text, without a line break.
+     */
+    static std::string summary(const MeshStatistics &statistics);
+};
+
+/**
+ * @brief The MeshAnalysisJob class, analyzes a copy of the geometry of a mesh on its own thread.
+ */
+class MeshAnalysisJob
+{
+public:
+    /**
+     * @brief Copy the positions and the faces of a mesh, then start the analysis.
+     * @param mesh : The mesh, only read by the constructor.
+     */
+    explicit MeshAnalysisJob(const Mesh &mesh);
+
+    /**
+     * @brief Wait for the thread.
+     */
+    ~MeshAnalysisJob();
+
+    bool isFinished() const;
+
+    /**
+     * @brief Get the statistics once the job is finished.
+     */
+    const MeshStatistics &getStatistics() const;
+
+protected:
+    void run();
+
+    std::vector<QVector3D> positions;
+    std::vector<std::array<unsigned int, 3>> faces;
+    MeshStatistics statistics;
+    std::atomic<bool> finished;
+    std::thread worker;
+};
+
+#endif // MESHANALYSIS_H
@@ -0,0 +1,92 @@
+#ifndef NORMALESTIMATOR_H
+#define NORMALESTIMATOR_H
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <QVector3D>
+
+struct NormalEstimationOptions
+{
+    std::size_t neighbors = 16; // points of the fitted plane, the point itself included
+    bool orient = true;         // propagate a common side over the cloud, else each sign is arbitrary
+    const std::atomic<bool> *cancel = nullptr; // if set, checked between the slices of work, the result is then empty
+};
+
+/**
+ * @brief The NormalEstimator class, the normals of a point cloud without faces.
+ * The normal of a point is the direction of least variance of its nearest neighbors, the smallest eigenvector
+ * of their covariance, so the cloud doesn't need to be a height field. The signs are then made consistent
+ * along a minimum spanning tree of the neighbor graph, where the nearly parallel planes are crossed first.
+ */
+class NormalEstimator
+{
+public:
+    /**
+     * @brief Estimate a unit normal per point, the planes are fitted on all the threads.
+     * @param points : The cloud.
+     * @param options : The number of neighbors, the orientation and the cancel flag.
+     * @return One normal per point, nothing if the estimation was cancelled.
+     */
+    static std::vector<QVector3D> estimate(const std::vector<QVector3D> &points, const NormalEstimationOptions &options = NormalEstimationOptions());
+
+    /**
+     * @brief Get the unit eigenvector of the smallest eigenvalue of a symmetric matrix, solved in closed form.
+     * @param covariance : The matrix as xx, xy, xz, yy, yz, zz.
+     * @return The eigenvector, a vector across the line for a matrix of rank 1, the z axis for a null matrix.
+     */
+    static QVector3D smallestEigenvector(const std::array<double, 6> &covariance);
+
+    /**
+     * @brief Flip the normals so the neighbors agree, along a minimum spanning tree of 1 - |ni.nj|.
+     * Each connected part is then flipped as a whole if the normal of its highest point is turned down.
+     * @param points : The cloud.
+     * @param neighbors : k neighbors per point, NO_POINT for the missing ones, the graph is made symmetric.
+     * @param k : The neighbors per point.
+     * @param normals : The normals, flipped in place.
+     * @param cancel : If set and true, the orientation stops early and the signs are left partly propagated.
+     * @return The number of connected parts.
+     */
+    static std::size_t orient(const std::vector<QVector3D> &points, const std::vector<unsigned int> &neighbors, std::size_t k,
+                              std::vector<QVector3D> &normals, const std::atomic<bool> *cancel = nullptr);
+};
+
+/**
+ * @brief The NormalEstimationJob class, estimates the normals of a cloud on its own thread.
+ */
+class NormalEstimationJob
+{
+public:
+    /**
+     * @brief Start the estimation, the points are copied.
+     * @param points : The cloud.
+     * @param options : The number of neighbors and the orientation, the cancel flag is the one of the job.
+     */
+    NormalEstimationJob(const std::vector<QVector3D> &points, const NormalEstimationOptions &options = NormalEstimationOptions());
+
+    /**
+     * @brief Cancel the estimation and wait for the thread.
+     */
+    ~NormalEstimationJob();
+
+    bool isFinished() const;
+
+    /**
+     * @brief Take the normals once the job is finished.
+     * @return One normal per point, nothing before the end or after the first call.
+     */
+    std::vector<QVector3D> takeNormals();
+
+protected:
+    void run();
+
+    std::vector<QVector3D> points;
+    std::vector<QVector3D> normals;
+    NormalEstimationOptions options;
+    std::atomic<bool> stopping;
+    std::atomic<bool> finished;
+    std::thread worker;
+};
+
+#endif // NORMALESTIMATOR_H
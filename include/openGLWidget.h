@@ -7,9 +7,22 @@
 #include <QOpenGLTexture>
 #include <QMouseEvent>
 #include <QWheelEvent>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <functional>
+#include <memory>
 
 #include "camera.h"
 #include "mesh.h"
+#include "bvh.h"
+#include "simplifier.h"
+#include "vertexCompression.h"
+#include "chunks.h"
+#include "chunkFile.h"
+#include "chunkStreamer.h"
+#include "smoother.h"
+#include "meshAnalysis.h"
+#include "normalEstimator.h"
 
 class OpenGLWidget : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core {
     Q_OBJECT
@@ -18,6 +31,12 @@ signals:
     void verticesChanged(int value);
     void trianglesChanged(int value);
     void textureChanged(QImage currentTexture);
+    void selectionChanged(int face, int vertex);
+    void indicesOptimized(CacheStatistics before, CacheStatistics after);
+    void chunksCulled(int culled, int total);
+    void smoothingProgress(int iteration, int total);
+    void meshAnalyzed(MeshStatistics statistics);
+    void pointsFiltered(int pointsIn, int pointsOut);
 
 
 public:
@@ -30,8 +49,78 @@ public:
     void updateMeshBuffers();
     void deleteTexture();
 
+    /**
+     * @brief Set the frame time targeted by the adaptive rendering while the user interacts.
+     * @param ms : The frame budget in milliseconds.
+     */
+    void setFrameBudget(float ms);
+
+    /**
+     * @brief Set the space filling curve used to reorder the next loaded meshes.
+     * @param order : The curve, SpatialOrder::NONE keeps the file order.
+     */
+    void setSpatialOrder(SpatialOrder order);
+
+    /**
+     * @brief Load the next .txt files as point clouds, without triangulating them.
+     * @param enabled : True to skip the triangulation.
+     */
+    void setPointCloudMode(bool enabled);
+
+    /**
+     * @brief Estimate the normals of the next loaded point clouds, so they are lit without a triangulation.
+     * The cloud is drawn unlit while the normals are estimated on a worker thread.
+     * @param enabled : False to draw the points unlit.
+     */
+    void setPointNormals(bool enabled);
+
+    /**
+     * @brief Set the filter of the .txt clouds, applied before their triangulation.
+     * @param options : The cells of the duplicates and of the voxels.
+     */
+    void setPointFilter(const PointFilterOptions &options);
+
 public slots:
     void setWireframe(bool enabled);
+    void setAdaptiveRendering(bool enabled);
+    void setOptimizeOnLoad(bool enabled);
+    void setCompactVertices(bool enabled);
+    void setPointSize(double size);
+
+    /**
+     * @brief Triangulate the loaded point cloud, the mesh replaces the points.
+     * @return MeshError::OK if the function terminates correctly, other else.
+     */
+    int triangulatePointCloud();
+
+    /**
+     * @brief Reorder the indices of the mesh and of its levels of detail for the GPU caches.
+     */
+    void optimizeIndices();
+
+    /**
+     * @brief Refine the mesh by one level of subdivision, the levels of detail are built again.
+     */
+    void subdivideLoop();
+    void subdivideSqrt3();
+
+    /**
+     * @brief Edit the selection, only the changed vertices and faces are uploaded.
+     * The selected edge goes from the selected vertex to the next vertex of the selected face.
+     */
+    void splitSelectedEdge();
+    void flipSelectedEdge();
+    void collapseSelectedEdge();
+    void insertVertexInSelection();
+
+    /**
+     * @brief Smooth the mesh on a worker thread, the intermediate iterations are drawn as they come.
+     * A smoothing still running is stopped and the new one starts from its last drawn positions.
+     * @param method : Laplacian or Taubin.
+     * @param iterations : The number of iterations.
+     */
+    void smooth(SmoothingMethod method, int iterations);
+    void setPreserveBoundary(bool enabled);
 
 protected:
     void initializeGL() override;
@@ -40,8 +129,141 @@ protected:
 
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
     void wheelEvent(QWheelEvent *event) override;
 
+    /**
+     * @brief Cast a ray under the cursor and select the closest face and its closest vertex.
+     * @param pos : The cursor position in the widget.
+     */
+    void pick(const QPointF &pos);
+
+    /**
+     * @brief Draw the mesh, paintGL wraps it with the CPU and GPU timers.
+     */
+    void drawFrame();
+
+    /**
+     * @brief Draw range of a level of detail inside the shared vertex and index buffers.
+     */
+    struct LodRange {
+        GLsizei indexCount;
+        std::size_t firstIndex;
+        GLint baseVertex;
+        float error;
+        float cpuMs; // cost of a frame of the level measured by paintGL, negative if unknown
+        float gpuMs; // cost measured by the timer queries, negative if unknown
+        qint64 measuredAt; // time of the last measure on the lod clock
+        std::size_t firstChunk;
+        std::size_t chunkCount;
+        bool closed; // the chunks seen from behind can be culled
+    };
+
+    /**
+     * @brief Select the coarsest level of detail whose error projected on screen stays under the threshold.
+     * @param projection : The projection matrix of the camera.
+     * @return The index of the level in lodRanges, 0 being the full mesh.
+     */
+    int selectLod(const QMatrix4x4 &projection) const;
+
+    /**
+     * @brief Select the finest level of detail whose frame time fits in the budget.
+     * @return The index of the level in lodRanges.
+     */
+    int selectInteractiveLod() const;
+
+    /**
+     * @brief Add a measured cost of a frame to its level, a stale measure is replaced instead of averaged.
+     * @param lod : The index of the level in lodRanges, nothing is done for -1.
+     * @param ms : The CPU time of paintGL or the GPU time of its timer query.
+     * @param gpu : True for a GPU time.
+     */
+    void addFrameSample(int lod, float ms, bool gpu);
+
+    /**
+     * @brief Get the measured frame time of a level, the largest of its CPU and GPU costs.
+     * @param lod : The index of the level in lodRanges.
+     * @return The frame time in milliseconds, negative if the level wasn't measured recently.
+     */
+    float measuredFrameTime(int lod) const;
+
+    /**
+     * @brief Estimate the frame time of a level, from its recent measures or from the closest recently measured level.
+     * @param lod : The index of the level in lodRanges.
+     * @return The estimated frame time in milliseconds.
+     */
+    float estimateFrameTime(int lod) const;
+
+    /**
+     * @brief Switch to the interactive rendering, until the mouse is released or stays idle.
+     */
+    void beginInteraction();
+
+    /**
+     * @brief Go back to the full detail rendering.
+     */
+    void endInteraction();
+
+    /**
+     * @brief Optimize the mesh and its levels of detail, the statistics of the mesh are emitted.
+     */
+    void optimizeMeshIndices();
+
+    /**
+     * @brief Build the levels of detail, the picking structure and the buffers of a new mesh.
+     */
+    void prepareMesh();
+
+    /**
+     * @brief Open a chunk file built by MeshChunker, its chunks are streamed while the camera moves.
+     * @param link
+     * @return MeshError::OK if the function terminates correctly, other else.
+     */
+    int loadChunkFile(const char *link);
+
+    /**
+     * @brief Stop the streaming and release its buffers.
+     */
+    void closeChunkFile();
+
+    /**
+     * @brief Upload the chunks read since the last frame and draw the visible resident ones.
+     * @param view : The view matrix of the camera.
+     * @param projection : The projection matrix of the camera.
+     */
+    void paintStreamed(const QMatrix4x4 &view, const QMatrix4x4 &projection);
+
+    /**
+     * @brief Apply a local edit to the selection, then upload the dirty region of the mesh.
+     * @param edit : Called with the selected face and edge, returns false if the edit is refused.
+     */
+    void editSelection(const std::function<bool(unsigned int, int)> &edit);
+
+    /**
+     * @brief Upload the vertices and faces changed by the local edits, the new ones go in the reserve after the full mesh.
+     * The buffers are rebuilt when the reserve is full.
+     */
+    void uploadDirtyRegion();
+
+    /**
+     * @brief Draw the last positions published by the smoothing, the levels of detail are built again when it ends.
+     */
+    void pollSmoothing();
+
+    /**
+     * @brief Upload the normals of the point cloud once their estimation ends, the points are then lit.
+     */
+    void pollPointNormals();
+
+    /**
+     * @brief Send the statistics of the last analysis, then analyze the mesh again if it was edited since.
+     */
+    void pollAnalysis();
+
+    /**
+     * @brief Drop the analysis of the edits, the mesh was replaced.
+     */
+    void stopAnalysis();
 
     GLuint VAO;
     GLuint VBO;
@@ -53,10 +275,79 @@ protected:
 
     Camera camera;
     QPointF lastMousePos;
+    QPointF pressMousePos;
     bool leftPressed;
     bool middlePressed;
 
     Mesh mesh;
+    BVH bvh;
+    std::vector<LevelOfDetail> lods;
+    std::vector<LodRange> lodRanges;
+    QVector3D meshCenter;
+    float meshRadius;
+    int drawnTriangles;
+
+    bool adaptive;
+    bool interacting;
+    int frameLod; // level measured by the current frame, -1 if none
+    float frameBudget;
+    int drawnLod;
+    QTimer *idleTimer;
+    QElapsedTimer lodClock; // dates the frame time samples
+    bool optimizeOnLoad;
+    SpatialOrder spatialOrder;
+    bool compactVertices;
+    Quantization quantization;
+    GLenum indexType;
+    std::size_t indexSize;
+
+    std::vector<Chunk> chunks;
+    std::vector<unsigned char> visibleChunks;
+    std::vector<GLsizei> drawCounts;
+    std::vector<const void*> drawOffsets;
+    std::vector<GLint> drawBaseVertices;
+    int culledChunks;
+    int totalChunks;
+
+    // out of core rendering, each slot of the buffers holds one chunk
+    ChunkFile chunkFile;
+    std::unique_ptr<ChunkStreamer> streamer;
+    GLuint streamVAO;
+    GLuint streamVBO;
+    GLuint streamEBO;
+    QMatrix4x4 streamModel;
+    std::vector<unsigned int> streamVisible;
+    std::vector<GLuint> timerQueries;
+    std::vector<int> timerLods; // level drawn during each query, -1 if none
+    std::size_t timerFrame;
+    float gpuMs;
+
+    // local edits, the full mesh is the last level of the buffers so its faces can grow in the reserve
+    int selectedFace;
+    int selectedVertex;
+    bool edited; // the levels of detail and the chunks are out of date, the full mesh is drawn whole
+    bool bvhStale;
+    std::vector<unsigned int> faceSlots; // triangle of the full mesh range holding each face
+    std::vector<unsigned int> freeSlots;
+    std::size_t usedSlots;
+    std::size_t slotCapacity;
+    std::size_t vertexCapacity;
+
+    // smoothing on a worker thread, polled by a timer
+    std::unique_ptr<SmoothingJob> smoothing;
+    QTimer *smoothingTimer;
+    bool preserveBoundary;
+
+    // statistics of the edited mesh, analyzed on a worker at most once per interval
+    std::unique_ptr<MeshAnalysisJob> analysis;
+    QTimer *analysisTimer;
+    bool analysisStale;
+
+    bool pointCloudMode;
+    bool pointNormals;
+    std::unique_ptr<NormalEstimationJob> normalEstimation;
+    QTimer *normalTimer;
+    float pointSize; // in pixels
     bool wireframe;
     bool useTexCoords;
 
@@ -0,0 +1,30 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * @brief Get the number of threads used by the parallel helpers, see TaskScheduler::getThreadCount.
+ * @return The count of MESHVIEWER_THREADS or of TaskScheduler::setThreadCount, else the hardware threads, at least 1.
+ */
+unsigned int parallelThreadCount();
+
+/**
+ * @brief Split the range [begin, end) in blocks and process them on several threads.
+ * @param begin : First index of the range.
+ * @param end : One past the last index of the range.
+ * @param grain : Minimum number of indices processed by a block.
+ * @param body : Function called with the bounds [blockBegin, blockEnd) of each block.
+ */
+void parallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+                 const std::function<void(std::size_t, std::size_t)> &body);
+
+/**
+ * @brief Run two functions concurrently and wait for both of them, the calling thread runs other tasks while it waits.
+ * @param a : First function, queued as a task of the scheduler, it can be stolen by any worker.
+ * @param b : Second function, run on the calling thread.
+ */
+void parallelInvoke(const std::function<void()> &a, const std::function<void()> &b);
+
+#endif // PARALLEL_H
@@ -0,0 +1,63 @@
+#ifndef POINTFILTER_H
+#define POINTFILTER_H
+
+#include <unordered_map>
+#include <vector>
+#include <QVector3D>
+
+#include "edgeKeyHash.h"
+
+enum class VoxelPoint {
+    CENTROID=0, // the mean of the points of the voxel
+    CLOSEST=1   // the point of the voxel closest to its center, an input point is kept as it is
+};
+
+struct PointFilterOptions
+{
+    float epsilon = 0.0f;   // points in the same cell of this size, or closer across a cell border, are duplicates, 0 for the exact ones only
+    float voxelSize = 0.0f; // one point per voxel of this size, 0 to only remove the duplicates
+    VoxelPoint voxelPoint = VoxelPoint::CENTROID;
+    bool planar = true;     // compare x and y only, like the triangulation of the clouds
+};
+
+/**
+ * @brief The points read and kept by a filter.
+ */
+struct PointFilterStatistics
+{
+    std::size_t pointsIn = 0;
+    std::size_t pointsOut = 0;
+};
+
+/**
+ * @brief The PointFilter class, removes the duplicates of a point cloud and downsamples it on a grid before its triangulation.
+ * The points are spread over buckets by the hash of their cell, each bucket is reduced alone on the threads.
+ */
+class PointFilter
+{
+public:
+    /**
+     * @brief Keep one point per cell, the first of its duplicates or the representative of its voxel.
+     * The kept points stay in the order of their first point in the cloud.
+     * @param points : The cloud, filtered in place.
+     * @param options : The sizes of the cells.
+     * @return The number of points before and after.
+     */
+    static PointFilterStatistics filter(std::vector<QVector3D> &points, const PointFilterOptions &options);
+
+protected:
+    /**
+     * @brief Remove the kept points closer than epsilon to an earlier kept point of one of the 8 or 26 neighbor cells.
+     * @param points : The cloud.
+     * @param keys : The cell of each point.
+     * @param firstPoints : The first point of each cell, in the bucket of the hash of its key.
+     * @param epsilon : The size of the cells.
+     * @param axes : 2 to compare x and y only, else 3.
+     * @param kept : The first point of each cell is set, the duplicates are cleared.
+     */
+    static void removeBorderDuplicates(const std::vector<QVector3D> &points, const std::vector<PositionKey> &keys,
+                                       const std::vector<std::unordered_map<PositionKey, unsigned int, PositionKeyHash>> &firstPoints,
+                                       float epsilon, int axes, std::vector<unsigned char> &kept);
+};
+
+#endif // POINTFILTER_H
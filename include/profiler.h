@@ -0,0 +1,101 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Rolling statistics of the last frames.
+ */
+struct FrameStatistics
+{
+    float frameMs;  // mean CPU time of paintGL
+    float p95Ms;    // 95th percentile of the CPU time
+    float gpuMs;    // mean GPU time, negative without timer queries
+    int triangles;  // drawn by the last frame
+    std::size_t uploadedBytes; // sent to the GPU by the last frame
+    std::size_t frames; // number of frames in the statistics
+};
+
+/**
+ * @brief The Profiler class, records timed events, counters and frame statistics shared by all the threads.
+ * The event names must be string literals, only their address is kept.
+ */
+class Profiler
+{
+public:
+    /**
+     * @brief Enable or disable the recording, a disabled profiler costs one atomic load per event.
+     * @param enabled
+     */
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    /**
+     * @brief Get the time elapsed since the start of the program.
+     * @return The time in microseconds.
+     */
+    static std::int64_t now();
+
+    /**
+     * @brief Record an event of the calling thread.
+     * @param name : The name of the event.
+     * @param start : The start time in microseconds, from now().
+     * @param duration : The duration in microseconds.
+     */
+    static void addEvent(const char *name, std::int64_t start, std::int64_t duration);
+
+    /**
+     * @brief Record the value of a counter at the current time.
+     * @param name : The name of the counter.
+     * @param value : Its value.
+     */
+    static void addCounter(const char *name, std::int64_t value);
+
+    /**
+     * @brief Count bytes sent to the GPU, they are given to the next frame.
+     * @param bytes
+     */
+    static void addUpload(std::size_t bytes);
+
+    /**
+     * @brief Close a frame and add it to the rolling statistics.
+     * @param cpuMs : The CPU time of the frame.
+     * @param gpuMs : The GPU time of a recent frame, negative if unknown.
+     * @param triangles : The number of drawn triangles.
+     */
+    static void addFrame(float cpuMs, float gpuMs, int triangles);
+
+    static FrameStatistics getFrameStatistics();
+
+    /**
+     * @brief Write the recorded events in the Chrome trace format, readable by chrome://tracing or Perfetto.
+     * @param link : The JSON file.
+     * @return False if the file can't be written.
+     */
+    static bool saveChromeTrace(const char *link);
+
+    /**
+     * @brief Forget the recorded events and frames.
+     */
+    static void clear();
+};
+
+/**
+ * @brief The ScopedTimer class, records an event from its construction to its destruction.
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(const char *name);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+protected:
+    const char *name;
+    std::int64_t start;
+};
+
+#endif // PROFILER_H
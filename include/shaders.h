@@ -9,12 +9,26 @@ static const char* vertexShader =
     "uniform mat4 model;\n"
     "uniform mat4 view;\n"
     "uniform mat4 projection;\n\n"
+    "// compact vertices, quantized positions and octahedral normals\n"
+    "uniform vec3 positionOffset;\n"
+    "uniform vec3 positionScale;\n"
+    "uniform bool octNormal;\n\n"
 
     "out vec3 Normal;\n\n"
 
+    "vec3 decodeNormal(vec3 n) {\n"
+    "    if (!octNormal) return n;\n"
+    "    vec3 v = vec3(n.xy, 1.0 - abs(n.x) - abs(n.y));\n"
+    "    float t = max(-v.z, 0.0);\n"
+    "    v.x += v.x >= 0.0 ? -t : t;\n"
+    "    v.y += v.y >= 0.0 ? -t : t;\n"
+    "    return normalize(v);\n"
+    "}\n\n"
+
     "void main() {\n"
-    "    Normal = mat3(transpose(inverse(model))) * aNormal;\n"
-    "    gl_Position = projection * view * model * vec4(aPos, 1.0);\n"
+    "    vec3 position = positionOffset + aPos * positionScale;\n"
+    "    Normal = mat3(transpose(inverse(model))) * decodeNormal(aNormal);\n"
+    "    gl_Position = projection * view * model * vec4(position, 1.0);\n"
     "}\n";
 
 static const char* vertexTexShader =
@@ -26,14 +40,28 @@ static const char* vertexTexShader =
     "uniform mat4 model;\n"
     "uniform mat4 view;\n"
     "uniform mat4 projection;\n\n"
+    "// compact vertices, quantized positions and octahedral normals\n"
+    "uniform vec3 positionOffset;\n"
+    "uniform vec3 positionScale;\n"
+    "uniform bool octNormal;\n\n"
 
     "out vec3 Normal;\n"
     "out vec2 TexCoords;\n\n"
 
+    "vec3 decodeNormal(vec3 n) {\n"
+    "    if (!octNormal) return n;\n"
+    "    vec3 v = vec3(n.xy, 1.0 - abs(n.x) - abs(n.y));\n"
+    "    float t = max(-v.z, 0.0);\n"
+    "    v.x += v.x >= 0.0 ? -t : t;\n"
+    "    v.y += v.y >= 0.0 ? -t : t;\n"
+    "    return normalize(v);\n"
+    "}\n\n"
+
     "void main() {\n"
-    "    gl_Position = projection * view * model * vec4(aPos, 1.0);\n"
+    "    vec3 position = positionOffset + aPos * positionScale;\n"
+    "    gl_Position = projection * view * model * vec4(position, 1.0);\n"
     "    TexCoords = aTexCoords;\n"
-    "    Normal = aNormal;\n"
+    "    Normal = decodeNormal(aNormal);\n"
     "}\n";
 
 static const char* fragmentShader =
@@ -43,6 +71,9 @@ static const char* fragmentShader =
 
     "out vec4 FragColor;\n\n"
 
+    "// false for the point clouds without estimated normals\n"
+    "uniform bool shading;\n\n"
+
     "vec3 fragmentShader(vec3 n, vec3 l) {\n"
     "    float cos_theta = dot(normalize(n), normalize(l));\n"
     "    return vec3(cos_theta);\n"
@@ -57,6 +88,10 @@ static const char* fragmentShader =
 
 
     "void main() {\n"
+    "    if (!shading) {\n"
+    "        FragColor = vec4(0.85, 0.85, 0.85, 1.0);\n"
+    "        return;\n"
+    "    }\n"
     "    vec3 lightDir = normalize(vec3(0.0, 0.0, 1.0));\n"
     "    vec3 color = fragmentShader(Normal, lightDir);\n"
     "    // vec3 color = toonShading(Normal, lightDir, 2.0);\n"
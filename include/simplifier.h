@@ -0,0 +1,126 @@
+#ifndef SIMPLIFIER_H
+#define SIMPLIFIER_H
+
+#include <array>
+#include <queue>
+#include <vector>
+
+#include "mesh.h"
+
+/**
+ * @brief A simplified version of a mesh, with the geometric error it introduces.
+ */
+struct LevelOfDetail
+{
+    Mesh mesh;
+    float error;
+};
+
+/**
+ * @brief The Simplifier class, quadric error metric edge-collapse simplification.
+ * Boundary edges are found with the faces adjacency of the mesh and constrained by perpendicular planes.
+ */
+class Simplifier
+{
+public:
+    /**
+     * @brief Prepare the simplification of a mesh, the quadrics are accumulated on several threads.
+     * @param mesh : The mesh to simplify, it must have been sewed.
+     */
+    explicit Simplifier(const Mesh &mesh);
+
+    /**
+     * @brief Collapse the cheapest edges until the number of faces is reached.
+     * @param targetFaces : The wanted number of faces.
+     * @return The simplified mesh.
+     */
+    Mesh simplify(std::size_t targetFaces);
+
+    /**
+     * @brief Get the error of the last simplification.
+     * @return The largest distance between a collapsed vertex and its planes.
+     */
+    float getError() const;
+
+    /**
+     * @brief Build a chain of simplified meshes, each level is simplified from the previous one.
+     * @param mesh : The full detail mesh.
+     * @param ratios : The decreasing ratios of faces kept by each level, relative to the full mesh.
+     * @return The levels of detail, from the finest to the coarsest.
+     */
+    static std::vector<LevelOfDetail> buildLodChain(const Mesh &mesh, const std::vector<float> &ratios);
+
+    /**
+     * @brief Build a coarse proxy by merging the vertices inside each cell of a regular grid.
+     * Much faster than the edge collapses, used while the user interacts with huge meshes.
+     * @param mesh : The full detail mesh.
+     * @param resolution : The number of cells along the largest side of the bounding box.
+     * @return The proxy, its error is the diagonal of a cell.
+     */
+    static LevelOfDetail clusterVertices(const Mesh &mesh, int resolution);
+
+protected:
+
+    using Quadric = std::array<double, 10>;
+
+    struct Collapse {
+        double cost;
+        unsigned int v0;
+        unsigned int v1;
+        std::array<double, 3> target;
+    };
+
+    // heap entry, the target is evaluated again when the candidate is popped
+    struct Candidate {
+        double cost;
+        unsigned int v0;
+        unsigned int v1;
+        unsigned int version0;
+        unsigned int version1;
+
+        bool operator<(const Candidate &c) const { return cost > c.cost; }
+    };
+
+    /**
+     * @brief Compute the cost and the best position of an edge collapse.
+     * @param v0 : The kept vertex.
+     * @param v1 : The removed vertex.
+     * @return The collapse candidate.
+     */
+    Collapse evaluate(unsigned int v0, unsigned int v1) const;
+
+    /**
+     * @brief Push the collapse of an edge in the heap.
+     * @param v0 : The kept vertex.
+     * @param v1 : The removed vertex.
+     */
+    void push(unsigned int v0, unsigned int v1);
+
+    /**
+     * @brief Check if a collapse keeps the mesh manifold and doesn't flip any face.
+     * @param c : The tested collapse.
+     * @return True if the collapse is valid, else false.
+     */
+    bool isValid(const Collapse &c) const;
+
+    /**
+     * @brief Collapse an edge, the removed vertex faces are given to the kept vertex.
+     * @param c : The collapse.
+     */
+    void apply(const Collapse &c);
+
+    std::vector<std::array<double, 3>> positions;
+    std::vector<Vertex> attributes;
+    std::vector<std::array<unsigned int, 3>> tris;
+    std::vector<bool> faceAlive;
+    std::vector<bool> vertexAlive;
+    std::vector<unsigned int> versions;
+    std::vector<std::vector<unsigned int>> vertexFaces;
+    std::vector<Quadric> quadrics;
+    std::priority_queue<Candidate> heap;
+    std::size_t aliveFaces;
+    double maxCost;
+    bool texCoords;
+};
+
+#endif // SIMPLIFIER_H
@@ -0,0 +1,142 @@
+#ifndef SMOOTHER_H
+#define SMOOTHER_H
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mesh.h"
+
+enum class SmoothingMethod {
+    LAPLACIAN=0, // moves each vertex toward the center of its neighbors, the mesh shrinks
+    TAUBIN=1     // a Laplacian step then an inflating one, removes the noise without shrinking
+};
+
+struct SmoothingOptions
+{
+    SmoothingMethod method = SmoothingMethod::TAUBIN;
+    int iterations = 10;
+    float lambda = 0.5f;
+    float mu = -0.53f; // second step of Taubin, a bit stronger than lambda and inflating
+    bool preserveBoundary = true;
+};
+
+/**
+ * @brief The Smoother class, Laplacian and Taubin smoothing over the one-ring of each vertex.
+ * The positions are stored by coordinate in 2 buffers, each step reads one and writes the other on all the threads.
+ */
+class Smoother
+{
+public:
+    /**
+     * @brief Build the one-ring index of a mesh, the faces don't need to be sewed.
+     * @param mesh : The mesh to smooth.
+     * @param preserveBoundary : True to keep the vertices of the boundary and of the non-manifold fans in place.
+     */
+    Smoother(const Mesh &mesh, bool preserveBoundary = true);
+
+    /**
+     * @brief Move each vertex toward the center of its neighbors.
+     * @param factor : The fraction of the way, negative to move away.
+     */
+    void step(float factor);
+
+    /**
+     * @brief Run one iteration of a method, 1 step for Laplacian and 2 for Taubin.
+     * @param options : The method and its factors.
+     */
+    void iterate(const SmoothingOptions &options);
+
+    /**
+     * @brief Run the iterations of a method.
+     * @param options : The method, its factors and the number of iterations.
+     * @param progress : If set, called after each iteration with its number from 1, returns false to stop.
+     * @return The number of iterations done.
+     */
+    int smooth(const SmoothingOptions &options, const std::function<bool(int)> &progress = nullptr);
+
+    /**
+     * @brief Get the smoothed positions.
+     * @return One position per vertex of the mesh.
+     */
+    std::vector<QVector3D> getPositions() const;
+
+    /**
+     * @brief Get the normals of the smoothed positions, summed like Mesh::computeNormals.
+     * @return One unit normal per vertex of the mesh.
+     */
+    std::vector<QVector3D> getNormals() const;
+
+    /**
+     * @brief Check if a vertex moves.
+     * @param vertex : The index of the vertex.
+     * @return False for a vertex kept in place.
+     */
+    bool isFree(unsigned int vertex) const;
+
+protected:
+    std::vector<unsigned int> ringStart; // neighbors of the vertex v in ring[ringStart[v], ringStart[v + 1])
+    std::vector<unsigned int> ring;
+    std::vector<float> weight; // 1 for a free vertex, 0 for a fixed one
+    std::vector<std::array<unsigned int, 3>> faces;
+    std::vector<unsigned int> faceStart; // faces of the vertex v in faceList[faceStart[v], faceStart[v + 1]), in increasing order
+    std::vector<unsigned int> faceList;
+    std::array<std::vector<float>, 3> positions;
+    std::array<std::vector<float>, 3> next;
+};
+
+/**
+ * @brief The SmoothingJob class, runs a Smoother on its own thread and publishes the positions and normals after each iteration.
+ */
+class SmoothingJob
+{
+public:
+    /**
+     * @brief Start the smoothing, the mesh is only read by the constructor.
+     * @param mesh : The mesh to smooth.
+     * @param options : The method, its factors and the number of iterations.
+     */
+    SmoothingJob(const Mesh &mesh, const SmoothingOptions &options);
+
+    /**
+     * @brief Stop the smoothing after the current iteration and wait for the thread.
+     */
+    ~SmoothingJob();
+
+    /**
+     * @brief Take the positions of the last iteration, the iterations done while nothing was taken are skipped.
+     * @param positions : Receives the positions.
+     * @param normals : Receives the normals of the positions, computed on the smoothing thread.
+     * @param iteration : Receives the number of the iteration.
+     * @return False if no iteration ended since the last call.
+     */
+    bool takePositions(std::vector<QVector3D> &positions, std::vector<QVector3D> &normals, int &iteration);
+
+    /**
+     * @brief Check if the last iteration is done, its positions can still be waiting to be taken.
+     */
+    bool isFinished() const;
+
+    int getIterations() const;
+
+protected:
+    void run();
+
+    Smoother smoother;
+    SmoothingOptions options;
+
+    // shared with the smoothing thread
+    std::mutex mutex;
+    std::vector<QVector3D> published;
+    std::vector<QVector3D> publishedNormals;
+    int publishedIteration;
+    bool taken;
+    std::atomic<bool> stopping;
+    std::atomic<bool> finished;
+    std::thread worker;
+};
+
+#endif // SMOOTHER_H
@@ -0,0 +1,67 @@
+#ifndef SPATIALSORT_H
+#define SPATIALSORT_H
+
+#include <vector>
+
+#include "vertex.h"
+
+/**
+ * @brief The SpatialOrder enum, space filling curve used to reorder a mesh.
+ */
+enum class SpatialOrder {
+    NONE=0,
+    MORTON=1,
+    HILBERT=2
+};
+
+/**
+ * @brief The SpatialSort class, sorts points along a space filling curve.
+ * The points are quantized on a 1024^3 grid over their bounding box, their 30 bits codes
+ * are then sorted by a parallel radix sort.
+ */
+class SpatialSort
+{
+public:
+    /**
+     * @brief Interleave the bits of 3 grid coordinates, x holds the most significant bit of each triple.
+     * @param x : X coordinate, 10 bits.
+     * @param y : Y coordinate, 10 bits.
+     * @param z : Z coordinate, 10 bits.
+     * @return The Morton code.
+     */
+    static unsigned int mortonCode(unsigned int x, unsigned int y, unsigned int z);
+
+    /**
+     * @brief Compute the distance along the Hilbert curve with the Skilling's transform.
+     * @param x : X coordinate, 10 bits.
+     * @param y : Y coordinate, 10 bits.
+     * @param z : Z coordinate, 10 bits.
+     * @return The Hilbert code.
+     */
+    static unsigned int hilbertCode(unsigned int x, unsigned int y, unsigned int z);
+
+    /**
+     * @brief Compute the codes of points quantized over their bounding box.
+     * @param points : The points.
+     * @param order : The curve, SpatialOrder::NONE gives the index of each point.
+     * @return The code of each point.
+     */
+    static std::vector<unsigned int> computeCodes(const std::vector<QVector3D> &points, SpatialOrder order);
+
+    /**
+     * @brief Sort indices by their keys with a stable LSD radix sort, the passes are split between threads.
+     * @param keys : The key of each index.
+     * @return The indices sorted by increasing keys.
+     */
+    static std::vector<unsigned int> sortByKey(const std::vector<unsigned int> &keys);
+
+    /**
+     * @brief Order points along a space filling curve.
+     * @param points : The points.
+     * @param order : The curve.
+     * @return The old index of each point in the new order.
+     */
+    static std::vector<unsigned int> sortPoints(const std::vector<QVector3D> &points, SpatialOrder order);
+};
+
+#endif // SPATIALSORT_H
@@ -0,0 +1,100 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Activity of a thread of the scheduler since the last reset.
+ */
+struct WorkerStatistics
+{
+    std::uint64_t tasks;  // tasks run by the thread
+    std::uint64_t steals; // tasks taken from the queue of another worker
+    float utilization;    // time spent in the tasks over the elapsed time, in [0, 1]
+};
+
+/**
+ * @brief The TaskGroup class, a set of tasks run by the scheduler and waited for together.
+ * The waiting thread runs queued tasks instead of sleeping, so groups can be nested in tasks
+ * and a group waited by the Qt thread only blocks it as long as the work lasts.
+ */
+class TaskGroup
+{
+public:
+    TaskGroup();
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    /**
+     * @brief Wait for the tasks not waited yet, their exceptions are lost.
+     */
+    ~TaskGroup();
+
+    /**
+     * @brief Queue a task, it must not touch Qt objects living in another thread.
+     * @param task : The function to run, on any thread.
+     */
+    void run(std::function<void()> task);
+
+    /**
+     * @brief Wait for all the tasks of the group, and run other tasks in the meantime.
+     * The first exception thrown by a task is thrown again here.
+     */
+    void wait();
+
+private:
+    friend class TaskScheduler;
+    void finish(std::exception_ptr error);
+
+    std::atomic<std::size_t> pending;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+};
+
+/**
+ * @brief The TaskScheduler class, the pool of threads shared by all the algorithms.
+ * Each worker has its own queue : it runs its last tasks first and an idle worker steals the oldest
+ * tasks of the others. The threads outside the pool queue their tasks in a shared queue.
+ */
+class TaskScheduler
+{
+public:
+    /**
+     * @brief Change the number of threads working on the tasks, the calling thread included.
+     * It must not be called while tasks run, the statistics are reset.
+     * @param count : Number of threads, 0 for the number of hardware threads.
+     * The default comes from the MESHVIEWER_THREADS environment variable, else the hardware.
+     */
+    static void setThreadCount(unsigned int count);
+
+    /**
+     * @brief Get the number of threads working on the tasks, the pool and the calling thread.
+     * @return At least 1.
+     */
+    static unsigned int getThreadCount();
+
+    /**
+     * @brief Get the activity of each thread since the last reset.
+     * @return The threads outside the pool first, then one entry per worker.
+     */
+    static std::vector<WorkerStatistics> getStatistics();
+
+    /**
+     * @brief Set the counters of all the threads to zero and restart the utilization clock.
+     */
+    static void resetStatistics();
+
+private:
+    friend class TaskGroup;
+    class Pool;
+    static Pool &pool();
+    static void submit(TaskGroup *group, std::function<void()> task);
+    static void waitFor(TaskGroup *group);
+};
+
+#endif // TASKSCHEDULER_H
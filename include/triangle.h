@@ -13,6 +13,9 @@ struct Triangle
     int localIndex(unsigned int indice) const;
     std::pair<int, int> findCommonEdge(const Triangle &t) const;
 
+    // idFaces value of an edge without neighbor
+    static constexpr unsigned int NO_NEIGHBOR = static_cast<unsigned int>(-1);
+
     std::array<unsigned int, 3> idVertices;
     std::vector<unsigned int> idFaces;
 };
@@ -0,0 +1,96 @@
+#ifndef VERTEXCOMPRESSION_H
+#define VERTEXCOMPRESSION_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "vertex.h"
+
+/**
+ * @brief A vertex of the compact GPU stream, 16 bytes instead of the 32 bytes of Vertex.
+ */
+struct PackedVertex
+{
+    std::array<std::uint16_t, 4> position; // quantized x, y, z and padding
+    std::array<std::int16_t, 2> normal; // octahedral encoding, signed normalized
+    std::array<std::uint16_t, 2> texCoords; // half floats
+};
+
+/**
+ * @brief Mapping of the quantized positions to the mesh space, position = offset + q * scale.
+ */
+struct Quantization
+{
+    QVector3D offset;
+    QVector3D scale;
+};
+
+/**
+ * @brief The VertexCompression class, encodes vertices for the compact GPU stream.
+ * The decoding functions do the same math than the vertex shaders.
+ */
+class VertexCompression
+{
+public:
+    /**
+     * @brief Compute the quantization of the positions over their bounding box.
+     * @param vertices : The vertices.
+     * @return The offset and the scale, the rounding error is at most half of the scale on each axis.
+     */
+    static Quantization computeQuantization(const std::vector<Vertex> &vertices);
+
+    /**
+     * @brief Encode a vertex.
+     * @param v : The vertex.
+     * @param quantization : The quantization of the positions.
+     * @return The packed vertex.
+     */
+    static PackedVertex pack(const Vertex &v, const Quantization &quantization);
+
+    /**
+     * @brief Decode a packed vertex.
+     * @param p : The packed vertex.
+     * @param quantization : The quantization used by pack().
+     * @return The vertex.
+     */
+    static Vertex unpack(const PackedVertex &p, const Quantization &quantization);
+
+    /**
+     * @brief Encode all the vertices of a mesh.
+     * @param vertices : The vertices.
+     * @param quantization : The quantization of the positions.
+     * @return The packed vertices.
+     */
+    static std::vector<PackedVertex> packVertices(const std::vector<Vertex> &vertices, const Quantization &quantization);
+
+    /**
+     * @brief Project a unit vector on the octahedron and unfold it on a square.
+     * @param n : The unit vector.
+     * @return The coordinates on the square, as signed normalized 16 bits.
+     */
+    static std::array<std::int16_t, 2> encodeOctahedral(const QVector3D &n);
+
+    /**
+     * @brief Decode a vector unfolded on the square.
+     * @param e : The coordinates on the square, as signed normalized 16 bits.
+     * @return The unit vector.
+     */
+    static QVector3D decodeOctahedral(const std::array<std::int16_t, 2> &e);
+
+    /**
+     * @brief Convert a float to a half float, rounded to the nearest even.
+     * @param f : The float.
+     * @return The bits of the half float.
+     */
+    static std::uint16_t floatToHalf(float f);
+
+    /**
+     * @brief Convert a half float to a float.
+     * @param h : The bits of the half float.
+     * @return The float.
+     */
+    static float halfToFloat(std::uint16_t h);
+};
+
+#endif // VERTEXCOMPRESSION_H
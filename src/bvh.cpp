@@ -0,0 +1,390 @@
+#include "bvh.h"
+#include "parallel.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const int BINS = 16;
+const int MAX_DEPTH = 60;
+const unsigned int PARALLEL_MIN_TRIANGLES = 65536;
+
+struct Bin {
+    float boundsMin[3] = { 1e30f, 1e30f, 1e30f };
+    float boundsMax[3] = { -1e30f, -1e30f, -1e30f };
+    unsigned int count = 0;
+
+    void grow(const QVector3D &bmin, const QVector3D &bmax) {
+        for (int a = 0; a < 3; a++) {
+            boundsMin[a] = std::min(boundsMin[a], bmin[a]);
+            boundsMax[a] = std::max(boundsMax[a], bmax[a]);
+        }
+    }
+
+    void merge(const Bin &b) {
+        for (int a = 0; a < 3; a++) {
+            boundsMin[a] = std::min(boundsMin[a], b.boundsMin[a]);
+            boundsMax[a] = std::max(boundsMax[a], b.boundsMax[a]);
+        }
+        count += b.count;
+    }
+
+    float area() const {
+        float ex = boundsMax[0] - boundsMin[0];
+        float ey = boundsMax[1] - boundsMin[1];
+        float ez = boundsMax[2] - boundsMin[2];
+        if (ex < 0.0f) return 0.0f;
+        return ex * ey + ey * ez + ez * ex;
+    }
+};
+
+float nodeArea(const BVHNode &node) {
+    float ex = node.boundsMax[0] - node.boundsMin[0];
+    float ey = node.boundsMax[1] - node.boundsMin[1];
+    float ez = node.boundsMax[2] - node.boundsMin[2];
+    return ex * ey + ey * ez + ez * ex;
+}
+
+float intersectAABB(const Ray &ray, const float invDir[3], const BVHNode &node, float tMax) {
+    float tx1 = (node.boundsMin[0] - ray.origin.x()) * invDir[0];
+    float tx2 = (node.boundsMax[0] - ray.origin.x()) * invDir[0];
+    float tmin = std::min(tx1, tx2), tmax = std::max(tx1, tx2);
+    float ty1 = (node.boundsMin[1] - ray.origin.y()) * invDir[1];
+    float ty2 = (node.boundsMax[1] - ray.origin.y()) * invDir[1];
+    tmin = std::max(tmin, std::min(ty1, ty2)); tmax = std::min(tmax, std::max(ty1, ty2));
+    float tz1 = (node.boundsMin[2] - ray.origin.z()) * invDir[2];
+    float tz2 = (node.boundsMax[2] - ray.origin.z()) * invDir[2];
+    tmin = std::max(tmin, std::min(tz1, tz2)); tmax = std::min(tmax, std::max(tz1, tz2));
+
+    if (tmax >= tmin && tmin < tMax && tmax > 0.0f) return tmin;
+    return 1e30f;
+}
+
+} // namespace
+
+Ray::Ray() : origin(0.0f, 0.0f, 0.0f), direction(0.0f, 0.0f, -1.0f), tMax(1e30f) {}
+
+Ray::Ray(const QVector3D &o, const QVector3D &d, float maxDistance) : origin(o), direction(d), tMax(maxDistance) {}
+
+RayHit::RayHit() : face(-1), t(1e30f), u(0.0f), v(0.0f) {}
+
+BVH::BVH() : parallelDepth(0) {}
+
+void BVH::clear() {
+    nodes.clear();
+    triIndices.clear();
+    centroids.clear();
+    triMin.clear();
+    triMax.clear();
+    v0x.clear(); v0y.clear(); v0z.clear();
+    e1x.clear(); e1y.clear(); e1z.clear();
+    e2x.clear(); e2y.clear(); e2z.clear();
+}
+
+bool BVH::isEmpty() const {
+    return nodes.empty();
+}
+
+const std::vector<BVHNode> &BVH::getNodes() const {
+    return nodes;
+}
+
+std::size_t BVH::faceCount() const {
+    return triIndices.size();
+}
+
+void BVH::build(const std::vector<Vertex> &vertices, const std::vector<Triangle> &faces) {
+    ScopedTimer timer("BVH::build");
+    clear();
+    if (faces.empty()) return;
+
+    unsigned int n = faces.size();
+    triIndices.resize(n);
+    centroids.resize(n);
+    triMin.resize(n);
+    triMax.resize(n);
+
+    parallelFor(0, n, 4096, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            const QVector3D &a = vertices[faces[i].idVertices[0]].position;
+            const QVector3D &b = vertices[faces[i].idVertices[1]].position;
+            const QVector3D &c = vertices[faces[i].idVertices[2]].position;
+            triIndices[i] = i;
+            centroids[i] = (a + b + c) / 3.0f;
+            triMin[i] = QVector3D(std::min({a.x(), b.x(), c.x()}), std::min({a.y(), b.y(), c.y()}), std::min({a.z(), b.z(), c.z()}));
+            triMax[i] = QVector3D(std::max({a.x(), b.x(), c.x()}), std::max({a.y(), b.y(), c.y()}), std::max({a.z(), b.z(), c.z()}));
+        }
+    });
+
+    // the root is alone in the first cache line, siblings are then allocated by pairs
+    nodes.resize(2 * std::size_t(n) + 1);
+    nodes[0].leftFirst = 0;
+    nodes[0].count = n;
+    std::atomic<unsigned int> nodesUsed(2);
+
+    parallelDepth = 1;
+    while ((1u << parallelDepth) < parallelThreadCount() * 2) parallelDepth++;
+
+    updateNodeBounds(0);
+    subdivide(0, 0, nodesUsed);
+
+    nodes.resize(nodesUsed.load());
+    nodes.shrink_to_fit();
+
+    centroids.clear(); centroids.shrink_to_fit();
+    triMin.clear(); triMin.shrink_to_fit();
+    triMax.clear(); triMax.shrink_to_fit();
+
+    for (auto *soa : { &v0x, &v0y, &v0z, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z }) soa->resize(n);
+
+    parallelFor(0, n, 4096, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            const Triangle &f = faces[triIndices[i]];
+            const QVector3D &a = vertices[f.idVertices[0]].position;
+            QVector3D e1 = vertices[f.idVertices[1]].position - a;
+            QVector3D e2 = vertices[f.idVertices[2]].position - a;
+            v0x[i] = a.x(); v0y[i] = a.y(); v0z[i] = a.z();
+            e1x[i] = e1.x(); e1y[i] = e1.y(); e1z[i] = e1.z();
+            e2x[i] = e2.x(); e2y[i] = e2.y(); e2z[i] = e2.z();
+        }
+    });
+}
+
+void BVH::updateNodeBounds(unsigned int nodeIndex) {
+    BVHNode &node = nodes[nodeIndex];
+
+    auto boundsOf = [&](std::size_t first, std::size_t last) {
+        Bin b;
+        for (std::size_t i = first; i < last; i++) {
+            b.grow(triMin[triIndices[i]], triMax[triIndices[i]]);
+        }
+        return b;
+    };
+
+    Bin bounds;
+    std::size_t first = node.leftFirst, last = node.leftFirst + node.count;
+    if (node.count < PARALLEL_MIN_TRIANGLES) {
+        bounds = boundsOf(first, last);
+    } else {
+        std::vector<Bin> partial(parallelThreadCount());
+        std::size_t blockSize = (node.count + partial.size() - 1) / partial.size();
+        parallelFor(0, partial.size(), 1, [&](std::size_t b0, std::size_t b1) {
+            for (std::size_t b = b0; b < b1; b++) {
+                partial[b] = boundsOf(std::min(last, first + b * blockSize), std::min(last, first + (b + 1) * blockSize));
+            }
+        });
+        for (auto &p : partial) bounds.merge(p);
+    }
+
+    for (int a = 0; a < 3; a++) {
+        node.boundsMin[a] = bounds.boundsMin[a];
+        node.boundsMax[a] = bounds.boundsMax[a];
+    }
+}
+
+float BVH::findBestSplit(const BVHNode &node, int &axis, float &splitPos) const {
+    std::size_t first = node.leftFirst, last = node.leftFirst + node.count;
+    std::size_t blocks = node.count < PARALLEL_MIN_TRIANGLES ? 1 : parallelThreadCount();
+    std::size_t blockSize = (node.count + blocks - 1) / blocks;
+
+    // bounds of the centroids, the bins are spread over them
+    std::vector<Bin> centroidBounds(blocks);
+    parallelFor(0, blocks, 1, [&](std::size_t b0, std::size_t b1) {
+        for (std::size_t b = b0; b < b1; b++) {
+            std::size_t end = std::min(last, first + (b + 1) * blockSize);
+            for (std::size_t i = first + b * blockSize; i < end; i++) {
+                const QVector3D &c = centroids[triIndices[i]];
+                centroidBounds[b].grow(c, c);
+            }
+        }
+    });
+    for (std::size_t b = 1; b < blocks; b++) centroidBounds[0].merge(centroidBounds[b]);
+    const Bin &cb = centroidBounds[0];
+
+    std::vector<std::array<std::array<Bin, BINS>, 3>> bins(blocks);
+    parallelFor(0, blocks, 1, [&](std::size_t b0, std::size_t b1) {
+        for (std::size_t b = b0; b < b1; b++) {
+            std::size_t end = std::min(last, first + (b + 1) * blockSize);
+            for (std::size_t i = first + b * blockSize; i < end; i++) {
+                unsigned int tri = triIndices[i];
+                for (int a = 0; a < 3; a++) {
+                    float extent = cb.boundsMax[a] - cb.boundsMin[a];
+                    if (extent <= 0.0f) continue;
+                    int binIdx = std::min(BINS - 1, int((centroids[tri][a] - cb.boundsMin[a]) * BINS / extent));
+                    bins[b][a][binIdx].count++;
+                    bins[b][a][binIdx].grow(triMin[tri], triMax[tri]);
+                }
+            }
+        }
+    });
+
+    float bestCost = std::numeric_limits<float>::max();
+    for (int a = 0; a < 3; a++) {
+        float extent = cb.boundsMax[a] - cb.boundsMin[a];
+        if (extent <= 0.0f) continue;
+
+        std::array<Bin, BINS> merged;
+        for (std::size_t b = 0; b < blocks; b++) {
+            for (int i = 0; i < BINS; i++) merged[i].merge(bins[b][a][i]);
+        }
+
+        float leftArea[BINS - 1], rightArea[BINS - 1];
+        unsigned int leftCount[BINS - 1], rightCount[BINS - 1];
+        Bin leftBox, rightBox;
+        for (int i = 0; i < BINS - 1; i++) {
+            leftBox.merge(merged[i]);
+            leftCount[i] = leftBox.count;
+            leftArea[i] = leftBox.area();
+            rightBox.merge(merged[BINS - 1 - i]);
+            rightCount[BINS - 2 - i] = rightBox.count;
+            rightArea[BINS - 2 - i] = rightBox.area();
+        }
+
+        float scale = extent / BINS;
+        for (int i = 0; i < BINS - 1; i++) {
+            if (leftCount[i] == 0 || rightCount[i] == 0) continue;
+            float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+            if (cost < bestCost) {
+                bestCost = cost;
+                axis = a;
+                splitPos = cb.boundsMin[a] + scale * (i + 1);
+            }
+        }
+    }
+
+    return bestCost;
+}
+
+void BVH::subdivide(unsigned int nodeIndex, int depth, std::atomic<unsigned int> &nodesUsed) {
+    BVHNode &node = nodes[nodeIndex];
+    if (node.count <= 1 || depth >= MAX_DEPTH) return;
+
+    int axis = 0;
+    float splitPos = 0.0f;
+    float splitCost = findBestSplit(node, axis, splitPos);
+    float noSplitCost = node.count * nodeArea(node);
+    if (splitCost >= noSplitCost) return;
+
+    int i = node.leftFirst;
+    int j = i + node.count - 1;
+    while (i <= j) {
+        if (centroids[triIndices[i]][axis] < splitPos) i++;
+        else std::swap(triIndices[i], triIndices[j--]);
+    }
+
+    unsigned int leftCount = i - node.leftFirst;
+    if (leftCount == 0 || leftCount == node.count) return;
+
+    unsigned int leftChild = nodesUsed.fetch_add(2);
+    unsigned int rightChild = leftChild + 1;
+    nodes[leftChild].leftFirst = node.leftFirst;
+    nodes[leftChild].count = leftCount;
+    nodes[rightChild].leftFirst = i;
+    nodes[rightChild].count = node.count - leftCount;
+    node.leftFirst = leftChild;
+    node.count = 0;
+
+    updateNodeBounds(leftChild);
+    updateNodeBounds(rightChild);
+
+    if (depth < parallelDepth && nodes[leftChild].count + nodes[rightChild].count >= 4096) {
+        parallelInvoke([&]() { subdivide(leftChild, depth + 1, nodesUsed); },
+                       [&]() { subdivide(rightChild, depth + 1, nodesUsed); });
+    } else {
+        subdivide(leftChild, depth + 1, nodesUsed);
+        subdivide(rightChild, depth + 1, nodesUsed);
+    }
+}
+
+void BVH::intersectLeaf(const BVHNode &node, const Ray &ray, RayHit &hit) const {
+    const float ox = ray.origin.x(), oy = ray.origin.y(), oz = ray.origin.z();
+    const float dx = ray.direction.x(), dy = ray.direction.y(), dz = ray.direction.z();
+    const float epsilon = 1e-8f;
+
+    unsigned int first = node.leftFirst, last = node.leftFirst + node.count;
+    for (unsigned int i = first; i < last; i++) {
+        // Möller-Trumbore, written without early exits so the loop can be vectorized
+        float px = dy * e2z[i] - dz * e2y[i];
+        float py = dz * e2x[i] - dx * e2z[i];
+        float pz = dx * e2y[i] - dy * e2x[i];
+        float det = e1x[i] * px + e1y[i] * py + e1z[i] * pz;
+        float invDet = 1.0f / det;
+
+        float tx = ox - v0x[i], ty = oy - v0y[i], tz = oz - v0z[i];
+        float u = (tx * px + ty * py + tz * pz) * invDet;
+
+        float qx = ty * e1z[i] - tz * e1y[i];
+        float qy = tz * e1x[i] - tx * e1z[i];
+        float qz = tx * e1y[i] - ty * e1x[i];
+        float v = (dx * qx + dy * qy + dz * qz) * invDet;
+        float t = (e2x[i] * qx + e2y[i] * qy + e2z[i] * qz) * invDet;
+
+        bool valid = std::fabs(det) > epsilon && u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > epsilon && t < hit.t;
+        if (valid) {
+            hit.t = t;
+            hit.u = u;
+            hit.v = v;
+            hit.face = triIndices[i];
+        }
+    }
+}
+
+bool BVH::intersect(const Ray &ray, RayHit &hit) const {
+    if (nodes.empty()) return false;
+
+    float invDir[3] = { 1.0f / ray.direction.x(), 1.0f / ray.direction.y(), 1.0f / ray.direction.z() };
+    float startT = std::min(hit.t, ray.tMax);
+    hit.t = startT;
+
+    unsigned int stack[64];
+    int stackPtr = 0;
+    const BVHNode *node = &nodes[0];
+    if (intersectAABB(ray, invDir, *node, hit.t) == 1e30f) return false;
+
+    while (true) {
+        if (node->isLeaf()) {
+            intersectLeaf(*node, ray, hit);
+            if (stackPtr == 0) break;
+            node = &nodes[stack[--stackPtr]];
+            continue;
+        }
+
+        unsigned int child1 = node->leftFirst;
+        unsigned int child2 = node->leftFirst + 1;
+        float dist1 = intersectAABB(ray, invDir, nodes[child1], hit.t);
+        float dist2 = intersectAABB(ray, invDir, nodes[child2], hit.t);
+        if (dist1 > dist2) {
+            std::swap(dist1, dist2);
+            std::swap(child1, child2);
+        }
+
+        if (dist1 == 1e30f) {
+            if (stackPtr == 0) break;
+            node = &nodes[stack[--stackPtr]];
+        } else {
+            node = &nodes[child1];
+            if (dist2 != 1e30f) stack[stackPtr++] = child2;
+        }
+    }
+
+    return hit.t < startT;
+}
+
+std::size_t BVH::intersect(const std::vector<Ray> &rays, std::vector<RayHit> &hits) const {
+    hits.assign(rays.size(), RayHit());
+    std::atomic<std::size_t> hitCount(0);
+
+    parallelFor(0, rays.size(), 256, [&](std::size_t first, std::size_t last) {
+        std::size_t localCount = 0;
+        for (std::size_t i = first; i < last; i++) {
+            if (intersect(rays[i], hits[i])) localCount++;
+        }
+        hitCount += localCount;
+    });
+
+    return hitCount.load();
+}
@@ -0,0 +1,533 @@
+#include "chunkFile.h"
+#include "mesh.h"
+#include "chunks.h"
+#include "spatialSort.h"
+#include "indexOptimizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+const char CHUNK_MAGIC[8] = { 'M', 'V', 'C', 'H', 'U', 'N', 'K', 'S' };
+const std::uint32_t CHUNK_VERSION = 1;
+const std::uint64_t PAGE_SIZE = 4096;
+// 4096 buckets, the 4 first levels of the octree of the Morton codes
+const unsigned int BUCKET_BITS = 12;
+const unsigned int NODE_FANOUT = 8;
+// the indices of a chunk are stored on 16 bits
+const unsigned int MAX_CHUNK_FACES = 65536 / 3;
+// consecutive buckets are split together up to this many chunks, so small buckets don't make small chunks
+const std::uint64_t BATCH_CHUNKS = 64;
+
+std::uint64_t alignToPage(std::uint64_t offset) {
+    return (offset + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+}
+
+void writeVector(float *dst, const QVector3D &v) {
+    dst[0] = v.x();
+    dst[1] = v.y();
+    dst[2] = v.z();
+}
+
+/**
+ * @brief Split a range of faces sorted on the high bits of their Morton code until each part can be loaded.
+ * A part too large is sorted in place on the next bits of the code, a part where all the faces have
+ * the same code, a dense point or a flat box, is cut in slices.
+ * @param sorted : The faces, 3 vertex ids each.
+ * @param begin : The first face of the range.
+ * @param end : The end of the range.
+ * @param shift : The low bits of the code not sorted yet.
+ * @param limit : The maximum number of faces of a part.
+ * @param codeOf : The Morton code of a face.
+ * @param bounds : The ends of the parts, appended in order.
+ */
+template <typename CodeOf>
+void splitRange(std::uint32_t *sorted, std::uint64_t begin, std::uint64_t end, unsigned int shift, std::uint64_t limit,
+                const CodeOf &codeOf, std::vector<std::uint64_t> &bounds) {
+    if (end - begin <= limit) {
+        bounds.push_back(end);
+        return;
+    }
+    if (shift == 0) {
+        for (std::uint64_t slice = begin + limit; slice < end; slice += limit) bounds.push_back(slice);
+        bounds.push_back(end);
+        return;
+    }
+
+    unsigned int bits = std::min(BUCKET_BITS, shift);
+    shift -= bits;
+    auto digitOf = [&](std::uint64_t f) { return (codeOf(sorted + 3 * f) >> shift) & ((1u << bits) - 1); };
+    std::vector<std::uint64_t> start((1u << bits) + 1, 0);
+    for (std::uint64_t f = begin; f < end; f++) start[digitOf(f) + 1]++;
+    start[0] = begin;
+    for (std::size_t d = 1; d < start.size(); d++) start[d] += start[d - 1];
+
+    // an in place radix pass, each face is swapped to the next free place of its digit
+    std::vector<std::uint64_t> next(start.begin(), start.end() - 1);
+    for (std::size_t d = 0; d < next.size(); d++) {
+        while (next[d] < start[d + 1]) {
+            unsigned int digit = digitOf(next[d]);
+            if (digit == d) next[d]++;
+            else std::swap_ranges(sorted + 3 * next[d], sorted + 3 * next[d] + 3, sorted + 3 * next[digit]++);
+        }
+    }
+    for (std::size_t d = 0; d < next.size(); d++) splitRange(sorted, start[d], start[d + 1], shift, limit, codeOf, bounds);
+}
+
+/**
+ * @brief Stream the positions and the triangulated faces of a .off or .obj file to binary files.
+ * @return MeshError::OK if the function terminates correctly, other else.
+ */
+int streamMesh(const char *input, std::ofstream &vertexOut, std::ofstream &faceOut,
+               std::uint64_t &vertexCount, std::uint64_t &faceCount, QVector3D &min, QVector3D &max) {
+    std::string filename(input);
+    std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
+    bool off = filename.size() >= 4 && filename.substr(filename.size() - 4) == ".off";
+    bool obj = filename.size() >= 4 && filename.substr(filename.size() - 4) == ".obj";
+    if (!off && !obj) return MeshError::FORMAT;
+
+    std::ifstream meshFile(input);
+    if (!meshFile.is_open()) return MeshError::READ;
+
+    auto addVertex = [&](float x, float y, float z) {
+        float p[3] = { x, y, z };
+        vertexOut.write(reinterpret_cast<const char*>(p), sizeof(p));
+        min = QVector3D(std::min(min.x(), x), std::min(min.y(), y), std::min(min.z(), z));
+        max = QVector3D(std::max(max.x(), x), std::max(max.y(), y), std::max(max.z(), z));
+        vertexCount++;
+    };
+    auto addPolygon = [&](const std::vector<std::uint32_t> &ids) {
+        for (std::size_t j = 1; j + 1 < ids.size(); ++j) {
+            std::uint32_t f[3] = { ids[0], ids[j], ids[j + 1] };
+            faceOut.write(reinterpret_cast<const char*>(f), sizeof(f));
+            faceCount++;
+        }
+    };
+
+    std::vector<std::uint32_t> ids;
+    if (off) {
+        auto nextToken = [&](std::string &token) {
+            while (meshFile >> token) {
+                if (token[0] == '#') {
+                    std::string line;
+                    std::getline(meshFile, line);
+                    continue;
+                }
+                return true;
+            }
+            return false;
+        };
+
+        std::string token;
+        if (!nextToken(token) || token != "OFF") return MeshError::FORMAT;
+        std::uint64_t numVertices, numFaces;
+        if (!nextToken(token)) return MeshError::READ;
+        numVertices = std::stoull(token);
+        if (!nextToken(token)) return MeshError::READ;
+        numFaces = std::stoull(token);
+        if (!nextToken(token)) return MeshError::READ;
+
+        for (std::uint64_t i = 0; i < numVertices; ++i) {
+            float x, y, z;
+            if (!(meshFile >> x >> y >> z)) return MeshError::READ;
+            addVertex(x, y, z);
+        }
+        for (std::uint64_t i = 0; i < numFaces; ++i) {
+            int nVerts;
+            if (!(meshFile >> nVerts) || nVerts < 0) return MeshError::READ;
+            ids.resize(nVerts);
+            for (int j = 0; j < nVerts; ++j) {
+                if (!(meshFile >> ids[j])) return MeshError::READ;
+            }
+            addPolygon(ids);
+        }
+    } else {
+        std::string line;
+        while (std::getline(meshFile, line)) {
+            if (line.size() < 2 || line[0] == '#') continue;
+            std::istringstream iss(line);
+            std::string prefix;
+            iss >> prefix;
+
+            if (prefix == "v") {
+                float x, y, z;
+                if (!(iss >> x >> y >> z)) return MeshError::READ;
+                addVertex(x, y, z);
+            } else if (prefix == "f") {
+                // only the position index is kept, "v", "v/t", "v//n" or "v/t/n"
+                ids.clear();
+                std::string token;
+                while (iss >> token) {
+                    unsigned long id = std::strtoul(token.c_str(), nullptr, 10);
+                    if (id == 0) return MeshError::FORMAT;
+                    ids.push_back(std::uint32_t(id - 1));
+                }
+                addPolygon(ids);
+            }
+        }
+    }
+
+    return vertexOut.good() && faceOut.good() ? MeshError::OK : MeshError::SAVE;
+}
+
+}
+
+ChunkFile::ChunkFile() : data(nullptr) {
+    std::memset(&header, 0, sizeof(header));
+}
+
+ChunkFile::~ChunkFile() {
+    close();
+}
+
+int ChunkFile::build(const char *input, const char *output, unsigned int maxChunkFaces) {
+    QString base(output);
+    QString verticesPath = base + ".vertices.tmp", facesPath = base + ".faces.tmp";
+    QString normalsPath = base + ".normals.tmp", sortedPath = base + ".sorted.tmp";
+    QFile verticesFile(verticesPath), facesFile(facesPath), normalsFile(normalsPath), sortedFile(sortedPath);
+    auto removeTemporaries = [&]() {
+        verticesFile.close();
+        facesFile.close();
+        normalsFile.close();
+        sortedFile.close();
+        QFile::remove(verticesPath);
+        QFile::remove(facesPath);
+        QFile::remove(normalsPath);
+        QFile::remove(sortedPath);
+    };
+
+    maxChunkFaces = std::clamp(maxChunkFaces, 1u, MAX_CHUNK_FACES);
+
+    // streamed to the disk, the mesh never has to fit in memory
+    std::uint64_t vertexCount = 0, faceCount = 0;
+    float inf = std::numeric_limits<float>::max();
+    QVector3D min(inf, inf, inf), max(-inf, -inf, -inf);
+    {
+        std::ofstream vertexOut(verticesPath.toStdString(), std::ios::binary);
+        std::ofstream faceOut(facesPath.toStdString(), std::ios::binary);
+        if (!vertexOut.is_open() || !faceOut.is_open()) {
+            removeTemporaries();
+            return MeshError::SAVE;
+        }
+        int ok = streamMesh(input, vertexOut, faceOut, vertexCount, faceCount, min, max);
+        if (ok != MeshError::OK || faceCount == 0) {
+            removeTemporaries();
+            return ok != MeshError::OK ? ok : MeshError::FORMAT;
+        }
+    }
+
+    if (!verticesFile.open(QIODevice::ReadOnly) || !facesFile.open(QIODevice::ReadOnly) ||
+        !normalsFile.open(QIODevice::ReadWrite | QIODevice::Truncate) || !sortedFile.open(QIODevice::ReadWrite | QIODevice::Truncate) ||
+        !normalsFile.resize(vertexCount * 3 * sizeof(float)) || !sortedFile.resize(faceCount * 3 * sizeof(std::uint32_t))) {
+        removeTemporaries();
+        return MeshError::SAVE;
+    }
+
+    const float *positions = reinterpret_cast<const float*>(verticesFile.map(0, verticesFile.size()));
+    const std::uint32_t *faces = reinterpret_cast<const std::uint32_t*>(facesFile.map(0, facesFile.size()));
+    float *normals = reinterpret_cast<float*>(normalsFile.map(0, normalsFile.size()));
+    std::uint32_t *sorted = reinterpret_cast<std::uint32_t*>(sortedFile.map(0, sortedFile.size()));
+    if (!positions || !faces || !normals || !sorted) {
+        removeTemporaries();
+        return MeshError::SAVE;
+    }
+
+    auto position = [&](std::uint32_t v) { return QVector3D(positions[3 * v], positions[3 * v + 1], positions[3 * v + 2]); };
+
+    // vertex normals accumulated over the whole mesh, so the chunks have no seams
+    for (std::uint64_t f = 0; f < faceCount; f++) {
+        const std::uint32_t *v = faces + 3 * f;
+        if (v[0] >= vertexCount || v[1] >= vertexCount || v[2] >= vertexCount) {
+            removeTemporaries();
+            return MeshError::FORMAT;
+        }
+        QVector3D normal = QVector3D::crossProduct(position(v[1]) - position(v[0]), position(v[2]) - position(v[0]));
+        for (int k = 0; k < 3; k++) {
+            for (int axis = 0; axis < 3; axis++) normals[3 * v[k] + axis] += normal[axis];
+        }
+    }
+
+    // faces bucketed by the Morton code of their centroid, a counting sort through the mapped file
+    QVector3D extent = max - min;
+    float size = std::max({ extent.x(), extent.y(), extent.z() });
+    float scale = size > 0.0f ? 1023.0f / size : 0.0f;
+    auto codeOf = [&](const std::uint32_t *v) {
+        QVector3D q = ((position(v[0]) + position(v[1]) + position(v[2])) / 3.0f - min) * scale;
+        auto cell = [](float c) { return std::min<unsigned int>(std::max(c, 0.0f), 1023); };
+        return SpatialSort::mortonCode(cell(q.x()), cell(q.y()), cell(q.z()));
+    };
+    auto bucketOf = [&](std::uint64_t f) { return codeOf(faces + 3 * f) >> (30 - BUCKET_BITS); };
+
+    std::vector<std::uint64_t> bucketStart((1u << BUCKET_BITS) + 1, 0);
+    for (std::uint64_t f = 0; f < faceCount; f++) bucketStart[bucketOf(f) + 1]++;
+    for (std::size_t b = 1; b < bucketStart.size(); b++) bucketStart[b] += bucketStart[b - 1];
+    std::vector<std::uint64_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+    for (std::uint64_t f = 0; f < faceCount; f++) {
+        std::memcpy(sorted + 3 * fill[bucketOf(f)]++, faces + 3 * f, 3 * sizeof(std::uint32_t));
+    }
+
+    // the buckets too large to be loaded are split on the next bits, the parts stay in the Morton order
+    std::uint64_t batchFaces = BATCH_CHUNKS * maxChunkFaces;
+    std::vector<std::uint64_t> partStart = { 0 };
+    for (std::size_t b = 0; b + 1 < bucketStart.size(); b++) {
+        splitRange(sorted, bucketStart[b], bucketStart[b + 1], 30 - BUCKET_BITS, batchFaces, codeOf, partStart);
+    }
+
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        removeTemporaries();
+        return MeshError::SAVE;
+    }
+
+    ChunkFileHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, CHUNK_MAGIC, sizeof(h.magic));
+    h.version = CHUNK_VERSION;
+    h.vertexCount = vertexCount;
+    h.faceCount = faceCount;
+    writeVector(h.boundsMin, min);
+    writeVector(h.boundsMax, max);
+    Quantization quantization = VertexCompression::computeQuantization({ Vertex(min), Vertex(max) });
+    writeVector(h.quantizationOffset, quantization.offset);
+    writeVector(h.quantizationScale, quantization.scale);
+
+    // the first page is kept for the header, written once the tables are known
+    std::vector<char> zeros(PAGE_SIZE, 0);
+    out.write(zeros.data(), PAGE_SIZE);
+    std::uint64_t offset = PAGE_SIZE;
+
+    std::vector<ChunkRecord> records;
+    std::vector<int> chunkId;
+    std::size_t partCount = partStart.size() - 1;
+    for (std::size_t b = 0; b < partCount;) {
+        std::size_t last = b + 1;
+        while (last < partCount && partStart[last + 1] - partStart[b] <= batchFaces) last++;
+        std::uint64_t batchBegin = partStart[b], batchEnd = partStart[last];
+        b = last;
+        if (batchEnd == batchBegin) continue;
+
+        // a batch of parts is small enough to be loaded
+        std::unordered_map<std::uint32_t, unsigned int> local;
+        std::vector<Vertex> bucketVertices;
+        std::vector<Triangle> bucketFaces;
+        for (std::uint64_t f = batchBegin; f < batchEnd; f++) {
+            unsigned int ids[3];
+            for (int k = 0; k < 3; k++) {
+                std::uint32_t g = sorted[3 * f + k];
+                auto it = local.find(g);
+                if (it == local.end()) {
+                    it = local.emplace(g, bucketVertices.size()).first;
+                    Vertex v(position(g));
+                    v.normal = QVector3D(normals[3 * g], normals[3 * g + 1], normals[3 * g + 2]).normalized();
+                    bucketVertices.push_back(v);
+                }
+                ids[k] = it->second;
+            }
+            bucketFaces.push_back(Triangle(ids[0], ids[1], ids[2]));
+        }
+
+        std::vector<unsigned int> order;
+        auto bucketChunks = ChunkPartition::build(bucketVertices, bucketFaces, maxChunkFaces, order);
+        chunkId.assign(bucketVertices.size(), -1);
+
+        for (const Chunk &c : bucketChunks) {
+            // chunk local vertices, the faces ordered for the vertex cache then the vertices by first use
+            std::vector<unsigned int> chunkVertices, indices;
+            for (std::size_t i = c.firstIndex / 3; i < (c.firstIndex + c.indexCount) / 3; i++) {
+                for (unsigned int v : bucketFaces[order[i]].idVertices) {
+                    if (chunkId[v] < 0) {
+                        chunkId[v] = chunkVertices.size();
+                        chunkVertices.push_back(v);
+                    }
+                    indices.push_back(chunkId[v]);
+                }
+            }
+            for (unsigned int v : chunkVertices) chunkId[v] = -1;
+
+            std::vector<unsigned int> cacheOrder = IndexOptimizer::optimizeVertexCache(indices, chunkVertices.size());
+            std::vector<unsigned int> cached;
+            cached.reserve(indices.size());
+            for (unsigned int f : cacheOrder) cached.insert(cached.end(), indices.begin() + 3 * f, indices.begin() + 3 * f + 3);
+            std::vector<unsigned int> fetchOrder = IndexOptimizer::optimizeVertexFetch(cached, chunkVertices.size());
+            std::vector<unsigned int> remap(chunkVertices.size());
+            for (std::size_t i = 0; i < fetchOrder.size(); i++) remap[fetchOrder[i]] = i;
+
+            std::vector<PackedVertex> packed;
+            packed.reserve(fetchOrder.size());
+            for (unsigned int v : fetchOrder) packed.push_back(VertexCompression::pack(bucketVertices[chunkVertices[v]], quantization));
+            std::vector<std::uint16_t> shortIndices;
+            shortIndices.reserve(cached.size());
+            for (unsigned int i : cached) shortIndices.push_back(remap[i]);
+
+            ChunkRecord r;
+            r.offset = offset;
+            r.vertexCount = packed.size();
+            r.indexCount = shortIndices.size();
+            writeVector(r.boundsMin, c.boundsMin);
+            writeVector(r.boundsMax, c.boundsMax);
+            writeVector(r.center, c.center);
+            r.radius = c.radius;
+            writeVector(r.coneAxis, c.coneAxis);
+            r.coneCutoff = c.coneCutoff;
+            records.push_back(r);
+            h.maxChunkVertices = std::max(h.maxChunkVertices, r.vertexCount);
+            h.maxChunkIndices = std::max(h.maxChunkIndices, r.indexCount);
+
+            std::uint64_t bytes = packed.size() * sizeof(PackedVertex) + shortIndices.size() * sizeof(std::uint16_t);
+            out.write(reinterpret_cast<const char*>(packed.data()), packed.size() * sizeof(PackedVertex));
+            out.write(reinterpret_cast<const char*>(shortIndices.data()), shortIndices.size() * sizeof(std::uint16_t));
+            out.write(zeros.data(), alignToPage(offset + bytes) - offset - bytes);
+            offset = alignToPage(offset + bytes);
+        }
+    }
+
+    removeTemporaries();
+
+    // the chunks follow the Morton order, consecutive chunks are grouped level by level
+    std::vector<ChunkNode> hierarchy;
+    auto addNodes = [&](std::size_t count, bool leaf, std::size_t firstChild) {
+        for (std::size_t first = 0; first < count; first += NODE_FANOUT) {
+            ChunkNode node;
+            node.first = firstChild + first;
+            node.count = std::min<std::size_t>(NODE_FANOUT, count - first);
+            node.leaf = leaf ? 1 : 0;
+            node.padding = 0;
+            for (int axis = 0; axis < 3; axis++) {
+                node.boundsMin[axis] = inf;
+                node.boundsMax[axis] = -inf;
+            }
+            for (std::uint32_t i = node.first; i < node.first + node.count; i++) {
+                const float *childMin = leaf ? records[i].boundsMin : hierarchy[i].boundsMin;
+                const float *childMax = leaf ? records[i].boundsMax : hierarchy[i].boundsMax;
+                for (int axis = 0; axis < 3; axis++) {
+                    node.boundsMin[axis] = std::min(node.boundsMin[axis], childMin[axis]);
+                    node.boundsMax[axis] = std::max(node.boundsMax[axis], childMax[axis]);
+                }
+            }
+            hierarchy.push_back(node);
+        }
+    };
+    addNodes(records.size(), true, 0);
+    std::size_t levelBegin = 0;
+    while (hierarchy.size() - levelBegin > 1) {
+        std::size_t levelEnd = hierarchy.size();
+        addNodes(levelEnd - levelBegin, false, levelBegin);
+        levelBegin = levelEnd;
+    }
+
+    h.chunkCount = records.size();
+    h.nodeCount = hierarchy.size();
+    h.tableOffset = offset;
+    out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(ChunkRecord));
+    out.write(reinterpret_cast<const char*>(hierarchy.data()), hierarchy.size() * sizeof(ChunkNode));
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.close();
+
+    return out.good() ? MeshError::OK : MeshError::SAVE;
+}
+
+int ChunkFile::open(const char *link) {
+    close();
+    file.setFileName(link);
+    if (!file.open(QIODevice::ReadOnly)) return MeshError::READ;
+
+    qint64 size = file.size();
+    if (size < qint64(sizeof(ChunkFileHeader))) {
+        close();
+        return MeshError::FORMAT;
+    }
+
+    data = file.map(0, size);
+    if (!data) {
+        close();
+        return MeshError::READ;
+    }
+
+    std::memcpy(&header, data, sizeof(header));
+    std::uint64_t fileSize = size;
+    std::uint64_t tablesSize = std::uint64_t(header.chunkCount) * sizeof(ChunkRecord) + std::uint64_t(header.nodeCount) * sizeof(ChunkNode);
+    if (std::memcmp(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0 || header.version != CHUNK_VERSION ||
+        header.chunkCount == 0 || header.nodeCount == 0 || header.maxChunkVertices == 0 || header.maxChunkIndices == 0 || header.tableOffset > fileSize || tablesSize > fileSize - header.tableOffset ||
+        header.maxChunkVertices > 65536 || header.maxChunkIndices > 3 * MAX_CHUNK_FACES) {
+        close();
+        return MeshError::FORMAT;
+    }
+
+    chunks.resize(header.chunkCount);
+    nodes.resize(header.nodeCount);
+    std::memcpy(chunks.data(), data + header.tableOffset, chunks.size() * sizeof(ChunkRecord));
+    std::memcpy(nodes.data(), data + header.tableOffset + chunks.size() * sizeof(ChunkRecord), nodes.size() * sizeof(ChunkNode));
+
+    // the pages are read without checks afterwards, every record has to be inside the file, fit the slots and index its own vertices
+    for (const ChunkRecord &r : chunks) {
+        std::uint64_t bytes = std::uint64_t(r.vertexCount) * sizeof(PackedVertex) + std::uint64_t(r.indexCount) * sizeof(std::uint16_t);
+        if (r.vertexCount > header.maxChunkVertices || r.indexCount > header.maxChunkIndices || r.indexCount % 3 != 0 ||
+            r.offset > fileSize || bytes > fileSize - r.offset) {
+            close();
+            return MeshError::FORMAT;
+        }
+        const uchar *indices = data + r.offset + std::uint64_t(r.vertexCount) * sizeof(PackedVertex);
+        for (unsigned int i = 0; i < r.indexCount; i++) {
+            std::uint16_t index;
+            std::memcpy(&index, indices + i * sizeof(index), sizeof(index));
+            if (index >= r.vertexCount) {
+                close();
+                return MeshError::FORMAT;
+            }
+        }
+    }
+    // the children of a node come before it, the traversal from the root always ends
+    for (std::size_t i = 0; i < nodes.size(); i++) {
+        std::uint64_t end = std::uint64_t(nodes[i].first) + nodes[i].count;
+        if (end > (nodes[i].leaf ? chunks.size() : i)) {
+            close();
+            return MeshError::FORMAT;
+        }
+    }
+
+    return MeshError::OK;
+}
+
+void ChunkFile::close() {
+    if (data) file.unmap(const_cast<uchar*>(data));
+    data = nullptr;
+    file.close();
+    chunks.clear();
+    nodes.clear();
+    std::memset(&header, 0, sizeof(header));
+}
+
+bool ChunkFile::isOpen() const {
+    return data != nullptr;
+}
+
+const ChunkFileHeader &ChunkFile::getHeader() const {
+    return header;
+}
+
+const std::vector<ChunkRecord> &ChunkFile::getChunks() const {
+    return chunks;
+}
+
+const std::vector<ChunkNode> &ChunkFile::getNodes() const {
+    return nodes;
+}
+
+Quantization ChunkFile::getQuantization() const {
+    return { QVector3D(header.quantizationOffset[0], header.quantizationOffset[1], header.quantizationOffset[2]),
+             QVector3D(header.quantizationScale[0], header.quantizationScale[1], header.quantizationScale[2]) };
+}
+
+const PackedVertex *ChunkFile::chunkVertices(unsigned int chunk) const {
+    return reinterpret_cast<const PackedVertex*>(data + chunks[chunk].offset);
+}
+
+const std::uint16_t *ChunkFile::chunkIndices(unsigned int chunk) const {
+    return reinterpret_cast<const std::uint16_t*>(data + chunks[chunk].offset + chunks[chunk].vertexCount * sizeof(PackedVertex));
+}
@@ -0,0 +1,175 @@
+#include "chunkStreamer.h"
+
+#include <algorithm>
+
+namespace {
+
+// chunks read ahead by the loader thread, bounds the memory waiting for a slot
+const std::size_t MAX_LOADED = 64;
+
+QVector3D toVector(const float *v) {
+    return QVector3D(v[0], v[1], v[2]);
+}
+
+}
+
+ChunkStreamer::ChunkStreamer(const ChunkFile &file, std::size_t slotCount)
+    : file(file), slotCount(slotCount), frame(0), stopping(false) {
+    std::size_t chunkCount = file.getChunks().size();
+    chunkSlots.assign(chunkCount, -1);
+    lastUsed.assign(chunkCount, 0);
+    lruPosition.resize(chunkCount);
+    inFlight.assign(chunkCount, 0);
+
+    freeSlots.resize(slotCount);
+    for (std::size_t i = 0; i < slotCount; i++) freeSlots[i] = slotCount - 1 - i;
+
+    loader = std::thread(&ChunkStreamer::loaderLoop, this);
+}
+
+ChunkStreamer::~ChunkStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    loader.join();
+}
+
+std::size_t ChunkStreamer::update(const Frustum &frustum, const QVector3D &cameraPosition, std::vector<unsigned int> &visible) {
+    frame++;
+    visible.clear();
+
+    const auto &chunks = file.getChunks();
+    const auto &nodes = file.getNodes();
+    if (!nodes.empty()) {
+        std::vector<unsigned int> stack = { unsigned(nodes.size() - 1) };
+        while (!stack.empty()) {
+            const ChunkNode &node = nodes[stack.back()];
+            stack.pop_back();
+            if (!frustum.intersects(toVector(node.boundsMin), toVector(node.boundsMax))) continue;
+
+            for (unsigned int i = node.first; i < node.first + node.count; i++) {
+                if (!node.leaf) {
+                    stack.push_back(i);
+                } else if (frustum.intersects(toVector(chunks[i].boundsMin), toVector(chunks[i].boundsMax))) {
+                    visible.push_back(i);
+                }
+            }
+        }
+    }
+
+    std::vector<std::pair<float, unsigned int>> byDistance;
+    byDistance.reserve(visible.size());
+    for (unsigned int c : visible) byDistance.push_back({ (toVector(chunks[c].center) - cameraPosition).lengthSquared(), c });
+    std::sort(byDistance.begin(), byDistance.end());
+    for (std::size_t i = 0; i < visible.size(); i++) visible[i] = byDistance[i].second;
+
+    // the visible resident chunks become the most recently used, from the furthest so the nearest ends first
+    std::vector<unsigned int> missing;
+    for (auto it = visible.rbegin(); it != visible.rend(); ++it) {
+        if (chunkSlots[*it] < 0) continue;
+        lastUsed[*it] = frame;
+        lru.splice(lru.begin(), lru, lruPosition[*it]);
+    }
+    for (unsigned int c : visible) {
+        if (chunkSlots[c] < 0) missing.push_back(c);
+    }
+
+    // no more requests than slots that can be given, the rest would be evicted before being drawn
+    std::size_t resident = lru.size();
+    std::size_t residentVisible = visible.size() - missing.size();
+    std::size_t available = freeSlots.size() + (resident - residentVisible);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (unsigned int c : requests) inFlight[c] = 0;
+        requests.clear();
+        for (std::size_t i = 0; i < missing.size() && i < available; i++) {
+            if (inFlight[missing[i]]) continue;
+            inFlight[missing[i]] = 1;
+            requests.push_back(missing[i]);
+        }
+    }
+    wakeUp.notify_one();
+
+    return std::min(missing.size(), available);
+}
+
+std::vector<ChunkStreamer::LoadedChunk> ChunkStreamer::takeLoaded(std::size_t maxCount) {
+    std::vector<LoadedChunk> taken;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!loaded.empty() && taken.size() < maxCount) {
+            inFlight[loaded.front().chunk] = 0;
+            taken.push_back(std::move(loaded.front()));
+            loaded.pop_front();
+        }
+    }
+    wakeUp.notify_one();
+
+    std::vector<LoadedChunk> placed;
+    for (auto &c : taken) {
+        if (chunkSlots[c.chunk] >= 0) continue;
+
+        unsigned int slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else if (!lru.empty() && lastUsed[lru.back()] < frame) {
+            unsigned int victim = lru.back();
+            lru.pop_back();
+            slot = chunkSlots[victim];
+            chunkSlots[victim] = -1;
+        } else {
+            // every slot is drawn, the chunk is requested again once one is released
+            continue;
+        }
+
+        chunkSlots[c.chunk] = slot;
+        lastUsed[c.chunk] = frame;
+        lru.push_front(c.chunk);
+        lruPosition[c.chunk] = lru.begin();
+        c.slot = slot;
+        placed.push_back(std::move(c));
+    }
+
+    return placed;
+}
+
+int ChunkStreamer::slotOf(unsigned int chunk) const {
+    return chunkSlots[chunk];
+}
+
+std::size_t ChunkStreamer::getSlotCount() const {
+    return slotCount;
+}
+
+std::size_t ChunkStreamer::getResidentCount() const {
+    return lru.size();
+}
+
+void ChunkStreamer::loaderLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeUp.wait(lock, [&]() { return stopping || (!requests.empty() && loaded.size() < MAX_LOADED); });
+        if (stopping) return;
+
+        unsigned int chunk = requests.front();
+        requests.pop_front();
+        lock.unlock();
+
+        // the pages are read from the disk here, away from the rendering thread
+        const ChunkRecord &record = file.getChunks()[chunk];
+        LoadedChunk c;
+        c.chunk = chunk;
+        c.slot = 0;
+        const PackedVertex *vertices = file.chunkVertices(chunk);
+        const std::uint16_t *indices = file.chunkIndices(chunk);
+        c.vertices.assign(vertices, vertices + record.vertexCount);
+        c.indices.assign(indices, indices + record.indexCount);
+
+        lock.lock();
+        loaded.push_back(std::move(c));
+    }
+}
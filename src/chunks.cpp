@@ -0,0 +1,145 @@
+#include "chunks.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+// chunks tested by a block of the parallel culling
+const std::size_t CULL_GRAIN = 512;
+
+}
+
+bool Chunk::isBackFacing(const QVector3D &cameraPosition) const {
+    // every direction from the camera to the bounding sphere must be inside the cone of the normals, shrunk by 90 degrees
+    QVector3D view = center - cameraPosition;
+    return QVector3D::dotProduct(view, coneAxis) >= coneCutoff * view.length() + radius;
+}
+
+Frustum::Frustum(const QMatrix4x4 &viewProjection) {
+    QVector4D r0 = viewProjection.row(0), r1 = viewProjection.row(1);
+    QVector4D r2 = viewProjection.row(2), r3 = viewProjection.row(3);
+    planes = { r3 + r0, r3 - r0, r3 + r1, r3 - r1, r3 + r2, r3 - r2 };
+}
+
+bool Frustum::intersects(const QVector3D &min, const QVector3D &max) const {
+    for (const auto &p : planes) {
+        // the corner the furthest along the normal
+        QVector3D corner(p.x() >= 0.0f ? max.x() : min.x(),
+                         p.y() >= 0.0f ? max.y() : min.y(),
+                         p.z() >= 0.0f ? max.z() : min.z());
+        if (QVector3D::dotProduct(p.toVector3D(), corner) + p.w() < 0.0f) return false;
+    }
+    return true;
+}
+
+std::vector<Chunk> ChunkPartition::build(const std::vector<Vertex> &vertices, const std::vector<Triangle> &faces,
+                                         unsigned int maxFaces, std::vector<unsigned int> &faceOrder) {
+    std::vector<QVector3D> centroids(faces.size());
+    for (std::size_t i = 0; i < faces.size(); i++) {
+        const auto &v = faces[i].idVertices;
+        centroids[i] = (vertices[v[0]].position + vertices[v[1]].position + vertices[v[2]].position) / 3.0f;
+    }
+
+    faceOrder.resize(faces.size());
+    std::iota(faceOrder.begin(), faceOrder.end(), 0);
+    maxFaces = std::max(maxFaces, 1u);
+
+    // median cuts along the largest side of the centroids bounds
+    std::vector<std::pair<std::size_t, std::size_t>> ranges;
+    std::vector<std::pair<std::size_t, std::size_t>> stack = { { 0, faces.size() } };
+    while (!stack.empty()) {
+        auto [begin, end] = stack.back();
+        stack.pop_back();
+        if (end - begin <= maxFaces) {
+            if (end > begin) ranges.push_back({ begin, end });
+            continue;
+        }
+
+        QVector3D min = centroids[faceOrder[begin]], max = min;
+        for (std::size_t i = begin; i < end; i++) {
+            const QVector3D &c = centroids[faceOrder[i]];
+            min = QVector3D(std::min(min.x(), c.x()), std::min(min.y(), c.y()), std::min(min.z(), c.z()));
+            max = QVector3D(std::max(max.x(), c.x()), std::max(max.y(), c.y()), std::max(max.z(), c.z()));
+        }
+        QVector3D extent = max - min;
+        int axis = extent.x() >= extent.y() && extent.x() >= extent.z() ? 0 : (extent.y() >= extent.z() ? 1 : 2);
+
+        std::size_t mid = begin + (end - begin) / 2;
+        std::nth_element(faceOrder.begin() + begin, faceOrder.begin() + mid, faceOrder.begin() + end,
+                         [&](unsigned int a, unsigned int b) { return centroids[a][axis] < centroids[b][axis]; });
+
+        // pushed in reverse so the chunks come out from the lowest to the highest coordinates
+        stack.push_back({ mid, end });
+        stack.push_back({ begin, mid });
+    }
+
+    std::vector<Chunk> chunks;
+    chunks.reserve(ranges.size());
+    for (auto [begin, end] : ranges) {
+        std::sort(faceOrder.begin() + begin, faceOrder.begin() + end);
+
+        Chunk chunk;
+        chunk.firstIndex = 3 * begin;
+        chunk.indexCount = 3 * (end - begin);
+        chunk.baseVertex = 0;
+
+        const QVector3D &first = vertices[faces[faceOrder[begin]].idVertices[0]].position;
+        chunk.boundsMin = chunk.boundsMax = first;
+        QVector3D normalSum;
+        std::vector<QVector3D> normals;
+        normals.reserve(end - begin);
+        for (std::size_t i = begin; i < end; i++) {
+            const auto &v = faces[faceOrder[i]].idVertices;
+            for (unsigned int id : v) {
+                const QVector3D &p = vertices[id].position;
+                chunk.boundsMin = QVector3D(std::min(chunk.boundsMin.x(), p.x()), std::min(chunk.boundsMin.y(), p.y()), std::min(chunk.boundsMin.z(), p.z()));
+                chunk.boundsMax = QVector3D(std::max(chunk.boundsMax.x(), p.x()), std::max(chunk.boundsMax.y(), p.y()), std::max(chunk.boundsMax.z(), p.z()));
+            }
+
+            QVector3D normal = QVector3D::crossProduct(vertices[v[1]].position - vertices[v[0]].position,
+                                                       vertices[v[2]].position - vertices[v[0]].position);
+            if (normal.lengthSquared() == 0.0f) continue;
+            normals.push_back(normal.normalized());
+            normalSum += normals.back();
+        }
+
+        chunk.center = (chunk.boundsMin + chunk.boundsMax) * 0.5f;
+        chunk.radius = 0.0f;
+        for (std::size_t i = begin; i < end; i++) {
+            for (unsigned int id : faces[faceOrder[i]].idVertices) {
+                chunk.radius = std::max(chunk.radius, (vertices[id].position - chunk.center).length());
+            }
+        }
+
+        // a cone wider than a half space can't hide the chunk
+        chunk.coneAxis = normalSum.normalized();
+        chunk.coneCutoff = 2.0f;
+        if (normalSum.length() > 0.0f) {
+            float minDot = 1.0f;
+            for (const auto &n : normals) minDot = std::min(minDot, QVector3D::dotProduct(n, chunk.coneAxis));
+            if (minDot > 0.0f) chunk.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+
+        chunks.push_back(chunk);
+    }
+
+    return chunks;
+}
+
+std::size_t ChunkPartition::cull(const std::vector<Chunk> &chunks, std::size_t first, std::size_t count,
+                                 const Frustum &frustum, const QVector3D &cameraPosition, bool coneCulling,
+                                 std::vector<unsigned char> &visible) {
+    visible.resize(count);
+    parallelFor(0, count, CULL_GRAIN, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            const Chunk &c = chunks[first + i];
+            bool inside = frustum.intersects(c.boundsMin, c.boundsMax);
+            visible[i] = inside && !(coneCulling && c.isBackFacing(cameraPosition));
+        }
+    });
+
+    return count - std::count(visible.begin(), visible.end(), 1);
+}
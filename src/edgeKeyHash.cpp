@@ -1,5 +1,19 @@
 #include "edgeKeyHash.h"
 
+#include <cstring>
+#include <functional>
+
 size_t EdgeKeyHash::operator()(const std::pair<int,int>& p) const noexcept {
     return (static_cast<size_t>(p.first) << 32) ^ static_cast<size_t>(p.second);
 }
+
+size_t PositionKeyHash::operator()(const PositionKey& k) const noexcept {
+    return std::hash<std::int64_t>()(k[0] * 73856093 ^ k[1] * 19349663 ^ k[2] * 83492791);
+}
+
+std::int64_t coordinateBits(float value) {
+    value += 0.0f;
+    std::int32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
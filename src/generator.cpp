@@ -0,0 +1,388 @@
+#include "generator.h"
+#include "parallel.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace {
+
+const float PI = 3.14159265358979f;
+// rows, points or edges generated by one task
+const std::size_t GENERATE_GRAIN = 4096;
+// elements formatted by one task, the text of all the threads is then written in order
+const std::size_t WRITE_BLOCK = 1 << 16;
+// a sphere of l levels has 20 * 4^l faces, 20 * 4^14 doesn't fit in 32 bits (its 10 * 4^14 + 2 vertices would)
+const unsigned int MAX_ICOSPHERE_LEVELS = 13;
+const unsigned int TERRAIN_OCTAVES = 6;
+const float TERRAIN_BASE_FREQUENCY = 2.0f;
+// white noise added to each height, relative to the amplitude
+const float TERRAIN_JITTER = 0.02f;
+const unsigned int CLOUD_CLUSTERS = 32;
+const float CLUSTER_RADIUS = 0.05f;
+const float CLOUD_HEIGHT = 0.1f;
+
+// a regular icosahedron, the faces are counterclockwise seen from outside
+const float GOLDEN = 1.61803398874989f;
+const std::array<std::array<float, 3>, 12> ICO_VERTICES = {{
+    { -1, GOLDEN, 0 }, { 1, GOLDEN, 0 }, { -1, -GOLDEN, 0 }, { 1, -GOLDEN, 0 },
+    { 0, -1, GOLDEN }, { 0, 1, GOLDEN }, { 0, -1, -GOLDEN }, { 0, 1, -GOLDEN },
+    { GOLDEN, 0, -1 }, { GOLDEN, 0, 1 }, { -GOLDEN, 0, -1 }, { -GOLDEN, 0, 1 }
+}};
+const std::array<std::array<unsigned int, 3>, 20> ICO_FACES = {{
+    { 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+    { 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+    { 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+    { 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 }
+}};
+
+// splitmix64 of a counter, each value only depends on the seed, the element and the stream
+std::uint64_t hash(std::uint64_t seed, std::uint64_t index, unsigned int stream) {
+    std::uint64_t z = seed * 0xD1B54A32D192ED03ull + (index * 8 + stream + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// uniform in [0, 1), 24 bits like the mantissa of a float
+float uniform(std::uint64_t seed, std::uint64_t index, unsigned int stream) {
+    return (hash(seed, index, stream) >> 40) * (1.0f / 16777216.0f);
+}
+
+float smoothstep(float t) {
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// value noise in [-1, 1], the lattice values are hashed from their coordinates
+float valueNoise(float x, float y, std::uint64_t seed) {
+    float fx = std::floor(x), fy = std::floor(y);
+    std::uint64_t ix = static_cast<std::uint64_t>(fx), iy = static_cast<std::uint64_t>(fy);
+    auto lattice = [&](std::uint64_t i, std::uint64_t j) { return 2.0f * uniform(seed, (i << 32) | j, 0) - 1.0f; };
+
+    float tx = smoothstep(x - fx), ty = smoothstep(y - fy);
+    float bottom = lattice(ix, iy) + tx * (lattice(ix + 1, iy) - lattice(ix, iy));
+    float top = lattice(ix, iy + 1) + tx * (lattice(ix + 1, iy + 1) - lattice(ix, iy + 1));
+    return bottom + ty * (top - bottom);
+}
+
+void appendFloat(std::string &text, float value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    text.append(buffer, result.ptr);
+}
+
+void appendUInt(std::string &text, unsigned long long value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    text.append(buffer, result.ptr);
+}
+
+/**
+ * @brief Format the elements [0, count) by blocks on all the threads and write the blocks in order.
+ * @param format : Called with an element index and the text of its block.
+ * @return False if the file can't be written.
+ */
+template <typename Format>
+bool writeBlocks(std::ofstream &file, std::size_t count, const Format &format) {
+    std::vector<std::string> texts(parallelThreadCount());
+    const std::size_t batch = WRITE_BLOCK * texts.size();
+
+    for (std::size_t first = 0; first < count; first += batch) {
+        std::size_t last = std::min(count, first + batch);
+        std::size_t blocks = (last - first + WRITE_BLOCK - 1) / WRITE_BLOCK;
+        parallelFor(0, blocks, 1, [&](std::size_t blockBegin, std::size_t blockEnd) {
+            for (std::size_t b = blockBegin; b < blockEnd; b++) {
+                std::string &text = texts[b];
+                text.clear();
+                std::size_t end = std::min(last, first + (b + 1) * WRITE_BLOCK);
+                for (std::size_t e = first + b * WRITE_BLOCK; e < end; e++) format(e, text);
+            }
+        });
+
+        for (std::size_t b = 0; b < blocks; b++) file.write(texts[b].data(), texts[b].size());
+        if (!file) return false;
+    }
+    return true;
+}
+
+}
+
+GeneratedMesh Generator::icosphere(unsigned int levels) {
+    ScopedTimer timer("Generator::icosphere");
+    if (levels > MAX_ICOSPHERE_LEVELS) {
+        std::cerr << "Warning: icosphere limited to " << MAX_ICOSPHERE_LEVELS << " levels\n";
+        levels = MAX_ICOSPHERE_LEVELS;
+    }
+
+    // each face is a triangular lattice of n steps, the vertices of the corners and the edges are shared
+    const std::size_t n = std::size_t(1) << levels;
+    const std::size_t edgeVertices = n - 1;
+    const std::size_t faceVertices = (n - 1) * (n - 2) / 2;
+    const std::size_t edgeStart = ICO_VERTICES.size();
+    const std::size_t faceStart = edgeStart + 30 * edgeVertices;
+
+    std::map<std::pair<unsigned int, unsigned int>, unsigned int> edgeIds;
+    std::vector<std::pair<unsigned int, unsigned int>> edges;
+    for (const auto &f : ICO_FACES) {
+        for (int e = 0; e < 3; e++) {
+            auto key = std::minmax(f[e], f[(e + 1) % 3]);
+            if (edgeIds.emplace(key, edges.size()).second) edges.push_back(key);
+        }
+    }
+
+    // the vertex t steps from a toward b
+    auto edgeVertex = [&](unsigned int a, unsigned int b, std::size_t t) {
+        std::size_t e = edgeIds.at(std::minmax(a, b));
+        std::size_t step = a < b ? t : n - t;
+        return static_cast<unsigned int>(edgeStart + e * edgeVertices + step - 1);
+    };
+
+    auto corner = [](unsigned int c) {
+        return QVector3D(ICO_VERTICES[c][0], ICO_VERTICES[c][1], ICO_VERTICES[c][2]);
+    };
+
+    GeneratedMesh mesh;
+    mesh.positions.resize(faceStart + 20 * faceVertices);
+    mesh.indices.resize(3 * 20 * n * n);
+
+    for (std::size_t c = 0; c < ICO_VERTICES.size(); c++) mesh.positions[c] = corner(c).normalized();
+
+    parallelFor(0, edges.size() * edgeVertices, GENERATE_GRAIN, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t v = begin; v < end; v++) {
+            std::size_t e = v / edgeVertices, t = v % edgeVertices + 1;
+            QVector3D p = corner(edges[e].first) * float(n - t) + corner(edges[e].second) * float(t);
+            mesh.positions[edgeStart + v] = p.normalized();
+        }
+    });
+
+    // one task per row of a face : its inner vertices and the strip of triangles above it
+    parallelFor(0, 20 * n, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t row = begin; row < end; row++) {
+            const std::size_t f = row / n, j = row % n;
+            const auto &c = ICO_FACES[f];
+            const std::size_t rowStart = faceStart + f * faceVertices + (j > 0 ? (j - 1) * (n - 1) - (j - 1) * j / 2 : 0);
+
+            auto vertex = [&](std::size_t i, std::size_t jj) -> unsigned int {
+                if (i == 0 && jj == 0) return c[0];
+                if (i == n) return c[1];
+                if (jj == n) return c[2];
+                if (jj == 0) return edgeVertex(c[0], c[1], i);
+                if (i == 0) return edgeVertex(c[0], c[2], jj);
+                if (i + jj == n) return edgeVertex(c[1], c[2], jj);
+                std::size_t start = faceStart + f * faceVertices + (jj - 1) * (n - 1) - (jj - 1) * jj / 2;
+                return static_cast<unsigned int>(start + i - 1);
+            };
+
+            if (j > 0) {
+                for (std::size_t i = 1; i + j < n; i++) {
+                    QVector3D p = corner(c[0]) * float(n - i - j) + corner(c[1]) * float(i) + corner(c[2]) * float(j);
+                    mesh.positions[rowStart + i - 1] = p.normalized();
+                }
+            }
+
+            unsigned int *out = mesh.indices.data() + 3 * (f * n * n + 2 * n * j - j * j);
+            for (std::size_t i = 0; i + j < n; i++) {
+                unsigned int a = vertex(i, j), b = vertex(i + 1, j), d = vertex(i, j + 1);
+                *out++ = a; *out++ = b; *out++ = d;
+                if (i + j + 1 < n) {
+                    *out++ = b; *out++ = vertex(i + 1, j + 1); *out++ = d;
+                }
+            }
+        }
+    });
+
+    return mesh;
+}
+
+GeneratedMesh Generator::torus(unsigned int rings, unsigned int sides, float majorRadius, float minorRadius) {
+    ScopedTimer timer("Generator::torus");
+    rings = std::max(rings, 3u);
+    sides = std::max(sides, 3u);
+
+    GeneratedMesh mesh;
+    mesh.positions.resize(std::size_t(rings) * sides);
+    mesh.indices.resize(6 * std::size_t(rings) * sides);
+
+    parallelFor(0, rings, std::max<std::size_t>(1, GENERATE_GRAIN / sides), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t r = begin; r < end; r++) {
+            float u = 2.0f * PI * r / rings;
+            std::size_t next = (r + 1) % rings;
+            for (std::size_t s = 0; s < sides; s++) {
+                float v = 2.0f * PI * s / sides;
+                float distance = majorRadius + minorRadius * std::cos(v);
+                mesh.positions[r * sides + s] = QVector3D(distance * std::cos(u), distance * std::sin(u), minorRadius * std::sin(v));
+
+                unsigned int a = r * sides + s, b = next * sides + s;
+                unsigned int c = r * sides + (s + 1) % sides, d = next * sides + (s + 1) % sides;
+                unsigned int *out = mesh.indices.data() + 6 * (r * sides + s);
+                *out++ = a; *out++ = b; *out++ = d;
+                *out++ = a; *out++ = d; *out++ = c;
+            }
+        }
+    });
+
+    return mesh;
+}
+
+GeneratedMesh Generator::terrain(unsigned int cells, float amplitude, std::uint64_t seed) {
+    ScopedTimer timer("Generator::terrain");
+    cells = std::max(cells, 1u);
+    const std::size_t side = std::size_t(cells) + 1;
+
+    GeneratedMesh mesh;
+    mesh.positions.resize(side * side);
+    mesh.indices.resize(6 * std::size_t(cells) * cells);
+
+    parallelFor(0, side, std::max<std::size_t>(1, GENERATE_GRAIN / side), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t y = begin; y < end; y++) {
+            for (std::size_t x = 0; x < side; x++) {
+                float px = 2.0f * x / cells - 1.0f, py = 2.0f * y / cells - 1.0f;
+
+                // octaves of halved weight and doubled frequency, each one with its own lattice
+                float height = 0.0f, weight = 1.0f, weights = 0.0f, frequency = TERRAIN_BASE_FREQUENCY;
+                for (unsigned int o = 0; o < TERRAIN_OCTAVES; o++) {
+                    height += weight * valueNoise((px + 1.0f) * frequency, (py + 1.0f) * frequency, seed + o);
+                    weights += weight;
+                    weight *= 0.5f;
+                    frequency *= 2.0f;
+                }
+                float jitter = TERRAIN_JITTER * (2.0f * uniform(seed, y * side + x, 1) - 1.0f);
+                mesh.positions[y * side + x] = QVector3D(px, py, amplitude * (height / weights + jitter));
+            }
+
+            if (y == cells) continue;
+            for (std::size_t x = 0; x < cells; x++) {
+                unsigned int a = y * side + x, b = a + 1, c = a + side, d = c + 1;
+                unsigned int *out = mesh.indices.data() + 6 * (y * cells + x);
+                *out++ = a; *out++ = b; *out++ = d;
+                *out++ = a; *out++ = d; *out++ = c;
+            }
+        }
+    });
+
+    return mesh;
+}
+
+GeneratedMesh Generator::pointCloud(std::size_t count, CloudDistribution distribution, std::uint64_t seed) {
+    ScopedTimer timer("Generator::pointCloud");
+    GeneratedMesh mesh;
+    mesh.positions.resize(count);
+    // the grid is scaled by a power of 2 to stay in [-1, 1], its coordinates stay exact
+    const std::size_t gridSide = std::max<std::size_t>(1, std::ceil(std::sqrt(double(count))));
+    const float gridScale = std::ldexp(2.0f, -int(std::ceil(std::log2(double(gridSide)))));
+
+    parallelFor(0, count, GENERATE_GRAIN, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            float height = CLOUD_HEIGHT * uniform(seed, i, 2);
+            QVector3D &p = mesh.positions[i];
+
+            switch (distribution) {
+            case CloudDistribution::UNIFORM:
+                p = QVector3D(2.0f * uniform(seed, i, 0) - 1.0f, 2.0f * uniform(seed, i, 1) - 1.0f, height);
+                break;
+            case CloudDistribution::CLUSTERED: {
+                // Box-Muller around a center drawn from the index of the cluster
+                std::uint64_t cluster = hash(seed, i, 3) % CLOUD_CLUSTERS;
+                float cx = (2.0f * uniform(seed, cluster, 4) - 1.0f) * (1.0f - 3.0f * CLUSTER_RADIUS);
+                float cy = (2.0f * uniform(seed, cluster, 5) - 1.0f) * (1.0f - 3.0f * CLUSTER_RADIUS);
+                float radius = CLUSTER_RADIUS * std::sqrt(-2.0f * std::log(std::max(uniform(seed, i, 0), 1e-7f)));
+                float angle = 2.0f * PI * uniform(seed, i, 1);
+                p = QVector3D(cx + radius * std::cos(angle), cy + radius * std::sin(angle), height);
+                break;
+            }
+            case CloudDistribution::COLLINEAR: {
+                // y = x / 2 is exact in floating point
+                float x = 2.0f * uniform(seed, i, 0) - 1.0f;
+                p = QVector3D(x, 0.5f * x, height);
+                break;
+            }
+            case CloudDistribution::COCIRCULAR: {
+                float angle = 2.0f * PI * uniform(seed, i, 0);
+                p = QVector3D(std::cos(angle), std::sin(angle), height);
+                break;
+            }
+            case CloudDistribution::GRID: {
+                float x = float(i % gridSide) - float(gridSide / 2), y = float(i / gridSide) - float(gridSide / 2);
+                p = QVector3D(gridScale * x, gridScale * y, 0.0f);
+                break;
+            }
+            }
+        }
+    });
+
+    return mesh;
+}
+
+Mesh Generator::toMesh(const GeneratedMesh &generated) {
+    ScopedTimer timer("Generator::toMesh");
+    std::vector<Vertex> vertices;
+    vertices.reserve(generated.positions.size());
+    for (const auto &p : generated.positions) vertices.push_back(Vertex(p));
+
+    std::vector<Triangle> faces;
+    faces.reserve(generated.indices.size() / 3);
+    for (std::size_t i = 0; i + 2 < generated.indices.size(); i += 3) {
+        faces.push_back(Triangle(generated.indices[i], generated.indices[i + 1], generated.indices[i + 2]));
+    }
+
+    return Mesh(std::move(vertices), std::move(faces));
+}
+
+int Generator::save(const GeneratedMesh &generated, const char *link) {
+    ScopedTimer timer("Generator::save");
+    std::string filename(link);
+    std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
+    std::string extension = filename.size() >= 4 ? filename.substr(filename.size() - 4) : "";
+    if (extension != ".off" && extension != ".obj" && extension != ".txt") {
+        std::cerr << "Unsupported format : " << link << "\n";
+        return MeshError::FORMAT;
+    }
+
+    std::ofstream file(link, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Can't open file \"" << link << "\"\n";
+        return MeshError::SAVE;
+    }
+
+    const std::size_t faceCount = generated.indices.size() / 3;
+    if (extension == ".off") file << "OFF\n" << generated.positions.size() << " " << faceCount << " 0\n";
+    if (extension == ".txt") file << generated.positions.size() << "\n";
+
+    const char *vertexPrefix = extension == ".obj" ? "v " : "";
+    bool ok = writeBlocks(file, generated.positions.size(), [&](std::size_t v, std::string &text) {
+        const QVector3D &p = generated.positions[v];
+        text += vertexPrefix;
+        appendFloat(text, p.x());
+        text += ' ';
+        appendFloat(text, p.y());
+        text += ' ';
+        appendFloat(text, p.z());
+        text += '\n';
+    });
+
+    if (ok && extension != ".txt") {
+        // OBJ indices start at 1
+        const bool obj = extension == ".obj";
+        ok = writeBlocks(file, faceCount, [&](std::size_t f, std::string &text) {
+            text += obj ? "f" : "3";
+            for (int k = 0; k < 3; k++) {
+                text += ' ';
+                appendUInt(text, generated.indices[3 * f + k] + (obj ? 1ull : 0ull));
+            }
+            text += '\n';
+        });
+    }
+
+    file.close();
+    if (!ok || !file) {
+        std::cerr << "Failed to write \"" << link << "\"\n";
+        return MeshError::SAVE;
+    }
+    return MeshError::OK;
+}
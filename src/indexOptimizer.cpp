@@ -0,0 +1,214 @@
+#include "indexOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+
+CacheStatistics IndexOptimizer::simulateVertexCache(const std::vector<unsigned int> &indices, std::size_t vertexCount, unsigned int cacheSize) {
+    std::size_t faceCount = indices.size() / 3;
+    if (faceCount == 0) return { 0.0f, 0.0f };
+
+    // a vertex is inside the FIFO while less than cacheSize vertices entered after it
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    unsigned int timestamp = cacheSize + 1;
+    std::size_t misses = 0, referencedCount = 0;
+
+    for (std::size_t i = 0; i < faceCount * 3; i++) {
+        unsigned int v = indices[i];
+        if (timestamp - cacheTime[v] > cacheSize) {
+            cacheTime[v] = timestamp++;
+            misses++;
+        }
+        if (!referenced[v]) {
+            referenced[v] = true;
+            referencedCount++;
+        }
+    }
+
+    return { float(misses) / faceCount, float(misses) / referencedCount };
+}
+
+std::vector<unsigned int> IndexOptimizer::optimizeVertexCache(const std::vector<unsigned int> &indices, std::size_t vertexCount, unsigned int cacheSize) {
+    std::size_t faceCount = indices.size() / 3;
+    std::vector<unsigned int> order;
+    order.reserve(faceCount);
+    if (faceCount == 0) return order;
+
+    // faces around each vertex, stored as compressed rows
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (std::size_t i = 0; i < faceCount * 3; i++) offsets[indices[i] + 1]++;
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<unsigned int> adjacency(faceCount * 3);
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < faceCount * 3; i++) adjacency[fill[indices[i]]++] = i / 3;
+
+    std::vector<unsigned int> live(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; v++) live[v] = offsets[v + 1] - offsets[v];
+
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(faceCount, false);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    unsigned int timestamp = cacheSize + 1;
+    std::size_t cursor = 0;
+    long long fanning = indices[0];
+
+    while (fanning >= 0) {
+        // emit all the remaining faces around the fanning vertex
+        candidates.clear();
+        for (unsigned int i = offsets[fanning]; i < offsets[fanning + 1]; i++) {
+            unsigned int f = adjacency[i];
+            if (emitted[f]) continue;
+            emitted[f] = true;
+            order.push_back(f);
+
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = indices[3 * f + k];
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (timestamp - cacheTime[v] > cacheSize) cacheTime[v] = timestamp++;
+            }
+        }
+
+        // next fanning vertex, the oldest one that will still be in the cache after its faces are emitted
+        fanning = -1;
+        int bestPriority = -1;
+        for (unsigned int v : candidates) {
+            if (live[v] == 0) continue;
+            int priority = 0;
+            if (timestamp - cacheTime[v] + 2 * live[v] <= cacheSize) priority = timestamp - cacheTime[v];
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                fanning = v;
+            }
+        }
+
+        // dead end, go back to a recently used vertex or to the next unprocessed one
+        while (fanning < 0 && !deadEnd.empty()) {
+            unsigned int v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0) fanning = v;
+        }
+        while (fanning < 0 && cursor < vertexCount) {
+            if (live[cursor] > 0) fanning = cursor;
+            cursor++;
+        }
+    }
+
+    return order;
+}
+
+std::vector<unsigned int> IndexOptimizer::optimizeOverdraw(const std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices, unsigned int cacheSize, float threshold) {
+    std::size_t faceCount = indices.size() / 3;
+    std::vector<unsigned int> order(faceCount);
+    std::iota(order.begin(), order.end(), 0);
+    if (faceCount == 0) return order;
+
+    std::vector<unsigned int> cacheTime(vertices.size(), 0);
+    unsigned int timestamp = cacheSize + 1;
+    auto faceMisses = [&](std::size_t f) {
+        unsigned int misses = 0;
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = indices[3 * f + k];
+            if (timestamp - cacheTime[v] > cacheSize) {
+                cacheTime[v] = timestamp++;
+                misses++;
+            }
+        }
+        return misses;
+    };
+    auto flushCache = [&]() { timestamp += cacheSize + 1; };
+
+    // hard boundaries, where Tipsify restarted from a vertex out of the cache
+    std::vector<std::size_t> hard;
+    for (std::size_t f = 0; f < faceCount; f++) {
+        if (faceMisses(f) == 3) hard.push_back(f);
+    }
+    if (hard.empty() || hard[0] != 0) hard.insert(hard.begin(), 0);
+    hard.push_back(faceCount);
+
+    // soft boundaries, a cluster is closed once its ACMR is close to the one of its hard cluster
+    std::vector<std::size_t> clusters;
+    for (std::size_t h = 0; h + 1 < hard.size(); h++) {
+        std::size_t begin = hard[h], end = hard[h + 1];
+
+        flushCache();
+        std::size_t misses = 0;
+        for (std::size_t f = begin; f < end; f++) misses += faceMisses(f);
+        float target = float(misses) / (end - begin) * threshold;
+
+        flushCache();
+        clusters.push_back(begin);
+        std::size_t clusterMisses = 0, clusterFaces = 0;
+        for (std::size_t f = begin; f < end; f++) {
+            clusterMisses += faceMisses(f);
+            clusterFaces++;
+            if (f + 1 < end && float(clusterMisses) / clusterFaces <= target) {
+                clusters.push_back(f + 1);
+                clusterMisses = clusterFaces = 0;
+                flushCache();
+            }
+        }
+    }
+    clusters.push_back(faceCount);
+
+    // clusters whose normal points away from the mesh center are drawn first
+    std::size_t clusterCount = clusters.size() - 1;
+    std::vector<QVector3D> centroids(clusterCount), normals(clusterCount);
+    QVector3D meshCentroid;
+    float meshArea = 0.0f;
+    for (std::size_t c = 0; c < clusterCount; c++) {
+        float clusterArea = 0.0f;
+        for (std::size_t f = clusters[c]; f < clusters[c + 1]; f++) {
+            const QVector3D &a = vertices[indices[3 * f]].position;
+            const QVector3D &b = vertices[indices[3 * f + 1]].position;
+            const QVector3D &d = vertices[indices[3 * f + 2]].position;
+            QVector3D normal = QVector3D::crossProduct(b - a, d - a);
+            float area = normal.length();
+            centroids[c] += (a + b + d) / 3.0f * area;
+            normals[c] += normal;
+            clusterArea += area;
+        }
+        meshCentroid += centroids[c];
+        meshArea += clusterArea;
+        centroids[c] = clusterArea > 0.0f ? centroids[c] / clusterArea : vertices[indices[3 * clusters[c]]].position;
+    }
+    if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+    std::vector<float> keys(clusterCount);
+    for (std::size_t c = 0; c < clusterCount; c++) {
+        keys[c] = QVector3D::dotProduct(centroids[c] - meshCentroid, normals[c].normalized());
+    }
+
+    std::vector<unsigned int> clusterOrder(clusterCount);
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](unsigned int a, unsigned int b) {
+        return keys[a] > keys[b];
+    });
+
+    order.clear();
+    for (unsigned int c : clusterOrder) {
+        for (std::size_t f = clusters[c]; f < clusters[c + 1]; f++) order.push_back(f);
+    }
+
+    return order;
+}
+
+std::vector<unsigned int> IndexOptimizer::optimizeVertexFetch(const std::vector<unsigned int> &indices, std::size_t vertexCount) {
+    std::vector<unsigned int> order;
+    order.reserve(vertexCount);
+    std::vector<bool> used(vertexCount, false);
+
+    for (unsigned int v : indices) {
+        if (used[v]) continue;
+        used[v] = true;
+        order.push_back(v);
+    }
+    for (std::size_t v = 0; v < vertexCount; v++) {
+        if (!used[v]) order.push_back(v);
+    }
+
+    return order;
+}
@@ -0,0 +1,270 @@
+#include "kdTree.h"
+#include "parallel.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace {
+
+// a node of at most this many points is a leaf, scanned without a split
+const std::size_t KD_LEAF_SIZE = 16;
+// the children of smaller nodes are split on the same thread
+const std::size_t KD_PARALLEL_MIN_POINTS = 1 << 15;
+// queries answered by one task
+const std::size_t KD_QUERY_GRAIN = 256;
+// the depth of a balanced tree of 2^32 points, the bound of the traversal stacks
+const int KD_MAX_DEPTH = 64;
+
+const float INFINITE_DISTANCE = std::numeric_limits<float>::infinity();
+
+struct Pending {
+    unsigned int first;
+    unsigned int last;
+    float distance; // lower bound of the squared distance to the points of the node
+};
+
+}
+
+KDTree::KDTree() : parallelDepth(0) {}
+
+void KDTree::build(const std::vector<Vertex> &vertices) {
+    std::vector<QVector3D> points(vertices.size());
+    parallelFor(0, points.size(), 1 << 14, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) points[i] = vertices[i].position;
+    });
+    build(points);
+}
+
+void KDTree::build(const std::vector<QVector3D> &points) {
+    ScopedTimer timer("KDTree::build");
+    clear();
+    std::size_t n = points.size();
+    if (n == 0) return;
+
+    entries.resize(n);
+    std::size_t blocks = parallelThreadCount();
+    std::vector<std::pair<QVector3D, QVector3D>> partial(blocks, { QVector3D(INFINITE_DISTANCE, INFINITE_DISTANCE, INFINITE_DISTANCE),
+                                                                   QVector3D(-INFINITE_DISTANCE, -INFINITE_DISTANCE, -INFINITE_DISTANCE) });
+    parallelFor(0, blocks, 1, [&](std::size_t b0, std::size_t b1) {
+        for (std::size_t b = b0; b < b1; b++) {
+            auto &bounds = partial[b];
+            for (std::size_t i = n * b / blocks; i < n * (b + 1) / blocks; i++) {
+                const QVector3D &p = points[i];
+                entries[i] = { { p.x(), p.y(), p.z() }, unsigned(i) };
+                for (int a = 0; a < 3; a++) {
+                    bounds.first[a] = std::min(bounds.first[a], p[a]);
+                    bounds.second[a] = std::max(bounds.second[a], p[a]);
+                }
+            }
+        }
+    });
+    QVector3D boundsMin = partial[0].first, boundsMax = partial[0].second;
+    for (const auto &bounds : partial) {
+        for (int a = 0; a < 3; a++) {
+            boundsMin[a] = std::min(boundsMin[a], bounds.first[a]);
+            boundsMax[a] = std::max(boundsMax[a], bounds.second[a]);
+        }
+    }
+
+    axes.assign(n, 0);
+    parallelDepth = 1;
+    while ((1u << parallelDepth) < parallelThreadCount() * 2) parallelDepth++;
+    split(0, n, boundsMin, boundsMax, 0);
+
+    px.resize(n);
+    py.resize(n);
+    pz.resize(n);
+    indices.resize(n);
+    parallelFor(0, n, 1 << 14, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            px[i] = entries[i].position[0];
+            py[i] = entries[i].position[1];
+            pz[i] = entries[i].position[2];
+            indices[i] = entries[i].index;
+        }
+    });
+    entries.clear();
+    entries.shrink_to_fit();
+}
+
+void KDTree::split(std::size_t first, std::size_t last, QVector3D boundsMin, QVector3D boundsMax, int depth) {
+    if (last - first <= KD_LEAF_SIZE) return;
+
+    // the longest side of the cell, the cells stay close to cubes without measuring the points again
+    QVector3D extent = boundsMax - boundsMin;
+    int axis = extent.x() >= extent.y() && extent.x() >= extent.z() ? 0 : (extent.y() >= extent.z() ? 1 : 2);
+    std::size_t mid = first + (last - first) / 2;
+    std::nth_element(entries.begin() + first, entries.begin() + mid, entries.begin() + last,
+                     [axis](const Entry &a, const Entry &b) { return a.position[axis] < b.position[axis]; });
+    axes[mid] = axis;
+
+    float splitPosition = entries[mid].position[axis];
+    QVector3D leftMax = boundsMax, rightMin = boundsMin;
+    leftMax[axis] = splitPosition;
+    rightMin[axis] = splitPosition;
+    if (depth < parallelDepth && last - first >= KD_PARALLEL_MIN_POINTS) {
+        parallelInvoke([&]() { split(first, mid, boundsMin, leftMax, depth + 1); },
+                       [&]() { split(mid + 1, last, rightMin, boundsMax, depth + 1); });
+    } else {
+        split(first, mid, boundsMin, leftMax, depth + 1);
+        split(mid + 1, last, rightMin, boundsMax, depth + 1);
+    }
+}
+
+void KDTree::clear() {
+    entries.clear();
+    px.clear();
+    py.clear();
+    pz.clear();
+    indices.clear();
+    axes.clear();
+}
+
+bool KDTree::isEmpty() const {
+    return indices.empty();
+}
+
+std::size_t KDTree::size() const {
+    return indices.size();
+}
+
+void KDTree::knn(const QVector3D &position, std::size_t k, std::vector<unsigned int> &neighbors, std::vector<float> *squaredDistances) const {
+    neighbors.clear();
+    if (squaredDistances) squaredDistances->clear();
+    if (k == 0 || indices.empty()) return;
+
+    const float qx = position.x(), qy = position.y(), qz = position.z();
+    const float *coordinates[3] = { px.data(), py.data(), pz.data() };
+
+    // max-heap of the best points so far, by squared distance then tree position
+    std::vector<std::pair<float, unsigned int>> best;
+    best.reserve(k + 1);
+    float worst = INFINITE_DISTANCE;
+
+    std::array<Pending, KD_MAX_DEPTH + 1> stack;
+    int top = 0;
+    stack[top++] = { 0, unsigned(indices.size()), 0.0f };
+    while (top > 0) {
+        Pending node = stack[--top];
+        if (node.distance > worst) continue;
+
+        bool leaf = node.last - node.first <= KD_LEAF_SIZE;
+        unsigned int mid = node.first + (node.last - node.first) / 2;
+        unsigned int first = leaf ? node.first : mid, last = leaf ? node.last : mid + 1;
+
+        // the distances first, a loop the compiler vectorizes
+        float distances[KD_LEAF_SIZE];
+        for (unsigned int i = first; i < last; i++) {
+            float dx = px[i] - qx, dy = py[i] - qy, dz = pz[i] - qz;
+            distances[i - first] = dx * dx + dy * dy + dz * dz;
+        }
+        for (unsigned int i = first; i < last; i++) {
+            float distance = distances[i - first];
+            if (best.size() == k && distance >= worst) continue;
+            best.push_back({ distance, i });
+            std::push_heap(best.begin(), best.end());
+            if (best.size() > k) {
+                std::pop_heap(best.begin(), best.end());
+                best.pop_back();
+            }
+            if (best.size() == k) worst = best.front().first;
+        }
+        if (leaf) continue;
+
+        int axis = axes[mid];
+        float difference = position[axis] - coordinates[axis][mid];
+        Pending left = { node.first, mid, node.distance }, right = { mid + 1, node.last, node.distance };
+        Pending &far = difference < 0.0f ? right : left;
+        far.distance = std::max(node.distance, difference * difference);
+        // the near child is popped first
+        stack[top++] = far;
+        stack[top++] = difference < 0.0f ? left : right;
+    }
+
+    std::sort_heap(best.begin(), best.end());
+    neighbors.reserve(best.size());
+    for (const auto &b : best) neighbors.push_back(indices[b.second]);
+    if (squaredDistances) {
+        squaredDistances->reserve(best.size());
+        for (const auto &b : best) squaredDistances->push_back(b.first);
+    }
+}
+
+void KDTree::knn(const std::vector<QVector3D> &positions, std::size_t k, std::vector<unsigned int> &neighbors, std::vector<float> *squaredDistances) const {
+    ScopedTimer timer("KDTree::knn");
+    neighbors.assign(positions.size() * k, NO_POINT);
+    if (squaredDistances) squaredDistances->assign(positions.size() * k, INFINITE_DISTANCE);
+
+    parallelFor(0, positions.size(), KD_QUERY_GRAIN, [&](std::size_t first, std::size_t last) {
+        std::vector<unsigned int> found;
+        std::vector<float> distances;
+        for (std::size_t q = first; q < last; q++) {
+            knn(positions[q], k, found, squaredDistances ? &distances : nullptr);
+            std::copy(found.begin(), found.end(), neighbors.begin() + q * k);
+            if (squaredDistances) std::copy(distances.begin(), distances.end(), squaredDistances->begin() + q * k);
+        }
+    });
+}
+
+void KDTree::radius(const QVector3D &position, float radius, std::vector<unsigned int> &neighbors) const {
+    neighbors.clear();
+    if (indices.empty() || radius < 0.0f) return;
+
+    const float qx = position.x(), qy = position.y(), qz = position.z();
+    const float *coordinates[3] = { px.data(), py.data(), pz.data() };
+    const float squaredRadius = radius * radius;
+
+    std::array<Pending, KD_MAX_DEPTH + 1> stack;
+    int top = 0;
+    stack[top++] = { 0, unsigned(indices.size()), 0.0f };
+    while (top > 0) {
+        Pending node = stack[--top];
+        if (node.distance > squaredRadius) continue;
+
+        bool leaf = node.last - node.first <= KD_LEAF_SIZE;
+        unsigned int mid = node.first + (node.last - node.first) / 2;
+        unsigned int first = leaf ? node.first : mid, last = leaf ? node.last : mid + 1;
+        for (unsigned int i = first; i < last; i++) {
+            float dx = px[i] - qx, dy = py[i] - qy, dz = pz[i] - qz;
+            if (dx * dx + dy * dy + dz * dz <= squaredRadius) neighbors.push_back(indices[i]);
+        }
+        if (leaf) continue;
+
+        int axis = axes[mid];
+        float difference = position[axis] - coordinates[axis][mid];
+        Pending left = { node.first, mid, node.distance }, right = { mid + 1, node.last, node.distance };
+        Pending &far = difference < 0.0f ? right : left;
+        far.distance = std::max(node.distance, difference * difference);
+        stack[top++] = far;
+        stack[top++] = difference < 0.0f ? left : right;
+    }
+}
+
+std::size_t KDTree::radius(const std::vector<QVector3D> &positions, float radius, std::vector<std::size_t> &start, std::vector<unsigned int> &neighbors) const {
+    ScopedTimer timer("KDTree::radius");
+    std::size_t count = positions.size();
+    std::size_t blocks = (count + KD_QUERY_GRAIN - 1) / KD_QUERY_GRAIN;
+    start.assign(count + 1, 0);
+
+    // each block of queries fills its own list, the lists are then put end to end
+    std::vector<std::vector<unsigned int>> found(blocks);
+    parallelFor(0, blocks, 1, [&](std::size_t b0, std::size_t b1) {
+        std::vector<unsigned int> ball;
+        for (std::size_t b = b0; b < b1; b++) {
+            for (std::size_t q = b * KD_QUERY_GRAIN; q < std::min(count, (b + 1) * KD_QUERY_GRAIN); q++) {
+                this->radius(positions[q], radius, ball);
+                start[q + 1] = ball.size();
+                found[b].insert(found[b].end(), ball.begin(), ball.end());
+            }
+        }
+    });
+
+    for (std::size_t q = 0; q < count; q++) start[q + 1] += start[q];
+    neighbors.resize(start[count]);
+    parallelFor(0, blocks, 1, [&](std::size_t b0, std::size_t b1) {
+        for (std::size_t b = b0; b < b1; b++) std::copy(found[b].begin(), found[b].end(), neighbors.begin() + start[b * KD_QUERY_GRAIN]);
+    });
+    return neighbors.size();
+}
@@ -1,12 +1,16 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "openGLWidget.h"
+#include "profiler.h"
+#include "taskScheduler.h"
 
 #include <QSurfaceFormat>
 #include <QFileDialog>
 #include <QTimer>
 #include <QGraphicsPixmapItem>
 #include <QFileInfo>
+#include <QActionGroup>
+#include <QInputDialog>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), ui(new Ui::MainWindow)
@@ -24,19 +28,116 @@ MainWindow::MainWindow(QWidget *parent)
     ui->graphicsView->setScene(scene);
 
     connect(ui->actionLoad, &QAction::triggered, this, &MainWindow::onActionLoad);
+    connect(ui->actionOptimizeIndices, &QAction::triggered,
+            ui->openGLWidget, &OpenGLWidget::optimizeIndices);
+    connect(ui->actionOptimizeOnLoad, &QAction::toggled,
+            ui->openGLWidget, &OpenGLWidget::setOptimizeOnLoad);
+    connect(ui->actionCompactVertices, &QAction::toggled,
+            ui->openGLWidget, &OpenGLWidget::setCompactVertices);
+    connect(ui->actionPointCloud, &QAction::toggled, this, [=](bool enabled) {
+        ui->openGLWidget->setPointCloudMode(enabled);
+    });
+    connect(ui->actionVoxelSize, &QAction::triggered, this, [=]() {
+        bool ok = false;
+        double size = QInputDialog::getDouble(this, tr("Point cloud filter"), tr("Voxel size (0 keeps all the distinct points)"),
+                                              pointFilter.voxelSize, 0.0, 1e6, 4, &ok);
+        if (!ok) return;
+        pointFilter.voxelSize = size;
+        ui->openGLWidget->setPointFilter(pointFilter);
+    });
+    connect(ui->actionVoxelClosest, &QAction::toggled, this, [=](bool enabled) {
+        pointFilter.voxelPoint = enabled ? VoxelPoint::CLOSEST : VoxelPoint::CENTROID;
+        ui->openGLWidget->setPointFilter(pointFilter);
+    });
+    connect(ui->actionPointNormals, &QAction::toggled,
+            ui->openGLWidget, &OpenGLWidget::setPointNormals);
+    connect(ui->openGLWidget, &OpenGLWidget::pointsFiltered, this, [=](int pointsIn, int pointsOut) {
+        ui->statusbar->showMessage(tr("Points %1 -> %2 before the triangulation").arg(pointsIn).arg(pointsOut));
+    });
+    connect(ui->actionTriangulate, &QAction::triggered, this, [=]() {
+        handleMeshError(ui->openGLWidget->triangulatePointCloud());
+    });
+    connect(ui->actionSubdivideLoop, &QAction::triggered,
+            ui->openGLWidget, &OpenGLWidget::subdivideLoop);
+    connect(ui->actionSubdivideSqrt3, &QAction::triggered,
+            ui->openGLWidget, &OpenGLWidget::subdivideSqrt3);
+    auto askSmoothing = [=](SmoothingMethod method) {
+        bool ok = false;
+        int iterations = QInputDialog::getInt(this, tr("Smooth"), tr("Iterations"), 10, 1, 10000, 1, &ok);
+        if (ok) ui->openGLWidget->smooth(method, iterations);
+    };
+    connect(ui->actionSmoothLaplacian, &QAction::triggered, this, [=]() {
+        askSmoothing(SmoothingMethod::LAPLACIAN);
+    });
+    connect(ui->actionSmoothTaubin, &QAction::triggered, this, [=]() {
+        askSmoothing(SmoothingMethod::TAUBIN);
+    });
+    connect(ui->actionPreserveBoundary, &QAction::toggled,
+            ui->openGLWidget, &OpenGLWidget::setPreserveBoundary);
+    connect(ui->openGLWidget, &OpenGLWidget::smoothingProgress, this, [=](int iteration, int total) {
+        ui->statusbar->showMessage(tr("Smoothing %1 / %2").arg(iteration).arg(total));
+    });
+    connect(ui->actionSplitEdge, &QAction::triggered,
+            ui->openGLWidget, &OpenGLWidget::splitSelectedEdge);
+    connect(ui->actionFlipEdge, &QAction::triggered,
+            ui->openGLWidget, &OpenGLWidget::flipSelectedEdge);
+    connect(ui->actionCollapseEdge, &QAction::triggered,
+            ui->openGLWidget, &OpenGLWidget::collapseSelectedEdge);
+    connect(ui->actionInsertVertex, &QAction::triggered,
+            ui->openGLWidget, &OpenGLWidget::insertVertexInSelection);
+    connect(ui->pointSizeSpin, &QDoubleSpinBox::valueChanged,
+            ui->openGLWidget, &OpenGLWidget::setPointSize);
+    QActionGroup *orderGroup = new QActionGroup(this);
+    orderGroup->addAction(ui->actionOrderNone);
+    orderGroup->addAction(ui->actionOrderMorton);
+    orderGroup->addAction(ui->actionOrderHilbert);
+    connect(ui->actionOrderNone, &QAction::triggered, this, [=]() {
+        ui->openGLWidget->setSpatialOrder(SpatialOrder::NONE);
+    });
+    connect(ui->actionOrderMorton, &QAction::triggered, this, [=]() {
+        ui->openGLWidget->setSpatialOrder(SpatialOrder::MORTON);
+    });
+    connect(ui->actionOrderHilbert, &QAction::triggered, this, [=]() {
+        ui->openGLWidget->setSpatialOrder(SpatialOrder::HILBERT);
+    });
+    connect(ui->openGLWidget, &OpenGLWidget::indicesOptimized, this, [=](CacheStatistics before, CacheStatistics after) {
+        ui->statusbar->showMessage(tr("ACMR %1 -> %2, ATVR %3 -> %4")
+                                       .arg(before.acmr, 0, 'f', 3).arg(after.acmr, 0, 'f', 3)
+                                       .arg(before.atvr, 0, 'f', 3).arg(after.atvr, 0, 'f', 3));
+    });
     connect(ui->openGLWidget, &OpenGLWidget::verticesChanged, this, [=](unsigned int count) {
         ui->verticesCount->setText(QString::number(count));
     });
     connect(ui->openGLWidget, &OpenGLWidget::trianglesChanged, this, [=](unsigned int count) {
         ui->trianglesCount->setText(QString::number(count));
     });
+    connect(ui->openGLWidget, &OpenGLWidget::meshAnalyzed, this, [=](MeshStatistics statistics) {
+        QString text = tr("%1 parts, %2 loops, Euler %3").arg(statistics.components).arg(statistics.boundaryLoops).arg(statistics.eulerCharacteristic);
+        if (statistics.nonManifoldEdges > 0 || statistics.degenerateFaces > 0) text += tr(" (defects)");
+        ui->topologyCount->setText(statistics.faces == 0 ? QString("-") : text);
+        ui->topologyCount->setToolTip(QString::fromStdString(MeshAnalysis::summary(statistics)));
+    });
+    connect(ui->openGLWidget, &OpenGLWidget::chunksCulled, this, [=](int culled, int total) {
+        ui->culledCount->setText(QString("%1 / %2").arg(culled).arg(total));
+    });
+    connect(ui->openGLWidget, &OpenGLWidget::selectionChanged, this, [=](int face, int vertex) {
+        ui->pickedFaceIndex->setText(face < 0 ? QString("-") : QString::number(face));
+        ui->pickedVertexIndex->setText(vertex < 0 ? QString("-") : QString::number(vertex));
+    });
     connect(ui->wireframeCheck, &QCheckBox::toggled,
             ui->openGLWidget, &OpenGLWidget::setWireframe);
+    connect(ui->adaptiveCheck, &QCheckBox::toggled,
+            ui->openGLWidget, &OpenGLWidget::setAdaptiveRendering);
     connect(errorTimer, SIGNAL(timeout()), this, SLOT(clearErrorLabel()));
     connect(ui->saveButton, &QPushButton::clicked, this, &MainWindow::onSaveClicked);
     connect(ui->uploadTexAction, &QPushButton::clicked, this, &MainWindow::onLoadTexAction);
     connect(ui->deleteTexAction, &QPushButton::clicked, this, &MainWindow::onDeleteTexAction);
     connect(ui->openGLWidget, &OpenGLWidget::textureChanged, this, &MainWindow::updateTextureDisplay);
+    connect(ui->actionSaveTrace, &QAction::triggered, this, &MainWindow::onSaveTraceAction);
+
+    statsTimer = new QTimer(this);
+    connect(statsTimer, &QTimer::timeout, this, &MainWindow::updateStatistics);
+    statsTimer->start(500);
 
 
 }
@@ -57,7 +158,7 @@ void MainWindow::onActionLoad() {
         this,
         tr("Open a mesh file"),
         QString(),
-        tr("Mesh file (*.txt *.obj *.off);;All files (*.*)")
+        tr("Mesh file (*.txt *.obj *.off);;Chunk file (*.mvc);;All files (*.*)")
         );
 
     if (!filename.isEmpty()) {
@@ -83,6 +184,38 @@ void MainWindow::onSaveClicked() {
     }
 }
 
+void MainWindow::onSaveTraceAction() {
+    QString filename = QFileDialog::getSaveFileName(
+        this,
+        tr("Save a trace"),
+        QString("trace.json"),
+        tr("Chrome trace (*.json);;All files (*.*)")
+        );
+
+    if (!filename.isEmpty()) {
+        bool ok = Profiler::saveChromeTrace(filename.toStdString().c_str());
+        handleMeshError(ok ? MeshError::OK : MeshError::SAVE);
+    }
+}
+
+void MainWindow::updateStatistics() {
+    FrameStatistics stats = Profiler::getFrameStatistics();
+    if (stats.frames == 0) return;
+
+    // busy time of the worker threads since the last update
+    std::vector<WorkerStatistics> workers = TaskScheduler::getStatistics();
+    TaskScheduler::resetStatistics();
+    float busy = 0.0f;
+    for (const auto &w : workers) busy += w.utilization;
+    busy /= workers.size();
+
+    QString gpu = stats.gpuMs < 0.0f ? QString("-") : QString::number(stats.gpuMs, 'f', 2);
+    ui->statsLabel->setText(tr("Frame %1 ms (p95 %2 ms), GPU %3 ms\nTriangles %4, uploaded %5 KB\nThreads %6, busy %7 %")
+                                .arg(stats.frameMs, 0, 'f', 2).arg(stats.p95Ms, 0, 'f', 2).arg(gpu)
+                                .arg(stats.triangles).arg(stats.uploadedBytes / 1024)
+                                .arg(workers.size()).arg(busy * 100.0f, 0, 'f', 0));
+}
+
 void MainWindow::onLoadTexAction(){
     QString filename = QFileDialog::getOpenFileName(
         this,
@@ -1,95 +1,136 @@
 #include "mesh.h"
 #include "edgeKeyHash.h"
-
+#include "parallel.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <cmath>
 #include <iostream>
 #include <cstddef>
 #include <fstream>
 #include <sstream>
 #include <exception>
-#include <set>
-#include <queue>
-
-Mesh::Mesh() : normCoeff(0.0f), hasTexCoords(false) {}
-
-const std::vector<Vertex> &Mesh::getVertices() const {
-    return vertices;
-}
+#include <unordered_map>
+
+namespace {
+
+// bytes of a .txt file parsed by one task, cut at the end of a line
+const std::size_t PARSE_BLOCK_BYTES = 1 << 22;
+// faces or vertices processed by one task
+const std::size_t SEW_GRAIN = 1 << 14;
+const std::size_t NORMALS_GRAIN = 1 << 14;
+const std::size_t SUBDIVISION_GRAIN = 1 << 14;
+const float TWO_PI = 6.28318531f;
+// distance of the super triangle vertices of the triangulation, in sizes of the bounding box
+const float SUPER_TRIANGLE_SCALE = 20.0f;
+// buckets of halfedges matched per thread, more buckets balance the stealing better
+const std::size_t SEW_BUCKETS_PER_THREAD = 8;
+
+/**
+ * @brief Parse the numbers of a part of a .txt file, the comments start with '#' and end with the line.
+ * @return False if a token isn't a number, the numbers before it are kept.
+ */
+template <typename Scalar>
+bool parseNumbers(const char *begin, const char *end, std::vector<Scalar> &values) {
+    const char *p = begin;
+    while (true) {
+        while (p < end && std::isspace(static_cast<unsigned char>(*p))) p++;
+        if (p == end) return true;
+        if (*p == '#') {
+            while (p < end && *p != '\n') p++;
+            continue;
+        }
+        if (*p == '+') p++;
 
-const std::vector<unsigned int> Mesh::getIndices() const {
-    std::vector<unsigned int> indices;
-    for (auto &f: faces) {
-        indices.push_back(f.idVertices[0]);
-        indices.push_back(f.idVertices[1]);
-        indices.push_back(f.idVertices[2]);
+        Scalar value;
+        auto [next, error] = std::from_chars(p, end, value);
+        if (error != std::errc() || (next < end && !std::isspace(static_cast<unsigned char>(*next)))) return false;
+        values.push_back(value);
+        p = next;
     }
-
-    return indices;
 }
 
-const bool &Mesh::hasTexture() const {
-    return hasTexCoords;
-}
-
-void Mesh::clear() {
-    vertices.clear();
-    faces.clear();
-    hasTexCoords = false;
-}
-
-void Mesh::sew() {
-    for (auto& f : faces) f.idFaces.clear();
-
-    std::unordered_map<std::pair<int,int>, std::pair<int,int>, EdgeKeyHash> halfedge;
-
-    for (std::size_t fi = 0; fi < faces.size(); ++fi) {
-        faces[fi].idFaces.resize(3, -1);
-        auto& tri = faces[fi];
-        for (std::size_t e = 0; e < 3; ++e) {
-            int u = tri.idVertices[e];
-            int v = tri.idVertices[(e+1)%3];
-            auto key = std::make_pair(u, v);
-            halfedge.emplace(key, std::make_pair(fi, e));
-        }
+/**
+ * @brief Read the coordinates of the points of a .txt file, 3 per point.
+ * @return MeshError::OK if the function terminates correctly, other else.
+ */
+template <typename Scalar>
+int readCoordinates(const char *link, std::vector<Scalar> &coordinates) {
+    std::ifstream meshFile(link, std::ios::binary | std::ios::ate);
+    if (!meshFile.is_open()) {
+        return MeshError::READ;
     }
 
-    for (std::size_t fi = 0; fi < faces.size(); ++fi) {
-        auto& tri = faces[fi];
-        for (int e = 0; e < 3; ++e) {
-            if (tri.idFaces[e] != -1) continue;
-            int u = tri.idVertices[e];
-            int v = tri.idVertices[(e+1)%3];
-            auto oppKey = std::make_pair(v, u);
-            auto it = halfedge.find(oppKey);
-            if (it != halfedge.end()) {
-                int fj = it->second.first;
-                int ej = it->second.second;
-                tri.idFaces[e] = fj;
-                faces[fj].idFaces[ej] = fi;
-            }
-        }
+    // one read of the whole file, the parsing then runs at memory speed
+    std::string buffer(static_cast<std::size_t>(meshFile.tellg()), '\0');
+    meshFile.seekg(0);
+    if (!meshFile.read(buffer.data(), buffer.size())) {
+        return MeshError::READ;
     }
-}
+    meshFile.close();
 
-int Mesh::loadFile(const char* link) {
-    std::string filename(link);
-    std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
-    int ok;
+    const char *p = buffer.data(), *end = buffer.data() + buffer.size();
+    while (p < end) {
+        while (p < end && std::isspace(static_cast<unsigned char>(*p))) p++;
+        if (p == end || *p != '#') break;
+        while (p < end && *p != '\n') p++;
+    }
+    if (p == end) return MeshError::READ;
 
-    if (filename.size() >= 4 && filename.substr(filename.size() - 4) == ".off") {
-        ok = loadOFF(link);
-        return ok;
-    } else if (filename.size() >= 4 && filename.substr(filename.size() - 4) == ".obj") {
-        ok = loadOBJ(link);
-        return ok;
-    } else if (filename.size() >= 4 && filename.substr(filename.size() - 4) == ".txt") {
-        ok = loadTXT(link);
-        return ok;
-    } else {
+    unsigned long numVertices = 0;
+    auto [next, error] = std::from_chars(p, end, numVertices);
+    if (error != std::errc() || (next < end && !std::isspace(static_cast<unsigned char>(*next)))) {
         return MeshError::FORMAT;
     }
+    // a point takes at least 6 bytes with its separator, a larger count can't be in the file
+    if (numVertices > std::size_t(end - next) / 6) {
+        return MeshError::READ;
+    }
+
+    // blocks cut after a line end, their numbers put back together in order
+    std::vector<const char*> cuts = { next };
+    while (end - cuts.back() > std::ptrdiff_t(PARSE_BLOCK_BYTES)) {
+        const char *cut = std::find(cuts.back() + PARSE_BLOCK_BYTES, end, '\n');
+        cuts.push_back(cut == end ? end : cut + 1);
+        if (cut == end) break;
+    }
+    if (cuts.back() != end) cuts.push_back(end);
+
+    std::size_t blocks = cuts.size() - 1;
+    std::vector<std::vector<Scalar>> values(blocks);
+    std::vector<unsigned char> valid(blocks, 1);
+    parallelFor(0, blocks, 1, [&](std::size_t begin, std::size_t last) {
+        for (std::size_t b = begin; b < last; b++) valid[b] = parseNumbers(cuts[b], cuts[b + 1], values[b]);
+    });
+
+    // an invalid token only matters before the last expected point
+    std::size_t needed = 3 * std::size_t(numVertices);
+    coordinates.clear();
+    coordinates.reserve(needed);
+    for (std::size_t b = 0; b < blocks && coordinates.size() < needed; b++) {
+        std::size_t count = std::min(values[b].size(), needed - coordinates.size());
+        coordinates.insert(coordinates.end(), values[b].begin(), values[b].begin() + count);
+        if (!valid[b] && coordinates.size() < needed) return MeshError::READ;
+    }
+    if (coordinates.size() < needed) {
+        return MeshError::READ;
+    }
+
+    return MeshError::OK;
 }
 
-int Mesh::loadOFF(const char* link) {
+/**
+ * @brief Read the vertices and the faces of a .off file, the polygons are split in fans.
+ * @param addVertex : Called with the coordinates of each vertex, read as Scalar.
+ * @return MeshError::OK if the function terminates correctly, other else.
+ */
+template <typename Scalar, typename AddVertex>
+int readOFF(const char *link, AddVertex addVertex, std::vector<Triangle> &faces) {
     std::ifstream meshFile(link);
     if (!meshFile.is_open()) {
         return MeshError::READ;
@@ -122,14 +163,12 @@ int Mesh::loadOFF(const char* link) {
     if (!nextToken(token)) return MeshError::READ;
     numEdges = std::stoul(token);
 
-    clear();
-
     for (int i = 0; i < numVertices; ++i) {
-        float x, y, z;
+        Scalar x, y, z;
         if (!(meshFile >> x >> y >> z)) {
             return MeshError::READ;
         }
-        vertices.push_back(Vertex(x, y, z));
+        addVertex(x, y, z);
     }
 
     for (int i = 0; i < numFaces; ++i) {
@@ -148,7 +187,172 @@ int Mesh::loadOFF(const char* link) {
         }
     }
 
-    meshFile.close();
+    return MeshError::OK;
+}
+
+}
+
+Mesh::Mesh() : normCoeff(0.0f), hasTexCoords(false), loadOrder(SpatialOrder::NONE), pointNormals(false) {}
+
+Mesh::Mesh(std::vector<Vertex> vertices, std::vector<Triangle> faces, bool texCoords)
+    : vertices(std::move(vertices)), faces(std::move(faces)), normCoeff(0.0f), hasTexCoords(texCoords), loadOrder(SpatialOrder::NONE), pointNormals(false) {
+    sew();
+    computeNormals();
+}
+
+const std::vector<Vertex> &Mesh::getVertices() const {
+    return vertices;
+}
+
+const std::vector<Triangle> &Mesh::getFaces() const {
+    return faces;
+}
+
+const std::vector<unsigned int> Mesh::getIndices() const {
+    std::vector<unsigned int> indices;
+    for (auto &f: faces) {
+        indices.push_back(f.idVertices[0]);
+        indices.push_back(f.idVertices[1]);
+        indices.push_back(f.idVertices[2]);
+    }
+
+    return indices;
+}
+
+const bool &Mesh::hasTexture() const {
+    return hasTexCoords;
+}
+
+bool Mesh::isClosed() const {
+    for (const auto &f : faces) {
+        if (f.idFaces.size() != 3) return false;
+        for (auto neighbor : f.idFaces) {
+            if (neighbor == Triangle::NO_NEIGHBOR) return false;
+        }
+    }
+    return true;
+}
+
+void Mesh::clear() {
+    vertices.clear();
+    faces.clear();
+    hasTexCoords = false;
+    pointNormals = false;
+    pointFilterStatistics = PointFilterStatistics();
+    dirty = DirtyRegion();
+}
+
+void Mesh::sew() {
+    ScopedTimer timer("Mesh::sew");
+    std::size_t n = faces.size();
+    parallelFor(0, n, SEW_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t fi = first; fi < last; fi++) faces[fi].idFaces.assign(3, Triangle::NO_NEIGHBOR);
+    });
+
+    // the halfedges of an edge, in both directions, fall in the same bucket and keep the order of the faces,
+    // so each bucket is matched alone with the same result as a single pass over the faces
+    std::size_t blocks = n < SEW_GRAIN ? 1 : parallelThreadCount();
+    std::size_t buckets = blocks == 1 ? 1 : blocks * SEW_BUCKETS_PER_THREAD;
+    auto bucketOf = [&](int u, int v) {
+        return EdgeKeyHash()(std::make_pair(std::min(u, v), std::max(u, v))) % buckets;
+    };
+    auto blockBegin = [&](std::size_t b) { return n * b / blocks; };
+
+    std::vector<std::vector<std::size_t>> offsets(blocks, std::vector<std::size_t>(buckets, 0));
+    parallelFor(0, blocks, 1, [&](std::size_t first, std::size_t last) {
+        for (std::size_t b = first; b < last; b++) {
+            for (std::size_t fi = blockBegin(b); fi < blockBegin(b + 1); fi++) {
+                const auto &ids = faces[fi].idVertices;
+                for (int e = 0; e < 3; e++) offsets[b][bucketOf(ids[e], ids[(e + 1) % 3])]++;
+            }
+        }
+    });
+
+    std::vector<std::size_t> bucketBegin(buckets + 1, 0);
+    std::size_t offset = 0;
+    for (std::size_t k = 0; k < buckets; k++) {
+        bucketBegin[k] = offset;
+        for (std::size_t b = 0; b < blocks; b++) {
+            std::size_t count = offsets[b][k];
+            offsets[b][k] = offset;
+            offset += count;
+        }
+    }
+    bucketBegin[buckets] = offset;
+
+    // halfedge e of the face fi is stored as 3 * fi + e
+    std::vector<std::size_t> halfedges(offset);
+    parallelFor(0, blocks, 1, [&](std::size_t first, std::size_t last) {
+        for (std::size_t b = first; b < last; b++) {
+            for (std::size_t fi = blockBegin(b); fi < blockBegin(b + 1); fi++) {
+                const auto &ids = faces[fi].idVertices;
+                for (int e = 0; e < 3; e++) halfedges[offsets[b][bucketOf(ids[e], ids[(e + 1) % 3])]++] = 3 * fi + e;
+            }
+        }
+    });
+
+    parallelFor(0, buckets, 1, [&](std::size_t first, std::size_t last) {
+        std::unordered_map<std::pair<int,int>, std::pair<int,int>, EdgeKeyHash> halfedge;
+        for (std::size_t k = first; k < last; k++) {
+            halfedge.clear();
+            for (std::size_t h = bucketBegin[k]; h < bucketBegin[k + 1]; h++) {
+                std::size_t fi = halfedges[h] / 3, e = halfedges[h] % 3;
+                const auto &tri = faces[fi];
+                halfedge.emplace(std::make_pair(int(tri.idVertices[e]), int(tri.idVertices[(e + 1) % 3])),
+                                 std::make_pair(int(fi), int(e)));
+            }
+
+            for (std::size_t h = bucketBegin[k]; h < bucketBegin[k + 1]; h++) {
+                std::size_t fi = halfedges[h] / 3, e = halfedges[h] % 3;
+                auto &tri = faces[fi];
+                if (tri.idFaces[e] != Triangle::NO_NEIGHBOR) continue;
+                int u = tri.idVertices[e];
+                int v = tri.idVertices[(e + 1) % 3];
+                auto it = halfedge.find(std::make_pair(v, u));
+                if (it != halfedge.end()) {
+                    int fj = it->second.first;
+                    int ej = it->second.second;
+                    tri.idFaces[e] = fj;
+                    faces[fj].idFaces[ej] = fi;
+                }
+            }
+        }
+    });
+}
+
+int Mesh::loadFile(const char* link, SpatialOrder order) {
+    std::string filename(link);
+    loadOrder = order;
+    std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
+    int ok;
+
+    if (filename.size() >= 4 && filename.substr(filename.size() - 4) == ".off") {
+        ok = loadOFF(link);
+        return ok;
+    } else if (filename.size() >= 4 && filename.substr(filename.size() - 4) == ".obj") {
+        ok = loadOBJ(link);
+        return ok;
+    } else if (filename.size() >= 4 && filename.substr(filename.size() - 4) == ".txt") {
+        ok = loadTXT(link);
+        return ok;
+    } else {
+        return MeshError::FORMAT;
+    }
+}
+
+int Mesh::loadOFF(const char* link) {
+    ScopedTimer timer("Mesh::loadOFF");
+    std::vector<Vertex> offVertices;
+    std::vector<Triangle> offFaces;
+    int ok = readOFF<float>(link, [&](float x, float y, float z) { offVertices.push_back(Vertex(x, y, z)); }, offFaces);
+    if (ok != MeshError::OK) {
+        return ok;
+    }
+
+    clear();
+    vertices = std::move(offVertices);
+    faces = std::move(offFaces);
+    spatialReorder(loadOrder);
     sew();
     computeNormals();
 
@@ -156,6 +360,7 @@ int Mesh::loadOFF(const char* link) {
 }
 
 int Mesh::loadOBJ(const char* link) {
+    ScopedTimer timer("Mesh::loadOBJ");
     std::ifstream meshFile(link);
     if (!meshFile.is_open()) {
         return MeshError::READ;
@@ -226,6 +431,7 @@ int Mesh::loadOBJ(const char* link) {
     }
 
     meshFile.close();
+    spatialReorder(loadOrder);
     sew();
     if (tempNormals.empty()) computeNormals();
     if (!tempTexCoords.empty()) hasTexCoords = true;
@@ -234,57 +440,327 @@ int Mesh::loadOBJ(const char* link) {
 }
 
 int Mesh::loadTXT(const char* link) {
-    std::ifstream meshFile(link);
-    if (!meshFile.is_open()) {
-        return MeshError::READ;
+    std::vector<QVector3D> points;
+    int ok = readPoints(link, points);
+    if (ok != MeshError::OK) {
+        return ok;
     }
 
-    auto nextToken = [&](std::string &token) {
-        while (meshFile >> token) {
-            if (token[0] == '#') {
-                std::string line;
-                std::getline(meshFile, line);
-                continue;
+    clear();
+    pointFilterStatistics = PointFilter::filter(points, pointFilter);
+    triangulate(points);
+
+    return MeshError::OK;
+}
+
+int Mesh::loadPoints(const char* link, SpatialOrder order) {
+    std::vector<QVector3D> points;
+    int ok = readPoints(link, points);
+    if (ok != MeshError::OK) {
+        return ok;
+    }
+
+    clear();
+    loadOrder = order;
+    vertices.reserve(points.size());
+    for (const auto &p : points) vertices.push_back(Vertex(p));
+    spatialReorder(loadOrder);
+
+    return MeshError::OK;
+}
+
+int Mesh::loadCentered(const char* link, std::array<double, 3> &origin) {
+    ScopedTimer timer("Mesh::loadCentered");
+    std::string filename(link);
+    std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
+    std::string extension = filename.size() >= 4 ? filename.substr(filename.size() - 4) : std::string();
+
+    std::vector<double> coordinates;
+    std::vector<Triangle> offFaces;
+    int ok;
+    if (extension == ".off") {
+        ok = readOFF<double>(link, [&](double x, double y, double z) { coordinates.insert(coordinates.end(), { x, y, z }); }, offFaces);
+    } else if (extension == ".txt") {
+        ok = readCoordinates(link, coordinates);
+    } else {
+        return MeshError::FORMAT;
+    }
+    if (ok != MeshError::OK) {
+        return ok;
+    }
+
+    // the center is removed in double, the float positions are then small and keep the steps
+    origin = { 0.0, 0.0, 0.0 };
+    if (!coordinates.empty()) {
+        for (int axis = 0; axis < 3; axis++) {
+            double min = coordinates[axis], max = coordinates[axis];
+            for (std::size_t i = axis; i < coordinates.size(); i += 3) {
+                min = std::min(min, coordinates[i]);
+                max = std::max(max, coordinates[i]);
             }
-            return true;
+            origin[axis] = (min + max) / 2.0;
         }
-        return false;
-    };
+    }
+    std::vector<QVector3D> points(coordinates.size() / 3);
+    for (std::size_t i = 0; i < points.size(); i++) {
+        points[i] = QVector3D(coordinates[3 * i] - origin[0], coordinates[3 * i + 1] - origin[1], coordinates[3 * i + 2] - origin[2]);
+    }
 
-    int numVertices = 0;
-    std::string token;
-    if (!nextToken(token)) return MeshError::READ;
-    try {
-        numVertices = std::stoul(token);
-    } catch (const std::invalid_argument&) {
-        return MeshError::FORMAT;
-    } catch (const std::out_of_range&) {
+    clear();
+    if (extension == ".txt") {
+        pointFilterStatistics = PointFilter::filter(points, pointFilter);
+        triangulate(points);
+        return MeshError::OK;
+    }
+
+    vertices.reserve(points.size());
+    for (const auto &p : points) vertices.push_back(Vertex(p));
+    faces = std::move(offFaces);
+    spatialReorder(loadOrder);
+    sew();
+    computeNormals();
+
+    return MeshError::OK;
+}
+
+int Mesh::triangulatePoints() {
+    if (!faces.empty()) {
         return MeshError::FORMAT;
     }
 
+    std::vector<QVector3D> points;
+    points.reserve(vertices.size());
+    for (const auto &v : vertices) points.push_back(v.position);
+
     clear();
+    pointFilterStatistics = PointFilter::filter(points, pointFilter);
+    triangulate(points);
+
+    return MeshError::OK;
+}
 
-    initializeSuperTriangle();
+void Mesh::setPointFilter(const PointFilterOptions &options) {
+    pointFilter = options;
+}
 
-    for (int i = 0; i < numVertices; ++i) {
-        float x, y, z;
-        if (!(meshFile >> x >> y >> z)) {
-            return MeshError::READ;
+const PointFilterStatistics &Mesh::getPointFilterStatistics() const {
+    return pointFilterStatistics;
+}
+
+bool Mesh::isPointCloud() const {
+    return faces.empty() && !vertices.empty();
+}
+
+int Mesh::estimatePointNormals(const NormalEstimationOptions &options) {
+    if (!isPointCloud()) {
+        return MeshError::FORMAT;
+    }
+
+    std::vector<QVector3D> points(vertices.size());
+    for (std::size_t i = 0; i < vertices.size(); ++i) points[i] = vertices[i].position;
+    return setPointNormals(NormalEstimator::estimate(points, options));
+}
+
+int Mesh::setPointNormals(const std::vector<QVector3D> &normals) {
+    if (!isPointCloud() || normals.size() != vertices.size()) {
+        return MeshError::FORMAT;
+    }
+
+    for (std::size_t i = 0; i < vertices.size(); ++i) vertices[i].normal = normals[i];
+    pointNormals = true;
+
+    return MeshError::OK;
+}
+
+bool Mesh::hasPointNormals() const {
+    return pointNormals && isPointCloud();
+}
+
+int Mesh::readPoints(const char* link, std::vector<QVector3D> &points) {
+    ScopedTimer timer("Mesh::readPoints");
+    std::vector<float> coordinates;
+    int ok = readCoordinates(link, coordinates);
+    if (ok != MeshError::OK) {
+        return ok;
+    }
+
+    points.resize(coordinates.size() / 3);
+    for (std::size_t i = 0; i < points.size(); i++) {
+        points[i] = QVector3D(coordinates[3 * i], coordinates[3 * i + 1], coordinates[3 * i + 2]);
+    }
+
+    return MeshError::OK;
+}
+
+void Mesh::triangulate(const std::vector<QVector3D> &points) {
+    ScopedTimer timer("Mesh::triangulate");
+    const unsigned int none = Triangle::NO_NEIGHBOR;
+    std::size_t n = points.size();
+    vertices.reserve(n);
+    for (const auto &p : points) vertices.push_back(Vertex(p));
+
+    QVector3D center = getCenter();
+    float size = 0.0f;
+    for (const auto &p : points) size = std::max({ size, std::fabs(p.x() - center.x()), std::fabs(p.y() - center.y()) });
+    if (n < 3 || size == 0.0f) {
+        spatialReorder(loadOrder);
+        sew();
+        computeNormals();
+        return;
+    }
+
+    // a super triangle around the points, its vertices follow the points
+    float far = SUPER_TRIANGLE_SCALE * size;
+    std::array<QVector3D, 3> super = {{ QVector3D(center.x() - far, center.y() - far, 0.0f),
+                                        QVector3D(center.x() + far, center.y() - far, 0.0f),
+                                        QVector3D(center.x(), center.y() + far, 0.0f) }};
+    auto point = [&](unsigned int i) -> const QVector3D & { return i < n ? points[i] : super[i - n]; };
+
+    // the predicates run in double, the float coordinates are exact in it
+    auto orientation = [&](unsigned int a, unsigned int b, const QVector3D &p) {
+        const QVector3D &pa = point(a), &pb = point(b);
+        return (double(pb.x()) - pa.x()) * (double(p.y()) - pa.y()) - (double(pb.y()) - pa.y()) * (double(p.x()) - pa.x());
+    };
+    auto inCircle = [&](const std::array<unsigned int, 3> &f, const QVector3D &p) {
+        const QVector3D &a = point(f[0]), &b = point(f[1]), &c = point(f[2]);
+        double adx = double(a.x()) - p.x(), ady = double(a.y()) - p.y();
+        double bdx = double(b.x()) - p.x(), bdy = double(b.y()) - p.y();
+        double cdx = double(c.x()) - p.x(), cdy = double(c.y()) - p.y();
+        double det = adx * (bdy * (cdx * cdx + cdy * cdy) - (bdx * bdx + bdy * bdy) * cdy)
+                   - ady * (bdx * (cdx * cdx + cdy * cdy) - (bdx * bdx + bdy * bdy) * cdx)
+                   + (adx * adx + ady * ady) * (bdx * cdy - bdy * cdx);
+        return det > 0.0;
+    };
+
+    std::vector<std::array<unsigned int, 3>> tris = { { unsigned(n), unsigned(n + 1), unsigned(n + 2) } };
+    std::vector<std::array<unsigned int, 3>> adjacent = { { none, none, none } };
+    std::vector<std::size_t> visit = { 0 }; // last insertion which visited each face
+    tris.reserve(2 * n + 1);
+    adjacent.reserve(2 * n + 1);
+
+    // the points sorted along a curve, so the walk from the last faces is short
+    std::vector<QVector3D> relative(n);
+    for (std::size_t i = 0; i < n; i++) relative[i] = QVector3D(points[i].x() - center.x(), points[i].y() - center.y(), 0.0f);
+    std::vector<unsigned int> order = SpatialSort::sortPoints(relative, SpatialOrder::HILBERT);
+
+    struct Edge {
+        unsigned int a, b, outside;
+    };
+    std::vector<unsigned int> cavity, stack, created;
+    std::vector<Edge> boundary;
+    std::size_t start = 0, skipped = 0, failed = 0, insertion = 0;
+
+    for (unsigned int id : order) {
+        const QVector3D &p = points[id];
+        insertion++;
+
+        // walk towards the point, a walk in a Delaunay triangulation never loops
+        std::size_t t = start, steps = 0;
+        for (bool moved = true; moved && steps <= tris.size(); steps++) {
+            moved = false;
+            for (int e = 0; e < 3; e++) {
+                if (orientation(tris[t][e], tris[t][(e + 1) % 3], p) < 0 && adjacent[t][e] != none) {
+                    t = adjacent[t][e];
+                    moved = true;
+                    break;
+                }
+            }
+        }
+        if (steps > tris.size()) {
+            failed++;
+            continue;
         }
+        if (std::any_of(tris[t].begin(), tris[t].end(), [&](unsigned int v) { return point(v) == p; })) {
+            skipped++;
+            continue;
+        }
+
+        // Bowyer-Watson : the faces whose circumcircle holds the point form a star around it
+        cavity.assign(1, unsigned(t));
+        stack.assign(1, unsigned(t));
+        visit[t] = insertion;
+        boundary.clear();
+        bool star = false;
+        while (true) {
+            while (!stack.empty()) {
+                unsigned int c = stack.back();
+                stack.pop_back();
+                for (int e = 0; e < 3; e++) {
+                    unsigned int o = adjacent[c][e];
+                    if (o != none && visit[o] == insertion) continue;
+                    if (o != none && inCircle(tris[o], p)) {
+                        visit[o] = insertion;
+                        cavity.push_back(o);
+                        stack.push_back(o);
+                    } else {
+                        boundary.push_back({ tris[c][e], tris[c][(e + 1) % 3], o });
+                    }
+                }
+            }
 
-        int newPointIndex = insert(x, y, z);
-        if (newPointIndex == -1) {
-            std::cerr << "Failed to insert point " << i << ": (" << x << ", " << y << ", " << z << ")\n";
+            // a rounded predicate can leave an edge facing away from the point, its outside face joins the cavity
+            auto facingAway = std::find_if(boundary.begin(), boundary.end(),
+                                           [&](const Edge &edge) { return orientation(edge.a, edge.b, p) <= 0; });
+            if (facingAway == boundary.end()) {
+                star = boundary.size() == cavity.size() + 2;
+                break;
+            }
+            unsigned int o = facingAway->outside;
+            if (o == none) break;
+            visit[o] = insertion;
+            cavity.push_back(o);
+            stack = cavity;
+            boundary.clear();
+        }
+        if (!star) {
+            failed++;
+            continue;
+        }
+
+        // one face per boundary edge, in the slots of the cavity then at the end
+        created.resize(boundary.size());
+        for (std::size_t i = 0; i < boundary.size(); i++) {
+            if (i < cavity.size()) {
+                created[i] = cavity[i];
+            } else {
+                created[i] = tris.size();
+                tris.emplace_back();
+                adjacent.emplace_back();
+                visit.push_back(0);
+            }
+        }
+        for (std::size_t i = 0; i < boundary.size(); i++) {
+            const Edge &edge = boundary[i];
+            unsigned int f = created[i];
+            tris[f] = { edge.a, edge.b, id };
+            adjacent[f] = { edge.outside, none, none };
+            if (edge.outside != none) {
+                const auto &o = tris[edge.outside];
+                for (int e = 0; e < 3; e++) {
+                    if (o[e] == edge.b && o[(e + 1) % 3] == edge.a) adjacent[edge.outside][e] = f;
+                }
+            }
+        }
+        // the boundary is a loop around the point, the faces meet at its vertices
+        for (std::size_t i = 0; i < boundary.size(); i++) {
+            for (std::size_t j = 0; j < boundary.size(); j++) {
+                if (boundary[j].a == boundary[i].b) adjacent[created[i]][1] = created[j];
+                if (boundary[j].b == boundary[i].a) adjacent[created[i]][2] = created[j];
+            }
         }
+        start = created[0];
     }
 
-    meshFile.close();
+    // the faces of the super triangle are removed
+    for (const auto &t : tris) {
+        if (t[0] < n && t[1] < n && t[2] < n) faces.push_back(Triangle(t[0], t[1], t[2]));
+    }
+    if (skipped > 0) std::cerr << "Mesh::triangulate : " << skipped << " duplicated points left out\n";
+    if (failed > 0) std::cerr << "Mesh::triangulate : failed to insert " << failed << " points\n";
 
-    removeSuperTriangle();
+    spatialReorder(loadOrder);
     sew();
     computeNormals();
-
-    return MeshError::OK;
 }
 
 int Mesh::saveFile(const char *link) {
@@ -410,10 +886,11 @@ int Mesh::saveTXT(const char *link) const {
     return MeshError::OK;
 }
 
-int Mesh::findNeighbor(unsigned int triIndex, unsigned int a, unsigned int b) const {
-    int res = -1;
+unsigned int Mesh::findNeighbor(unsigned int triIndex, unsigned int a, unsigned int b) const {
+    unsigned int res = Triangle::NO_NEIGHBOR;
 
-    for (int i: faces[triIndex].idFaces) {
+    for (unsigned int i: faces[triIndex].idFaces) {
+        if (i == Triangle::NO_NEIGHBOR) continue; // boundary edge
         const Triangle &t = faces[i];
         if ((a == t.idVertices[1] && b == t.idVertices[0]) ||
             (a == t.idVertices[2] && b == t.idVertices[1]) ||
@@ -435,29 +912,28 @@ float Mesh::faceArea(int faceIndex) const {
 }
 
 void Mesh::computeNormals() {
-    for (auto &v : vertices) {
-        v.normal = QVector3D(0,0,0);
-    }
-
-    for (std::size_t i = 0; i < faces.size(); i ++) {
-        unsigned int i0 = faces[i].idVertices[0];
-        unsigned int i1 = faces[i].idVertices[1];
-        unsigned int i2 = faces[i].idVertices[2];
-
-        QVector3D &v0 = vertices[i0].position;
-        QVector3D &v1 = vertices[i1].position;
-        QVector3D &v2 = vertices[i2].position;
-
-        QVector3D normal = QVector3D::crossProduct(v1 - v0, v2 - v0).normalized();
+    ScopedTimer timer("Mesh::computeNormals");
+    std::vector<QVector3D> faceNormals(faces.size());
+    parallelFor(0, faces.size(), NORMALS_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            const QVector3D &v0 = vertices[faces[i].idVertices[0]].position;
+            const QVector3D &v1 = vertices[faces[i].idVertices[1]].position;
+            const QVector3D &v2 = vertices[faces[i].idVertices[2]].position;
+            faceNormals[i] = QVector3D::crossProduct(v1 - v0, v2 - v0).normalized();
+        }
+    });
 
-        vertices[i0].normal += normal;
-        vertices[i1].normal += normal;
-        vertices[i2].normal += normal;
-    }
+    // faces around each vertex in increasing order, each vertex sums its own normals in the same order as a serial pass
+    std::vector<unsigned int> firstFace, faceList;
+    vertexFaces(firstFace, faceList);
 
-    for (auto &v : vertices) {
-        v.normal.normalize();
-    }
+    parallelFor(0, vertices.size(), NORMALS_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t v = first; v < last; v++) {
+            QVector3D normal(0, 0, 0);
+            for (unsigned int k = firstFace[v]; k < firstFace[v + 1]; k++) normal += faceNormals[faceList[k]];
+            vertices[v].normal = normal.normalized();
+        }
+    });
 }
 
 
@@ -485,54 +961,6 @@ float Mesh::getBoundingRadius() const {
     return maxDist;
 }
 
-void Mesh::initializeSuperTriangle() {
-    vertices.push_back(QVector3D(-100000.0f, -100000.0f, 0.0f));
-    vertices.push_back(QVector3D(100000.0f, -100000.0f, 0.0f));
-    vertices.push_back(QVector3D(0.0f, 100000.0f, 0.0f));
-    faces.push_back(Triangle(0, 1, 2));
-}
-
-void Mesh::removeSuperTriangle() {
-    const int superVertex1 = 0;
-    const int superVertex2 = 1;
-    const int superVertex3 = 2;
-
-    std::vector<Triangle> validFaces;
-    validFaces.reserve(faces.size());
-
-    for (const Triangle& face : faces) {
-        bool containsSuperVertex = false;
-
-        for (int i = 0; i < 3; i++) {
-            int vertexId = face.idVertices[i];
-            if (vertexId == superVertex1 || vertexId == superVertex2 || vertexId == superVertex3) {
-                containsSuperVertex = true;
-                break;
-            }
-        }
-
-        if (!containsSuperVertex) {
-            validFaces.push_back(face);
-        }
-    }
-
-    vertices.erase(vertices.begin(), vertices.begin() + 3);
-
-    for (Triangle& face : validFaces) {
-        for (int i = 0; i < 3; i++) {
-            if (face.idVertices[i] >= 3) {
-                face.idVertices[i] -= 3;
-            } else {
-                std::cerr << "Error: Triangle still references super-triangle vertex!\n";
-            }
-        }
-
-        face.idFaces.clear();
-    }
-
-    faces = std::move(validFaces);
-}
-
 void Mesh::triangleSplit(int p, int triIndex) {
     if (triIndex<0 || triIndex>=faces.size() || p<0 || p>=vertices.size()) return;
     Triangle tri = faces[triIndex];
@@ -540,9 +968,9 @@ void Mesh::triangleSplit(int p, int triIndex) {
     int v = tri.idVertices[1];
     int w = tri.idVertices[2];
 
-    int nei1Index = findNeighbor(triIndex, u, v);
-    int nei2Index = findNeighbor(triIndex, v, w);
-    int nei3Index = findNeighbor(triIndex, w, u);
+    unsigned int nei1Index = findNeighbor(triIndex, u, v);
+    unsigned int nei2Index = findNeighbor(triIndex, v, w);
+    unsigned int nei3Index = findNeighbor(triIndex, w, u);
 
     faces[triIndex] = Triangle(u,v,p);
     faces.push_back(Triangle(v,w,p));
@@ -550,9 +978,9 @@ void Mesh::triangleSplit(int p, int triIndex) {
     int tri2Index = faces.size() - 2;
     int tri3Index = faces.size() - 1;
 
-    if (nei1Index != -1) faces[triIndex].idFaces.push_back(nei1Index);
+    if (nei1Index != Triangle::NO_NEIGHBOR) faces[triIndex].idFaces.push_back(nei1Index);
 
-    if (nei2Index != -1) {
+    if (nei2Index != Triangle::NO_NEIGHBOR) {
         auto& nei2 = faces[nei2Index].idFaces;
         auto it = std::find(nei2.begin(), nei2.end(), triIndex);
         if (it != nei2.end()) nei2.erase(it);
@@ -560,7 +988,7 @@ void Mesh::triangleSplit(int p, int triIndex) {
         faces[tri2Index].idFaces.push_back(nei2Index);
     }
 
-    if (nei3Index != -1) {
+    if (nei3Index != Triangle::NO_NEIGHBOR) {
         auto& nei3 = faces[nei3Index].idFaces;
         auto it = std::find(nei3.begin(), nei3.end(), triIndex);
         if (it != nei3.end()) nei3.erase(it);
@@ -601,10 +1029,10 @@ void Mesh::edgeFlip(int t1, int t2) {
     faces[t1].idVertices[cLocal] = tri2.idVertices[dLocal];
     faces[t2].idVertices[cLocal_t2] = tri1.idVertices[aLocal];
 
-    int nei1To2Index = findNeighbor(t1, c, faces[t1].idVertices[aLocal]);
-    int nei2To1Index = findNeighbor(t2, b, faces[t2].idVertices[dLocal]);
+    unsigned int nei1To2Index = findNeighbor(t1, c, faces[t1].idVertices[aLocal]);
+    unsigned int nei2To1Index = findNeighbor(t2, b, faces[t2].idVertices[dLocal]);
 
-    if (nei1To2Index != -1) {
+    if (nei1To2Index != Triangle::NO_NEIGHBOR) {
         auto& nei1To2 = faces[nei1To2Index].idFaces;
         auto it = std::find(nei1To2.begin(), nei1To2.end(), t1);
         if (it != nei1To2.end()) nei1To2.erase(it);
@@ -612,7 +1040,7 @@ void Mesh::edgeFlip(int t1, int t2) {
         faces[t2].idFaces.push_back(nei1To2Index);
     }
 
-    if (nei2To1Index != -1) {
+    if (nei2To1Index != Triangle::NO_NEIGHBOR) {
         auto& nei2To1 = faces[nei2To1Index].idFaces;
         auto it = std::find(nei2To1.begin(), nei2To1.end(), t2);
         if (it != nei2To1.end()) nei2To1.erase(it);
@@ -624,45 +1052,14 @@ void Mesh::edgeFlip(int t1, int t2) {
 void Mesh::edgeSplit(int p, int t1, int t2) {
     if (t1<0 || t1>=faces.size() || t2<0 || t2>=faces.size() || p<0 || p>=vertices.size()) return;
 
-    auto tri1 = faces[t1];
-    auto tri2 = faces[t2];
-
-    std::pair<int, int> commonEdge = tri1.findCommonEdge(tri2);
-    if (commonEdge.first == -1 || commonEdge.second == -1) {
+    const auto &neighbors = faces[t1].idFaces;
+    auto it = std::find(neighbors.begin(), neighbors.end(), static_cast<unsigned int>(t2));
+    if (neighbors.size() != 3 || it == neighbors.end()) {
         std::cerr << "Common edge not found\n";
         return;
     }
 
-    int b = commonEdge.first;
-    int c = commonEdge.second;
-
-    int a = -1;
-    int d = -1;
-
-    for (int i = 0; i < 3; i++) {
-        if (tri1.idVertices[i] != b && tri1.idVertices[i] != c) {
-            a = tri1.idVertices[i];
-            break;
-        }
-    }
-
-    for (int i = 0; i < 3; i++) {
-        if (tri2.idVertices[i] != b && tri2.idVertices[i] != c) {
-            d = tri2.idVertices[i];
-            break;
-        }
-    }
-
-    if (a == -1 || d == -1) return;
-
-    faces[t1] = Triangle(a, b, p);
-    faces[t2] = Triangle(b, p, d);
-
-    faces.push_back(Triangle(a, p, c));
-    faces.push_back(Triangle(p, c, d));
-
-    sew();
-    computeNormals();
+    updateNormals(splitEdgeAt(t1, it - neighbors.begin(), p));
 }
 
 float Mesh::orientationTest(int p, int q, int r) const {
@@ -708,33 +1105,6 @@ int Mesh::pointInTriangle(int p, int triIndex) const {
     return -1;
 }
 
-int Mesh::insert(float x, float y, float z) {
-    vertices.push_back(QVector3D(x, y, z));
-    int pIndex = vertices.size() - 1;
-
-    int containingTriangle = -1;
-    for (std::size_t i = 0; i < faces.size(); i++) {
-        int result = pointInTriangle(pIndex, i);
-        if (result >= 0) {
-            containingTriangle = i;
-            break;
-        }
-    }
-
-    if (containingTriangle == -1) {
-        std::cerr << "Warning: Point (" << x << ", " << y << ", " << z
-                  << ") not inside any triangle during insertion\n";
-        vertices.pop_back();
-        return -1;
-    }
-
-    triangleSplit(pIndex, containingTriangle);
-    lawsonLocalUpdate(pIndex);
-
-    return pIndex;
-}
-
-
 bool Mesh::isInCircumcircleNorm(int a, int b, int c, int d) const {
     if (a < 0 || a >= vertices.size() || b < 0 || b >= vertices.size() ||
         c < 0 || c >= vertices.size() || d < 0 || d >= vertices.size()) {
@@ -800,229 +1170,715 @@ bool Mesh::isLocallyDelaunay(int t1, int t2) const {
     return !isInCircumcircleNorm(a, b, c, d);
 }
 
-void Mesh::lawsonAlgorithm() {
-    std::queue<std::pair<int, int>> edgeQueue;
-    std::set<std::pair<int, int>> processed;
-    int maxIterations = faces.size() * faces.size();
-    int iterations = 0;
+void Mesh::normalize() {
+    normCoeff = getBoundingRadius();
+    float scale = 30.0f / normCoeff;
 
-    for (std::size_t i = 0; i < faces.size(); i++) {
-        for (int j : faces[i].idFaces) {
-            if (i < j) {
-                edgeQueue.push({i, j});
-            }
-        }
+    for (auto& vertex : vertices) {
+        vertex.position = vertex.position * scale;
     }
+}
 
-    while (!edgeQueue.empty() && iterations < maxIterations) {
-        iterations++;
+void Mesh::deNormalize() {
+    float scale = normCoeff / 30.0f;
 
-        auto [t1, t2] = edgeQueue.front();
-        edgeQueue.pop();
+    for (auto& vertex : vertices) {
+        vertex.position = vertex.position * scale;
+    }
 
-        if (t1 >= (int)faces.size() || t2 >= (int)faces.size()) continue;
+    normCoeff = 0.0f;
+}
 
-        std::pair<int, int> edgePair = {std::min(t1, t2), std::max(t1, t2)};
-        if (processed.find(edgePair) != processed.end()) continue;
-        processed.insert(edgePair);
+void Mesh::reorder(const std::vector<unsigned int> &vertexOrder, const std::vector<unsigned int> &faceOrder) {
+    if (!vertexOrder.empty()) {
+        std::vector<unsigned int> remap(vertices.size());
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertexOrder.size());
+        for (std::size_t i = 0; i < vertexOrder.size(); ++i) {
+            reordered.push_back(vertices[vertexOrder[i]]);
+            remap[vertexOrder[i]] = i;
+        }
+        vertices = std::move(reordered);
 
-        if (!isLocallyDelaunay(t1, t2)) {
-            std::vector<unsigned int> oldNeighbors_t1 = faces[t1].idFaces;
-            std::vector<unsigned int> oldNeighbors_t2 = faces[t2].idFaces;
+        for (auto &f : faces) {
+            for (auto &v : f.idVertices) v = remap[v];
+        }
+    }
 
-            edgeFlip(t1, t2);
+    if (!faceOrder.empty()) {
+        std::vector<unsigned int> remap(faces.size());
+        for (std::size_t i = 0; i < faceOrder.size(); ++i) remap[faceOrder[i]] = i;
 
-            for (int neighbor : faces[t1].idFaces) {
-                if (neighbor != t2) {
-                    std::pair<int, int> newEdge = {std::min(t1, neighbor), std::max(t1, neighbor)};
-                    if (processed.find(newEdge) == processed.end()) {
-                        edgeQueue.push({t1, neighbor});
-                    }
-                }
+        std::vector<Triangle> reordered;
+        reordered.reserve(faceOrder.size());
+        for (unsigned int old : faceOrder) {
+            reordered.push_back(std::move(faces[old]));
+            for (auto &neighbor : reordered.back().idFaces) {
+                if (neighbor != Triangle::NO_NEIGHBOR) neighbor = remap[neighbor];
             }
+        }
+        faces = std::move(reordered);
+    }
+}
 
-            for (int neighbor : faces[t2].idFaces) {
-                if (neighbor != t1) {
-                    std::pair<int, int> newEdge = {std::min(t2, neighbor), std::max(t2, neighbor)};
-                    if (processed.find(newEdge) == processed.end()) {
-                        edgeQueue.push({t2, neighbor});
-                    }
-                }
-            }
+void Mesh::optimizeIndices(CacheStatistics *before, CacheStatistics *after) {
+    ScopedTimer timer("Mesh::optimizeIndices");
+    if (before) *before = IndexOptimizer::simulateVertexCache(getIndices(), vertices.size());
+
+    reorder({}, IndexOptimizer::optimizeVertexCache(getIndices(), vertices.size()));
+    reorder({}, IndexOptimizer::optimizeOverdraw(getIndices(), vertices));
+    reorder(IndexOptimizer::optimizeVertexFetch(getIndices(), vertices.size()), {});
+
+    if (after) *after = IndexOptimizer::simulateVertexCache(getIndices(), vertices.size());
+}
 
-            processed.clear();
+void Mesh::spatialReorder(SpatialOrder order) {
+    if (order == SpatialOrder::NONE) return;
+    ScopedTimer timer("Mesh::spatialReorder");
+
+    std::vector<QVector3D> points(vertices.size());
+    for (std::size_t i = 0; i < vertices.size(); ++i) points[i] = vertices[i].position;
+    reorder(SpatialSort::sortPoints(points, order), {});
+
+    points.resize(faces.size());
+    for (std::size_t i = 0; i < faces.size(); ++i) {
+        const auto &v = faces[i].idVertices;
+        points[i] = (vertices[v[0]].position + vertices[v[1]].position + vertices[v[2]].position) / 3.0f;
+    }
+    reorder({}, SpatialSort::sortPoints(points, order));
+}
+
+std::size_t Mesh::weld(float tolerance) {
+    ScopedTimer timer("Mesh::weld");
+    auto key = [&](const QVector3D &p) {
+        const float coordinates[3] = { p.x(), p.y(), p.z() };
+        PositionKey k;
+        for (int axis = 0; axis < 3; axis++) {
+            k[axis] = tolerance > 0.0f ? std::llround(coordinates[axis] / tolerance) : coordinateBits(coordinates[axis]);
         }
+        return k;
+    };
+
+    std::unordered_map<PositionKey, unsigned int, PositionKeyHash> first;
+    first.reserve(vertices.size());
+    std::vector<unsigned int> remap(vertices.size());
+    std::vector<Vertex> kept;
+    for (std::size_t v = 0; v < vertices.size(); ++v) {
+        auto [it, inserted] = first.emplace(key(vertices[v].position), kept.size());
+        if (inserted) kept.push_back(vertices[v]);
+        remap[v] = it->second;
     }
 
-    if (iterations >= maxIterations) {
-        std::cerr << "Lawson algorithm reached maximum iterations limit\n";
+    std::size_t removed = vertices.size() - kept.size();
+    vertices = std::move(kept);
+
+    std::vector<Triangle> welded;
+    welded.reserve(faces.size());
+    for (const auto &f : faces) {
+        unsigned int a = remap[f.idVertices[0]], b = remap[f.idVertices[1]], c = remap[f.idVertices[2]];
+        if (a != b && b != c && c != a) welded.push_back(Triangle(a, b, c));
+    }
+    faces = std::move(welded);
+
+    sew();
+    computeNormals();
+    return removed;
+}
+
+bool DirtyRegion::isEmpty() const {
+    return vertices.empty() && faces.empty();
+}
+
+void DirtyRegion::addVertex(unsigned int vertex) {
+    vertices.push_back(vertex);
+}
+
+void DirtyRegion::addFace(unsigned int face) {
+    faces.push_back(face);
+}
+
+void DirtyRegion::compact() {
+    for (auto *indices : { &vertices, &faces }) {
+        std::sort(indices->begin(), indices->end());
+        indices->erase(std::unique(indices->begin(), indices->end()), indices->end());
     }
 }
 
-void Mesh::lawsonLocalUpdate(int p) {
-    if (p < 0 || p >= (int)vertices.size()) return;
+const DirtyRegion &Mesh::getDirtyRegion() const {
+    return dirty;
+}
 
-    std::queue<std::pair<int, int>> edgeQueue;
-    std::set<std::pair<int, int>> processed;
-    int maxIterations = 100;
-    int iterations = 0;
+void Mesh::clearDirtyRegion() {
+    dirty = DirtyRegion();
+}
 
-    std::vector<int> incidentTriangles;
-    for (int i = 0; i < (int)faces.size(); i++) {
-        const Triangle& tri = faces[i];
-        for (int j = 0; j < 3; j++) {
-            if (tri.idVertices[j] == p) {
-                incidentTriangles.push_back(i);
-                break;
-            }
+std::vector<unsigned int> Mesh::facesAround(unsigned int face, unsigned int vertex, bool *boundary) const {
+    std::vector<unsigned int> around;
+    bool open = false;
+
+    // turn across the edge ending at the vertex, then from the start the other way if the fan is open
+    unsigned int f = face;
+    do {
+        around.push_back(f);
+        int corner = faces[f].localIndex(vertex);
+        f = faces[f].idFaces[(corner + 2) % 3];
+    } while (f != Triangle::NO_NEIGHBOR && f != face && around.size() <= faces.size());
+
+    if (f == Triangle::NO_NEIGHBOR) {
+        open = true;
+        f = face;
+        while (true) {
+            int corner = faces[f].localIndex(vertex);
+            f = faces[f].idFaces[corner];
+            if (f == Triangle::NO_NEIGHBOR || f == face || around.size() > faces.size()) break;
+            around.push_back(f);
         }
     }
 
-    for (int triIndex : incidentTriangles) {
-        const Triangle& tri = faces[triIndex];
+    if (boundary) *boundary = open;
+    return around;
+}
 
-        int oppositeVertex1 = -1, oppositeVertex2 = -1;
-        for (int j = 0; j < 3; j++) {
-            if (tri.idVertices[j] != p) {
-                if (oppositeVertex1 == -1) {
-                    oppositeVertex1 = tri.idVertices[j];
-                } else {
-                    oppositeVertex2 = tri.idVertices[j];
-                    break;
-                }
-            }
+void Mesh::setNeighbor(unsigned int face, unsigned int a, unsigned int b, unsigned int neighbor) {
+    if (face == Triangle::NO_NEIGHBOR) return;
+    Triangle &t = faces[face];
+    for (int e = 0; e < 3; e++) {
+        if (t.idVertices[e] == a && t.idVertices[(e + 1) % 3] == b) t.idFaces[e] = neighbor;
+    }
+}
+
+unsigned int Mesh::removeFace(unsigned int face) {
+    unsigned int last = faces.size() - 1;
+    if (face != last) {
+        faces[face] = std::move(faces[last]);
+        const Triangle &moved = faces[face];
+        for (int e = 0; e < 3; e++) {
+            setNeighbor(moved.idFaces[e], moved.idVertices[(e + 1) % 3], moved.idVertices[e], face);
         }
+    }
+    faces.pop_back();
+    dirty.addFace(face);
+    dirty.addFace(last);
+    return last;
+}
 
-        for (int adjTriIndex : faces[triIndex].idFaces) {
-            if (adjTriIndex != triIndex) {
-                const Triangle& adjTri = faces[adjTriIndex];
-                bool sharesOppositeEdge = false;
-                int sharedCount = 0;
+void Mesh::updateNormals(const std::vector<unsigned int> &touched) {
+    auto faceNormal = [&](unsigned int f) {
+        const auto &ids = faces[f].idVertices;
+        const QVector3D &v0 = vertices[ids[0]].position;
+        return QVector3D::crossProduct(vertices[ids[1]].position - v0, vertices[ids[2]].position - v0).normalized();
+    };
 
-                for (int k = 0; k < 3; k++) {
-                    int adjVertex = adjTri.idVertices[k];
-                    if (adjVertex == oppositeVertex1 || adjVertex == oppositeVertex2) {
-                        sharedCount++;
-                    }
-                }
+    std::vector<unsigned int> done;
+    for (unsigned int f : touched) {
+        dirty.addFace(f);
+        for (unsigned int v : faces[f].idVertices) {
+            if (std::find(done.begin(), done.end(), v) != done.end()) continue;
+            done.push_back(v);
+
+            // summed in increasing face order like computeNormals, the result doesn't depend on the edits
+            std::vector<unsigned int> around = facesAround(f, v);
+            std::sort(around.begin(), around.end());
+            QVector3D normal(0, 0, 0);
+            for (unsigned int g : around) normal += faceNormal(g);
+            vertices[v].normal = normal.normalized();
+            dirty.addVertex(v);
+        }
+    }
+}
 
-                if (sharedCount == 2) {
-                    std::pair<int, int> edgePair = {std::min(triIndex, adjTriIndex),
-                                                    std::max(triIndex, adjTriIndex)};
-                    if (processed.find(edgePair) == processed.end()) {
-                        edgeQueue.push({triIndex, adjTriIndex});
-                    }
-                }
+std::vector<unsigned int> Mesh::splitEdgeAt(unsigned int face, int edge, unsigned int m) {
+    // f = (a, b, c) and its neighbor g = (b, a, d) become (a, m, c), (m, b, c), (b, m, d) and (m, a, d)
+    unsigned int f = face;
+    unsigned int a = faces[f].idVertices[edge];
+    unsigned int b = faces[f].idVertices[(edge + 1) % 3];
+    unsigned int c = faces[f].idVertices[(edge + 2) % 3];
+    unsigned int nbc = faces[f].idFaces[(edge + 1) % 3];
+    unsigned int nca = faces[f].idFaces[(edge + 2) % 3];
+    unsigned int g = faces[f].idFaces[edge];
+    const unsigned int none = Triangle::NO_NEIGHBOR;
+
+    unsigned int f2 = faces.size();
+    unsigned int g2 = g == none ? none : f2 + 1;
+    faces.push_back(Triangle(m, b, c));
+    faces[f2].idFaces = { g, nbc, f };
+    setNeighbor(nbc, c, b, f2);
+
+    if (g != none) {
+        int eg = faces[g].localIndex(b);
+        unsigned int d = faces[g].idVertices[(eg + 2) % 3];
+        unsigned int nad = faces[g].idFaces[(eg + 1) % 3];
+        unsigned int ndb = faces[g].idFaces[(eg + 2) % 3];
+
+        faces.push_back(Triangle(m, a, d));
+        faces[g2].idFaces = { f, nad, g };
+        setNeighbor(nad, d, a, g2);
+
+        faces[g].idVertices = { b, m, d };
+        faces[g].idFaces = { f2, g2, ndb };
+    }
+
+    faces[f].idVertices = { a, m, c };
+    faces[f].idFaces = { g2, f2, nca };
+
+    std::vector<unsigned int> touched = { f2, f };
+    if (g != none) touched.insert(touched.begin() + 1, { g2, g });
+    return touched;
+}
+
+int Mesh::splitEdge(unsigned int face, int edge, const QVector3D &position) {
+    if (face >= faces.size() || faces[face].idFaces.size() != 3 || edge < 0 || edge > 2) return -1;
+
+    // the texture coordinates of the projection on the edge
+    const Vertex &a = vertices[faces[face].idVertices[edge]];
+    const Vertex &b = vertices[faces[face].idVertices[(edge + 1) % 3]];
+    QVector3D ab = b.position - a.position;
+    float t = ab.lengthSquared() > 0.0f ? QVector3D::dotProduct(position - a.position, ab) / ab.lengthSquared() : 0.5f;
+    t = std::clamp(t, 0.0f, 1.0f);
+    Vertex vertex(position);
+    vertex.texCoords = a.texCoords * (1.0f - t) + b.texCoords * t;
+
+    vertices.push_back(vertex);
+    unsigned int m = vertices.size() - 1;
+    updateNormals(splitEdgeAt(face, edge, m));
+    return m;
+}
+
+bool Mesh::flipEdge(unsigned int face, int edge) {
+    if (face >= faces.size() || faces[face].idFaces.size() != 3 || edge < 0 || edge > 2) return false;
+
+    // f = (a, b, c) and g = (b, a, d) become (a, d, c) and (d, b, c)
+    unsigned int f = face;
+    unsigned int g = faces[f].idFaces[edge];
+    if (g == Triangle::NO_NEIGHBOR) return false;
+    unsigned int a = faces[f].idVertices[edge];
+    unsigned int b = faces[f].idVertices[(edge + 1) % 3];
+    unsigned int c = faces[f].idVertices[(edge + 2) % 3];
+    int eg = faces[g].localIndex(b);
+    unsigned int d = faces[g].idVertices[(eg + 2) % 3];
+    if (c == d) return false;
+
+    for (unsigned int around : facesAround(f, c)) {
+        const auto &ids = faces[around].idVertices;
+        if (std::find(ids.begin(), ids.end(), d) != ids.end()) return false;
+    }
+
+    unsigned int nbc = faces[f].idFaces[(edge + 1) % 3];
+    unsigned int nca = faces[f].idFaces[(edge + 2) % 3];
+    unsigned int nad = faces[g].idFaces[(eg + 1) % 3];
+    unsigned int ndb = faces[g].idFaces[(eg + 2) % 3];
+
+    faces[f].idVertices = { a, d, c };
+    faces[f].idFaces = { nad, g, nca };
+    faces[g].idVertices = { d, b, c };
+    faces[g].idFaces = { ndb, nbc, f };
+    setNeighbor(nad, d, a, f);
+    setNeighbor(nbc, c, b, g);
+
+    updateNormals({ f, g });
+    return true;
+}
+
+int Mesh::collapseEdge(unsigned int face, int edge) {
+    if (face >= faces.size() || faces[face].idFaces.size() != 3 || edge < 0 || edge > 2) return -1;
+
+    // b is merged in a, f = (a, b, c) and g = (b, a, d) are removed
+    unsigned int f = face;
+    unsigned int g = faces[f].idFaces[edge];
+    unsigned int a = faces[f].idVertices[edge];
+    unsigned int b = faces[f].idVertices[(edge + 1) % 3];
+    unsigned int c = faces[f].idVertices[(edge + 2) % 3];
+    const unsigned int none = Triangle::NO_NEIGHBOR;
+    int eg = g == none ? -1 : faces[g].localIndex(b);
+    unsigned int d = g == none ? none : faces[g].idVertices[(eg + 2) % 3];
+
+    // link condition : a and b only share the vertices of the removed faces
+    bool boundaryA, boundaryB;
+    std::vector<unsigned int> aroundA = facesAround(f, a, &boundaryA);
+    std::vector<unsigned int> aroundB = facesAround(f, b, &boundaryB);
+    if (g != none && boundaryA && boundaryB) return -1;
+
+    auto ringOf = [&](const std::vector<unsigned int> &around, unsigned int center) {
+        std::vector<unsigned int> ring;
+        for (unsigned int other : around) {
+            for (unsigned int v : faces[other].idVertices) {
+                if (v != center && std::find(ring.begin(), ring.end(), v) == ring.end()) ring.push_back(v);
             }
         }
+        return ring;
+    };
+    std::vector<unsigned int> ringA = ringOf(aroundA, a), ringB = ringOf(aroundB, b);
+    std::size_t shared = 0;
+    for (unsigned int v : ringA) shared += std::find(ringB.begin(), ringB.end(), v) != ringB.end();
+    if (shared != (g == none ? 1u : 2u)) return -1;
+
+    // an opposite vertex with 3 faces would keep 2 faces back to back
+    for (unsigned int opposite : { c, d }) {
+        if (opposite == none) continue;
+        bool open;
+        std::size_t valence = facesAround(opposite == c ? f : g, opposite, &open).size();
+        if (!open && valence <= 3) return -1;
     }
 
-    while (!edgeQueue.empty() && iterations < maxIterations) {
-        iterations++;
+    unsigned int nbc = faces[f].idFaces[(edge + 1) % 3];
+    unsigned int nca = faces[f].idFaces[(edge + 2) % 3];
+    setNeighbor(nbc, c, b, nca);
+    setNeighbor(nca, a, c, nbc);
+    unsigned int nad = none, ndb = none;
+    if (g != none) {
+        nad = faces[g].idFaces[(eg + 1) % 3];
+        ndb = faces[g].idFaces[(eg + 2) % 3];
+        setNeighbor(ndb, b, d, nad);
+        setNeighbor(nad, d, a, ndb);
+    }
 
-        auto [t1, t2] = edgeQueue.front();
-        edgeQueue.pop();
+    for (unsigned int around : aroundB) {
+        if (around == f || around == g) continue;
+        for (auto &v : faces[around].idVertices) {
+            if (v == b) v = a;
+        }
+    }
+    vertices[a].position = (vertices[a].position + vertices[b].position) / 2.0f;
+    vertices[a].texCoords = (vertices[a].texCoords + vertices[b].texCoords) * 0.5f;
+    dirty.addVertex(b);
+
+    // a face left around a, the last faces move in the slots of the removed ones from the highest
+    unsigned int kept = none;
+    for (unsigned int candidate : { nca, nbc, nad, ndb }) {
+        if (candidate != none) {
+            kept = candidate;
+            break;
+        }
+    }
+    std::vector<unsigned int> removed = { f };
+    if (g != none) removed.push_back(g);
+    std::sort(removed.rbegin(), removed.rend());
+    std::vector<unsigned int> relocated;
+    for (unsigned int r : removed) {
+        unsigned int moved = removeFace(r);
+        if (kept == moved) kept = r;
+        for (auto &slot : relocated) {
+            if (slot == moved) slot = r;
+        }
+        if (moved != r) relocated.push_back(r);
+    }
+
+    // the moved faces change the order of the sums around their vertices
+    std::vector<unsigned int> touched = kept != none ? facesAround(kept, a) : std::vector<unsigned int>();
+    touched.insert(touched.end(), relocated.begin(), relocated.end());
+    updateNormals(touched);
+    dirty.addVertex(a);
+    return a;
+}
 
-        if (t1 >= (int)faces.size() || t2 >= (int)faces.size()) continue;
+int Mesh::insertVertex(unsigned int face, const QVector3D &position) {
+    if (face >= faces.size() || faces[face].idFaces.size() != 3) return -1;
+
+    // f = (a, b, c) becomes (a, b, m), (b, c, m) and (c, a, m)
+    unsigned int f = face;
+    auto ids = faces[f].idVertices;
+    unsigned int a = ids[0], b = ids[1], c = ids[2];
+    unsigned int nbc = faces[f].idFaces[1];
+    unsigned int nca = faces[f].idFaces[2];
+
+    // barycentric coordinates of the position projected on the face, for the texture coordinates
+    QVector3D p0 = vertices[a].position, e1 = vertices[b].position - p0, e2 = vertices[c].position - p0, q = position - p0;
+    float d11 = QVector3D::dotProduct(e1, e1), d12 = QVector3D::dotProduct(e1, e2), d22 = QVector3D::dotProduct(e2, e2);
+    float q1 = QVector3D::dotProduct(q, e1), q2 = QVector3D::dotProduct(q, e2);
+    float denominator = d11 * d22 - d12 * d12;
+    float u = denominator != 0.0f ? (d22 * q1 - d12 * q2) / denominator : 1.0f / 3.0f;
+    float v = denominator != 0.0f ? (d11 * q2 - d12 * q1) / denominator : 1.0f / 3.0f;
+    Vertex vertex(position);
+    vertex.texCoords = vertices[a].texCoords * (1.0f - u - v) + vertices[b].texCoords * u + vertices[c].texCoords * v;
+    vertices.push_back(vertex);
+    unsigned int m = vertices.size() - 1;
+
+    unsigned int f2 = faces.size(), f3 = f2 + 1;
+    faces.push_back(Triangle(b, c, m));
+    faces.push_back(Triangle(c, a, m));
+    faces[f].idVertices = { a, b, m };
+    faces[f].idFaces = { faces[f].idFaces[0], f2, f3 };
+    faces[f2].idFaces = { nbc, f3, f };
+    faces[f3].idFaces = { nca, f, f2 };
+    setNeighbor(nbc, c, b, f2);
+    setNeighbor(nca, a, c, f3);
+
+    updateNormals({ f, f2, f3 });
+    return m;
+}
 
-        std::pair<int, int> edgePair = {std::min(t1, t2), std::max(t1, t2)};
-        if (processed.find(edgePair) != processed.end()) continue;
-        processed.insert(edgePair);
+void Mesh::setPositions(const std::vector<QVector3D> &positions) {
+    if (positions.size() != vertices.size()) return;
+    for (std::size_t v = 0; v < vertices.size(); v++) {
+        vertices[v].position = positions[v];
+        dirty.addVertex(v);
+    }
+    computeNormals();
+}
 
-        if (!isLocallyDelaunay(t1, t2)) {
+void Mesh::setPositions(const std::vector<QVector3D> &positions, const std::vector<QVector3D> &normals) {
+    if (positions.size() != vertices.size() || normals.size() != vertices.size()) return;
+    for (std::size_t v = 0; v < vertices.size(); v++) {
+        vertices[v].position = positions[v];
+        vertices[v].normal = normals[v];
+        dirty.addVertex(v);
+    }
+}
 
-            edgeFlip(t1, t2);
+void Mesh::vertexFaces(std::vector<unsigned int> &first, std::vector<unsigned int> &faceList) const {
+    first.assign(vertices.size() + 1, 0);
+    for (const auto &f : faces) {
+        for (unsigned int id : f.idVertices) first[id + 1]++;
+    }
+    for (std::size_t i = 0; i < vertices.size(); i++) first[i + 1] += first[i];
+    faceList.resize(first.back());
+    std::vector<unsigned int> next(first.begin(), first.end() - 1);
+    for (std::size_t i = 0; i < faces.size(); i++) {
+        for (unsigned int id : faces[i].idVertices) faceList[next[id]++] = i;
+    }
+}
 
-            for (int neighbor : faces[t1].idFaces) {
-                if (neighbor != t2) {
-                    bool inInfluenceZone = false;
-                    const Triangle& neighborTri = faces[neighbor];
-                    for (int k = 0; k < 3; k++) {
-                        if (neighborTri.idVertices[k] == p) {
-                            inInfluenceZone = true;
-                            break;
-                        }
-                    }
+int Mesh::twinEdge(unsigned int face, int edge) const {
+    const Triangle &f = faces[face];
+    unsigned int g = f.idFaces[edge];
+    if (g == Triangle::NO_NEIGHBOR) return -1;
+    int twin = faces[g].localIndex(f.idVertices[(edge + 1) % 3]);
+    if (twin < 0 || faces[g].idVertices[(twin + 1) % 3] != f.idVertices[edge] || faces[g].idFaces[twin] != face) return -1;
+    return twin;
+}
 
-                    if (!inInfluenceZone) {
-                        for (int incidentTri : incidentTriangles) {
-                            if (incidentTri < (int)faces.size()) {
-                                for (int adj : faces[incidentTri].idFaces) {
-                                    if (adj == neighbor) {
-                                        inInfluenceZone = true;
-                                        break;
-                                    }
-                                }
-                                if (inInfluenceZone) break;
-                            }
-                        }
-                    }
+void Mesh::subdivideLoop(int levels) {
+    ScopedTimer timer("Mesh::subdivideLoop");
+    if (faces.empty() || levels < 1) return;
+    if (std::any_of(faces.begin(), faces.end(), [](const Triangle &f) { return f.idFaces.size() != 3; })) sew();
+
+    const unsigned int none = Triangle::NO_NEIGHBOR;
+    std::vector<Vertex> refined;
+    std::vector<Triangle> children;
+    std::vector<int> twins;
+    std::vector<unsigned int> edgeVertex, owned, firstFace, faceList;
+
+    for (int level = 0; level < levels; level++) {
+        std::size_t vertexCount = vertices.size(), faceCount = faces.size();
+
+        // each edge is numbered by its face of lower index, or by its only face on a boundary
+        twins.resize(3 * faceCount);
+        edgeVertex.resize(3 * faceCount);
+        owned.assign(faceCount + 1, 0);
+        auto owns = [&](std::size_t f, int e) { return twins[3 * f + e] < 0 || f < faces[f].idFaces[e]; };
+        parallelFor(0, faceCount, SUBDIVISION_GRAIN, [&](std::size_t first, std::size_t last) {
+            for (std::size_t f = first; f < last; f++) {
+                for (int e = 0; e < 3; e++) twins[3 * f + e] = twinEdge(f, e);
+                for (int e = 0; e < 3; e++) owned[f + 1] += owns(f, e);
+            }
+        });
+        for (std::size_t f = 0; f < faceCount; f++) owned[f + 1] += owned[f];
+        std::size_t edgeCount = owned.back();
+
+        // the next counts are V + E vertices, 2E + 3F edges and 4F faces, the buffers are sized once for the last level
+        if (level == 0) {
+            std::size_t v = vertexCount, e = edgeCount, f = faceCount;
+            for (int l = 0; l < levels; l++) {
+                v += e;
+                e = 2 * e + 3 * f;
+                f *= 4;
+            }
+            vertices.reserve(v);
+            refined.reserve(v);
+            faces.reserve(f);
+            children.reserve(f);
+        }
 
-                    if (inInfluenceZone) {
-                        std::pair<int, int> newEdge = {std::min(t1, neighbor), std::max(t1, neighbor)};
-                        if (processed.find(newEdge) == processed.end()) {
-                            edgeQueue.push({t1, neighbor});
-                        }
+        refined.resize(vertexCount + edgeCount, Vertex(0.0f, 0.0f, 0.0f));
+        parallelFor(0, faceCount, SUBDIVISION_GRAIN, [&](std::size_t first, std::size_t last) {
+            for (std::size_t f = first; f < last; f++) {
+                unsigned int id = vertexCount + owned[f];
+                const auto &v = faces[f].idVertices;
+                for (int e = 0; e < 3; e++) {
+                    if (!owns(f, e)) continue;
+                    const Vertex &a = vertices[v[e]], &b = vertices[v[(e + 1) % 3]];
+                    Vertex m((a.position + b.position) * 0.5f);
+                    int twin = twins[3 * f + e];
+                    if (twin >= 0) {
+                        const Vertex &c = vertices[v[(e + 2) % 3]];
+                        const Vertex &d = vertices[faces[faces[f].idFaces[e]].idVertices[(twin + 2) % 3]];
+                        m.position = (a.position + b.position) * 0.375f + (c.position + d.position) * 0.125f;
                     }
+                    m.texCoords = (a.texCoords + b.texCoords) * 0.5f;
+                    edgeVertex[3 * f + e] = id;
+                    refined[id++] = m;
                 }
             }
-
-            for (int neighbor : faces[t2].idFaces) {
-                if (neighbor != t1 && neighbor > 0) {
-                    bool inInfluenceZone = false;
-                    const Triangle& neighborTri = faces[neighbor];
-                    for (int k = 0; k < 3; k++) {
-                        if (neighborTri.idVertices[k] == p) {
-                            inInfluenceZone = true;
-                            break;
-                        }
+        });
+        parallelFor(0, faceCount, SUBDIVISION_GRAIN, [&](std::size_t first, std::size_t last) {
+            for (std::size_t f = first; f < last; f++) {
+                for (int e = 0; e < 3; e++) {
+                    if (!owns(f, e)) edgeVertex[3 * f + e] = edgeVertex[3 * faces[f].idFaces[e] + twins[3 * f + e]];
+                }
+            }
+        });
+
+        // an interior vertex is pulled toward its ring, a boundary vertex toward its 2 boundary neighbors
+        vertexFaces(firstFace, faceList);
+        parallelFor(0, vertexCount, SUBDIVISION_GRAIN, [&](std::size_t first, std::size_t last) {
+            for (std::size_t v = first; v < last; v++) {
+                QVector3D ring(0, 0, 0), border(0, 0, 0);
+                int valence = 0, borders = 0;
+                for (unsigned int k = firstFace[v]; k < firstFace[v + 1]; k++) {
+                    unsigned int f = faceList[k];
+                    const auto &ids = faces[f].idVertices;
+                    int corner = faces[f].localIndex(v);
+                    const QVector3D &next = vertices[ids[(corner + 1) % 3]].position;
+                    ring += next;
+                    valence++;
+                    if (twins[3 * f + corner] < 0) {
+                        border += next;
+                        borders++;
                     }
-
-                    if (!inInfluenceZone) {
-                        for (int incidentTri : incidentTriangles) {
-                            if (incidentTri < (int)faces.size()) {
-                                for (int adj : faces[incidentTri].idFaces) {
-                                    if (adj == neighbor) {
-                                        inInfluenceZone = true;
-                                        break;
-                                    }
-                                }
-                                if (inInfluenceZone) break;
-                            }
-                        }
+                    if (twins[3 * f + (corner + 2) % 3] < 0) {
+                        border += vertices[ids[(corner + 2) % 3]].position;
+                        borders++;
                     }
+                }
 
-                    if (inInfluenceZone) {
-                        std::pair<int, int> newEdge = {std::min(t2, neighbor), std::max(t2, neighbor)};
-                        if (processed.find(newEdge) == processed.end()) {
-                            edgeQueue.push({t2, neighbor});
-                        }
-                    }
+                refined[v] = vertices[v];
+                if (borders == 2) {
+                    refined[v].position = vertices[v].position * 0.75f + border * 0.125f;
+                } else if (borders == 0 && valence > 0) {
+                    float c = 0.375f + 0.25f * std::cos(TWO_PI / valence);
+                    float beta = (0.625f - c * c) / valence;
+                    refined[v].position = vertices[v].position * (1.0f - valence * beta) + ring * beta;
                 }
             }
-        }
-    }
+        });
+
+        // the child at corner k keeps the vertex k, its neighbors across the old edges are the children of the same corner
+        children.resize(4 * faceCount);
+        parallelFor(0, faceCount, SUBDIVISION_GRAIN, [&](std::size_t first, std::size_t last) {
+            for (std::size_t f = first; f < last; f++) {
+                const Triangle &parent = faces[f];
+                const unsigned int *m = &edgeVertex[3 * f];
+                for (int k = 0; k < 3; k++) {
+                    auto across = [&](int e) {
+                        if (twins[3 * f + e] < 0) return none;
+                        unsigned int g = parent.idFaces[e];
+                        return 4 * g + faces[g].localIndex(parent.idVertices[k]);
+                    };
+                    Triangle &child = children[4 * f + k];
+                    child.idVertices[k] = parent.idVertices[k];
+                    child.idVertices[(k + 1) % 3] = m[k];
+                    child.idVertices[(k + 2) % 3] = m[(k + 2) % 3];
+                    child.idFaces.resize(3);
+                    child.idFaces[k] = across(k);
+                    child.idFaces[(k + 1) % 3] = 4 * f + 3;
+                    child.idFaces[(k + 2) % 3] = across((k + 2) % 3);
+                }
+                Triangle &center = children[4 * f + 3];
+                center.idVertices = { m[0], m[1], m[2] };
+                center.idFaces.assign({ unsigned(4 * f + 1), unsigned(4 * f + 2), unsigned(4 * f) });
+            }
+        });
 
-    if (iterations >= maxIterations) {
-        std::cerr << "Local Lawson update reached iteration limit for point " << p << "\n";
+        vertices.swap(refined);
+        faces.swap(children);
     }
+
+    dirty = DirtyRegion();
+    computeNormals();
 }
 
-void Mesh::normalize() {
-    normCoeff = getBoundingRadius();
-    float scale = 30.0f / normCoeff;
+void Mesh::subdivideSqrt3(int levels) {
+    ScopedTimer timer("Mesh::subdivideSqrt3");
+    if (faces.empty() || levels < 1) return;
+    if (std::any_of(faces.begin(), faces.end(), [](const Triangle &f) { return f.idFaces.size() != 3; })) sew();
 
-    for (auto& vertex : vertices) {
-        vertex.position = vertex.position * scale;
+    // V + F vertices and 3F faces per level
+    std::size_t finalVertices = vertices.size(), finalFaces = faces.size();
+    for (int l = 0; l < levels; l++) {
+        finalVertices += finalFaces;
+        finalFaces *= 3;
     }
-}
+    std::vector<Vertex> refined;
+    std::vector<Triangle> children;
+    vertices.reserve(finalVertices);
+    refined.reserve(finalVertices);
+    faces.reserve(finalFaces);
+    children.reserve(finalFaces);
+
+    const unsigned int none = Triangle::NO_NEIGHBOR;
+    std::vector<int> twins;
+    std::vector<unsigned int> firstFace, faceList;
+
+    for (int level = 0; level < levels; level++) {
+        std::size_t vertexCount = vertices.size(), faceCount = faces.size();
+        twins.resize(3 * faceCount);
+        refined.resize(vertexCount + faceCount, Vertex(0.0f, 0.0f, 0.0f));
+        parallelFor(0, faceCount, SUBDIVISION_GRAIN, [&](std::size_t first, std::size_t last) {
+            for (std::size_t f = first; f < last; f++) {
+                for (int e = 0; e < 3; e++) twins[3 * f + e] = twinEdge(f, e);
+                const auto &v = faces[f].idVertices;
+                Vertex center((vertices[v[0]].position + vertices[v[1]].position + vertices[v[2]].position) * (1.0f / 3.0f));
+                center.texCoords = (vertices[v[0]].texCoords + vertices[v[1]].texCoords + vertices[v[2]].texCoords) * (1.0f / 3.0f);
+                refined[vertexCount + f] = center;
+            }
+        });
+
+        vertexFaces(firstFace, faceList);
+        parallelFor(0, vertexCount, SUBDIVISION_GRAIN, [&](std::size_t first, std::size_t last) {
+            for (std::size_t v = first; v < last; v++) {
+                QVector3D ring(0, 0, 0);
+                int valence = 0;
+                bool border = false;
+                for (unsigned int k = firstFace[v]; k < firstFace[v + 1]; k++) {
+                    unsigned int f = faceList[k];
+                    int corner = faces[f].localIndex(v);
+                    ring += vertices[faces[f].idVertices[(corner + 1) % 3]].position;
+                    valence++;
+                    border = border || twins[3 * f + corner] < 0 || twins[3 * f + (corner + 2) % 3] < 0;
+                }
 
-void Mesh::deNormalize() {
-    float scale = normCoeff / 30.0f;
+                refined[v] = vertices[v];
+                if (!border && valence > 0) {
+                    float alpha = (4.0f - 2.0f * std::cos(TWO_PI / valence)) / 9.0f;
+                    refined[v].position = vertices[v].position * (1.0f - alpha) + ring * (alpha / valence);
+                }
+            }
+        });
+
+        // the face of edge e joins its first vertex a to the centers of the 2 faces of the edge,
+        // a boundary edge keeps the face (a, b, center)
+        children.resize(3 * faceCount);
+        parallelFor(0, faceCount, SUBDIVISION_GRAIN, [&](std::size_t first, std::size_t last) {
+            for (std::size_t f = first; f < last; f++) {
+                const Triangle &parent = faces[f];
+                unsigned int center = vertexCount + f;
+                for (int e = 0; e < 3; e++) {
+                    int previous = (e + 2) % 3;
+                    int twinPrevious = twins[3 * f + previous];
+                    unsigned int before = twinPrevious < 0 ? 3 * f + previous : 3 * parent.idFaces[previous] + twinPrevious;
+
+                    Triangle &child = children[3 * f + e];
+                    child.idFaces.resize(3);
+                    int twin = twins[3 * f + e];
+                    if (twin < 0) {
+                        child.idVertices = { parent.idVertices[e], parent.idVertices[(e + 1) % 3], center };
+                        child.idFaces[0] = none;
+                        child.idFaces[1] = 3 * f + (e + 1) % 3;
+                    } else {
+                        unsigned int g = parent.idFaces[e];
+                        child.idVertices = { parent.idVertices[e], unsigned(vertexCount + g), center };
+                        child.idFaces[0] = 3 * g + (twin + 1) % 3;
+                        child.idFaces[1] = 3 * g + twin;
+                    }
+                    child.idFaces[2] = before;
+                }
+            }
+        });
 
-    for (auto& vertex : vertices) {
-        vertex.position = vertex.position * scale;
+        vertices.swap(refined);
+        faces.swap(children);
     }
 
-    normCoeff = 0.0f;
+    dirty = DirtyRegion();
+    computeNormals();
 }
@@ -0,0 +1,252 @@
+#include "meshAnalysis.h"
+#include "parallel.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+
+namespace {
+
+// faces or vertices handled by one task
+const std::size_t ANALYSIS_GRAIN = 1 << 14;
+
+typedef std::vector<std::atomic<unsigned int>> UnionFind;
+
+void initialize(UnionFind &parent) {
+    parallelFor(0, parent.size(), ANALYSIS_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t v = first; v < last; v++) parent[v].store(v, std::memory_order_relaxed);
+    });
+}
+
+// a parent is never larger than its child, so the walk ends even while other threads link and halve the paths
+unsigned int findRoot(UnionFind &parent, unsigned int x) {
+    unsigned int p = parent[x].load(std::memory_order_relaxed);
+    while (p != x) {
+        unsigned int grandParent = parent[p].load(std::memory_order_relaxed);
+        if (grandParent != p) parent[x].compare_exchange_weak(p, grandParent, std::memory_order_relaxed);
+        x = grandParent;
+        p = parent[x].load(std::memory_order_relaxed);
+    }
+    return x;
+}
+
+// the larger root is linked to the smaller one, the link fails if another thread linked it first
+void unite(UnionFind &parent, unsigned int a, unsigned int b) {
+    while (true) {
+        a = findRoot(parent, a);
+        b = findRoot(parent, b);
+        if (a == b) return;
+        if (a < b) std::swap(a, b);
+        unsigned int expected = a;
+        if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+    }
+}
+
+// joins the vertices of each face, and flags the vertices used
+template <typename FaceIds>
+void uniteFaces(std::size_t faceCount, const FaceIds &faceIds, UnionFind &parent, std::vector<std::atomic<unsigned char>> &used) {
+    parallelFor(0, faceCount, ANALYSIS_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t f = first; f < last; f++) {
+            const auto &ids = faceIds(f);
+            for (unsigned int id : ids) used[id].store(1, std::memory_order_relaxed);
+            unite(parent, ids[0], ids[1]);
+            unite(parent, ids[0], ids[2]);
+        }
+    });
+}
+/**
+ * @brief Compute the statistics of faces given by their vertex ids.
+ * @param count : The number of vertices.
+ * @param faceCount : The number of faces.
+ * @param positionOf : The position of a vertex.
+ * @param faceIds : The 3 vertex ids of a face.
+ * @return The counts.
+ */
+template <typename PositionOf, typename FaceIds>
+MeshStatistics analyzeFaces(std::size_t count, std::size_t faceCount, const PositionOf &positionOf, const FaceIds &faceIds) {
+    MeshStatistics statistics;
+    statistics.vertices = count;
+    statistics.faces = faceCount;
+
+    UnionFind parent(count);
+    initialize(parent);
+    std::vector<std::atomic<unsigned char>> used(count);
+    uniteFaces(faceCount, faceIds, parent, used);
+
+    // each edge is stored once, in the list of its smallest vertex
+    std::vector<std::atomic<unsigned int>> cursor(count);
+    std::atomic<std::size_t> degenerate(0);
+    parallelFor(0, faceCount, ANALYSIS_GRAIN, [&](std::size_t first, std::size_t last) {
+        std::size_t localDegenerate = 0;
+        for (std::size_t f = first; f < last; f++) {
+            const auto &ids = faceIds(f);
+            const QVector3D &a = positionOf(ids[0]), &b = positionOf(ids[1]), &c = positionOf(ids[2]);
+            bool repeated = ids[0] == ids[1] || ids[1] == ids[2] || ids[2] == ids[0];
+            if (repeated || QVector3D::crossProduct(b - a, c - a).lengthSquared() == 0.0f) localDegenerate++;
+            for (int e = 0; e < 3; e++) {
+                unsigned int u = ids[e], v = ids[(e + 1) % 3];
+                if (u != v) cursor[std::min(u, v)].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        degenerate += localDegenerate;
+    });
+    statistics.degenerateFaces = degenerate;
+
+    std::vector<unsigned int> edgeStart(count + 1, 0);
+    for (std::size_t v = 0; v < count; v++) {
+        edgeStart[v + 1] = edgeStart[v] + cursor[v].load(std::memory_order_relaxed);
+        cursor[v].store(edgeStart[v], std::memory_order_relaxed);
+    }
+    std::vector<unsigned int> others(edgeStart.back());
+    parallelFor(0, faceCount, ANALYSIS_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t f = first; f < last; f++) {
+            const auto &ids = faceIds(f);
+            for (int e = 0; e < 3; e++) {
+                unsigned int u = ids[e], v = ids[(e + 1) % 3];
+                if (u != v) others[cursor[std::min(u, v)].fetch_add(1, std::memory_order_relaxed)] = std::max(u, v);
+            }
+        }
+    });
+
+    // the faces of an edge are the repeats of its other vertex, the boundary edges are joined into loops
+    UnionFind loopParent(count);
+    initialize(loopParent);
+    std::vector<std::atomic<unsigned char>> onBoundary(count);
+    std::atomic<std::size_t> edges(0), boundaryEdges(0), nonManifoldEdges(0);
+    parallelFor(0, count, ANALYSIS_GRAIN, [&](std::size_t first, std::size_t last) {
+        std::size_t localEdges = 0, localBoundary = 0, localNonManifold = 0;
+        for (std::size_t u = first; u < last; u++) {
+            auto begin = others.begin() + edgeStart[u], end = others.begin() + edgeStart[u + 1];
+            std::sort(begin, end);
+            for (auto it = begin; it != end;) {
+                auto next = std::find_if(it, end, [&](unsigned int v) { return v != *it; });
+                std::size_t edgeFaces = next - it;
+                localEdges++;
+                if (edgeFaces == 1) {
+                    localBoundary++;
+                    onBoundary[u].store(1, std::memory_order_relaxed);
+                    onBoundary[*it].store(1, std::memory_order_relaxed);
+                    unite(loopParent, u, *it);
+                } else if (edgeFaces > 2) {
+                    localNonManifold++;
+                }
+                it = next;
+            }
+        }
+        edges += localEdges;
+        boundaryEdges += localBoundary;
+        nonManifoldEdges += localNonManifold;
+    });
+    statistics.edges = edges;
+    statistics.boundaryEdges = boundaryEdges;
+    statistics.nonManifoldEdges = nonManifoldEdges;
+
+    // a component or a loop is counted at its root, its smallest vertex
+    std::atomic<std::size_t> usedVertices(0), components(0), loops(0);
+    parallelFor(0, count, ANALYSIS_GRAIN, [&](std::size_t first, std::size_t last) {
+        std::size_t localUsed = 0, localComponents = 0, localLoops = 0;
+        for (std::size_t v = first; v < last; v++) {
+            if (!used[v].load(std::memory_order_relaxed)) continue;
+            localUsed++;
+            if (parent[v].load(std::memory_order_relaxed) == v) localComponents++;
+            if (onBoundary[v].load(std::memory_order_relaxed) && loopParent[v].load(std::memory_order_relaxed) == v) localLoops++;
+        }
+        usedVertices += localUsed;
+        components += localComponents;
+        loops += localLoops;
+    });
+    statistics.components = components;
+    statistics.boundaryLoops = loops;
+    statistics.isolatedVertices = count - usedVertices;
+    statistics.eulerCharacteristic = (long long)usedVertices - (long long)statistics.edges + (long long)statistics.faces;
+    return statistics;
+}
+
+}
+
+bool MeshStatistics::isClosedManifold() const {
+    return faces > 0 && boundaryEdges == 0 && nonManifoldEdges == 0;
+}
+
+MeshStatistics MeshAnalysis::analyze(const Mesh &mesh) {
+    ScopedTimer timer("MeshAnalysis::analyze");
+    const auto &vertices = mesh.getVertices();
+    const auto &faces = mesh.getFaces();
+    return analyzeFaces(vertices.size(), faces.size(), [&](unsigned int v) -> const QVector3D & { return vertices[v].position; },
+                        [&](std::size_t f) -> const std::array<unsigned int, 3> & { return faces[f].idVertices; });
+}
+
+MeshStatistics MeshAnalysis::analyze(const std::vector<QVector3D> &positions, const std::vector<std::array<unsigned int, 3>> &faces) {
+    ScopedTimer timer("MeshAnalysis::analyze");
+    return analyzeFaces(positions.size(), faces.size(), [&](unsigned int v) -> const QVector3D & { return positions[v]; },
+                        [&](std::size_t f) -> const std::array<unsigned int, 3> & { return faces[f]; });
+}
+
+
+std::size_t MeshAnalysis::labelComponents(const Mesh &mesh, std::vector<unsigned int> &faceLabels) {
+    ScopedTimer timer("MeshAnalysis::labelComponents");
+    const auto &faces = mesh.getFaces();
+    std::size_t count = mesh.getVertices().size();
+
+    UnionFind parent(count);
+    initialize(parent);
+    std::vector<std::atomic<unsigned char>> used(count);
+    uniteFaces(faces.size(), [&](std::size_t f) -> const std::array<unsigned int, 3> & { return faces[f].idVertices; }, parent, used);
+
+    // the roots are numbered in the order of the vertices
+    std::vector<unsigned int> label(count, 0);
+    std::size_t components = 0;
+    for (std::size_t v = 0; v < count; v++) {
+        if (used[v].load(std::memory_order_relaxed) && parent[v].load(std::memory_order_relaxed) == v) label[v] = components++;
+    }
+
+    faceLabels.resize(faces.size());
+    parallelFor(0, faces.size(), ANALYSIS_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t f = first; f < last; f++) faceLabels[f] = label[findRoot(parent, faces[f].idVertices[0])];
+    });
+    return components;
+}
+
+std::string MeshAnalysis::summary(const MeshStatistics &statistics) {
+    std::ostringstream text;
+    text << statistics.components << (statistics.components == 1 ? " component, " : " components, ")
+         << statistics.boundaryLoops << (statistics.boundaryLoops == 1 ? " boundary loop, " : " boundary loops, ")
+         << statistics.nonManifoldEdges << " non-manifold edges, "
+         << statistics.degenerateFaces << " degenerate faces, "
+         << statistics.isolatedVertices << " isolated vertices, "
+         << "Euler characteristic " << statistics.eulerCharacteristic;
+    return text.str();
+}
+
+MeshAnalysisJob::MeshAnalysisJob(const Mesh &mesh) : finished(false) {
+    ScopedTimer timer("MeshAnalysisJob::MeshAnalysisJob");
+    const auto &vertices = mesh.getVertices();
+    const auto &meshFaces = mesh.getFaces();
+    positions.resize(vertices.size());
+    faces.resize(meshFaces.size());
+    parallelFor(0, vertices.size(), ANALYSIS_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t v = first; v < last; v++) positions[v] = vertices[v].position;
+    });
+    parallelFor(0, meshFaces.size(), ANALYSIS_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t f = first; f < last; f++) faces[f] = meshFaces[f].idVertices;
+    });
+    worker = std::thread(&MeshAnalysisJob::run, this);
+}
+
+MeshAnalysisJob::~MeshAnalysisJob() {
+    worker.join();
+}
+
+void MeshAnalysisJob::run() {
+    statistics = MeshAnalysis::analyze(positions, faces);
+    finished = true;
+}
+
+bool MeshAnalysisJob::isFinished() const {
+    return finished;
+}
+
+const MeshStatistics &MeshAnalysisJob::getStatistics() const {
+    return statistics;
+}
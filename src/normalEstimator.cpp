@@ -0,0 +1,247 @@
+#include "normalEstimator.h"
+#include "kdTree.h"
+#include "parallel.h"
+#include "profiler.h"
+#include "spatialSort.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+// points fitted by one task
+const std::size_t NORMAL_GRAIN = 1024;
+// below this spread the matrix is a multiple of the identity, and below its square the cross products vanish
+const double EIGEN_EPSILON = 1e-9;
+// queries of the nearest neighbors between 2 checks of the cancel flag
+const std::size_t NORMAL_SLICE = 1 << 18;
+// edges taken by the orientation between 2 checks of the cancel flag
+const std::size_t ORIENT_CHECK = 1 << 16;
+// steps of the queue of the orientation, over the square root of the weights so they are about even in angle
+const unsigned int ORIENT_BUCKETS = 1024;
+
+const double PI = 3.14159265358979323846;
+
+// an edge of the neighbor graph waiting in the spanning tree queue
+struct PendingEdge {
+    unsigned int to;
+    unsigned int from;
+};
+
+}
+
+std::vector<QVector3D> NormalEstimator::estimate(const std::vector<QVector3D> &points, const NormalEstimationOptions &options) {
+    ScopedTimer timer("NormalEstimator::estimate");
+    std::size_t n = points.size();
+    auto cancelled = [&]() { return options.cancel && options.cancel->load(); };
+    std::vector<QVector3D> normals(n, QVector3D(0.0f, 0.0f, 1.0f));
+    if (n == 0) return normals;
+
+    // all the work is done on the points along a Morton curve, the neighbors of close points are then close in memory
+    std::vector<unsigned int> order = SpatialSort::sortPoints(points, SpatialOrder::MORTON);
+    std::vector<QVector3D> sorted(n);
+    parallelFor(0, n, NORMAL_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) sorted[i] = points[order[i]];
+    });
+
+    std::size_t k = std::max<std::size_t>(1, std::min(options.neighbors, n));
+    KDTree tree;
+    tree.build(sorted);
+    std::vector<unsigned int> neighbors(n * k), slice;
+    for (std::size_t first = 0; first < n; first += NORMAL_SLICE) {
+        if (cancelled()) return {};
+        std::vector<QVector3D> queries(sorted.begin() + first, sorted.begin() + std::min(n, first + NORMAL_SLICE));
+        tree.knn(queries, k, slice);
+        std::copy(slice.begin(), slice.end(), neighbors.begin() + first * k);
+    }
+
+    std::vector<QVector3D> sortedNormals(n);
+    parallelFor(0, n, NORMAL_GRAIN, [&](std::size_t first, std::size_t last) {
+        if (cancelled()) return;
+        for (std::size_t i = first; i < last; i++) {
+            const unsigned int *row = neighbors.data() + i * k;
+            std::size_t count = 0;
+            double mean[3] = { 0.0, 0.0, 0.0 };
+            for (; count < k && row[count] != KDTree::NO_POINT; count++) {
+                for (int a = 0; a < 3; a++) mean[a] += sorted[row[count]][a];
+            }
+            for (int a = 0; a < 3; a++) mean[a] /= count;
+
+            // centered before the products, the georeferenced clouds would lose all their precision else
+            std::array<double, 6> covariance = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+            for (std::size_t j = 0; j < count; j++) {
+                const QVector3D &p = sorted[row[j]];
+                double dx = p.x() - mean[0], dy = p.y() - mean[1], dz = p.z() - mean[2];
+                covariance[0] += dx * dx;
+                covariance[1] += dx * dy;
+                covariance[2] += dx * dz;
+                covariance[3] += dy * dy;
+                covariance[4] += dy * dz;
+                covariance[5] += dz * dz;
+            }
+            sortedNormals[i] = smallestEigenvector(covariance);
+        }
+    });
+
+    if (cancelled()) return {};
+    if (options.orient) orient(sorted, neighbors, k, sortedNormals, options.cancel);
+    if (cancelled()) return {};
+    parallelFor(0, n, NORMAL_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) normals[order[i]] = sortedNormals[i];
+    });
+    return normals;
+}
+
+QVector3D NormalEstimator::smallestEigenvector(const std::array<double, 6> &covariance) {
+    // scaled to the largest entry, the closed form is then the same for the tiny and the huge clouds
+    double scale = 0.0;
+    for (double c : covariance) scale = std::max(scale, std::abs(c));
+    if (!(scale > 0.0) || !std::isfinite(scale)) return QVector3D(0.0f, 0.0f, 1.0f);
+    double a00 = covariance[0] / scale, a01 = covariance[1] / scale, a02 = covariance[2] / scale;
+    double a11 = covariance[3] / scale, a12 = covariance[4] / scale, a22 = covariance[5] / scale;
+
+    // the eigenvalues are q + 2p cos(phi + 2 pi j / 3), the smallest for j = 1
+    double q = (a00 + a11 + a22) / 3.0;
+    double b00 = a00 - q, b11 = a11 - q, b22 = a22 - q;
+    double p = std::sqrt((b00 * b00 + b11 * b11 + b22 * b22 + 2.0 * (a01 * a01 + a02 * a02 + a12 * a12)) / 6.0);
+    if (p < EIGEN_EPSILON) return QVector3D(0.0f, 0.0f, 1.0f);
+    double determinant = b00 * (b11 * b22 - a12 * a12) - a01 * (a01 * b22 - a12 * a02) + a02 * (a01 * a12 - b11 * a02);
+    double r = std::clamp(determinant / (2.0 * p * p * p), -1.0, 1.0);
+    double smallest = q + 2.0 * p * std::cos(std::acos(r) / 3.0 + 2.0 * PI / 3.0);
+
+    // the eigenvector is orthogonal to the rows of A - smallest I, the longest cross product of 2 rows is the most accurate
+    QVector3D rows[3];
+    double m[3][3] = { { a00 - smallest, a01, a02 }, { a01, a11 - smallest, a12 }, { a02, a12, a22 - smallest } };
+    double best[3] = { 0.0, 0.0, 0.0 }, bestLength = 0.0;
+    for (int i = 0; i < 3; i++) {
+        for (int j = i + 1; j < 3; j++) {
+            double c[3] = { m[i][1] * m[j][2] - m[i][2] * m[j][1], m[i][2] * m[j][0] - m[i][0] * m[j][2], m[i][0] * m[j][1] - m[i][1] * m[j][0] };
+            double length = c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+            if (length > bestLength) {
+                bestLength = length;
+                std::copy(c, c + 3, best);
+            }
+        }
+        rows[i] = QVector3D(m[i][0], m[i][1], m[i][2]);
+    }
+    if (bestLength > EIGEN_EPSILON * EIGEN_EPSILON) {
+        double length = std::sqrt(bestLength);
+        return QVector3D(best[0] / length, best[1] / length, best[2] / length);
+    }
+
+    // the 2 smallest eigenvalues are equal, the points are on a line : any direction across it
+    QVector3D line = *std::max_element(rows, rows + 3, [](const QVector3D &a, const QVector3D &b) { return a.lengthSquared() < b.lengthSquared(); });
+    int axis = std::abs(line.x()) <= std::abs(line.y()) && std::abs(line.x()) <= std::abs(line.z()) ? 0 : (std::abs(line.y()) <= std::abs(line.z()) ? 1 : 2);
+    QVector3D other;
+    other[axis] = 1.0f;
+    return QVector3D::crossProduct(line, other).normalized();
+}
+
+std::size_t NormalEstimator::orient(const std::vector<QVector3D> &points, const std::vector<unsigned int> &neighbors, std::size_t k,
+                                    std::vector<QVector3D> &normals, const std::atomic<bool> *cancel) {
+    ScopedTimer timer("NormalEstimator::orient");
+    std::size_t n = points.size();
+    if (n == 0 || k == 0) return 0;
+
+    // the kNN graph isn't symmetric, the reverse edges are added so a point is reached from the points that chose it
+    // most edges are mutual, those are already in both rows
+    std::vector<char> reversed(n * k, 0);
+    parallelFor(0, n, NORMAL_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            for (std::size_t j = 0; j < k; j++) {
+                unsigned int other = neighbors[i * k + j];
+                if (other == KDTree::NO_POINT || other == i) continue;
+                const unsigned int *row = neighbors.data() + std::size_t(other) * k;
+                reversed[i * k + j] = std::find(row, row + k, i) == row + k;
+            }
+        }
+    });
+    std::vector<unsigned int> reverseStart(n + 1, 0), reverse;
+    for (std::size_t e = 0; e < n * k; e++) {
+        if (reversed[e]) reverseStart[neighbors[e] + 1]++;
+    }
+    std::partial_sum(reverseStart.begin(), reverseStart.end(), reverseStart.begin());
+    reverse.resize(reverseStart[n]);
+    std::vector<unsigned int> cursor(reverseStart.begin(), reverseStart.end() - 1);
+    for (std::size_t e = 0; e < n * k; e++) {
+        if (reversed[e]) reverse[cursor[neighbors[e]]++] = e / k;
+    }
+
+    // the weights are in [0, 1], the queue is a bucket per step of angle between the normals instead of a heap :
+    // the edges of a bucket are taken in any order, the tree is minimal up to the step
+    std::vector<std::vector<PendingEdge>> buckets(ORIENT_BUCKETS);
+    std::size_t lowest = 0, queued = 0;
+    std::vector<char> visited(n, 0);
+    std::vector<unsigned int> part;
+    std::vector<unsigned int> lightest(n, ORIENT_BUCKETS); // an edge is only queued if it is lighter than the ones waiting for its point
+    auto visit = [&](unsigned int v) {
+        visited[v] = 1;
+        part.push_back(v);
+        auto push = [&](unsigned int other) {
+            if (other == KDTree::NO_POINT || visited[other]) return;
+            float weight = 1.0f - std::abs(QVector3D::dotProduct(normals[v], normals[other]));
+            unsigned int bucket = std::min<unsigned int>(ORIENT_BUCKETS - 1, std::sqrt(std::max(weight, 0.0f)) * ORIENT_BUCKETS);
+            if (bucket >= lightest[other]) return;
+            lightest[other] = bucket;
+            buckets[bucket].push_back({ other, v });
+            lowest = std::min<std::size_t>(lowest, bucket);
+            queued++;
+        };
+        for (std::size_t j = 0; j < k; j++) push(neighbors[v * k + j]);
+        for (unsigned int j = reverseStart[v]; j < reverseStart[v + 1]; j++) push(reverse[j]);
+    };
+
+    std::size_t parts = 0, taken = 0;
+    for (unsigned int seed = 0; seed < n; seed++) {
+        if (visited[seed]) continue;
+        parts++;
+        part.clear();
+        visit(seed);
+        while (queued > 0) {
+            while (buckets[lowest].empty()) lowest++;
+            PendingEdge edge = buckets[lowest].back();
+            buckets[lowest].pop_back();
+            queued--;
+            if (++taken % ORIENT_CHECK == 0 && cancel && cancel->load()) return parts;
+            if (visited[edge.to]) continue;
+            if (QVector3D::dotProduct(normals[edge.from], normals[edge.to]) < 0.0f) normals[edge.to] = -normals[edge.to];
+            visit(edge.to);
+        }
+        lowest = 0;
+
+        // the signs only agree inside the part, it is turned so its highest normal points up
+        unsigned int top = *std::max_element(part.begin(), part.end(), [&](unsigned int a, unsigned int b) { return points[a].z() < points[b].z(); });
+        if (normals[top].z() < 0.0f) {
+            for (unsigned int v : part) normals[v] = -normals[v];
+        }
+    }
+    return parts;
+}
+
+NormalEstimationJob::NormalEstimationJob(const std::vector<QVector3D> &points, const NormalEstimationOptions &options)
+    : points(points), options(options), stopping(false), finished(false) {
+    this->options.cancel = &stopping;
+    worker = std::thread(&NormalEstimationJob::run, this);
+}
+
+NormalEstimationJob::~NormalEstimationJob() {
+    stopping = true;
+    worker.join();
+}
+
+void NormalEstimationJob::run() {
+    normals = NormalEstimator::estimate(points, options);
+    finished = true;
+}
+
+bool NormalEstimationJob::isFinished() const {
+    return finished;
+}
+
+std::vector<QVector3D> NormalEstimationJob::takeNormals() {
+    std::vector<QVector3D> result;
+    if (finished) result.swap(normals);
+    return result;
+}
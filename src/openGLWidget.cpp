@@ -1,12 +1,81 @@
 #include "openGLWidget.h"
 #include "shaders.h"
+#include "profiler.h"
 
-OpenGLWidget::OpenGLWidget(QWidget *parent) : QOpenGLWidget(parent), VAO(0), VBO(0), EBO(0), shaderLight(nullptr), shaderTexture(nullptr), shaderCurrent(nullptr), texture(nullptr), leftPressed(false), middlePressed(false), wireframe(false), useTexCoords(false) {
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace {
+
+// meshes under this size are drawn at full detail only
+const std::size_t LOD_MIN_FACES = 50000;
+const std::vector<float> LOD_RATIOS = { 0.5f, 0.25f, 0.125f, 0.0625f, 0.03125f };
+// largest error allowed on screen, in pixels
+const float LOD_PIXEL_ERROR = 1.0f;
+
+// faces of a chunk, culled as a whole
+const unsigned int CHUNK_FACES = 2048;
+
+// cells along the bounding box for the proxy drawn while interacting
+const int PROXY_RESOLUTION = 128;
+const float DEFAULT_FRAME_BUDGET_MS = 1000.0f / 30.0f;
+// guess used before any frame has been measured
+const float DEFAULT_TRIANGLES_PER_MS = 100000.0f;
+// delay without mouse motion after which the full detail is drawn again
+const int IDLE_DELAY_MS = 200;
+// a frame time older than this is estimated again from the other levels, so a finer level is tried again
+const qint64 FRAME_SAMPLE_LIFETIME_MS = 2000;
+
+// GPU memory given to the streamed chunks
+const std::size_t STREAM_BUDGET_BYTES = 256 * 1024 * 1024;
+// chunks copied to the GPU per frame, so a fast camera move doesn't stall a frame
+const std::size_t STREAM_UPLOADS_PER_FRAME = 32;
+
+const float DEFAULT_POINT_SIZE = 2.0f;
+
+// timer queries in flight, a result is read this many frames after its query
+const std::size_t TIMER_QUERIES = 3;
+
+// vertices and faces reserved after the full mesh for the local edits, as a fraction of its size
+const float EDIT_RESERVE = 1.0f / 16.0f;
+const std::size_t EDIT_RESERVE_MIN = 1024;
+// interval of the checks for a new iteration of the smoothing
+const int SMOOTHING_POLL_MS = 30;
+// interval of the checks for the end of the estimation of the point normals
+const int NORMALS_POLL_MS = 100;
+// the statistics of an edited mesh are computed again at most once per interval
+const int ANALYSIS_INTERVAL_MS = 500;
 
 }
 
+OpenGLWidget::OpenGLWidget(QWidget *parent) : QOpenGLWidget(parent), VAO(0), VBO(0), EBO(0), shaderLight(nullptr), shaderTexture(nullptr), shaderCurrent(nullptr), texture(nullptr), leftPressed(false), middlePressed(false), meshRadius(0.0f), drawnTriangles(0), adaptive(true), interacting(false), frameLod(-1), frameBudget(DEFAULT_FRAME_BUDGET_MS), drawnLod(-1), optimizeOnLoad(false), spatialOrder(SpatialOrder::NONE), compactVertices(true), indexType(GL_UNSIGNED_INT), indexSize(sizeof(unsigned int)), culledChunks(-1), totalChunks(0), streamVAO(0), streamVBO(0), streamEBO(0), timerFrame(0), gpuMs(-1.0f), selectedFace(-1), selectedVertex(-1), edited(false), bvhStale(false), usedSlots(0), slotCapacity(0), vertexCapacity(0), smoothingTimer(nullptr), preserveBoundary(true), analysisTimer(nullptr), analysisStale(false), pointCloudMode(false), pointNormals(true), normalTimer(nullptr), pointSize(DEFAULT_POINT_SIZE), wireframe(false), useTexCoords(false) {
+    idleTimer = new QTimer(this);
+    idleTimer->setSingleShot(true);
+    idleTimer->setInterval(IDLE_DELAY_MS);
+    connect(idleTimer, &QTimer::timeout, this, &OpenGLWidget::endInteraction);
+    lodClock.start();
+
+    smoothingTimer = new QTimer(this);
+    smoothingTimer->setInterval(SMOOTHING_POLL_MS);
+    connect(smoothingTimer, &QTimer::timeout, this, &OpenGLWidget::pollSmoothing);
+
+    normalTimer = new QTimer(this);
+    normalTimer->setInterval(NORMALS_POLL_MS);
+    connect(normalTimer, &QTimer::timeout, this, &OpenGLWidget::pollPointNormals);
+
+    analysisTimer = new QTimer(this);
+    analysisTimer->setInterval(ANALYSIS_INTERVAL_MS);
+    connect(analysisTimer, &QTimer::timeout, this, &OpenGLWidget::pollAnalysis);
+}
+
 OpenGLWidget::~OpenGLWidget() {
+    smoothing.reset();
+    normalEstimation.reset();
+    analysis.reset();
+    closeChunkFile();
     makeCurrent();
+    if (!timerQueries.empty()) glDeleteQueries(timerQueries.size(), timerQueries.data());
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     delete shaderLight;
@@ -18,10 +87,22 @@ OpenGLWidget::~OpenGLWidget() {
 }
 
 int OpenGLWidget::loadMesh(const char *link) {
-    int ok = mesh.loadFile(link);
+    ScopedTimer timer("OpenGLWidget::loadMesh");
+    smoothingTimer->stop();
+    smoothing.reset();
+    normalTimer->stop();
+    normalEstimation.reset();
+    if (QString(link).endsWith(".mvc", Qt::CaseInsensitive)) return loadChunkFile(link);
+    closeChunkFile();
+
+    // a point cloud is drawn as soon as it is read, the triangulation is asked for later
+    bool points = pointCloudMode && QString(link).endsWith(".txt", Qt::CaseInsensitive);
+    int ok = points ? mesh.loadPoints(link, spatialOrder) : mesh.loadFile(link, spatialOrder);
     if (ok > 0) {
         mesh.clear();
     }
+    const PointFilterStatistics &filtered = mesh.getPointFilterStatistics();
+    if (filtered.pointsIn > 0) emit pointsFiltered(filtered.pointsIn, filtered.pointsOut);
 
     float radius = mesh.getBoundingRadius();
     if (radius > 100.0f) {
@@ -31,11 +112,224 @@ int OpenGLWidget::loadMesh(const char *link) {
     QVector3D center = mesh.getCenter();
 
     camera.initialize(center, radius);
+    meshCenter = center;
+    meshRadius = mesh.getBoundingRadius();
+
+    prepareMesh();
+
+    // the first frame doesn't wait for the normals, the points are drawn unlit until they come
+    if (points && pointNormals && mesh.isPointCloud()) {
+        std::vector<QVector3D> positions(mesh.getVertices().size());
+        for (std::size_t i = 0; i < positions.size(); i++) positions[i] = mesh.getVertices()[i].position;
+        normalEstimation = std::make_unique<NormalEstimationJob>(positions);
+        normalTimer->start();
+    }
+    return ok;
+}
+
+int OpenGLWidget::triangulatePointCloud() {
+    normalTimer->stop();
+    normalEstimation.reset();
+    int ok = mesh.triangulatePoints();
+    if (ok != MeshError::OK) return ok;
+    const PointFilterStatistics &filtered = mesh.getPointFilterStatistics();
+    emit pointsFiltered(filtered.pointsIn, filtered.pointsOut);
+    prepareMesh();
+    return ok;
+}
+
+void OpenGLWidget::prepareMesh() {
+    lods.clear();
+    if (mesh.getFaces().size() >= LOD_MIN_FACES) {
+        lods = Simplifier::buildLodChain(mesh, LOD_RATIOS);
+
+        LevelOfDetail proxy = Simplifier::clusterVertices(mesh, PROXY_RESOLUTION);
+        std::size_t coarsest = lods.empty() ? mesh.getFaces().size() : lods.back().mesh.getFaces().size();
+        if (!proxy.mesh.getFaces().empty() && proxy.mesh.getFaces().size() < coarsest) {
+            lods.push_back(std::move(proxy));
+        }
+    }
+
+    if (optimizeOnLoad && !mesh.isPointCloud()) optimizeMeshIndices();
+
+    bvh.build(mesh.getVertices(), mesh.getFaces());
+    selectedFace = selectedVertex = -1;
+    emit selectionChanged(-1, -1);
+    stopAnalysis();
+    emit meshAnalyzed(MeshAnalysis::analyze(mesh));
+
+    updateMeshBuffers();
+}
+
+void OpenGLWidget::optimizeIndices() {
+    optimizeMeshIndices();
+
+    // the faces moved, the picking must use their new indices
+    bvh.build(mesh.getVertices(), mesh.getFaces());
+    selectedFace = selectedVertex = -1;
+    emit selectionChanged(-1, -1);
+
+    updateMeshBuffers();
+}
+
+void OpenGLWidget::subdivideLoop() {
+    if (streamer || smoothing || mesh.getFaces().empty()) return;
+    mesh.subdivideLoop();
+    prepareMesh();
+}
+
+void OpenGLWidget::subdivideSqrt3() {
+    if (streamer || smoothing || mesh.getFaces().empty()) return;
+    mesh.subdivideSqrt3();
+    prepareMesh();
+}
+
+void OpenGLWidget::smooth(SmoothingMethod method, int iterations) {
+    if (streamer || mesh.isPointCloud() || mesh.getFaces().empty() || iterations <= 0) return;
+    SmoothingOptions options;
+    options.method = method;
+    options.iterations = iterations;
+    options.preserveBoundary = preserveBoundary;
+    smoothing.reset();
+    smoothing = std::make_unique<SmoothingJob>(mesh, options);
+
+    // the levels of detail don't follow the smoothing, the full mesh is drawn until it ends
+    lods.clear();
+    smoothingTimer->start();
+}
+
+void OpenGLWidget::setPreserveBoundary(bool enabled) {
+    preserveBoundary = enabled;
+}
+
+void OpenGLWidget::pollSmoothing() {
+    if (!smoothing) {
+        smoothingTimer->stop();
+        return;
+    }
+
+    // read first, the last positions are published before the job is finished
+    bool finished = smoothing->isFinished();
+    std::vector<QVector3D> positions, normals;
+    int iteration = 0;
+    if (smoothing->takePositions(positions, normals, iteration)) {
+        mesh.setPositions(positions, normals);
+        emit smoothingProgress(iteration, smoothing->getIterations());
+        if (!finished) uploadDirtyRegion();
+    }
+    if (!finished) return;
+
+    // the levels of detail and the picking follow the smoothed mesh
+    smoothingTimer->stop();
+    smoothing.reset();
+    prepareMesh();
+}
+
+void OpenGLWidget::pollPointNormals() {
+    if (!normalEstimation || !normalEstimation->isFinished()) {
+        if (!normalEstimation) normalTimer->stop();
+        return;
+    }
+
+    normalTimer->stop();
+    if (mesh.setPointNormals(normalEstimation->takeNormals()) == MeshError::OK) {
+        updateMeshBuffers();
+        update();
+    }
+    normalEstimation.reset();
+}
+
+void OpenGLWidget::optimizeMeshIndices() {
+    CacheStatistics before, after;
+    mesh.optimizeIndices(&before, &after);
+    for (auto &lod : lods) lod.mesh.optimizeIndices();
+
+    emit indicesOptimized(before, after);
+}
+
+int OpenGLWidget::loadChunkFile(const char *link) {
+    closeChunkFile();
+    int ok = chunkFile.open(link);
 
+    // the streamed mesh replaces the loaded one, its faces can't be picked
+    mesh.clear();
+    lods.clear();
+    bvh.build(mesh.getVertices(), mesh.getFaces());
+    selectedFace = selectedVertex = -1;
+    emit selectionChanged(-1, -1);
+    stopAnalysis();
+    emit meshAnalyzed(MeshStatistics());
     updateMeshBuffers();
+    if (ok != MeshError::OK) return ok;
+
+    const ChunkFileHeader &header = chunkFile.getHeader();
+    QVector3D min(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    QVector3D max(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    QVector3D center = (min + max) * 0.5f;
+    float radius = (max - min).length() * 0.5f;
+
+    // the chunks can't be normalized like a loaded mesh, the model matrix scales them instead
+    streamModel.setToIdentity();
+    if (radius > 100.0f) {
+        streamModel.scale(30.0f / radius);
+        center *= 30.0f / radius;
+        radius = 30.0f;
+    }
+    camera.initialize(center, radius);
+    meshCenter = center;
+    meshRadius = radius;
+
+    std::size_t vertexBytes = header.maxChunkVertices * sizeof(PackedVertex);
+    std::size_t indexBytes = header.maxChunkIndices * sizeof(std::uint16_t);
+    std::size_t slotCount = std::clamp<std::size_t>(STREAM_BUDGET_BYTES / (vertexBytes + indexBytes), 1, header.chunkCount);
+
+    makeCurrent();
+    glGenVertexArrays(1, &streamVAO);
+    glGenBuffers(1, &streamVBO);
+    glGenBuffers(1, &streamEBO);
+
+    glBindVertexArray(streamVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, streamVBO);
+    glBufferData(GL_ARRAY_BUFFER, slotCount * vertexBytes, nullptr, GL_DYNAMIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, streamEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, slotCount * indexBytes, nullptr, GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    doneCurrent();
+
+    streamer = std::make_unique<ChunkStreamer>(chunkFile, slotCount);
+
+    drawnTriangles = 0;
+    culledChunks = -1;
+    emit verticesChanged(header.vertexCount);
+    emit trianglesChanged(drawnTriangles);
+
+    update();
     return ok;
 }
 
+void OpenGLWidget::closeChunkFile() {
+    if (!streamer && !chunkFile.isOpen()) return;
+
+    streamer.reset();
+    chunkFile.close();
+
+    makeCurrent();
+    if (streamVAO) glDeleteVertexArrays(1, &streamVAO);
+    if (streamVBO) glDeleteBuffers(1, &streamVBO);
+    if (streamEBO) glDeleteBuffers(1, &streamEBO);
+    streamVAO = streamVBO = streamEBO = 0;
+    doneCurrent();
+}
+
 int OpenGLWidget::saveMesh(const char *link) {
     int ok = mesh.saveFile(link);
     return ok;
@@ -77,6 +371,7 @@ void OpenGLWidget::deleteTexture() {
 
 
 void OpenGLWidget::updateMeshBuffers() {
+    ScopedTimer timer("OpenGLWidget::updateMeshBuffers");
     makeCurrent();
     glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
 
@@ -84,43 +379,123 @@ void OpenGLWidget::updateMeshBuffers() {
     if (VBO) glDeleteBuffers(1, &VBO);
     if (EBO) glDeleteBuffers(1, &EBO);
 
-    auto vertices = mesh.getVertices();
-    auto indices = mesh.getIndices();
+    // all the levels of detail share the same buffers, each one is drawn with its own base vertex
+    // the faces of each level are grouped by chunk so a chunk is a contiguous range of indices
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::size_t levelVertices = 0;
+    lodRanges.clear();
+    std::fill(timerLods.begin(), timerLods.end(), -1);
+    chunks.clear();
+
+    auto addLevel = [&](const Mesh &level, float error) {
+        std::vector<unsigned int> faceOrder;
+        auto levelChunks = ChunkPartition::build(level.getVertices(), level.getFaces(), CHUNK_FACES, faceOrder);
+        LodRange range = { GLsizei(3 * level.getFaces().size()), indices.size(), GLint(vertices.size()), error, -1.0f, -1.0f, 0,
+                           chunks.size(), levelChunks.size(), level.isClosed() };
+
+        for (auto &c : levelChunks) {
+            c.firstIndex += range.firstIndex;
+            c.baseVertex = range.baseVertex;
+            chunks.push_back(c);
+        }
+        for (unsigned int f : faceOrder) {
+            const auto &v = level.getFaces()[f].idVertices;
+            indices.insert(indices.end(), v.begin(), v.end());
+        }
+        vertices.insert(vertices.end(), level.getVertices().begin(), level.getVertices().end());
+        levelVertices = std::max(levelVertices, level.getVertices().size());
+        lodRanges.push_back(range);
+        return faceOrder;
+    };
+
+    // the full mesh is the last level, the faces and vertices added by the local edits go in the reserve after it
+    for (const auto &lod : lods) addLevel(lod.mesh, lod.error);
+    std::vector<unsigned int> faceOrder = addLevel(mesh, 0.0f);
+    std::rotate(lodRanges.begin(), lodRanges.end() - 1, lodRanges.end());
+
+    faceSlots.assign(faceOrder.size(), 0);
+    for (std::size_t i = 0; i < faceOrder.size(); i++) faceSlots[faceOrder[i]] = i;
+    freeSlots.clear();
+    usedSlots = faceOrder.size();
+    slotCapacity = usedSlots + std::max(EDIT_RESERVE_MIN, std::size_t(usedSlots * EDIT_RESERVE));
+    vertexCapacity = mesh.getVertices().size() + std::max(EDIT_RESERVE_MIN, std::size_t(mesh.getVertices().size() * EDIT_RESERVE));
+    std::size_t reservedVertices = vertexCapacity - mesh.getVertices().size();
+    indices.resize(indices.size() + 3 * (slotCapacity - usedSlots), 0);
+    mesh.clearDirtyRegion();
+    edited = false;
+    bvhStale = false;
 
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
     glBindVertexArray(VAO);
-
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    bool texCoords = useTexCoords && mesh.hasTexture();
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    if (compactVertices) {
+        quantization = VertexCompression::computeQuantization(vertices);
+        auto packed = VertexCompression::packVertices(vertices, quantization);
+        packed.resize(packed.size() + reservedVertices);
+        glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(PackedVertex), packed.data(), GL_STATIC_DRAW);
+        Profiler::addUpload(packed.size() * sizeof(PackedVertex));
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
-    glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+        glEnableVertexAttribArray(0);
 
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+        glEnableVertexAttribArray(1);
+
+        if (texCoords) {
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoords));
+            glEnableVertexAttribArray(2);
+        }
+    } else {
+        quantization = { QVector3D(0, 0, 0), QVector3D(1, 1, 1) };
+        vertices.resize(vertices.size() + reservedVertices, Vertex(QVector3D()));
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+        Profiler::addUpload(vertices.size() * sizeof(Vertex));
 
-    if (useTexCoords && mesh.hasTexture()) {
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
-        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+        glEnableVertexAttribArray(0);
 
-        shaderCurrent = shaderTexture;
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+        glEnableVertexAttribArray(1);
+
+        if (texCoords) {
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+            glEnableVertexAttribArray(2);
+        }
+    }
+
+    // the indices are relative to the base vertex of their level, 16 bits are enough for small levels
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    if (compactVertices && levelVertices <= 65536) {
+        std::vector<std::uint16_t> shortIndices(indices.begin(), indices.end());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(std::uint16_t), shortIndices.data(), GL_STATIC_DRAW);
+        Profiler::addUpload(shortIndices.size() * sizeof(std::uint16_t));
+        indexType = GL_UNSIGNED_SHORT;
+        indexSize = sizeof(std::uint16_t);
     } else {
-        shaderCurrent = shaderLight;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        Profiler::addUpload(indices.size() * sizeof(unsigned int));
+        indexType = GL_UNSIGNED_INT;
+        indexSize = sizeof(unsigned int);
     }
 
+    shaderCurrent = texCoords ? shaderTexture : shaderLight;
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
     doneCurrent();
 
-    emit verticesChanged(vertices.size());
-    emit trianglesChanged(indices.size() / 3);
+    drawnTriangles = mesh.getFaces().size();
+    drawnLod = -1;
+    culledChunks = -1;
+    emit verticesChanged(mesh.getVertices().size());
+    emit trianglesChanged(drawnTriangles);
 
     update();
 }
@@ -130,6 +505,45 @@ void OpenGLWidget::setWireframe(bool enabled) {
     update();
 }
 
+void OpenGLWidget::setAdaptiveRendering(bool enabled) {
+    adaptive = enabled;
+    update();
+}
+
+void OpenGLWidget::setCompactVertices(bool enabled) {
+    compactVertices = enabled;
+    if (!lodRanges.empty()) updateMeshBuffers();
+}
+
+void OpenGLWidget::setOptimizeOnLoad(bool enabled) {
+    optimizeOnLoad = enabled;
+}
+
+void OpenGLWidget::setPointCloudMode(bool enabled) {
+    pointCloudMode = enabled;
+}
+
+void OpenGLWidget::setPointNormals(bool enabled) {
+    pointNormals = enabled;
+}
+
+void OpenGLWidget::setPointSize(double size) {
+    pointSize = size;
+    update();
+}
+
+void OpenGLWidget::setPointFilter(const PointFilterOptions &options) {
+    mesh.setPointFilter(options);
+}
+
+void OpenGLWidget::setFrameBudget(float ms) {
+    frameBudget = ms;
+}
+
+void OpenGLWidget::setSpatialOrder(SpatialOrder order) {
+    spatialOrder = order;
+}
+
 void OpenGLWidget::initializeGL() {
     initializeOpenGLFunctions();
     glEnable(GL_DEPTH_TEST);
@@ -149,6 +563,10 @@ void OpenGLWidget::initializeGL() {
 
     shaderCurrent = shaderLight;
 
+    timerQueries.resize(TIMER_QUERIES);
+    timerLods.assign(TIMER_QUERIES, -1);
+    glGenQueries(timerQueries.size(), timerQueries.data());
+
     emit verticesChanged(0);
     emit trianglesChanged(0);
 }
@@ -160,12 +578,53 @@ void OpenGLWidget::resizeGL(int w, int h) {
 }
 
 void OpenGLWidget::paintGL() {
+    std::int64_t start = Profiler::now();
+
+    // the GPU time is read a few frames later, so the CPU never waits for it
+    std::size_t slot = timerQueries.empty() ? 0 : timerFrame % timerQueries.size();
+    GLuint query = timerQueries.empty() ? 0 : timerQueries[slot];
+    if (query && timerFrame >= timerQueries.size()) {
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+            gpuMs = ns / 1e6f;
+            addFrameSample(timerLods[slot], gpuMs, true);
+        }
+    }
+    if (query) glBeginQuery(GL_TIME_ELAPSED, query);
+
+    drawFrame();
+
+    if (query) {
+        glEndQuery(GL_TIME_ELAPSED);
+        timerLods[slot] = frameLod;
+        timerFrame++;
+    }
+
+    // the time spent waiting for the events between 2 frames isn't a cost of the level drawn
+    std::int64_t duration = Profiler::now() - start;
+    addFrameSample(frameLod, duration / 1000.0f, false);
+    Profiler::addEvent("OpenGLWidget::paintGL", start, duration);
+    Profiler::addFrame(duration / 1000.0f, gpuMs, drawnTriangles);
+}
+
+void OpenGLWidget::drawFrame() {
+    // only the frames of a level of detail are measured, not the points, the edits or the streamed chunks
+    frameLod = -1;
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     if (wireframe) glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     else glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
-    auto indices = mesh.getIndices();
+    if (streamer) {
+        paintStreamed(camera.getView(), camera.getProjection());
+        return;
+    }
+
+    if (lodRanges.empty()) return;
 
     QMatrix4x4 model, view, projection;
     model.setToIdentity();
@@ -177,20 +636,224 @@ void OpenGLWidget::paintGL() {
     shaderCurrent->setUniformValue("model", model);
     shaderCurrent->setUniformValue("view", view);
     shaderCurrent->setUniformValue("projection", projection);
+    shaderCurrent->setUniformValue("positionOffset", quantization.offset);
+    shaderCurrent->setUniformValue("positionScale", quantization.scale);
+    shaderCurrent->setUniformValue("octNormal", compactVertices);
+    shaderCurrent->setUniformValue("shading", !mesh.isPointCloud() || mesh.hasPointNormals());
 
     if (useTexCoords) {
         texture->bind(0);
         shaderCurrent->setUniformValue("textureSampler", 0);
     }
 
+    if (mesh.isPointCloud()) {
+        // the points are lit with their estimated normals, or unlit without them, with a fixed size on screen
+        glPointSize(pointSize);
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_POINTS, 0, mesh.getVertices().size());
+        glBindVertexArray(0);
+        shaderCurrent->release();
+        if (drawnTriangles != 0) {
+            drawnTriangles = 0;
+            emit trianglesChanged(drawnTriangles);
+        }
+        return;
+    }
+
+    if (edited) {
+        // the chunks were cut before the edits, the removed faces are degenerate triangles
+        const LodRange &range = lodRanges[0];
+        drawnLod = 0;
+        glBindVertexArray(VAO);
+        glDrawElementsBaseVertex(GL_TRIANGLES, GLsizei(3 * usedSlots), indexType, (const void*)(range.firstIndex * indexSize), range.baseVertex);
+        glBindVertexArray(0);
+        shaderCurrent->release();
+        return;
+    }
+
+    drawnLod = selectLod(projection);
+    if (adaptive && interacting) drawnLod = std::max(drawnLod, selectInteractiveLod());
+    frameLod = drawnLod;
+    const LodRange &range = lodRanges[drawnLod];
+
+    // the lines of the hidden faces are visible in wireframe, only the frustum can cull them
+    bool coneCulling = range.closed && !wireframe;
+    int culled = ChunkPartition::cull(chunks, range.firstChunk, range.chunkCount, Frustum(projection * view * model),
+                                      camera.getPosition(), coneCulling, visibleChunks);
+
+    drawCounts.clear();
+    drawOffsets.clear();
+    drawBaseVertices.clear();
+    int triangles = 0;
+    for (std::size_t i = 0; i < range.chunkCount; i++) {
+        if (!visibleChunks[i]) continue;
+        const Chunk &c = chunks[range.firstChunk + i];
+        drawCounts.push_back(c.indexCount);
+        drawOffsets.push_back((const void*)(c.firstIndex * indexSize));
+        drawBaseVertices.push_back(c.baseVertex);
+        triangles += c.indexCount / 3;
+    }
+
     glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    if (!drawCounts.empty()) {
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawCounts.data(), indexType, drawOffsets.data(),
+                                      drawCounts.size(), drawBaseVertices.data());
+    }
     glBindVertexArray(0);
     shaderCurrent->release();
+
+    if (triangles != drawnTriangles) {
+        drawnTriangles = triangles;
+        emit trianglesChanged(drawnTriangles);
+    }
+    if (culled != culledChunks || (int)range.chunkCount != totalChunks) {
+        culledChunks = culled;
+        totalChunks = range.chunkCount;
+        emit chunksCulled(culledChunks, totalChunks);
+    }
+}
+
+void OpenGLWidget::paintStreamed(const QMatrix4x4 &view, const QMatrix4x4 &projection) {
+    shaderLight->bind();
+    shaderLight->setUniformValue("model", streamModel);
+    shaderLight->setUniformValue("view", view);
+    shaderLight->setUniformValue("projection", projection);
+    shaderLight->setUniformValue("positionOffset", chunkFile.getQuantization().offset);
+    shaderLight->setUniformValue("positionScale", chunkFile.getQuantization().scale);
+    shaderLight->setUniformValue("octNormal", true);
+    shaderLight->setUniformValue("shading", true);
+
+    // the chunks are culled in their own space, the model matrix only scales them
+    QVector3D eye = streamModel.inverted().map(camera.getPosition());
+    std::size_t streaming = streamer->update(Frustum(projection * view * streamModel), eye, streamVisible);
+
+    const ChunkFileHeader &header = chunkFile.getHeader();
+    std::size_t vertexBytes = header.maxChunkVertices * sizeof(PackedVertex);
+    std::size_t indexBytes = header.maxChunkIndices * sizeof(std::uint16_t);
+
+    glBindVertexArray(streamVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, streamVBO);
+    for (const auto &c : streamer->takeLoaded(STREAM_UPLOADS_PER_FRAME)) {
+        glBufferSubData(GL_ARRAY_BUFFER, c.slot * vertexBytes, c.vertices.size() * sizeof(PackedVertex), c.vertices.data());
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, c.slot * indexBytes, c.indices.size() * sizeof(std::uint16_t), c.indices.data());
+        Profiler::addUpload(c.vertices.size() * sizeof(PackedVertex) + c.indices.size() * sizeof(std::uint16_t));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    drawCounts.clear();
+    drawOffsets.clear();
+    drawBaseVertices.clear();
+    int triangles = 0;
+    for (unsigned int chunk : streamVisible) {
+        int slot = streamer->slotOf(chunk);
+        if (slot < 0) continue;
+        const ChunkRecord &record = chunkFile.getChunks()[chunk];
+        drawCounts.push_back(record.indexCount);
+        drawOffsets.push_back((const void*)(slot * indexBytes));
+        drawBaseVertices.push_back(slot * header.maxChunkVertices);
+        triangles += record.indexCount / 3;
+    }
+
+    if (!drawCounts.empty()) {
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawCounts.data(), GL_UNSIGNED_SHORT, drawOffsets.data(),
+                                      drawCounts.size(), drawBaseVertices.data());
+    }
+    glBindVertexArray(0);
+    shaderLight->release();
+
+    if (triangles != drawnTriangles) {
+        drawnTriangles = triangles;
+        emit trianglesChanged(drawnTriangles);
+    }
+    int culled = header.chunkCount - streamVisible.size();
+    if (culled != culledChunks || (int)header.chunkCount != totalChunks) {
+        culledChunks = culled;
+        totalChunks = header.chunkCount;
+        emit chunksCulled(culledChunks, totalChunks);
+    }
+
+    // drawn again until the visible chunks are resident
+    if (streaming > 0) update();
+}
+
+int OpenGLWidget::selectLod(const QMatrix4x4 &projection) const {
+    if (lodRanges.size() <= 1) return 0;
+
+    // projection(1, 1) is cot(fov / 2), it gives the pixels covered by a world unit at a given distance
+    float distance = std::max((camera.getPosition() - meshCenter).length() - meshRadius, 1e-3f);
+    float pixelsPerUnit = projection(1, 1) * height() * 0.5f / distance;
+
+    int selected = 0;
+    for (std::size_t i = 1; i < lodRanges.size(); i++) {
+        if (lodRanges[i].error * pixelsPerUnit > LOD_PIXEL_ERROR) break;
+        selected = i;
+    }
+    return selected;
+}
+
+int OpenGLWidget::selectInteractiveLod() const {
+    int current = std::max(drawnLod, 0);
+    for (std::size_t i = 0; i < lodRanges.size(); i++) {
+        // going back to a finer level needs some margin, so the levels don't flicker
+        float budget = (int)i < current ? frameBudget * 0.8f : frameBudget;
+        if (estimateFrameTime(i) <= budget) return i;
+    }
+    return lodRanges.size() - 1;
+}
+
+void OpenGLWidget::addFrameSample(int lod, float ms, bool gpu) {
+    if (lod < 0 || lod >= (int)lodRanges.size() || ms <= 0.0f || ms >= 1000.0f) return;
+    LodRange &range = lodRanges[lod];
+    float &measured = gpu ? range.gpuMs : range.cpuMs;
+    qint64 now = lodClock.elapsed();
+    bool stale = now - range.measuredAt > FRAME_SAMPLE_LIFETIME_MS;
+    measured = measured < 0.0f || stale ? ms : 0.8f * measured + 0.2f * ms;
+    if (stale) (gpu ? range.cpuMs : range.gpuMs) = -1.0f;
+    range.measuredAt = now;
+}
+
+float OpenGLWidget::measuredFrameTime(int lod) const {
+    const LodRange &range = lodRanges[lod];
+    if (lodClock.elapsed() - range.measuredAt > FRAME_SAMPLE_LIFETIME_MS) return -1.0f;
+    // the CPU and the GPU work at the same time, the slowest one gives the frame rate
+    return std::max(range.cpuMs, range.gpuMs);
+}
+
+float OpenGLWidget::estimateFrameTime(int lod) const {
+    float measured = measuredFrameTime(lod);
+    if (measured >= 0.0f) return measured;
+
+    int closest = -1;
+    float closestMs = -1.0f;
+    for (int i = 0; i < (int)lodRanges.size(); i++) {
+        float ms = measuredFrameTime(i);
+        if (ms < 0.0f) continue;
+        if (closest < 0 || std::abs(i - lod) < std::abs(closest - lod)) {
+            closest = i;
+            closestMs = ms;
+        }
+    }
+
+    float triangles = std::max(lodRanges[lod].indexCount / 3, 1);
+    if (closest < 0) return triangles / DEFAULT_TRIANGLES_PER_MS;
+    return closestMs * triangles / std::max(lodRanges[closest].indexCount / 3, 1);
+}
+
+void OpenGLWidget::beginInteraction() {
+    interacting = true;
+    idleTimer->start();
+}
+
+void OpenGLWidget::endInteraction() {
+    idleTimer->stop();
+    if (!interacting) return;
+    interacting = false;
+    update();
 }
 
 void OpenGLWidget::mousePressEvent(QMouseEvent *event) {
     lastMousePos = event->position();
+    pressMousePos = event->position();
 }
 
 void OpenGLWidget::mouseMoveEvent(QMouseEvent *event) {
@@ -198,17 +861,220 @@ void OpenGLWidget::mouseMoveEvent(QMouseEvent *event) {
     lastMousePos = event->position();
 
     if (event->buttons() & Qt::LeftButton) {
+        beginInteraction();
         camera.orbit(delta.x(), delta.y());
         update();
     }
 
     if (event->buttons() & Qt::RightButton) {
+        beginInteraction();
         camera.pan(delta.x(), delta.y());
         update();
     }
 }
 
+void OpenGLWidget::mouseReleaseEvent(QMouseEvent *event) {
+    endInteraction();
+
+    if (event->button() == Qt::LeftButton && (event->position() - pressMousePos).manhattanLength() < 3.0) {
+        pick(event->position());
+    }
+}
+
+void OpenGLWidget::pick(const QPointF &pos) {
+    if (bvhStale) {
+        bvh.build(mesh.getVertices(), mesh.getFaces());
+        bvhStale = false;
+    }
+    if (bvh.isEmpty() || width() <= 0 || height() <= 0) return;
+
+    float x = 2.0f * pos.x() / width() - 1.0f;
+    float y = 1.0f - 2.0f * pos.y() / height();
+
+    QMatrix4x4 inverse = (camera.getProjection() * camera.getView()).inverted();
+    QVector3D nearPoint = inverse.map(QVector3D(x, y, -1.0f));
+    QVector3D farPoint = inverse.map(QVector3D(x, y, 1.0f));
+
+    RayHit hit;
+    int vertex = -1;
+    if (bvh.intersect(Ray(nearPoint, (farPoint - nearPoint).normalized()), hit)) {
+        // barycentric weights of the hit point are (1 - u - v, u, v)
+        const Triangle &face = mesh.getFaces()[hit.face];
+        float w = 1.0f - hit.u - hit.v;
+        int local = (w >= hit.u && w >= hit.v) ? 0 : (hit.u >= hit.v ? 1 : 2);
+        vertex = face.idVertices[local];
+    }
+
+    selectedFace = vertex < 0 ? -1 : hit.face;
+    selectedVertex = vertex;
+    emit selectionChanged(selectedFace, selectedVertex);
+}
+
 void OpenGLWidget::wheelEvent(QWheelEvent *event) {
+    beginInteraction();
     camera.zoom(event->angleDelta().y() / 120.0f);
     update();
 }
+
+void OpenGLWidget::splitSelectedEdge() {
+    editSelection([this](unsigned int face, int edge) {
+        const Triangle &f = mesh.getFaces()[face];
+        QVector3D a = mesh.getVertices()[f.idVertices[edge]].position;
+        QVector3D b = mesh.getVertices()[f.idVertices[(edge + 1) % 3]].position;
+        return mesh.splitEdge(face, edge, (a + b) * 0.5f) >= 0;
+    });
+}
+
+void OpenGLWidget::flipSelectedEdge() {
+    editSelection([this](unsigned int face, int edge) { return mesh.flipEdge(face, edge); });
+}
+
+void OpenGLWidget::collapseSelectedEdge() {
+    editSelection([this](unsigned int face, int edge) { return mesh.collapseEdge(face, edge) >= 0; });
+}
+
+void OpenGLWidget::insertVertexInSelection() {
+    editSelection([this](unsigned int face, int) {
+        const Triangle &f = mesh.getFaces()[face];
+        QVector3D center(0, 0, 0);
+        for (unsigned int v : f.idVertices) center += mesh.getVertices()[v].position;
+        return mesh.insertVertex(face, center * (1.0f / 3.0f)) >= 0;
+    });
+}
+
+void OpenGLWidget::editSelection(const std::function<bool(unsigned int, int)> &edit) {
+    if (streamer || smoothing || mesh.isPointCloud() || selectedFace < 0 || selectedFace >= (int)mesh.getFaces().size()) return;
+    int edge = mesh.getFaces()[selectedFace].localIndex(selectedVertex);
+    if (edge < 0 || !edit(selectedFace, edge)) return;
+
+    // the levels of detail don't follow the edits, the full mesh is drawn until the next load
+    lods.clear();
+    selectedFace = selectedVertex = -1;
+    emit selectionChanged(-1, -1);
+
+    // the whole mesh is analyzed again, on a worker and not after each edit of a fast series
+    analysisStale = true;
+    if (!analysisTimer->isActive()) analysisTimer->start();
+    uploadDirtyRegion();
+}
+
+void OpenGLWidget::pollAnalysis() {
+    if (analysis) {
+        if (!analysis->isFinished()) return;
+        emit meshAnalyzed(analysis->getStatistics());
+        analysis.reset();
+    }
+    if (!analysisStale) {
+        analysisTimer->stop();
+        return;
+    }
+    analysisStale = false;
+    analysis = std::make_unique<MeshAnalysisJob>(mesh);
+}
+
+void OpenGLWidget::stopAnalysis() {
+    analysisTimer->stop();
+    analysis.reset();
+    analysisStale = false;
+}
+
+void OpenGLWidget::uploadDirtyRegion() {
+    ScopedTimer timer("OpenGLWidget::uploadDirtyRegion");
+    DirtyRegion region = mesh.getDirtyRegion();
+    mesh.clearDirtyRegion();
+    region.compact();
+    if (region.isEmpty() || lodRanges.empty()) return;
+    edited = true;
+    bvhStale = true;
+
+    const auto &vertices = mesh.getVertices();
+    const auto &faces = mesh.getFaces();
+
+    // the slots of the dirty faces are given back, then taken again by the faces still there
+    std::map<unsigned int, std::array<unsigned int, 3>> slotFaces;
+    for (unsigned int f : region.faces) {
+        if (f >= faceSlots.size()) continue;
+        freeSlots.push_back(faceSlots[f]);
+        slotFaces[faceSlots[f]] = { 0, 0, 0 };
+    }
+    faceSlots.resize(faces.size());
+    for (unsigned int f : region.faces) {
+        if (f >= faces.size()) continue;
+        if (freeSlots.empty()) freeSlots.push_back(usedSlots++);
+        faceSlots[f] = freeSlots.back();
+        freeSlots.pop_back();
+        const auto &v = faces[f].idVertices;
+        slotFaces[faceSlots[f]] = { v[0], v[1], v[2] };
+    }
+
+    // a vertex moved out of the quantization box, by a Taubin step for instance, needs a new box
+    bool outside = false;
+    if (compactVertices) {
+        for (unsigned int v : region.vertices) {
+            if (v >= vertices.size()) continue;
+            QVector3D error = VertexCompression::unpack(VertexCompression::pack(vertices[v], quantization), quantization).position - vertices[v].position;
+            if (std::abs(error.x()) > quantization.scale.x() || std::abs(error.y()) > quantization.scale.y() || std::abs(error.z()) > quantization.scale.z()) {
+                outside = true;
+                break;
+            }
+        }
+    }
+
+    bool shortIndices = indexType == GL_UNSIGNED_SHORT;
+    if (outside || usedSlots > slotCapacity || vertices.size() > vertexCapacity || (shortIndices && vertices.size() > 65536)) {
+        updateMeshBuffers();
+        return;
+    }
+
+    makeCurrent();
+    const LodRange &range = lodRanges[0];
+    std::size_t uploaded = 0;
+
+    // consecutive indices are sent in one call
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    std::size_t vertexBytes = compactVertices ? sizeof(PackedVertex) : sizeof(Vertex);
+    for (std::size_t first = 0; first < region.vertices.size();) {
+        std::size_t last = first + 1;
+        while (last < region.vertices.size() && region.vertices[last] == region.vertices[last - 1] + 1) last++;
+        unsigned int begin = region.vertices[first];
+        unsigned int end = std::min<std::size_t>(region.vertices[last - 1] + 1, vertices.size());
+        if (begin < end) {
+            std::vector<Vertex> run(vertices.begin() + begin, vertices.begin() + end);
+            GLintptr offset = (range.baseVertex + begin) * vertexBytes;
+            if (compactVertices) {
+                auto packed = VertexCompression::packVertices(run, quantization);
+                glBufferSubData(GL_ARRAY_BUFFER, offset, packed.size() * vertexBytes, packed.data());
+            } else {
+                glBufferSubData(GL_ARRAY_BUFFER, offset, run.size() * vertexBytes, run.data());
+            }
+            uploaded += (end - begin) * vertexBytes;
+        }
+        first = last;
+    }
+
+    glBindVertexArray(VAO);
+    for (auto it = slotFaces.begin(); it != slotFaces.end();) {
+        unsigned int begin = it->first;
+        std::vector<unsigned int> run;
+        for (unsigned int next = begin; it != slotFaces.end() && it->first == next; ++it, ++next) {
+            run.insert(run.end(), it->second.begin(), it->second.end());
+        }
+        GLintptr offset = (range.firstIndex + 3 * begin) * indexSize;
+        if (shortIndices) {
+            std::vector<std::uint16_t> shortRun(run.begin(), run.end());
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, shortRun.size() * indexSize, shortRun.data());
+        } else {
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, run.size() * indexSize, run.data());
+        }
+        uploaded += run.size() * indexSize;
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    Profiler::addUpload(uploaded);
+    doneCurrent();
+
+    drawnTriangles = faces.size();
+    emit verticesChanged(vertices.size());
+    emit trianglesChanged(drawnTriangles);
+    update();
+}
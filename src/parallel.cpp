@@ -0,0 +1,48 @@
+#include "parallel.h"
+#include "taskScheduler.h"
+
+#include <algorithm>
+
+namespace {
+
+// blocks per thread, the idle threads steal the blocks left by the slow ones
+const std::size_t BLOCKS_PER_THREAD = 4;
+
+}
+
+unsigned int parallelThreadCount() {
+    return TaskScheduler::getThreadCount();
+}
+
+void parallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+                 const std::function<void(std::size_t, std::size_t)> &body) {
+    if (end <= begin) return;
+
+    std::size_t count = end - begin;
+    grain = std::max<std::size_t>(grain, 1);
+    unsigned int threads = parallelThreadCount();
+    std::size_t maxBlocks = threads == 1 ? 1 : threads * BLOCKS_PER_THREAD;
+    std::size_t blocks = std::min<std::size_t>(maxBlocks, (count + grain - 1) / grain);
+
+    if (blocks <= 1) {
+        body(begin, end);
+        return;
+    }
+
+    std::size_t blockSize = (count + blocks - 1) / blocks;
+    TaskGroup group;
+    for (std::size_t first = begin + blockSize; first < end; first += blockSize) {
+        std::size_t last = std::min(end, first + blockSize);
+        group.run([&body, first, last]() { body(first, last); });
+    }
+
+    body(begin, std::min(end, begin + blockSize));
+    group.wait();
+}
+
+void parallelInvoke(const std::function<void()> &a, const std::function<void()> &b) {
+    TaskGroup group;
+    group.run(a);
+    b();
+    group.wait();
+}
@@ -0,0 +1,180 @@
+#include "pointFilter.h"
+#include "edgeKeyHash.h"
+#include "parallel.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+
+// points processed by one task
+const std::size_t FILTER_GRAIN = 1 << 14;
+// buckets of cells reduced per thread, more buckets balance the stealing better
+const std::size_t FILTER_BUCKETS_PER_THREAD = 8;
+
+// the points of a cell, reduced to one
+struct CellPoints {
+    unsigned int first;
+    unsigned int closest;
+    float closestDistance;
+    std::array<double, 3> sum;
+    std::size_t count;
+};
+
+}
+
+PointFilterStatistics PointFilter::filter(std::vector<QVector3D> &points, const PointFilterOptions &options) {
+    ScopedTimer timer("PointFilter::filter");
+    PointFilterStatistics statistics;
+    statistics.pointsIn = points.size();
+    std::size_t n = points.size();
+    bool voxels = options.voxelSize > 0.0f;
+    float size = voxels ? options.voxelSize : std::max(options.epsilon, 0.0f);
+    int axes = options.planar ? 2 : 3;
+
+    std::vector<PositionKey> keys(n);
+    parallelFor(0, n, FILTER_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            PositionKey k = { 0, 0, 0 };
+            for (int axis = 0; axis < axes; axis++) {
+                k[axis] = size > 0.0f ? std::int64_t(std::floor(points[i][axis] / size)) : coordinateBits(points[i][axis]);
+            }
+            keys[i] = k;
+        }
+    });
+
+    // the points of a cell fall in the same bucket in the order of the cloud, like the halfedges of the sewing
+    std::size_t blocks = n < FILTER_GRAIN ? 1 : parallelThreadCount();
+    std::size_t buckets = blocks == 1 ? 1 : blocks * FILTER_BUCKETS_PER_THREAD;
+    auto blockBegin = [&](std::size_t b) { return n * b / blocks; };
+    std::vector<std::size_t> bucketOf(n);
+    std::vector<std::vector<std::size_t>> offsets(blocks, std::vector<std::size_t>(buckets, 0));
+    parallelFor(0, blocks, 1, [&](std::size_t first, std::size_t last) {
+        for (std::size_t b = first; b < last; b++) {
+            for (std::size_t i = blockBegin(b); i < blockBegin(b + 1); i++) {
+                bucketOf[i] = PositionKeyHash()(keys[i]) % buckets;
+                offsets[b][bucketOf[i]]++;
+            }
+        }
+    });
+
+    std::vector<std::size_t> bucketBegin(buckets + 1, 0);
+    std::size_t offset = 0;
+    for (std::size_t k = 0; k < buckets; k++) {
+        bucketBegin[k] = offset;
+        for (std::size_t b = 0; b < blocks; b++) {
+            std::size_t count = offsets[b][k];
+            offsets[b][k] = offset;
+            offset += count;
+        }
+    }
+    bucketBegin[buckets] = offset;
+
+    std::vector<unsigned int> order(n);
+    parallelFor(0, blocks, 1, [&](std::size_t first, std::size_t last) {
+        for (std::size_t b = first; b < last; b++) {
+            for (std::size_t i = blockBegin(b); i < blockBegin(b + 1); i++) order[offsets[b][bucketOf[i]]++] = i;
+        }
+    });
+
+    // each cell writes its point at the index of its first point, the cells don't share it
+    // the first points of the cells of each bucket are kept to find the duplicates across the cell borders
+    bool borders = !voxels && size > 0.0f;
+    std::vector<std::unordered_map<PositionKey, unsigned int, PositionKeyHash>> firstPoints(borders ? buckets : 0);
+    std::vector<QVector3D> reduced(n);
+    std::vector<unsigned char> kept(n, 0);
+    parallelFor(0, buckets, 1, [&](std::size_t first, std::size_t last) {
+        std::unordered_map<PositionKey, std::size_t, PositionKeyHash> cellIndex;
+        std::vector<CellPoints> cells;
+        for (std::size_t k = first; k < last; k++) {
+            cellIndex.clear();
+            cells.clear();
+            for (std::size_t h = bucketBegin[k]; h < bucketBegin[k + 1]; h++) {
+                unsigned int i = order[h];
+                auto [it, inserted] = cellIndex.emplace(keys[i], cells.size());
+                if (inserted) cells.push_back({ i, i, std::numeric_limits<float>::max(), { 0.0, 0.0, 0.0 }, 0 });
+                if (!voxels) continue;
+
+                CellPoints &cell = cells[it->second];
+                const QVector3D &p = points[i];
+                float distance = 0.0f;
+                for (int axis = 0; axis < axes; axis++) {
+                    float d = p[axis] - (float(keys[i][axis]) + 0.5f) * size;
+                    distance += d * d;
+                }
+                if (distance < cell.closestDistance) {
+                    cell.closest = i;
+                    cell.closestDistance = distance;
+                }
+                for (int axis = 0; axis < 3; axis++) cell.sum[axis] += p[axis];
+                cell.count++;
+            }
+
+            for (const CellPoints &cell : cells) {
+                kept[cell.first] = 1;
+                if (borders) firstPoints[k].emplace(keys[cell.first], cell.first);
+                if (!voxels) reduced[cell.first] = points[cell.first];
+                else if (options.voxelPoint == VoxelPoint::CLOSEST) reduced[cell.first] = points[cell.closest];
+                else reduced[cell.first] = QVector3D(cell.sum[0] / cell.count, cell.sum[1] / cell.count, cell.sum[2] / cell.count);
+            }
+        }
+    });
+
+    if (borders) removeBorderDuplicates(points, keys, firstPoints, size, axes, kept);
+
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        if (kept[i]) points[out++] = reduced[i];
+    }
+    points.resize(out);
+    statistics.pointsOut = out;
+    return statistics;
+}
+
+void PointFilter::removeBorderDuplicates(const std::vector<QVector3D> &points, const std::vector<PositionKey> &keys,
+                                         const std::vector<std::unordered_map<PositionKey, unsigned int, PositionKeyHash>> &firstPoints,
+                                         float epsilon, int axes, std::vector<unsigned char> &kept) {
+    std::size_t n = points.size();
+    std::size_t buckets = firstPoints.size();
+    float squaredEpsilon = epsilon * epsilon;
+
+    // the kept points closer than epsilon to an earlier kept point of a neighbor cell, usually few, found on all the threads
+    std::size_t blocks = (n + FILTER_GRAIN - 1) / FILTER_GRAIN;
+    std::vector<std::vector<std::pair<unsigned int, unsigned int>>> found(blocks);
+    parallelFor(0, blocks, 1, [&](std::size_t b0, std::size_t b1) {
+        for (std::size_t b = b0; b < b1; b++) {
+            for (std::size_t i = b * FILTER_GRAIN; i < std::min(n, (b + 1) * FILTER_GRAIN); i++) {
+                if (!kept[i]) continue;
+                for (int dz = axes == 3 ? -1 : 0; dz <= (axes == 3 ? 1 : 0); dz++) {
+                    for (int dy = -1; dy <= 1; dy++) {
+                        for (int dx = -1; dx <= 1; dx++) {
+                            if (dx == 0 && dy == 0 && dz == 0) continue;
+                            PositionKey neighbor = { keys[i][0] + dx, keys[i][1] + dy, keys[i][2] + dz };
+                            const auto &cells = firstPoints[PositionKeyHash()(neighbor) % buckets];
+                            auto it = cells.find(neighbor);
+                            if (it == cells.end() || it->second >= i) continue;
+                            float distance = 0.0f;
+                            for (int axis = 0; axis < axes; axis++) {
+                                float d = points[i][axis] - points[it->second][axis];
+                                distance += d * d;
+                            }
+                            if (distance < squaredEpsilon) found[b].push_back({ unsigned(i), it->second });
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    // in the order of the cloud, a point is removed if one of its earlier duplicates is still kept
+    std::vector<std::pair<unsigned int, unsigned int>> duplicates;
+    for (const auto &block : found) duplicates.insert(duplicates.end(), block.begin(), block.end());
+    std::sort(duplicates.begin(), duplicates.end());
+    for (const auto &[point, earlier] : duplicates) {
+        if (kept[earlier]) kept[point] = 0;
+    }
+}
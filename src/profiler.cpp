@@ -0,0 +1,184 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// oldest events dropped above this count, about 32 MB
+const std::size_t MAX_EVENTS = 1 << 20;
+// frames kept for the rolling statistics
+const std::size_t FRAME_HISTORY = 240;
+
+struct TraceEvent {
+    const char *name;
+    std::int64_t start;
+    std::int64_t duration; // the value of a counter
+    std::uint32_t thread;
+    char phase; // 'X' for a timed event, 'C' for a counter
+};
+
+struct FrameRecord {
+    float cpuMs;
+    float gpuMs;
+    int triangles;
+    std::size_t uploadedBytes;
+};
+
+struct ProfilerState {
+    std::atomic<bool> enabled{ true };
+    std::mutex mutex;
+    std::deque<TraceEvent> events;
+    std::deque<FrameRecord> frames;
+    std::size_t pendingBytes = 0;
+    std::uint64_t totalBytes = 0;
+};
+
+ProfilerState &state() {
+    static ProfilerState s;
+    return s;
+}
+
+const std::chrono::steady_clock::time_point START = std::chrono::steady_clock::now();
+
+std::uint32_t threadId() {
+    static std::atomic<std::uint32_t> next{ 1 };
+    thread_local std::uint32_t id = next++;
+    return id;
+}
+
+void record(const TraceEvent &event) {
+    ProfilerState &s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.events.size() >= MAX_EVENTS) s.events.pop_front();
+    s.events.push_back(event);
+}
+
+void writeName(std::ofstream &out, const char *name) {
+    out << '"';
+    for (const char *c = name; *c; c++) {
+        if (*c == '"' || *c == '\\') out << '\\';
+        out << *c;
+    }
+    out << '"';
+}
+
+}
+
+void Profiler::setEnabled(bool enabled) {
+    state().enabled = enabled;
+}
+
+bool Profiler::isEnabled() {
+    return state().enabled;
+}
+
+std::int64_t Profiler::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - START).count();
+}
+
+void Profiler::addEvent(const char *name, std::int64_t start, std::int64_t duration) {
+    if (!isEnabled()) return;
+    record({ name, start, duration, threadId(), 'X' });
+}
+
+void Profiler::addCounter(const char *name, std::int64_t value) {
+    if (!isEnabled()) return;
+    record({ name, now(), value, threadId(), 'C' });
+}
+
+void Profiler::addUpload(std::size_t bytes) {
+    if (!isEnabled()) return;
+    std::int64_t total;
+    {
+        ProfilerState &s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.pendingBytes += bytes;
+        s.totalBytes += bytes;
+        total = s.totalBytes;
+    }
+    addCounter("uploadedBytes", total);
+}
+
+void Profiler::addFrame(float cpuMs, float gpuMs, int triangles) {
+    if (!isEnabled()) return;
+    ProfilerState &s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.frames.size() >= FRAME_HISTORY) s.frames.pop_front();
+    s.frames.push_back({ cpuMs, gpuMs, triangles, s.pendingBytes });
+    s.pendingBytes = 0;
+}
+
+FrameStatistics Profiler::getFrameStatistics() {
+    ProfilerState &s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    FrameStatistics stats = { 0.0f, 0.0f, -1.0f, 0, 0, s.frames.size() };
+    if (s.frames.empty()) return stats;
+
+    std::vector<float> cpu;
+    cpu.reserve(s.frames.size());
+    float gpuSum = 0.0f;
+    int gpuCount = 0;
+    for (const auto &f : s.frames) {
+        cpu.push_back(f.cpuMs);
+        stats.frameMs += f.cpuMs;
+        if (f.gpuMs >= 0.0f) {
+            gpuSum += f.gpuMs;
+            gpuCount++;
+        }
+    }
+    stats.frameMs /= cpu.size();
+    if (gpuCount > 0) stats.gpuMs = gpuSum / gpuCount;
+
+    // nearest rank, the smallest time above 95% of the frames
+    std::size_t rank = (cpu.size() * 95 + 99) / 100;
+    std::nth_element(cpu.begin(), cpu.begin() + (rank - 1), cpu.end());
+    stats.p95Ms = cpu[rank - 1];
+
+    stats.triangles = s.frames.back().triangles;
+    stats.uploadedBytes = s.frames.back().uploadedBytes;
+    return stats;
+}
+
+bool Profiler::saveChromeTrace(const char *link) {
+    std::ofstream out(link);
+    if (!out.is_open()) return false;
+
+    ProfilerState &s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto &e : s.events) {
+        out << (first ? "\n" : ",\n") << "{\"name\":";
+        writeName(out, e.name);
+        out << ",\"ph\":\"" << e.phase << "\",\"ts\":" << e.start << ",\"pid\":1,\"tid\":" << e.thread;
+        if (e.phase == 'X') out << ",\"dur\":" << e.duration << "}";
+        else out << ",\"args\":{\"value\":" << e.duration << "}}";
+        first = false;
+    }
+    out << "\n]}\n";
+
+    return out.good();
+}
+
+void Profiler::clear() {
+    ProfilerState &s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.events.clear();
+    s.frames.clear();
+    s.pendingBytes = 0;
+    s.totalBytes = 0;
+}
+
+ScopedTimer::ScopedTimer(const char *name) : name(name), start(Profiler::isEnabled() ? Profiler::now() : -1) {}
+
+ScopedTimer::~ScopedTimer() {
+    if (start >= 0) Profiler::addEvent(name, start, Profiler::now() - start);
+}
@@ -0,0 +1,392 @@
+#include "simplifier.h"
+#include "parallel.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+const double BOUNDARY_WEIGHT = 10.0;
+
+using Vec3 = std::array<double, 3>;
+
+Vec3 sub(const Vec3 &a, const Vec3 &b) { return { a[0] - b[0], a[1] - b[1], a[2] - b[2] }; }
+
+Vec3 cross(const Vec3 &a, const Vec3 &b) {
+    return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+}
+
+double dot(const Vec3 &a, const Vec3 &b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+std::array<double, 10> planeQuadric(const Vec3 &n, double d, double weight) {
+    return { weight * n[0] * n[0], weight * n[0] * n[1], weight * n[0] * n[2], weight * n[0] * d,
+             weight * n[1] * n[1], weight * n[1] * n[2], weight * n[1] * d,
+             weight * n[2] * n[2], weight * n[2] * d,
+             weight * d * d };
+}
+
+void addQuadric(std::array<double, 10> &q, const std::array<double, 10> &r) {
+    for (int i = 0; i < 10; i++) q[i] += r[i];
+}
+
+double quadricError(const std::array<double, 10> &q, const Vec3 &p) {
+    double x = p[0], y = p[1], z = p[2];
+    return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x
+         + q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y
+         + q[7] * z * z + 2 * q[8] * z
+         + q[9];
+}
+
+} // namespace
+
+Simplifier::Simplifier(const Mesh &mesh) : aliveFaces(0), maxCost(0.0), texCoords(mesh.hasTexture()) {
+    const std::vector<Vertex> &vertices = mesh.getVertices();
+    const std::vector<Triangle> &faces = mesh.getFaces();
+
+    positions.resize(vertices.size());
+    for (std::size_t i = 0; i < vertices.size(); i++) {
+        const QVector3D &p = vertices[i].position;
+        positions[i] = { p.x(), p.y(), p.z() };
+    }
+    attributes = vertices;
+
+    tris.resize(faces.size());
+    vertexFaces.resize(vertices.size());
+    for (std::size_t f = 0; f < faces.size(); f++) {
+        tris[f] = faces[f].idVertices;
+        for (unsigned int v : tris[f]) vertexFaces[v].push_back(f);
+    }
+
+    faceAlive.assign(faces.size(), true);
+    vertexAlive.assign(vertices.size(), true);
+    versions.assign(vertices.size(), 0);
+    aliveFaces = faces.size();
+
+    // plane of each face, then the sum of the planes around each vertex
+    std::vector<Quadric> faceQuadrics(faces.size());
+    std::vector<Vec3> faceNormals(faces.size());
+    parallelFor(0, faces.size(), 4096, [&](std::size_t first, std::size_t last) {
+        for (std::size_t f = first; f < last; f++) {
+            const Vec3 &a = positions[tris[f][0]];
+            Vec3 n = cross(sub(positions[tris[f][1]], a), sub(positions[tris[f][2]], a));
+            double len = std::sqrt(dot(n, n));
+            if (len > 0.0) n = { n[0] / len, n[1] / len, n[2] / len };
+            faceNormals[f] = n;
+            faceQuadrics[f] = planeQuadric(n, -dot(n, a), len > 0.0 ? 1.0 : 0.0);
+        }
+    });
+
+    quadrics.resize(vertices.size());
+    parallelFor(0, vertices.size(), 4096, [&](std::size_t first, std::size_t last) {
+        for (std::size_t v = first; v < last; v++) {
+            Quadric q = {};
+            for (unsigned int f : vertexFaces[v]) addQuadric(q, faceQuadrics[f]);
+            quadrics[v] = q;
+        }
+    });
+
+    // boundary edges have no neighbor in the adjacency, a perpendicular plane keeps them in place
+    for (std::size_t f = 0; f < faces.size(); f++) {
+        if (faces[f].idFaces.size() != 3) continue;
+        for (int e = 0; e < 3; e++) {
+            if (faces[f].idFaces[e] != Triangle::NO_NEIGHBOR) continue;
+            unsigned int a = tris[f][e], b = tris[f][(e + 1) % 3];
+            Vec3 n = cross(sub(positions[b], positions[a]), faceNormals[f]);
+            double len = std::sqrt(dot(n, n));
+            if (len == 0.0) continue;
+            n = { n[0] / len, n[1] / len, n[2] / len };
+            Quadric q = planeQuadric(n, -dot(n, positions[a]), BOUNDARY_WEIGHT);
+            addQuadric(quadrics[a], q);
+            addQuadric(quadrics[b], q);
+        }
+    }
+
+    // each edge is pushed once, by the face with the lowest index
+    for (std::size_t f = 0; f < faces.size(); f++) {
+        for (int e = 0; e < 3; e++) {
+            unsigned int a = tris[f][e], b = tris[f][(e + 1) % 3];
+            unsigned int neighbor = faces[f].idFaces.size() == 3 ? faces[f].idFaces[e] : Triangle::NO_NEIGHBOR;
+            if (neighbor == Triangle::NO_NEIGHBOR || f < neighbor) push(a, b);
+        }
+    }
+}
+
+Simplifier::Collapse Simplifier::evaluate(unsigned int v0, unsigned int v1) const {
+    Quadric q = quadrics[v0];
+    addQuadric(q, quadrics[v1]);
+
+    Collapse c;
+    c.v0 = v0;
+    c.v1 = v1;
+
+    // minimum of the quadric, solved with Cramer's rule
+    double a00 = q[0], a01 = q[1], a02 = q[2], a11 = q[4], a12 = q[5], a22 = q[7];
+    double b0 = -q[3], b1 = -q[6], b2 = -q[8];
+    double det = a00 * (a11 * a22 - a12 * a12) - a01 * (a01 * a22 - a12 * a02) + a02 * (a01 * a12 - a11 * a02);
+
+    const Vec3 &p0 = positions[v0];
+    const Vec3 &p1 = positions[v1];
+    Vec3 edge = sub(p1, p0);
+    double scale = std::max(dot(edge, edge), 1e-30);
+
+    if (std::fabs(det) > 1e-10 * scale * scale * scale) {
+        Vec3 x = {
+            (b0 * (a11 * a22 - a12 * a12) - a01 * (b1 * a22 - a12 * b2) + a02 * (b1 * a12 - a11 * b2)) / det,
+            (a00 * (b1 * a22 - a12 * b2) - b0 * (a01 * a22 - a12 * a02) + a02 * (a01 * b2 - b1 * a02)) / det,
+            (a00 * (a11 * b2 - b1 * a12) - a01 * (a01 * b2 - b1 * a02) + b0 * (a01 * a12 - a11 * a02)) / det
+        };
+        // a target far from the edge is a badly conditioned solution
+        Vec3 mid = { (p0[0] + p1[0]) / 2, (p0[1] + p1[1]) / 2, (p0[2] + p1[2]) / 2 };
+        Vec3 d = sub(x, mid);
+        if (dot(d, d) <= 4.0 * scale) {
+            c.target = x;
+            c.cost = quadricError(q, x);
+            return c;
+        }
+    }
+
+    Vec3 mid = { (p0[0] + p1[0]) / 2, (p0[1] + p1[1]) / 2, (p0[2] + p1[2]) / 2 };
+    c.target = p0;
+    c.cost = quadricError(q, p0);
+    for (const Vec3 &p : { p1, mid }) {
+        double cost = quadricError(q, p);
+        if (cost < c.cost) {
+            c.cost = cost;
+            c.target = p;
+        }
+    }
+    return c;
+}
+
+void Simplifier::push(unsigned int v0, unsigned int v1) {
+    Collapse c = evaluate(v0, v1);
+    heap.push({ std::max(c.cost, 0.0), v0, v1, versions[v0], versions[v1] });
+}
+
+bool Simplifier::isValid(const Collapse &c) const {
+    // link condition: the vertices shared by both one-rings are the ones of the collapsed faces
+    std::vector<unsigned int> ring0, ring1;
+    int sharedFaces = 0;
+    for (unsigned int f : vertexFaces[c.v0]) {
+        if (!faceAlive[f]) continue;
+        bool shared = false;
+        for (unsigned int v : tris[f]) {
+            if (v == c.v1) shared = true;
+            if (v != c.v0) ring0.push_back(v);
+        }
+        if (shared) sharedFaces++;
+    }
+    if (sharedFaces == 0) return false;
+
+    for (unsigned int f : vertexFaces[c.v1]) {
+        if (!faceAlive[f]) continue;
+        for (unsigned int v : tris[f]) {
+            if (v != c.v1) ring1.push_back(v);
+        }
+    }
+
+    std::sort(ring0.begin(), ring0.end());
+    ring0.erase(std::unique(ring0.begin(), ring0.end()), ring0.end());
+    std::sort(ring1.begin(), ring1.end());
+    ring1.erase(std::unique(ring1.begin(), ring1.end()), ring1.end());
+
+    std::vector<unsigned int> common;
+    std::set_intersection(ring0.begin(), ring0.end(), ring1.begin(), ring1.end(), std::back_inserter(common));
+    common.erase(std::remove(common.begin(), common.end(), c.v0), common.end());
+    common.erase(std::remove(common.begin(), common.end(), c.v1), common.end());
+    if ((int)common.size() != sharedFaces) return false;
+
+    // the faces who stay must keep their orientation
+    for (unsigned int moved : { c.v0, c.v1 }) {
+        for (unsigned int f : vertexFaces[moved]) {
+            if (!faceAlive[f]) continue;
+            const auto &t = tris[f];
+            if (std::find(t.begin(), t.end(), moved == c.v0 ? c.v1 : c.v0) != t.end()) continue;
+
+            Vec3 p[3], q[3];
+            for (int i = 0; i < 3; i++) {
+                p[i] = positions[t[i]];
+                q[i] = t[i] == moved ? c.target : p[i];
+            }
+            Vec3 before = cross(sub(p[1], p[0]), sub(p[2], p[0]));
+            Vec3 after = cross(sub(q[1], q[0]), sub(q[2], q[0]));
+            if (dot(before, after) <= 0.0) return false;
+        }
+    }
+
+    return true;
+}
+
+void Simplifier::apply(const Collapse &c) {
+    positions[c.v0] = c.target;
+    addQuadric(quadrics[c.v0], quadrics[c.v1]);
+    vertexAlive[c.v1] = false;
+    versions[c.v0]++;
+    versions[c.v1]++;
+    maxCost = std::max(maxCost, c.cost);
+
+    for (unsigned int f : vertexFaces[c.v1]) {
+        if (!faceAlive[f]) continue;
+        auto &t = tris[f];
+        if (std::find(t.begin(), t.end(), c.v0) != t.end()) {
+            faceAlive[f] = false;
+            aliveFaces--;
+        } else {
+            std::replace(t.begin(), t.end(), c.v1, c.v0);
+            vertexFaces[c.v0].push_back(f);
+        }
+    }
+    vertexFaces[c.v1].clear();
+    vertexFaces[c.v1].shrink_to_fit();
+
+    auto &around = vertexFaces[c.v0];
+    around.erase(std::remove_if(around.begin(), around.end(), [&](unsigned int f) { return !faceAlive[f]; }), around.end());
+
+    std::vector<unsigned int> neighbors;
+    for (unsigned int f : around) {
+        for (unsigned int v : tris[f]) {
+            if (v != c.v0) neighbors.push_back(v);
+        }
+    }
+    std::sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+    for (unsigned int v : neighbors) push(c.v0, v);
+}
+
+Mesh Simplifier::simplify(std::size_t targetFaces) {
+    while (aliveFaces > targetFaces && !heap.empty()) {
+        Candidate top = heap.top();
+        heap.pop();
+
+        if (!vertexAlive[top.v0] || !vertexAlive[top.v1]) continue;
+        if (versions[top.v0] != top.version0 || versions[top.v1] != top.version1) continue;
+
+        Collapse c = evaluate(top.v0, top.v1);
+        if (!isValid(c)) continue;
+        apply(c);
+    }
+
+    std::vector<unsigned int> remap(positions.size(), std::numeric_limits<unsigned int>::max());
+    for (std::size_t f = 0; f < tris.size(); f++) {
+        if (!faceAlive[f]) continue;
+        for (unsigned int v : tris[f]) remap[v] = 0;
+    }
+
+    std::vector<Vertex> outVertices;
+    for (std::size_t v = 0; v < positions.size(); v++) {
+        if (remap[v] == std::numeric_limits<unsigned int>::max()) continue;
+        remap[v] = outVertices.size();
+        Vertex vertex(attributes[v]);
+        vertex.position = QVector3D(positions[v][0], positions[v][1], positions[v][2]);
+        outVertices.push_back(vertex);
+    }
+
+    std::vector<Triangle> outFaces;
+    outFaces.reserve(aliveFaces);
+    for (std::size_t f = 0; f < tris.size(); f++) {
+        if (!faceAlive[f]) continue;
+        outFaces.push_back(Triangle(remap[tris[f][0]], remap[tris[f][1]], remap[tris[f][2]]));
+    }
+
+    return Mesh(std::move(outVertices), std::move(outFaces), texCoords);
+}
+
+float Simplifier::getError() const {
+    return std::sqrt(maxCost);
+}
+
+std::vector<LevelOfDetail> Simplifier::buildLodChain(const Mesh &mesh, const std::vector<float> &ratios) {
+    ScopedTimer timer("Simplifier::buildLodChain");
+    std::vector<LevelOfDetail> lods;
+    lods.reserve(ratios.size());
+
+    const Mesh *source = &mesh;
+    float error = 0.0f;
+
+    for (float ratio : ratios) {
+        std::size_t target = std::max<std::size_t>(4, mesh.getFaces().size() * ratio);
+        if (target >= source->getFaces().size()) continue;
+
+        Simplifier simplifier(*source);
+        Mesh level = simplifier.simplify(target);
+        if (level.getFaces().size() >= source->getFaces().size()) break;
+
+        error += simplifier.getError();
+        lods.push_back({ std::move(level), error });
+        source = &lods.back().mesh;
+    }
+
+    return lods;
+}
+
+LevelOfDetail Simplifier::clusterVertices(const Mesh &mesh, int resolution) {
+    ScopedTimer timer("Simplifier::clusterVertices");
+    const std::vector<Vertex> &vertices = mesh.getVertices();
+    const std::vector<Triangle> &faces = mesh.getFaces();
+    if (vertices.empty() || resolution < 1) return { Mesh(), 0.0f };
+
+    QVector3D min = vertices[0].position, max = vertices[0].position;
+    for (const auto &v : vertices) {
+        for (int a = 0; a < 3; a++) {
+            min[a] = std::min(min[a], v.position[a]);
+            max[a] = std::max(max[a], v.position[a]);
+        }
+    }
+
+    QVector3D extent = max - min;
+    float cellSize = std::max({ extent.x(), extent.y(), extent.z() }) / resolution;
+    if (cellSize <= 0.0f) cellSize = 1.0f;
+
+    std::vector<std::uint64_t> cells(vertices.size());
+    parallelFor(0, vertices.size(), 16384, [&](std::size_t first, std::size_t last) {
+        for (std::size_t v = first; v < last; v++) {
+            QVector3D p = (vertices[v].position - min) / cellSize;
+            std::uint64_t x = std::min<std::uint64_t>(p.x(), resolution - 1);
+            std::uint64_t y = std::min<std::uint64_t>(p.y(), resolution - 1);
+            std::uint64_t z = std::min<std::uint64_t>(p.z(), resolution - 1);
+            cells[v] = (x * resolution + y) * resolution + z;
+        }
+    });
+
+    // each cluster is represented by the mean of its vertices
+    std::unordered_map<std::uint64_t, unsigned int> clusterOf;
+    std::vector<unsigned int> remap(vertices.size());
+    std::vector<Vertex> outVertices;
+    std::vector<unsigned int> clusterSize;
+    for (std::size_t v = 0; v < vertices.size(); v++) {
+        auto inserted = clusterOf.emplace(cells[v], outVertices.size());
+        if (inserted.second) {
+            outVertices.push_back(vertices[v]);
+            clusterSize.push_back(1);
+        } else {
+            outVertices[inserted.first->second].position += vertices[v].position;
+            clusterSize[inserted.first->second]++;
+        }
+        remap[v] = inserted.first->second;
+    }
+    for (std::size_t c = 0; c < outVertices.size(); c++) {
+        outVertices[c].position /= float(clusterSize[c]);
+    }
+
+    // faces with their 3 corners in different clusters survive, rotated so duplicates can be removed
+    std::vector<std::array<unsigned int, 3>> outTris;
+    outTris.reserve(faces.size() / 4);
+    for (const Triangle &f : faces) {
+        std::array<unsigned int, 3> t = { remap[f.idVertices[0]], remap[f.idVertices[1]], remap[f.idVertices[2]] };
+        if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0]) continue;
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        outTris.push_back(t);
+    }
+    std::sort(outTris.begin(), outTris.end());
+    outTris.erase(std::unique(outTris.begin(), outTris.end()), outTris.end());
+
+    std::vector<Triangle> outFaces;
+    outFaces.reserve(outTris.size());
+    for (const auto &t : outTris) outFaces.push_back(Triangle(t[0], t[1], t[2]));
+
+    return { Mesh(std::move(outVertices), std::move(outFaces), mesh.hasTexture()), cellSize * std::sqrt(3.0f) };
+}
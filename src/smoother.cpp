@@ -0,0 +1,183 @@
+#include "smoother.h"
+#include "parallel.h"
+#include "profiler.h"
+
+#include <algorithm>
+
+namespace {
+
+// vertices smoothed by one task
+const std::size_t SMOOTH_GRAIN = 1 << 13;
+
+}
+
+Smoother::Smoother(const Mesh &mesh, bool preserveBoundary) {
+    ScopedTimer timer("Smoother::Smoother");
+    const auto &vertices = mesh.getVertices();
+    const auto &meshFaces = mesh.getFaces();
+    std::size_t count = vertices.size();
+
+    // 2 neighbors per corner, each vertex sorts its own and drops the repeated ones
+    // the corners are filled in face order, they also give the faces of each vertex for the normals
+    faceStart.assign(count + 1, 0);
+    for (const auto &f : meshFaces) {
+        for (unsigned int id : f.idVertices) faceStart[id + 1]++;
+    }
+    for (std::size_t v = 0; v < count; v++) faceStart[v + 1] += faceStart[v];
+    std::vector<unsigned int> candidates(2 * faceStart.back());
+    std::vector<unsigned int> fill(faceStart.begin(), faceStart.end() - 1);
+    faces.resize(meshFaces.size());
+    faceList.resize(faceStart.back());
+    for (std::size_t i = 0; i < meshFaces.size(); i++) {
+        const auto &ids = meshFaces[i].idVertices;
+        faces[i] = ids;
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = ids[k];
+            candidates[2 * fill[v]] = ids[(k + 1) % 3];
+            candidates[2 * fill[v] + 1] = ids[(k + 2) % 3];
+            faceList[fill[v]] = i;
+            fill[v]++;
+        }
+    }
+
+    // a closed fan has as many neighbors as faces, an open or non-manifold one doesn't
+    ringStart.assign(count + 1, 0);
+    weight.assign(count, 1.0f);
+    parallelFor(0, count, SMOOTH_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t v = first; v < last; v++) {
+            auto begin = candidates.begin() + 2 * faceStart[v], end = candidates.begin() + 2 * faceStart[v + 1];
+            std::sort(begin, end);
+            std::size_t neighbors = std::unique(begin, end) - begin;
+            ringStart[v + 1] = neighbors;
+            std::size_t corners = faceStart[v + 1] - faceStart[v];
+            if (neighbors == 0 || (preserveBoundary && neighbors != corners)) weight[v] = 0.0f;
+        }
+    });
+    for (std::size_t v = 0; v < count; v++) ringStart[v + 1] += ringStart[v];
+    ring.resize(ringStart.back());
+    parallelFor(0, count, SMOOTH_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t v = first; v < last; v++) {
+            std::copy_n(candidates.begin() + 2 * faceStart[v], ringStart[v + 1] - ringStart[v], ring.begin() + ringStart[v]);
+        }
+    });
+
+    for (int c = 0; c < 3; c++) {
+        positions[c].resize(count);
+        next[c].resize(count);
+        for (std::size_t v = 0; v < count; v++) positions[c][v] = vertices[v].position[c];
+    }
+}
+
+void Smoother::step(float factor) {
+    parallelFor(0, weight.size(), SMOOTH_GRAIN, [&](std::size_t first, std::size_t last) {
+        // the gather is bound by the memory, the ring is read once for the 3 coordinates and the center blended in registers
+        const float *x = positions[0].data(), *y = positions[1].data(), *z = positions[2].data();
+        float *outX = next[0].data(), *outY = next[1].data(), *outZ = next[2].data();
+        for (std::size_t v = first; v < last; v++) {
+            unsigned int begin = ringStart[v], end = ringStart[v + 1];
+            float sumX = 0.0f, sumY = 0.0f, sumZ = 0.0f;
+            for (unsigned int k = begin; k < end; k++) {
+                unsigned int n = ring[k];
+                sumX += x[n];
+                sumY += y[n];
+                sumZ += z[n];
+            }
+            float move = end > begin ? factor * weight[v] : 0.0f;
+            float count = end > begin ? float(end - begin) : 1.0f;
+            outX[v] = x[v] + move * (sumX / count - x[v]);
+            outY[v] = y[v] + move * (sumY / count - y[v]);
+            outZ[v] = z[v] + move * (sumZ / count - z[v]);
+        }
+    });
+
+    std::swap(positions, next);
+}
+
+void Smoother::iterate(const SmoothingOptions &options) {
+    step(options.lambda);
+    if (options.method == SmoothingMethod::TAUBIN) step(options.mu);
+}
+
+int Smoother::smooth(const SmoothingOptions &options, const std::function<bool(int)> &progress) {
+    ScopedTimer timer("Smoother::smooth");
+    for (int i = 1; i <= options.iterations; i++) {
+        iterate(options);
+        if (progress && !progress(i)) return i;
+    }
+    return std::max(options.iterations, 0);
+}
+
+std::vector<QVector3D> Smoother::getPositions() const {
+    std::vector<QVector3D> result(weight.size());
+    for (std::size_t v = 0; v < result.size(); v++) result[v] = QVector3D(positions[0][v], positions[1][v], positions[2][v]);
+    return result;
+}
+
+std::vector<QVector3D> Smoother::getNormals() const {
+    ScopedTimer timer("Smoother::getNormals");
+    auto position = [&](unsigned int v) { return QVector3D(positions[0][v], positions[1][v], positions[2][v]); };
+    std::vector<QVector3D> faceNormals(faces.size());
+    parallelFor(0, faces.size(), SMOOTH_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            QVector3D v0 = position(faces[i][0]);
+            faceNormals[i] = QVector3D::crossProduct(position(faces[i][1]) - v0, position(faces[i][2]) - v0).normalized();
+        }
+    });
+
+    std::vector<QVector3D> normals(weight.size());
+    parallelFor(0, normals.size(), SMOOTH_GRAIN, [&](std::size_t first, std::size_t last) {
+        for (std::size_t v = first; v < last; v++) {
+            QVector3D normal(0, 0, 0);
+            for (unsigned int k = faceStart[v]; k < faceStart[v + 1]; k++) normal += faceNormals[faceList[k]];
+            normals[v] = normal.normalized();
+        }
+    });
+    return normals;
+}
+
+bool Smoother::isFree(unsigned int vertex) const {
+    return weight[vertex] != 0.0f;
+}
+
+SmoothingJob::SmoothingJob(const Mesh &mesh, const SmoothingOptions &options)
+    : smoother(mesh, options.preserveBoundary), options(options), publishedIteration(0), taken(true), stopping(false), finished(false) {
+    worker = std::thread(&SmoothingJob::run, this);
+}
+
+SmoothingJob::~SmoothingJob() {
+    stopping = true;
+    worker.join();
+}
+
+void SmoothingJob::run() {
+    smoother.smooth(options, [this](int iteration) {
+        // the positions are copied only when the previous ones have been taken, and always for the last iteration
+        std::lock_guard<std::mutex> lock(mutex);
+        if (taken || iteration == options.iterations) {
+            published = smoother.getPositions();
+            publishedNormals = smoother.getNormals();
+            publishedIteration = iteration;
+            taken = false;
+        }
+        return !stopping;
+    });
+    finished = true;
+}
+
+bool SmoothingJob::takePositions(std::vector<QVector3D> &positions, std::vector<QVector3D> &normals, int &iteration) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (taken) return false;
+    positions.swap(published);
+    normals.swap(publishedNormals);
+    iteration = publishedIteration;
+    taken = true;
+    return true;
+}
+
+bool SmoothingJob::isFinished() const {
+    return finished;
+}
+
+int SmoothingJob::getIterations() const {
+    return options.iterations;
+}
@@ -0,0 +1,155 @@
+#include "spatialSort.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace {
+
+const unsigned int GRID_BITS = 10;
+const unsigned int GRID_MAX = (1u << GRID_BITS) - 1;
+const std::size_t RADIX_BUCKETS = 256;
+// under this size the threads cost more than the passes
+const std::size_t PARALLEL_MIN_KEYS = 65536;
+
+// insert two zeros between each of the 10 low bits
+unsigned int expandBits(unsigned int v) {
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+}
+
+unsigned int SpatialSort::mortonCode(unsigned int x, unsigned int y, unsigned int z) {
+    return (expandBits(x) << 2) | (expandBits(y) << 1) | expandBits(z);
+}
+
+unsigned int SpatialSort::hilbertCode(unsigned int x, unsigned int y, unsigned int z) {
+    std::array<unsigned int, 3> X = { x, y, z };
+    const unsigned int M = 1u << (GRID_BITS - 1);
+
+    // inverse undo
+    for (unsigned int Q = M; Q > 1; Q >>= 1) {
+        unsigned int P = Q - 1;
+        for (int i = 0; i < 3; i++) {
+            if (X[i] & Q) {
+                X[0] ^= P;
+            } else {
+                unsigned int t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
+    }
+
+    // Gray encode
+    for (int i = 1; i < 3; i++) X[i] ^= X[i - 1];
+    unsigned int t = 0;
+    for (unsigned int Q = M; Q > 1; Q >>= 1) {
+        if (X[2] & Q) t ^= Q - 1;
+    }
+    for (int i = 0; i < 3; i++) X[i] ^= t;
+
+    // the transposed index is read by interleaving the bits
+    return mortonCode(X[0], X[1], X[2]);
+}
+
+std::vector<unsigned int> SpatialSort::computeCodes(const std::vector<QVector3D> &points, SpatialOrder order) {
+    std::vector<unsigned int> codes(points.size());
+    if (order == SpatialOrder::NONE || points.empty()) {
+        std::iota(codes.begin(), codes.end(), 0);
+        return codes;
+    }
+
+    QVector3D min = points[0], max = points[0];
+    for (const auto &p : points) {
+        min = QVector3D(std::min(min.x(), p.x()), std::min(min.y(), p.y()), std::min(min.z(), p.z()));
+        max = QVector3D(std::max(max.x(), p.x()), std::max(max.y(), p.y()), std::max(max.z(), p.z()));
+    }
+
+    // same scale on the 3 axes so the cells stay cubic
+    QVector3D extent = max - min;
+    float size = std::max({ extent.x(), extent.y(), extent.z() });
+    float scale = size > 0.0f ? GRID_MAX / size : 0.0f;
+
+    parallelFor(0, points.size(), PARALLEL_MIN_KEYS, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            QVector3D q = (points[i] - min) * scale;
+            unsigned int x = std::min<unsigned int>(q.x(), GRID_MAX);
+            unsigned int y = std::min<unsigned int>(q.y(), GRID_MAX);
+            unsigned int z = std::min<unsigned int>(q.z(), GRID_MAX);
+            codes[i] = order == SpatialOrder::MORTON ? mortonCode(x, y, z) : hilbertCode(x, y, z);
+        }
+    });
+
+    return codes;
+}
+
+std::vector<unsigned int> SpatialSort::sortByKey(const std::vector<unsigned int> &keys) {
+    std::size_t n = keys.size();
+    std::vector<unsigned int> order(n), sortedOrder(n);
+    std::vector<unsigned int> current(keys), sortedKeys(n);
+    std::iota(order.begin(), order.end(), 0);
+
+    // each block counts and scatters its own range, the blocks are fixed so the sort stays stable
+    std::size_t blocks = n < PARALLEL_MIN_KEYS ? 1 : parallelThreadCount();
+    std::vector<std::array<std::size_t, RADIX_BUCKETS>> histograms(blocks);
+    auto blockBegin = [&](std::size_t b) { return n * b / blocks; };
+
+    for (unsigned int shift = 0; shift < 32; shift += 8) {
+        parallelFor(0, blocks, 1, [&](std::size_t first, std::size_t last) {
+            for (std::size_t b = first; b < last; b++) {
+                histograms[b].fill(0);
+                for (std::size_t i = blockBegin(b); i < blockBegin(b + 1); i++) {
+                    histograms[b][(current[i] >> shift) & 0xFF]++;
+                }
+            }
+        });
+
+        // the pass is useless if all the keys share this digit
+        bool sameDigit = false;
+        for (std::size_t d = 0; d < RADIX_BUCKETS && !sameDigit; d++) {
+            std::size_t total = 0;
+            for (std::size_t b = 0; b < blocks; b++) total += histograms[b][d];
+            sameDigit = total == n;
+        }
+        if (sameDigit) continue;
+
+        std::size_t offset = 0;
+        for (std::size_t d = 0; d < RADIX_BUCKETS; d++) {
+            for (std::size_t b = 0; b < blocks; b++) {
+                std::size_t count = histograms[b][d];
+                histograms[b][d] = offset;
+                offset += count;
+            }
+        }
+
+        parallelFor(0, blocks, 1, [&](std::size_t first, std::size_t last) {
+            for (std::size_t b = first; b < last; b++) {
+                for (std::size_t i = blockBegin(b); i < blockBegin(b + 1); i++) {
+                    std::size_t position = histograms[b][(current[i] >> shift) & 0xFF]++;
+                    sortedKeys[position] = current[i];
+                    sortedOrder[position] = order[i];
+                }
+            }
+        });
+
+        current.swap(sortedKeys);
+        order.swap(sortedOrder);
+    }
+
+    return order;
+}
+
+std::vector<unsigned int> SpatialSort::sortPoints(const std::vector<QVector3D> &points, SpatialOrder order) {
+    if (order == SpatialOrder::NONE) {
+        std::vector<unsigned int> identity(points.size());
+        std::iota(identity.begin(), identity.end(), 0);
+        return identity;
+    }
+    return sortByKey(computeCodes(points, order));
+}
@@ -0,0 +1,300 @@
+#include "taskScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Task {
+    TaskGroup *group;
+    std::function<void()> function;
+};
+
+struct Counters {
+    std::atomic<std::uint64_t> tasks{0};
+    std::atomic<std::uint64_t> steals{0};
+    std::atomic<std::int64_t> busyNs{0};
+
+    void reset() {
+        tasks = 0;
+        steals = 0;
+        busyNs = 0;
+    }
+};
+
+struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks; // the owner pops the back, the thieves the front
+    Counters counters;
+    std::thread thread;
+};
+
+// index of the calling thread in the pool, -1 outside of it
+thread_local int workerIndex = -1;
+// tasks of the calling thread running one inside another while it waits for a group
+thread_local int runDepth = 0;
+// first victim of the next steal of a thread outside the pool
+thread_local std::size_t nextVictim = 0;
+
+unsigned int hardwareThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+unsigned int defaultThreadCount() {
+    const char *variable = std::getenv("MESHVIEWER_THREADS");
+    unsigned long count = variable ? std::strtoul(variable, nullptr, 10) : 0;
+    return count > 0 ? static_cast<unsigned int>(count) : hardwareThreadCount();
+}
+
+}
+
+class TaskScheduler::Pool
+{
+public:
+    Pool() { start(defaultThreadCount()); }
+    ~Pool() { stop(); }
+
+    void start(unsigned int threads);
+    void stop();
+    bool take(int self, Task &task, bool &stolen);
+    bool runOne(int self);
+    void notify(bool all);
+    void workerLoop(int self);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex sharedMutex;
+    std::deque<Task> shared;  // tasks queued by the threads outside the pool
+    Counters external;
+    std::atomic<std::size_t> queued{0};
+    std::atomic<unsigned int> threadCount{1};
+    std::atomic<Clock::rep> resetTime{0};
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    std::mutex configMutex;
+};
+
+TaskScheduler::Pool &TaskScheduler::pool() {
+    static Pool p;
+    return p;
+}
+
+void TaskScheduler::Pool::start(unsigned int threads) {
+    stopping = false;
+    external.reset();
+    resetTime = Clock::now().time_since_epoch().count();
+    threadCount = threads;
+
+    // all the workers exist before the first one can steal
+    for (unsigned int i = 1; i < threads; i++) workers.push_back(std::make_unique<Worker>());
+    for (std::size_t i = 0; i < workers.size(); i++) {
+        workers[i]->thread = std::thread(&TaskScheduler::Pool::workerLoop, this, static_cast<int>(i));
+    }
+}
+
+void TaskScheduler::Pool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &w : workers) w->thread.join();
+    workers.clear();
+}
+
+bool TaskScheduler::Pool::take(int self, Task &task, bool &stolen) {
+    stolen = false;
+    if (self >= 0) {
+        Worker &own = *workers[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        if (!shared.empty()) {
+            task = std::move(shared.front());
+            shared.pop_front();
+            return true;
+        }
+    }
+
+    std::size_t n = workers.size();
+    std::size_t first = self >= 0 ? self + 1 : nextVictim++;
+    for (std::size_t k = 0; k < n; k++) {
+        std::size_t v = (first + k) % n;
+        if (static_cast<int>(v) == self) continue;
+        Worker &victim = *workers[v];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            stolen = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::Pool::runOne(int self) {
+    Task task;
+    bool stolen;
+    if (!take(self, task, stolen)) return false;
+    queued--;
+
+    // a task run while another one waits is already in its time
+    Counters &counters = self >= 0 ? workers[self]->counters : external;
+    auto start = Clock::now();
+    runDepth++;
+    std::exception_ptr error;
+    try {
+        task.function();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    runDepth--;
+    if (runDepth == 0) {
+        counters.busyNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+    counters.tasks++;
+    if (stolen) counters.steals++;
+
+    task.group->finish(error);
+    return true;
+}
+
+void TaskScheduler::Pool::notify(bool all) {
+    // taking the lock orders the change before the check of a thread going to sleep
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    if (all) wake.notify_all();
+    else wake.notify_one();
+}
+
+void TaskScheduler::Pool::workerLoop(int self) {
+    workerIndex = self;
+    while (true) {
+        if (runOne(self)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [&]() { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
+
+TaskGroup::TaskGroup() : pending(0) {}
+
+TaskGroup::~TaskGroup() {
+    TaskScheduler::waitFor(this);
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    TaskScheduler::submit(this, std::move(task));
+}
+
+void TaskGroup::wait() {
+    TaskScheduler::waitFor(this);
+
+    std::exception_ptr first;
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        std::swap(first, error);
+    }
+    if (first) std::rethrow_exception(first);
+}
+
+void TaskGroup::finish(std::exception_ptr taskError) {
+    if (taskError) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error) error = taskError;
+    }
+    // the group may be destroyed as soon as pending is 0
+    if (pending.fetch_sub(1) == 1) TaskScheduler::pool().notify(true);
+}
+
+void TaskScheduler::setThreadCount(unsigned int count) {
+    Pool &p = pool();
+    std::lock_guard<std::mutex> lock(p.configMutex);
+    if (count == 0) count = hardwareThreadCount();
+    p.stop();
+    p.start(count);
+}
+
+unsigned int TaskScheduler::getThreadCount() {
+    return pool().threadCount;
+}
+
+std::vector<WorkerStatistics> TaskScheduler::getStatistics() {
+    Pool &p = pool();
+    double elapsed = std::chrono::duration<double, std::nano>(Clock::now().time_since_epoch()
+                                                               - Clock::duration(p.resetTime.load())).count();
+
+    auto statisticsOf = [&](const Counters &c) {
+        WorkerStatistics s;
+        s.tasks = c.tasks;
+        s.steals = c.steals;
+        s.utilization = elapsed > 0.0 ? static_cast<float>(std::min(1.0, c.busyNs / elapsed)) : 0.0f;
+        return s;
+    };
+
+    std::vector<WorkerStatistics> statistics = { statisticsOf(p.external) };
+    for (const auto &w : p.workers) statistics.push_back(statisticsOf(w->counters));
+    return statistics;
+}
+
+void TaskScheduler::resetStatistics() {
+    Pool &p = pool();
+    p.external.reset();
+    for (auto &w : p.workers) w->counters.reset();
+    p.resetTime = Clock::now().time_since_epoch().count();
+}
+
+void TaskScheduler::submit(TaskGroup *group, std::function<void()> task) {
+    Pool &p = pool();
+    group->pending++;
+
+    if (p.workers.empty()) {
+        std::exception_ptr error;
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        p.external.tasks++;
+        group->finish(error);
+        return;
+    }
+
+    if (workerIndex >= 0) {
+        Worker &own = *p.workers[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.tasks.push_back({ group, std::move(task) });
+    } else {
+        std::lock_guard<std::mutex> lock(p.sharedMutex);
+        p.shared.push_back({ group, std::move(task) });
+    }
+    p.queued++;
+    p.notify(false);
+}
+
+void TaskScheduler::waitFor(TaskGroup *group) {
+    Pool &p = pool();
+    while (group->pending > 0) {
+        if (p.runOne(workerIndex)) continue;
+
+        std::unique_lock<std::mutex> lock(p.sleepMutex);
+        p.wake.wait(lock, [&]() { return group->pending == 0 || p.queued > 0; });
+    }
+}
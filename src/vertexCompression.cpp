@@ -0,0 +1,128 @@
+#include "vertexCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const float POSITION_STEPS = 65535.0f;
+const float SNORM16_MAX = 32767.0f;
+
+}
+
+Quantization VertexCompression::computeQuantization(const std::vector<Vertex> &vertices) {
+    if (vertices.empty()) return { QVector3D(0, 0, 0), QVector3D(1, 1, 1) };
+
+    QVector3D min = vertices[0].position, max = vertices[0].position;
+    for (const auto &v : vertices) {
+        min = QVector3D(std::min(min.x(), v.position.x()), std::min(min.y(), v.position.y()), std::min(min.z(), v.position.z()));
+        max = QVector3D(std::max(max.x(), v.position.x()), std::max(max.y(), v.position.y()), std::max(max.z(), v.position.z()));
+    }
+
+    // flat axes keep a unit scale, all their vertices are quantized to 0
+    QVector3D extent = max - min;
+    QVector3D scale(extent.x() > 0.0f ? extent.x() / POSITION_STEPS : 1.0f,
+                    extent.y() > 0.0f ? extent.y() / POSITION_STEPS : 1.0f,
+                    extent.z() > 0.0f ? extent.z() / POSITION_STEPS : 1.0f);
+    return { min, scale };
+}
+
+PackedVertex VertexCompression::pack(const Vertex &v, const Quantization &quantization) {
+    PackedVertex p;
+    QVector3D q = (v.position - quantization.offset) / quantization.scale;
+    for (int i = 0; i < 3; i++) {
+        p.position[i] = std::uint16_t(std::clamp(std::round(q[i]), 0.0f, POSITION_STEPS));
+    }
+    p.position[3] = 0;
+    p.normal = encodeOctahedral(v.normal);
+    p.texCoords = { floatToHalf(v.texCoords.x()), floatToHalf(v.texCoords.y()) };
+    return p;
+}
+
+Vertex VertexCompression::unpack(const PackedVertex &p, const Quantization &quantization) {
+    Vertex v(quantization.offset + QVector3D(p.position[0], p.position[1], p.position[2]) * quantization.scale);
+    v.normal = decodeOctahedral(p.normal);
+    v.texCoords = QVector2D(halfToFloat(p.texCoords[0]), halfToFloat(p.texCoords[1]));
+    return v;
+}
+
+std::vector<PackedVertex> VertexCompression::packVertices(const std::vector<Vertex> &vertices, const Quantization &quantization) {
+    std::vector<PackedVertex> packed(vertices.size());
+    for (std::size_t i = 0; i < vertices.size(); i++) packed[i] = pack(vertices[i], quantization);
+    return packed;
+}
+
+std::array<std::int16_t, 2> VertexCompression::encodeOctahedral(const QVector3D &n) {
+    float l1 = std::abs(n.x()) + std::abs(n.y()) + std::abs(n.z());
+    if (l1 == 0.0f) return { 0, 0 };
+
+    float x = n.x() / l1, y = n.y() / l1;
+    // the lower half is folded over the diagonals
+    if (n.z() < 0.0f) {
+        float fx = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+
+    return { std::int16_t(std::round(std::clamp(x, -1.0f, 1.0f) * SNORM16_MAX)),
+             std::int16_t(std::round(std::clamp(y, -1.0f, 1.0f) * SNORM16_MAX)) };
+}
+
+QVector3D VertexCompression::decodeOctahedral(const std::array<std::int16_t, 2> &e) {
+    float x = std::max(e[0] / SNORM16_MAX, -1.0f), y = std::max(e[1] / SNORM16_MAX, -1.0f);
+    QVector3D n(x, y, 1.0f - std::abs(x) - std::abs(y));
+    float t = std::max(-n.z(), 0.0f);
+    n.setX(n.x() >= 0.0f ? n.x() - t : n.x() + t);
+    n.setY(n.y() >= 0.0f ? n.y() - t : n.y() + t);
+    return n.normalized();
+}
+
+std::uint16_t VertexCompression::floatToHalf(float f) {
+    std::uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+
+    std::uint32_t sign = (x >> 16) & 0x8000;
+    std::uint32_t biased = (x >> 23) & 0xFF;
+    std::uint32_t mantissa = x & 0x7FFFFF;
+    int exponent = int(biased) - 127 + 15;
+
+    if (biased == 0xFF) return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+    if (exponent >= 31) return sign | 0x7C00;
+
+    if (exponent <= 0) {
+        // subnormal half, the implicit bit becomes explicit
+        if (exponent < -10) return sign;
+        mantissa |= 0x800000;
+        std::uint32_t shift = 14 - exponent;
+        std::uint32_t half = mantissa >> shift;
+        std::uint32_t rest = mantissa & ((1u << shift) - 1);
+        std::uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) half++;
+        return sign | half;
+    }
+
+    // a carry of the rounding correctly moves to the exponent
+    std::uint32_t half = sign | (std::uint32_t(exponent) << 10) | (mantissa >> 13);
+    std::uint32_t rest = mantissa & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+    return half;
+}
+
+float VertexCompression::halfToFloat(std::uint16_t h) {
+    std::uint32_t sign = std::uint32_t(h & 0x8000) << 16;
+    std::uint32_t exponent = (h >> 10) & 0x1F;
+    std::uint32_t mantissa = h & 0x3FF;
+
+    if (exponent == 0) {
+        float f = std::ldexp(float(mantissa), -24);
+        return sign ? -f : f;
+    }
+
+    std::uint32_t x = exponent == 31 ? sign | 0x7F800000 | (mantissa << 13)
+                                     : sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
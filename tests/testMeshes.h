@@ -0,0 +1,64 @@
+#ifndef TESTMESHES_H
+#define TESTMESHES_H
+
+#include <map>
+#include "mesh.h"
+
+namespace testMeshes {
+
+// Octahedron subdivided and projected on the unit sphere, closed and manifold
+inline Mesh makeSphere(int levels) {
+    std::vector<Vertex> vertices = {
+        Vertex(1, 0, 0), Vertex(-1, 0, 0), Vertex(0, 1, 0),
+        Vertex(0, -1, 0), Vertex(0, 0, 1), Vertex(0, 0, -1)
+    };
+    std::vector<Triangle> faces = {
+        Triangle(0, 2, 4), Triangle(2, 1, 4), Triangle(1, 3, 4), Triangle(3, 0, 4),
+        Triangle(2, 0, 5), Triangle(1, 2, 5), Triangle(3, 1, 5), Triangle(0, 3, 5)
+    };
+
+    for (int l = 0; l < levels; l++) {
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int> middles;
+        auto middle = [&](unsigned int a, unsigned int b) {
+            auto key = std::make_pair(std::min(a, b), std::max(a, b));
+            auto it = middles.find(key);
+            if (it != middles.end()) return it->second;
+            vertices.push_back(Vertex(((vertices[a].position + vertices[b].position) / 2).normalized()));
+            middles[key] = vertices.size() - 1;
+            return (unsigned int)vertices.size() - 1;
+        };
+
+        std::vector<Triangle> refined;
+        for (const Triangle &t : faces) {
+            unsigned int a = t.idVertices[0], b = t.idVertices[1], c = t.idVertices[2];
+            unsigned int ab = middle(a, b), bc = middle(b, c), ca = middle(c, a);
+            refined.push_back(Triangle(a, ab, ca));
+            refined.push_back(Triangle(ab, b, bc));
+            refined.push_back(Triangle(ca, bc, c));
+            refined.push_back(Triangle(ab, bc, ca));
+        }
+        faces = std::move(refined);
+    }
+
+    return Mesh(std::move(vertices), std::move(faces));
+}
+
+inline Mesh makeGrid(int n) {
+    std::vector<Vertex> vertices;
+    std::vector<Triangle> faces;
+    for (int j = 0; j <= n; j++) {
+        for (int i = 0; i <= n; i++) vertices.push_back(Vertex(i, j, 0));
+    }
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < n; i++) {
+            unsigned int a = j * (n + 1) + i, b = a + 1, c = a + n + 1, d = c + 1;
+            faces.push_back(Triangle(a, b, d));
+            faces.push_back(Triangle(a, d, c));
+        }
+    }
+    return Mesh(std::move(vertices), std::move(faces));
+}
+
+} // namespace testMeshes
+
+#endif // TESTMESHES_H
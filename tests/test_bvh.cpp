@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include "bvh.h"
+
+class BVHTest : public ::testing::Test {
+
+protected:
+    void SetUp() override {
+        // UV sphere of radius 1 centered at the origin
+        const int rings = 32, sectors = 64;
+        for (int r = 0; r <= rings; r++) {
+            float phi = float(M_PI) * r / rings;
+            for (int s = 0; s < sectors; s++) {
+                float theta = 2.0f * float(M_PI) * s / sectors;
+                vertices.push_back(Vertex(std::sin(phi) * std::cos(theta), std::sin(phi) * std::sin(theta), std::cos(phi)));
+            }
+        }
+        for (int r = 0; r < rings; r++) {
+            for (int s = 0; s < sectors; s++) {
+                unsigned int a = r * sectors + s, b = r * sectors + (s + 1) % sectors;
+                unsigned int c = a + sectors, d = b + sectors;
+                faces.push_back(Triangle(a, c, b));
+                faces.push_back(Triangle(b, c, d));
+            }
+        }
+        bvh.build(vertices, faces);
+    }
+
+    RayHit bruteForce(const Ray &ray) const {
+        RayHit best;
+        for (std::size_t i = 0; i < faces.size(); i++) {
+            QVector3D a = vertices[faces[i].idVertices[0]].position;
+            QVector3D e1 = vertices[faces[i].idVertices[1]].position - a;
+            QVector3D e2 = vertices[faces[i].idVertices[2]].position - a;
+            QVector3D p = QVector3D::crossProduct(ray.direction, e2);
+            float det = QVector3D::dotProduct(e1, p);
+            if (std::fabs(det) < 1e-8f) continue;
+            QVector3D tv = ray.origin - a;
+            float u = QVector3D::dotProduct(tv, p) / det;
+            QVector3D q = QVector3D::crossProduct(tv, e1);
+            float v = QVector3D::dotProduct(ray.direction, q) / det;
+            float t = QVector3D::dotProduct(e2, q) / det;
+            if (u >= 0 && v >= 0 && u + v <= 1 && t > 1e-8f && t < best.t) {
+                best.t = t;
+                best.face = i;
+            }
+        }
+        return best;
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<Triangle> faces;
+    BVH bvh;
+};
+
+TEST_F(BVHTest, BuildKeepsAllFaces) {
+    EXPECT_FALSE(bvh.isEmpty());
+    EXPECT_EQ(bvh.faceCount(), faces.size());
+
+    std::size_t leafFaces = 0;
+    for (const auto &node : bvh.getNodes()) {
+        if (node.isLeaf()) leafFaces += node.count;
+    }
+    EXPECT_EQ(leafFaces, faces.size()) << "Leaves don't cover all the faces\n";
+}
+
+TEST_F(BVHTest, ChildrenInsideParentBounds) {
+    const auto &nodes = bvh.getNodes();
+    for (std::size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].isLeaf() || (i == 1)) continue;
+        for (unsigned int child : { nodes[i].leftFirst, nodes[i].leftFirst + 1 }) {
+            for (int a = 0; a < 3; a++) {
+                EXPECT_GE(nodes[child].boundsMin[a], nodes[i].boundsMin[a]);
+                EXPECT_LE(nodes[child].boundsMax[a], nodes[i].boundsMax[a]);
+            }
+        }
+    }
+}
+
+TEST_F(BVHTest, RayHitsClosestFace) {
+    Ray ray(QVector3D(0.05f, 0.03f, 5.0f), QVector3D(0.0f, 0.0f, -1.0f));
+    RayHit hit;
+    ASSERT_TRUE(bvh.intersect(ray, hit));
+    EXPECT_NEAR(hit.t, 4.0f, 0.01f) << "The first hit should be the front of the sphere\n";
+    EXPECT_EQ(hit.face, bruteForce(ray).face);
+}
+
+TEST_F(BVHTest, RayMiss) {
+    Ray ray(QVector3D(2.0f, 2.0f, 5.0f), QVector3D(0.0f, 0.0f, -1.0f));
+    RayHit hit;
+    EXPECT_FALSE(bvh.intersect(ray, hit));
+    EXPECT_EQ(hit.face, -1);
+}
+
+TEST_F(BVHTest, BatchMatchesBruteForce) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<Ray> rays;
+    for (int i = 0; i < 500; i++) {
+        QVector3D origin(dist(rng) * 3.0f, dist(rng) * 3.0f, dist(rng) * 3.0f);
+        QVector3D target(dist(rng) * 0.5f, dist(rng) * 0.5f, dist(rng) * 0.5f);
+        rays.push_back(Ray(origin, (target - origin).normalized()));
+    }
+
+    std::vector<RayHit> hits;
+    bvh.intersect(rays, hits);
+    ASSERT_EQ(hits.size(), rays.size());
+
+    for (std::size_t i = 0; i < rays.size(); i++) {
+        RayHit expected = bruteForce(rays[i]);
+        EXPECT_EQ(hits[i].face == -1, expected.face == -1) << "Ray " << i << " differs\n";
+        if (expected.face != -1) {
+            EXPECT_NEAR(hits[i].t, expected.t, 1e-4f) << "Ray " << i << " differs\n";
+        }
+    }
+}
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include "chunkFile.h"
+#include "chunkStreamer.h"
+#include "testMeshes.h"
+
+using namespace testMeshes;
+
+namespace {
+
+// a small sphere split in many chunks, written next to the test binary
+struct ChunkFileFixture : public ::testing::Test {
+    void SetUp() override {
+        sphere = makeSphere(4);
+        ASSERT_EQ(sphere.saveOFF("./chunkSphere.off"), MeshError::OK);
+        ASSERT_EQ(ChunkFile::build("./chunkSphere.off", "./chunkSphere.mvc", 64), MeshError::OK);
+        ASSERT_EQ(file.open("./chunkSphere.mvc"), MeshError::OK);
+    }
+
+    void TearDown() override {
+        file.close();
+        std::remove("./chunkSphere.off");
+        std::remove("./chunkSphere.mvc");
+    }
+
+    Mesh sphere;
+    ChunkFile file;
+};
+
+// a copy of the chunk file where a value of its tables is overwritten
+template <typename T>
+int openPatched(const char *source, std::uint64_t position, const T &value) {
+    std::ifstream in(source, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::memcpy(bytes.data() + position, &value, sizeof(value));
+    std::ofstream out("./patched.mvc", std::ios::binary);
+    out.write(bytes.data(), bytes.size());
+    out.close();
+    ChunkFile patched;
+    int result = patched.open("./patched.mvc");
+    patched.close();
+    std::remove("./patched.mvc");
+    return result;
+}
+
+// a unit sphere scaled around the origin and a triangle far away, so the whole sphere is in one bucket
+void writeClusteredSphere(const char *path, float radius) {
+    Mesh sphere = makeSphere(4);
+    std::ofstream file(path);
+    file << "OFF\n" << sphere.getVertices().size() + 3 << " " << sphere.getFaces().size() + 1 << " 0\n";
+    for (const Vertex &v : sphere.getVertices()) file << radius * v.position.x() << " " << radius * v.position.y() << " " << radius * v.position.z() << "\n";
+    file << "300 300 300\n301 300 300\n300 301 300\n";
+    for (const Triangle &t : sphere.getFaces()) file << "3 " << t.idVertices[0] << " " << t.idVertices[1] << " " << t.idVertices[2] << "\n";
+    std::size_t far = sphere.getVertices().size();
+    file << "3 " << far << " " << far + 1 << " " << far + 2 << "\n";
+}
+
+}
+
+TEST_F(ChunkFileFixture, ChunksCoverTheMesh) {
+    const ChunkFileHeader &header = file.getHeader();
+    EXPECT_EQ(header.vertexCount, sphere.getVertices().size());
+    EXPECT_EQ(header.faceCount, sphere.getFaces().size());
+    ASSERT_EQ(header.chunkCount, file.getChunks().size());
+    EXPECT_GT(header.chunkCount, 1u);
+
+    std::uint64_t faces = 0;
+    Quantization quantization = file.getQuantization();
+    for (unsigned int c = 0; c < header.chunkCount; c++) {
+        const ChunkRecord &record = file.getChunks()[c];
+        EXPECT_EQ(record.offset % 4096, 0u) << "Chunk " << c << " is not page aligned\n";
+        EXPECT_LE(record.indexCount, 3u * 64);
+        faces += record.indexCount / 3;
+
+        const std::uint16_t *indices = file.chunkIndices(c);
+        for (unsigned int i = 0; i < record.indexCount; i++) ASSERT_LT(indices[i], record.vertexCount);
+
+        // the unit sphere keeps its radius through the quantization
+        const PackedVertex *vertices = file.chunkVertices(c);
+        for (unsigned int v = 0; v < record.vertexCount; v++) {
+            Vertex p = VertexCompression::unpack(vertices[v], quantization);
+            EXPECT_NEAR(p.position.length(), 1.0f, 1e-3f);
+            EXPECT_GT(QVector3D::dotProduct(p.normal, p.position), 0.9f);
+        }
+    }
+    EXPECT_EQ(faces, header.faceCount);
+}
+
+TEST_F(ChunkFileFixture, HierarchyReachesEachChunkOnce) {
+    const auto &nodes = file.getNodes();
+    std::vector<int> seen(file.getChunks().size(), 0);
+    std::vector<unsigned int> stack = { unsigned(nodes.size() - 1) };
+    while (!stack.empty()) {
+        const ChunkNode &node = nodes[stack.back()];
+        stack.pop_back();
+        for (unsigned int i = node.first; i < node.first + node.count; i++) {
+            const float *childMin = node.leaf ? file.getChunks()[i].boundsMin : nodes[i].boundsMin;
+            const float *childMax = node.leaf ? file.getChunks()[i].boundsMax : nodes[i].boundsMax;
+            for (int axis = 0; axis < 3; axis++) {
+                EXPECT_LE(node.boundsMin[axis], childMin[axis]);
+                EXPECT_GE(node.boundsMax[axis], childMax[axis]);
+            }
+            if (node.leaf) seen[i]++;
+            else stack.push_back(i);
+        }
+    }
+
+    for (std::size_t c = 0; c < seen.size(); c++) EXPECT_EQ(seen[c], 1) << "Chunk " << c << "\n";
+}
+
+TEST_F(ChunkFileFixture, StreamerEvictsLeastRecentlyUsed) {
+    std::size_t chunkCount = file.getChunks().size();
+    std::size_t slotCount = chunkCount / 2;
+    ChunkStreamer streamer(file, slotCount);
+
+    QMatrix4x4 projection, view;
+    projection.perspective(45.0f, 1.0f, 0.1f, 100.0f);
+    view.translate(0.0f, 0.0f, -4.0f);
+    Frustum all(projection * view);
+    QVector3D eye(0.0f, 0.0f, 4.0f);
+
+    // the whole sphere is visible but only half of it fits, the slots end up full of the nearest chunks
+    std::vector<unsigned int> visible;
+    for (int frame = 0; frame < 1000; frame++) {
+        std::size_t streaming = streamer.update(all, eye, visible);
+        streamer.takeLoaded(8);
+        if (streaming == 0 && frame > 0) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(visible.size(), chunkCount);
+    EXPECT_EQ(streamer.getResidentCount(), slotCount);
+    for (std::size_t i = 0; i < visible.size(); i++) {
+        if (streamer.slotOf(visible[i]) < 0) continue;
+        for (std::size_t j = 0; j < i; j++) EXPECT_GE(streamer.slotOf(visible[j]), 0) << "A nearer chunk is missing\n";
+    }
+
+    // from the other side with a short far plane, only the back cap is visible and takes the slots of the front
+    QMatrix4x4 shortProjection, back;
+    shortProjection.perspective(45.0f, 1.0f, 0.1f, 3.4f);
+    back.translate(0.0f, 0.0f, -4.0f);
+    back.rotate(180.0f, 0.0f, 1.0f, 0.0f);
+    Frustum behind(shortProjection * back);
+    QVector3D behindEye(0.0f, 0.0f, -4.0f);
+    for (int frame = 0; frame < 1000; frame++) {
+        std::size_t streaming = streamer.update(behind, behindEye, visible);
+        streamer.takeLoaded(8);
+        if (streaming == 0 && frame > 0) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_FALSE(visible.empty());
+    ASSERT_LE(visible.size(), slotCount);
+    for (unsigned int c : visible) {
+        EXPECT_GE(streamer.slotOf(c), 0);
+        EXPECT_LT(file.getChunks()[c].boundsMin[2], 0.0f);
+    }
+    EXPECT_EQ(streamer.getResidentCount(), slotCount);
+}
+
+TEST_F(ChunkFileFixture, CorruptedTablesAreRejected) {
+    const ChunkFileHeader &header = file.getHeader();
+    std::uint64_t records = header.tableOffset, nodes = records + header.chunkCount * sizeof(ChunkRecord);
+    std::uint64_t size = std::uint64_t(header.tableOffset) + header.chunkCount * sizeof(ChunkRecord) + header.nodeCount * sizeof(ChunkNode);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", records + offsetof(ChunkRecord, offset), size - 8), MeshError::FORMAT);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", records + offsetof(ChunkRecord, offset), ~std::uint64_t(0)), MeshError::FORMAT);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", records + offsetof(ChunkRecord, vertexCount), header.maxChunkVertices + 1), MeshError::FORMAT);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", records + offsetof(ChunkRecord, indexCount), header.maxChunkIndices + 3), MeshError::FORMAT);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", nodes + offsetof(ChunkNode, first), header.chunkCount), MeshError::FORMAT);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", nodes + offsetof(ChunkNode, count), ~std::uint32_t(0)), MeshError::FORMAT);
+    // the root pointing to itself
+    std::uint64_t root = nodes + (header.nodeCount - 1) * sizeof(ChunkNode);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", root + offsetof(ChunkNode, first), header.nodeCount - 1), MeshError::FORMAT);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", offsetof(ChunkFileHeader, tableOffset), ~std::uint64_t(0)), MeshError::FORMAT);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", offsetof(ChunkFileHeader, maxChunkVertices), std::uint32_t(1) << 20), MeshError::FORMAT);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", offsetof(ChunkFileHeader, chunkCount), std::uint32_t(0)), MeshError::FORMAT);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", offsetof(ChunkFileHeader, maxChunkVertices), std::uint32_t(0)), MeshError::FORMAT);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", offsetof(ChunkFileHeader, maxChunkIndices), std::uint32_t(0)), MeshError::FORMAT);
+    // an index past the vertices of its chunk
+    const ChunkRecord &first = file.getChunks()[0];
+    std::uint64_t index = first.offset + first.vertexCount * sizeof(PackedVertex);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", index, std::uint16_t(first.vertexCount)), MeshError::FORMAT);
+    EXPECT_EQ(openPatched("./chunkSphere.mvc", records + offsetof(ChunkRecord, radius), 2.0f), MeshError::OK);
+}
+
+TEST(ChunkFileTest, LargeBucketsAreSplit) {
+    // the sphere spans a few Morton cells, then a single cell where only the slices split it
+    for (float radius : { 1.0f, 1e-4f }) {
+        writeClusteredSphere("./clustered.off", radius);
+        Mesh sphere = makeSphere(4);
+        ASSERT_EQ(ChunkFile::build("./clustered.off", "./clustered.mvc", 8), MeshError::OK);
+        ChunkFile file;
+        ASSERT_EQ(file.open("./clustered.mvc"), MeshError::OK);
+
+        // every face once : the sums of the centroids match the ones of the mesh
+        Quantization quantization = file.getQuantization();
+        std::uint64_t faces = 0;
+        double sum[3] = { 0.0, 0.0, 0.0 }, expected[3] = { 0.0, 0.0, 0.0 };
+        for (unsigned int c = 0; c < file.getChunks().size(); c++) {
+            const ChunkRecord &record = file.getChunks()[c];
+            ASSERT_LE(record.indexCount, 3u * 8);
+            const PackedVertex *vertices = file.chunkVertices(c);
+            const std::uint16_t *indices = file.chunkIndices(c);
+            for (unsigned int i = 0; i < record.indexCount; i++) {
+                ASSERT_LT(indices[i], record.vertexCount);
+                QVector3D p = VertexCompression::unpack(vertices[indices[i]], quantization).position;
+                for (int axis = 0; axis < 3; axis++) sum[axis] += p[axis] / 3.0;
+            }
+            faces += record.indexCount / 3;
+        }
+        for (const Triangle &t : sphere.getFaces()) {
+            for (unsigned int v : t.idVertices) {
+                for (int axis = 0; axis < 3; axis++) expected[axis] += radius * sphere.getVertices()[v].position[axis] / 3.0;
+            }
+        }
+        for (int axis = 0; axis < 3; axis++) expected[axis] += 300.0 + 1.0 / 3.0 * (axis < 2);
+        EXPECT_EQ(faces, sphere.getFaces().size() + 1);
+        for (int axis = 0; axis < 3; axis++) EXPECT_NEAR(sum[axis], expected[axis], 0.5) << "Axis " << axis << "\n";
+
+        file.close();
+        std::remove("./clustered.off");
+        std::remove("./clustered.mvc");
+    }
+}
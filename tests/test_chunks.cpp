@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "chunks.h"
+#include "testMeshes.h"
+
+using namespace testMeshes;
+
+TEST(ChunksTest, PartitionCoversAllFaces) {
+    Mesh sphere = makeSphere(5);
+    const auto &faces = sphere.getFaces();
+    std::vector<unsigned int> order;
+    auto chunks = ChunkPartition::build(sphere.getVertices(), faces, 300, order);
+
+    ASSERT_EQ(order.size(), faces.size());
+    std::vector<int> seen(faces.size(), 0);
+    std::size_t expectedIndex = 0;
+    for (const auto &c : chunks) {
+        EXPECT_EQ(c.firstIndex, expectedIndex);
+        EXPECT_LE(c.indexCount, 3 * 300);
+        expectedIndex += c.indexCount;
+
+        for (std::size_t i = c.firstIndex / 3; i < (c.firstIndex + c.indexCount) / 3; i++) {
+            if (i > c.firstIndex / 3) {
+                EXPECT_LT(order[i - 1], order[i]) << "Chunk faces lost their order\n";
+            }
+            seen[order[i]]++;
+            for (unsigned int v : faces[order[i]].idVertices) {
+                const QVector3D &p = sphere.getVertices()[v].position;
+                EXPECT_LE((p - c.center).length(), c.radius + 1e-5f);
+                for (int axis = 0; axis < 3; axis++) {
+                    EXPECT_GE(p[axis], c.boundsMin[axis]);
+                    EXPECT_LE(p[axis], c.boundsMax[axis]);
+                }
+            }
+        }
+    }
+    EXPECT_EQ(expectedIndex, 3 * faces.size());
+    for (int s : seen) EXPECT_EQ(s, 1);
+}
+
+TEST(ChunksTest, FrustumCulling) {
+    // camera at the origin looking down -z
+    QMatrix4x4 projection;
+    projection.perspective(45.0f, 1.0f, 1.0f, 100.0f);
+    Frustum frustum(projection);
+
+    EXPECT_TRUE(frustum.intersects(QVector3D(-1, -1, -11), QVector3D(1, 1, -9)));
+    EXPECT_FALSE(frustum.intersects(QVector3D(-1, -1, 9), QVector3D(1, 1, 11)));
+    EXPECT_FALSE(frustum.intersects(QVector3D(49, -1, -11), QVector3D(51, 1, -9)));
+    EXPECT_FALSE(frustum.intersects(QVector3D(-1, -1, -120), QVector3D(1, 1, -110)));
+    // straddling the left plane
+    EXPECT_TRUE(frustum.intersects(QVector3D(-10, -1, -11), QVector3D(-3, 1, -9)));
+}
+
+TEST(ChunksTest, ConeCullingIsConservative) {
+    Mesh sphere = makeSphere(5);
+    const auto &faces = sphere.getFaces();
+    const auto &vertices = sphere.getVertices();
+    std::vector<unsigned int> order;
+    auto chunks = ChunkPartition::build(vertices, faces, 128, order);
+
+    QVector3D camera(0, 0, 5);
+    std::size_t culled = 0;
+    for (const auto &c : chunks) {
+        if (!c.isBackFacing(camera)) continue;
+        culled++;
+        for (std::size_t i = c.firstIndex / 3; i < (c.firstIndex + c.indexCount) / 3; i++) {
+            const auto &v = faces[order[i]].idVertices;
+            QVector3D normal = QVector3D::crossProduct(vertices[v[1]].position - vertices[v[0]].position,
+                                                       vertices[v[2]].position - vertices[v[0]].position);
+            EXPECT_GE(QVector3D::dotProduct(vertices[v[0]].position - camera, normal), 0.0f) << "A visible face was culled\n";
+        }
+    }
+
+    // most of the far hemisphere is hidden
+    EXPECT_GT(culled, chunks.size() / 4);
+
+    std::vector<unsigned char> visible;
+    QMatrix4x4 everything;
+    everything.setToIdentity();
+    everything(0, 0) = everything(1, 1) = everything(2, 2) = 0.01f;
+    EXPECT_EQ(ChunkPartition::cull(chunks, 0, chunks.size(), Frustum(everything), camera, true, visible), culled);
+    EXPECT_EQ(ChunkPartition::cull(chunks, 0, chunks.size(), Frustum(everything), camera, false, visible), 0);
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include "generator.h"
+
+TEST(GeneratorTest, IcosphereIsClosedOnTheUnitSphere) {
+    for (unsigned int levels = 0; levels <= 3; levels++) {
+        GeneratedMesh sphere = Generator::icosphere(levels);
+        std::size_t n = std::size_t(1) << levels;
+        ASSERT_EQ(sphere.positions.size(), 10 * n * n + 2);
+        ASSERT_EQ(sphere.indices.size(), 3 * 20 * n * n);
+        for (const auto &p : sphere.positions) EXPECT_NEAR(p.length(), 1.0f, 1e-5f);
+
+        Mesh mesh = Generator::toMesh(sphere);
+        EXPECT_TRUE(mesh.isClosed()) << "Level " << levels << "\n";
+        // counterclockwise seen from outside
+        for (const auto &v : mesh.getVertices()) EXPECT_GT(QVector3D::dotProduct(v.normal, v.position), 0.9f);
+    }
+}
+
+TEST(GeneratorTest, TorusAndTerrainCounts) {
+    GeneratedMesh torus = Generator::torus(24, 12);
+    ASSERT_EQ(torus.positions.size(), 24u * 12);
+    ASSERT_EQ(torus.indices.size(), 6u * 24 * 12);
+    Mesh mesh = Generator::toMesh(torus);
+    EXPECT_TRUE(mesh.isClosed());
+
+    GeneratedMesh terrain = Generator::terrain(16, 0.2f, 5);
+    ASSERT_EQ(terrain.positions.size(), 17u * 17);
+    ASSERT_EQ(terrain.indices.size(), 6u * 16 * 16);
+    for (const auto &p : terrain.positions) {
+        EXPECT_LE(std::abs(p.z()), 0.2f * 1.02f + 1e-6f);
+        EXPECT_LE(std::abs(p.x()), 1.0f);
+    }
+}
+
+TEST(GeneratorTest, CloudsDependOnTheSeedOnly) {
+    for (int d = 0; d <= 4; d++) {
+        CloudDistribution distribution = static_cast<CloudDistribution>(d);
+        GeneratedMesh a = Generator::pointCloud(5000, distribution, 42);
+        GeneratedMesh b = Generator::pointCloud(5000, distribution, 42);
+        ASSERT_EQ(a.positions.size(), 5000u);
+        EXPECT_TRUE(a.indices.empty());
+        EXPECT_EQ(a.positions, b.positions) << "Distribution " << d << "\n";
+        for (const auto &p : a.positions) {
+            EXPECT_LE(std::abs(p.x()), 1.0f);
+            EXPECT_LE(std::abs(p.y()), 1.0f);
+        }
+    }
+
+    GeneratedMesh other = Generator::pointCloud(5000, CloudDistribution::UNIFORM, 43);
+    EXPECT_NE(other.positions, Generator::pointCloud(5000, CloudDistribution::UNIFORM, 42).positions);
+
+    // exactly degenerate
+    for (const auto &p : Generator::pointCloud(1000, CloudDistribution::COLLINEAR, 1).positions) EXPECT_EQ(p.y(), 0.5f * p.x());
+    for (const auto &p : Generator::pointCloud(1000, CloudDistribution::COCIRCULAR, 1).positions) {
+        EXPECT_NEAR(p.x() * p.x() + p.y() * p.y(), 1.0f, 1e-5f);
+    }
+}
+
+TEST(GeneratorTest, SaveLoadsBack) {
+    GeneratedMesh sphere = Generator::icosphere(2);
+    ASSERT_EQ(Generator::save(sphere, "./generated.off"), MeshError::OK);
+    Mesh off;
+    ASSERT_EQ(off.loadFile("./generated.off"), MeshError::OK);
+    ASSERT_EQ(off.getVertices().size(), sphere.positions.size());
+    ASSERT_EQ(off.getFaces().size(), sphere.indices.size() / 3);
+    EXPECT_EQ(off.getFaces()[7].idVertices[1], sphere.indices[3 * 7 + 1]);
+    EXPECT_EQ(off.getVertices()[11].position, sphere.positions[11]);
+    EXPECT_TRUE(off.isClosed());
+    std::remove("./generated.off");
+
+    // the OBJ loader splits the vertices by face
+    ASSERT_EQ(Generator::save(sphere, "./generated.obj"), MeshError::OK);
+    Mesh obj;
+    ASSERT_EQ(obj.loadFile("./generated.obj"), MeshError::OK);
+    EXPECT_EQ(obj.getFaces().size(), sphere.indices.size() / 3);
+    std::remove("./generated.obj");
+
+    GeneratedMesh cloud = Generator::pointCloud(300, CloudDistribution::UNIFORM, 3);
+    ASSERT_EQ(Generator::save(cloud, "./generated.txt"), MeshError::OK);
+    Mesh points;
+    ASSERT_EQ(points.loadPoints("./generated.txt"), MeshError::OK);
+    EXPECT_EQ(points.getVertices().size(), cloud.positions.size());
+    std::remove("./generated.txt");
+
+    EXPECT_EQ(Generator::save(cloud, "./generated.ply"), MeshError::FORMAT);
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include "indexOptimizer.h"
+#include "testMeshes.h"
+
+using namespace testMeshes;
+
+namespace {
+
+// Same sphere with its faces in a random order, like a soup written by another tool
+Mesh makeShuffledSphere(int levels) {
+    Mesh sphere = makeSphere(levels);
+    std::vector<Triangle> faces;
+    for (const auto &f : sphere.getFaces()) faces.push_back(Triangle(f.idVertices[0], f.idVertices[1], f.idVertices[2]));
+    std::shuffle(faces.begin(), faces.end(), std::mt19937(42));
+    return Mesh(sphere.getVertices(), std::move(faces));
+}
+
+}
+
+TEST(IndexOptimizerTest, CacheSimulator) {
+    // two triangles sharing an edge, the second one only misses its last vertex
+    std::vector<unsigned int> indices = { 0, 1, 2, 2, 1, 3 };
+    CacheStatistics stats = IndexOptimizer::simulateVertexCache(indices, 4);
+    EXPECT_FLOAT_EQ(stats.acmr, 2.0f);
+    EXPECT_FLOAT_EQ(stats.atvr, 1.0f);
+
+    // a cache of 3 entries has evicted vertex 0 when it is used again
+    indices = { 0, 1, 2, 3, 4, 5, 0, 4, 5 };
+    stats = IndexOptimizer::simulateVertexCache(indices, 6, 3);
+    EXPECT_FLOAT_EQ(stats.acmr, 7.0f / 3.0f);
+    EXPECT_FLOAT_EQ(stats.atvr, 7.0f / 6.0f);
+}
+
+TEST(IndexOptimizerTest, ImprovesCacheReuse) {
+    Mesh mesh = makeShuffledSphere(5);
+    std::size_t faceCount = mesh.getFaces().size();
+
+    CacheStatistics before, after;
+    mesh.optimizeIndices(&before, &after);
+
+    EXPECT_EQ(mesh.getFaces().size(), faceCount);
+    EXPECT_GT(before.acmr, 2.0f);
+    EXPECT_LT(after.acmr, 0.8f);
+    EXPECT_LT(after.atvr, 1.5f);
+    EXPECT_LT(after.acmr, before.acmr);
+}
+
+TEST(IndexOptimizerTest, KeepsTopology) {
+    Mesh mesh = makeShuffledSphere(3);
+    mesh.optimizeIndices();
+
+    const auto &faces = mesh.getFaces();
+    for (std::size_t fi = 0; fi < faces.size(); ++fi) {
+        ASSERT_EQ(faces[fi].idFaces.size(), 3);
+        for (int e = 0; e < 3; ++e) {
+            unsigned int n = faces[fi].idFaces[e];
+            ASSERT_LT(n, faces.size()) << "The reordered sphere has a hole\n";
+            unsigned int a = faces[fi].idVertices[e], b = faces[fi].idVertices[(e + 1) % 3];
+            int la = faces[n].localIndex(a), lb = faces[n].localIndex(b);
+            ASSERT_GE(la, 0);
+            ASSERT_GE(lb, 0);
+            EXPECT_EQ(faces[n].idFaces[lb], fi) << "Adjacency is not symmetric\n";
+        }
+    }
+}
+
+TEST(IndexOptimizerTest, VerticesInFirstUseOrder) {
+    Mesh mesh = makeShuffledSphere(3);
+    mesh.optimizeIndices();
+
+    unsigned int next = 0;
+    for (unsigned int v : mesh.getIndices()) {
+        ASSERT_LE(v, next) << "Vertex used before the previous ones\n";
+        if (v == next) next++;
+    }
+    EXPECT_EQ(next, mesh.getVertices().size());
+}
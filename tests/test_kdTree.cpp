@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include "kdTree.h"
+
+namespace {
+
+// a cloud with a flat part and repeated points, like a scan
+std::vector<QVector3D> makeCloud(std::size_t count) {
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> coordinate(-10.0f, 10.0f);
+    std::vector<QVector3D> points;
+    for (std::size_t i = 0; i < count; i++) {
+        float z = i % 3 == 0 ? 0.0f : coordinate(random) * 0.1f;
+        points.push_back(QVector3D(coordinate(random), coordinate(random), z));
+    }
+    for (std::size_t i = 0; i < count / 10; i++) points.push_back(points[i * 7 % count]);
+    return points;
+}
+
+std::vector<float> bruteForce(const std::vector<QVector3D> &points, const QVector3D &q) {
+    std::vector<float> distances;
+    for (const auto &p : points) distances.push_back((p - q).lengthSquared());
+    std::sort(distances.begin(), distances.end());
+    return distances;
+}
+
+}
+
+TEST(KDTreeTest, NeighborsMatchABruteForce) {
+    std::vector<QVector3D> points = makeCloud(20000);
+    KDTree tree;
+    tree.build(points);
+    ASSERT_EQ(tree.size(), points.size());
+
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> coordinate(-12.0f, 12.0f);
+    std::vector<QVector3D> queries;
+    for (int i = 0; i < 200; i++) queries.push_back(QVector3D(coordinate(random), coordinate(random), coordinate(random) * 0.1f));
+    queries.push_back(points[42]);
+
+    const std::size_t k = 10;
+    std::vector<unsigned int> neighbors;
+    std::vector<float> distances;
+    tree.knn(queries, k, neighbors, &distances);
+    ASSERT_EQ(neighbors.size(), queries.size() * k);
+
+    std::vector<std::size_t> start;
+    std::vector<unsigned int> balls;
+    const float radius = 0.8f;
+    tree.radius(queries, radius, start, balls);
+    ASSERT_EQ(start.size(), queries.size() + 1);
+
+    for (std::size_t q = 0; q < queries.size(); q++) {
+        std::vector<float> expected = bruteForce(points, queries[q]);
+        for (std::size_t j = 0; j < k; j++) {
+            EXPECT_EQ(distances[q * k + j], expected[j]) << "Query " << q << ", neighbor " << j << "\n";
+            EXPECT_EQ((points[neighbors[q * k + j]] - queries[q]).lengthSquared(), expected[j]);
+        }
+
+        std::size_t inside = std::upper_bound(expected.begin(), expected.end(), radius * radius) - expected.begin();
+        EXPECT_EQ(start[q + 1] - start[q], inside) << "Query " << q << "\n";
+        for (std::size_t i = start[q]; i < start[q + 1]; i++) EXPECT_LE((points[balls[i]] - queries[q]).lengthSquared(), radius * radius);
+    }
+    EXPECT_EQ(distances[(queries.size() - 1) * k], 0.0f);
+}
+
+TEST(KDTreeTest, SmallTrees) {
+    KDTree tree;
+    std::vector<unsigned int> neighbors;
+    tree.knn(QVector3D(0, 0, 0), 3, neighbors);
+    EXPECT_TRUE(neighbors.empty());
+
+    // fewer points than asked, the batch pads the rows
+    tree.build(std::vector<QVector3D>({ QVector3D(0, 0, 0), QVector3D(3, 0, 0), QVector3D(1, 0, 0) }));
+    tree.knn(QVector3D(2.1f, 0, 0), 5, neighbors);
+    EXPECT_EQ(neighbors, std::vector<unsigned int>({ 1, 2, 0 }));
+    std::vector<QVector3D> queries = { QVector3D(-1, 0, 0) };
+    tree.knn(queries, 4, neighbors);
+    EXPECT_EQ(neighbors, std::vector<unsigned int>({ 0, 2, 1, KDTree::NO_POINT }));
+
+    // all the points at the same place
+    std::vector<Vertex> same(100, Vertex(1.0f, 2.0f, 3.0f));
+    tree.build(same);
+    tree.radius(QVector3D(1, 2, 3), 0.0f, neighbors);
+    EXPECT_EQ(neighbors.size(), 100u);
+    tree.radius(QVector3D(1, 2, 3.5f), 0.1f, neighbors);
+    EXPECT_TRUE(neighbors.empty());
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
 #include "mesh.h"
+#include "testMeshes.h"
 
 class MeshTestable : public Mesh {
 public:
@@ -156,3 +159,214 @@ TEST_F(MeshTest, LoadOffCorrectly) {
         }
     }
 }
+
+TEST_F(MeshTest, LoadPointsWithoutTriangulation) {
+    auto ok = mesh.loadPoints("./data/test/points.txt");
+    EXPECT_EQ(ok, MeshError::OK);
+    EXPECT_EQ(mesh.vertices.size(), 20);
+    EXPECT_TRUE(mesh.faces.empty());
+    EXPECT_TRUE(mesh.isPointCloud());
+    EXPECT_EQ(mesh.loadPoints("./data/test/missing.txt"), MeshError::READ);
+
+    // a header count larger than the file is an error, not an allocation
+    std::ofstream file("./huge.txt");
+    file << "100000000000000\n1 2 3\n";
+    file.close();
+    EXPECT_EQ(mesh.loadFile("./huge.txt"), MeshError::READ);
+    EXPECT_EQ(mesh.loadPoints("./huge.txt"), MeshError::READ);
+    std::remove("./huge.txt");
+}
+
+TEST_F(MeshTest, TriangulatePointsLikeLoadTxt) {
+    Mesh triangulated;
+    ASSERT_EQ(triangulated.loadFile("./data/test/points.txt"), MeshError::OK);
+    ASSERT_EQ(mesh.loadPoints("./data/test/points.txt"), MeshError::OK);
+
+    EXPECT_EQ(mesh.triangulatePoints(), MeshError::OK);
+    EXPECT_FALSE(mesh.isPointCloud());
+    ASSERT_EQ(mesh.vertices.size(), triangulated.getVertices().size());
+    ASSERT_EQ(mesh.faces.size(), triangulated.getFaces().size());
+    for (std::size_t i = 0; i < mesh.vertices.size(); i++) {
+        EXPECT_EQ(mesh.vertices[i].position, triangulated.getVertices()[i].position);
+    }
+    EXPECT_EQ(mesh.triangulatePoints(), MeshError::FORMAT);
+}
+
+TEST_F(MeshTest, GeoreferencedPointsLoadAroundTheirCenter) {
+    // a 30 x 30 grid with a 1 cm step, 500 km from the origin like UTM coordinates
+    const int side = 30;
+    std::ofstream file("./georeferenced.txt");
+    file.precision(12);
+    file << side * side << "\n";
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) file << 500000.0 + 0.01 * x << " " << 4500000.0 + 0.01 * y << " 120\n";
+    }
+    file.close();
+
+    std::array<double, 3> origin;
+    ASSERT_EQ(mesh.loadCentered("./georeferenced.txt", origin), MeshError::OK);
+    EXPECT_NEAR(origin[0], 500000.145, 1e-6);
+    EXPECT_NEAR(origin[1], 4500000.145, 1e-6);
+    EXPECT_EQ(mesh.vertices.size(), std::size_t(side * side));
+    EXPECT_EQ(mesh.faces.size(), 2u * (side - 1) * (side - 1));
+    // the faces cover the grid once, all in the same direction
+    float area = 0.0f;
+    for (const Triangle &t : mesh.faces) {
+        QVector3D a = mesh.vertices[t.idVertices[0]].position, b = mesh.vertices[t.idVertices[1]].position, c = mesh.vertices[t.idVertices[2]].position;
+        float z = QVector3D::crossProduct(b - a, c - a).z();
+        EXPECT_GT(z, 0.0f);
+        area += z / 2.0f;
+    }
+    EXPECT_NEAR(area, 0.29f * 0.29f, 1e-4f);
+
+    // in float the points collapse on a few values, most of them are removed as duplicates
+    Mesh rounded;
+    ASSERT_EQ(rounded.loadFile("./georeferenced.txt"), MeshError::OK);
+    EXPECT_LT(rounded.getVertices().size(), mesh.vertices.size() / 4);
+    std::remove("./georeferenced.txt");
+
+    // a .off file keeps its faces
+    file.open("./georeferenced.off");
+    file.precision(12);
+    file << "OFF\n4 1 0\n500000 4500000 120\n500000.01 4500000 120\n500000.01 4500000.01 120\n500000 4500000.01 120\n4 0 1 2 3\n";
+    file.close();
+    ASSERT_EQ(mesh.loadCentered("./georeferenced.off", origin), MeshError::OK);
+    EXPECT_EQ(mesh.faces.size(), 2u);
+    EXPECT_NEAR(mesh.vertices[1].position.x() - mesh.vertices[0].position.x(), 0.01f, 1e-6f);
+    EXPECT_EQ(mesh.loadCentered("./georeferenced.obj", origin), MeshError::FORMAT);
+    std::remove("./georeferenced.off");
+}
+
+TEST_F(MeshTest, WeldMergesSplitCorners) {
+    Mesh octahedron;
+    ASSERT_EQ(octahedron.loadFile("./data/test/octahedron.off"), MeshError::OK);
+    ASSERT_EQ(octahedron.saveOBJ("./weld.obj"), MeshError::OK);
+
+    // the OBJ loader gives each corner its own vertex
+    ASSERT_EQ(mesh.loadFile("./weld.obj"), MeshError::OK);
+    std::remove("./weld.obj");
+    ASSERT_EQ(mesh.vertices.size(), 24);
+    EXPECT_FALSE(mesh.isClosed());
+
+    EXPECT_EQ(mesh.weld(), 18);
+    EXPECT_EQ(mesh.vertices.size(), 6);
+    EXPECT_EQ(mesh.faces.size(), 8);
+    EXPECT_TRUE(mesh.isClosed());
+
+    // a tolerance merges the close vertices, the collapsed face is removed
+    mesh.vertices.push_back(QVector3D(mesh.vertices[0].position + QVector3D(1e-4f, 0.0f, 0.0f)));
+    mesh.faces.push_back(Triangle(0, 1, mesh.vertices.size() - 1));
+    EXPECT_EQ(mesh.weld(), 0);
+    EXPECT_EQ(mesh.faces.size(), 9);
+    EXPECT_EQ(mesh.weld(1e-3f), 1);
+    EXPECT_EQ(mesh.faces.size(), 8);
+}
+
+TEST_F(MeshTest, LocalEditsMatchAGlobalSew) {
+    Mesh sphere = testMeshes::makeSphere(3);
+    mesh.vertices = sphere.getVertices();
+    mesh.faces = sphere.getFaces();
+
+    // the adjacency and the normals patched by each edit are the ones a full pass computes
+    auto check = [&](const char *edit) {
+        MeshTestable full;
+        full.vertices = mesh.vertices;
+        full.faces = mesh.faces;
+        full.sew();
+        full.computeNormals();
+        ASSERT_TRUE(mesh.isClosed()) << edit << "\n";
+        for (std::size_t f = 0; f < mesh.faces.size(); f++) {
+            ASSERT_EQ(mesh.faces[f].idFaces, full.faces[f].idFaces) << edit << " face " << f << "\n";
+        }
+        for (const auto &f : mesh.faces) {
+            for (unsigned int v : f.idVertices) {
+                EXPECT_LT((mesh.vertices[v].normal - full.vertices[v].normal).length(), 1e-5f) << edit << "\n";
+            }
+        }
+    };
+
+    std::size_t vertices = mesh.vertices.size(), faces = mesh.faces.size();
+    int m = mesh.splitEdge(10, 1, (mesh.vertices[mesh.faces[10].idVertices[1]].position +
+                                   mesh.vertices[mesh.faces[10].idVertices[2]].position) / 2.0f);
+    EXPECT_EQ(m, int(vertices));
+    EXPECT_EQ(mesh.faces.size(), faces + 2);
+    check("split");
+    DirtyRegion dirty = mesh.getDirtyRegion();
+    dirty.compact();
+    EXPECT_EQ(dirty.faces.size(), 4u);
+    EXPECT_EQ(dirty.faces.back(), mesh.faces.size() - 1);
+    EXPECT_EQ(dirty.vertices.back(), mesh.vertices.size() - 1);
+
+    mesh.clearDirtyRegion();
+    EXPECT_TRUE(mesh.getDirtyRegion().isEmpty());
+    unsigned int flipped = mesh.faces[40].idFaces[0];
+    EXPECT_TRUE(mesh.flipEdge(40, 0));
+    check("flip");
+    dirty = mesh.getDirtyRegion();
+    dirty.compact();
+    EXPECT_EQ(dirty.faces, std::vector<unsigned int>({ std::min(40u, flipped), std::max(40u, flipped) }));
+    EXPECT_EQ(dirty.vertices.size(), 4u);
+
+    QVector3D center = (mesh.vertices[mesh.faces[60].idVertices[0]].position + mesh.vertices[mesh.faces[60].idVertices[1]].position +
+                        mesh.vertices[mesh.faces[60].idVertices[2]].position) / 3.0f;
+    vertices = mesh.vertices.size();
+    EXPECT_EQ(mesh.insertVertex(60, center), int(vertices));
+    check("insert");
+
+    faces = mesh.faces.size();
+    EXPECT_GE(mesh.collapseEdge(100, 2), 0);
+    EXPECT_EQ(mesh.faces.size(), faces - 2);
+    check("collapse");
+    for (int i = 0; i < 30; i++) mesh.collapseEdge(i * 7 % mesh.faces.size(), i % 3);
+    check("collapses");
+
+    // the protected split keeps the same adjacency
+    unsigned int neighbor = mesh.faces[0].idFaces[0];
+    mesh.vertices.push_back(QVector3D(0.0f, 0.0f, 2.0f));
+    mesh.edgeSplit(mesh.vertices.size() - 1, 0, neighbor);
+    check("edgeSplit");
+}
+
+TEST_F(MeshTest, SubdivisionKeepsTheAdjacency) {
+    // the adjacency built from the coarse faces is the one a sew of the refined faces finds
+    auto check = [&](const char *scheme, std::size_t expectedVertices, std::size_t expectedFaces) {
+        ASSERT_EQ(mesh.vertices.size(), expectedVertices) << scheme << "\n";
+        ASSERT_EQ(mesh.faces.size(), expectedFaces) << scheme << "\n";
+        MeshTestable full;
+        full.vertices = mesh.vertices;
+        full.faces = mesh.faces;
+        full.sew();
+        for (std::size_t f = 0; f < mesh.faces.size(); f++) {
+            ASSERT_EQ(mesh.faces[f].idFaces, full.faces[f].idFaces) << scheme << " face " << f << "\n";
+        }
+    };
+
+    Mesh sphere = testMeshes::makeSphere(2);
+    std::size_t v = sphere.getVertices().size(), f = sphere.getFaces().size(), e = 3 * f / 2;
+    mesh.vertices = sphere.getVertices();
+    mesh.faces = sphere.getFaces();
+    mesh.subdivideLoop(2);
+    check("loop", v + e + (2 * e + 3 * f), 16 * f);
+    EXPECT_TRUE(mesh.isClosed());
+    for (const auto &vertex : mesh.vertices) {
+        EXPECT_LT(vertex.position.length(), 1.0f);
+        EXPECT_GT(vertex.position.length(), 0.9f);
+    }
+
+    mesh.vertices = sphere.getVertices();
+    mesh.faces = sphere.getFaces();
+    mesh.subdivideSqrt3(2);
+    check("sqrt3", v + f + 3 * f, 9 * f);
+    EXPECT_TRUE(mesh.isClosed());
+
+    // the boundary edges of an open grid keep a single face
+    Mesh grid = testMeshes::makeGrid(6);
+    for (int scheme = 0; scheme < 2; scheme++) {
+        mesh.vertices = grid.getVertices();
+        mesh.faces = grid.getFaces();
+        if (scheme == 0) mesh.subdivideLoop(1);
+        else mesh.subdivideSqrt3(1);
+        check(scheme == 0 ? "open loop" : "open sqrt3", grid.getVertices().size() + (scheme == 0 ? 3 * 36 + 12 : 72), (scheme == 0 ? 4 : 3) * grid.getFaces().size());
+        for (const auto &vertex : mesh.vertices) EXPECT_NEAR(vertex.position.z(), 0.0f, 1e-6f);
+    }
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "meshAnalysis.h"
+#include "generator.h"
+#include "testMeshes.h"
+
+namespace {
+
+// the faces of b are appended after those of a, with their vertices moved by offset
+Mesh merge(const Mesh &a, const Mesh &b, const QVector3D &offset) {
+    std::vector<Vertex> vertices = a.getVertices();
+    std::vector<Triangle> faces = a.getFaces();
+    unsigned int first = vertices.size();
+    for (const auto &v : b.getVertices()) vertices.push_back(Vertex(v.position + offset));
+    for (const auto &f : b.getFaces()) faces.push_back(Triangle(f.idVertices[0] + first, f.idVertices[1] + first, f.idVertices[2] + first));
+    return Mesh(vertices, faces);
+}
+
+}
+
+TEST(MeshAnalysisTest, TopologyOfKnownShapes) {
+    MeshStatistics sphere = MeshAnalysis::analyze(testMeshes::makeSphere(3));
+    EXPECT_EQ(sphere.components, 1u);
+    EXPECT_EQ(sphere.boundaryLoops, 0u);
+    EXPECT_EQ(sphere.edges, 3 * sphere.faces / 2);
+    EXPECT_EQ(sphere.eulerCharacteristic, 2);
+    EXPECT_TRUE(sphere.isClosedManifold());
+
+    MeshStatistics torus = MeshAnalysis::analyze(Generator::toMesh(Generator::torus(24, 12)));
+    EXPECT_EQ(torus.eulerCharacteristic, 0);
+    EXPECT_TRUE(torus.isClosedManifold());
+
+    MeshStatistics grid = MeshAnalysis::analyze(testMeshes::makeGrid(40));
+    EXPECT_EQ(grid.boundaryEdges, 160u);
+    EXPECT_EQ(grid.boundaryLoops, 1u);
+    EXPECT_EQ(grid.eulerCharacteristic, 1);
+    EXPECT_FALSE(grid.isClosedManifold());
+
+    // a sphere and a grid side by side, with a vertex used by no face
+    Mesh both = merge(testMeshes::makeSphere(2), testMeshes::makeGrid(10), QVector3D(5, 0, 0));
+    std::vector<Vertex> vertices = both.getVertices();
+    vertices.push_back(Vertex(0.0f, 0.0f, 9.0f));
+    Mesh withPoint(vertices, both.getFaces());
+    MeshStatistics merged = MeshAnalysis::analyze(withPoint);
+    EXPECT_EQ(merged.components, 2u);
+    EXPECT_EQ(merged.isolatedVertices, 1u);
+    EXPECT_EQ(merged.boundaryLoops, 1u);
+    EXPECT_EQ(merged.eulerCharacteristic, 3);
+
+    std::vector<unsigned int> labels;
+    ASSERT_EQ(MeshAnalysis::labelComponents(withPoint, labels), 2u);
+    std::size_t sphereFaces = testMeshes::makeSphere(2).getFaces().size();
+    for (std::size_t f = 0; f < labels.size(); f++) EXPECT_EQ(labels[f], f < sphereFaces ? 0u : 1u);
+
+    EXPECT_EQ(MeshAnalysis::analyze(Mesh()).components, 0u);
+}
+
+TEST(MeshAnalysisTest, DefectsAreCounted) {
+    // 3 faces on the edge 0-1, a face with a repeated vertex and a flat one
+    std::vector<Vertex> vertices = {
+        Vertex(0, 0, 0), Vertex(1, 0, 0), Vertex(0, 1, 0), Vertex(0, -1, 0), Vertex(0, 0, 1),
+        Vertex(2, 0, 0), Vertex(3, 0, 0), Vertex(4, 0, 0), Vertex(5, 0, 0), Vertex(5, 1, 0)
+    };
+    std::vector<Triangle> faces = {
+        Triangle(0, 1, 2), Triangle(1, 0, 3), Triangle(0, 1, 4),
+        Triangle(8, 8, 9), Triangle(5, 6, 7)
+    };
+    MeshStatistics statistics = MeshAnalysis::analyze(Mesh(vertices, faces));
+    EXPECT_EQ(statistics.nonManifoldEdges, 1u);
+    EXPECT_EQ(statistics.degenerateFaces, 2u);
+    EXPECT_EQ(statistics.components, 3u);
+    EXPECT_EQ(statistics.edges, 7u + 3u + 1u);
+    EXPECT_FALSE(statistics.isClosedManifold());
+    EXPECT_NE(MeshAnalysis::summary(statistics).find("1 non-manifold edges"), std::string::npos);
+}
+
+TEST(MeshAnalysisTest, EditedMeshesAreAnalyzedOnAJob) {
+    // the job analyzes a copy, the mesh can be edited while it runs
+    Mesh mesh = merge(testMeshes::makeSphere(3), testMeshes::makeGrid(20), QVector3D(5, 0, 0));
+    MeshStatistics expected = MeshAnalysis::analyze(mesh);
+    MeshAnalysisJob job(mesh);
+    mesh = Mesh();
+    while (!job.isFinished()) std::this_thread::yield();
+    const MeshStatistics &statistics = job.getStatistics();
+    EXPECT_EQ(statistics.faces, expected.faces);
+    EXPECT_EQ(statistics.edges, expected.edges);
+    EXPECT_EQ(statistics.components, 2u);
+    EXPECT_EQ(statistics.boundaryLoops, expected.boundaryLoops);
+    EXPECT_EQ(statistics.eulerCharacteristic, expected.eulerCharacteristic);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <thread>
+#include "kdTree.h"
+#include "mesh.h"
+#include "normalEstimator.h"
+
+namespace {
+
+// points on a sphere, the outside is the right side of every normal
+std::vector<QVector3D> makeSphere(std::size_t count, const QVector3D &center, float radius, unsigned int seed) {
+    std::mt19937 random(seed);
+    std::normal_distribution<float> gaussian;
+    std::vector<QVector3D> points;
+    for (std::size_t i = 0; i < count; i++) {
+        QVector3D direction(gaussian(random), gaussian(random), gaussian(random));
+        points.push_back(center + radius * direction.normalized());
+    }
+    return points;
+}
+
+}
+
+TEST(NormalEstimatorTest, SmallestEigenvector) {
+    // a flat cloud in the plane x + y = 0 : the normal is (1, 1, 0) / sqrt(2) up to its sign
+    QVector3D n = NormalEstimator::smallestEigenvector({ 2.0, -2.0, 0.0, 2.0, 0.0, 5.0 });
+    EXPECT_NEAR(std::abs(n.x()), std::sqrt(0.5f), 1e-5f);
+    EXPECT_NEAR(n.x(), n.y(), 1e-5f);
+    EXPECT_NEAR(n.z(), 0.0f, 1e-5f);
+
+    // tiny and diagonal
+    n = NormalEstimator::smallestEigenvector({ 3e-12, 0.0, 0.0, 1e-12, 0.0, 2e-12 });
+    EXPECT_NEAR(std::abs(n.y()), 1.0f, 1e-5f);
+
+    // points on the line x = y = z, any direction across it
+    n = NormalEstimator::smallestEigenvector({ 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 });
+    EXPECT_NEAR(n.length(), 1.0f, 1e-5f);
+    EXPECT_NEAR(QVector3D::dotProduct(n, QVector3D(1, 1, 1)), 0.0f, 1e-5f);
+
+    // no spread at all
+    EXPECT_EQ(NormalEstimator::smallestEigenvector({ 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 }), QVector3D(0, 0, 1));
+}
+
+TEST(NormalEstimatorTest, NormalsAreOrientedOutward) {
+    // 2 spheres apart, each one is its own part of the graph
+    std::vector<QVector3D> points = makeSphere(4000, QVector3D(0, 0, 0), 1.0f, 1);
+    std::vector<QVector3D> second = makeSphere(2000, QVector3D(5, 1, -3), 0.5f, 2);
+    points.insert(points.end(), second.begin(), second.end());
+
+    NormalEstimationOptions options;
+    options.orient = false;
+    std::vector<QVector3D> normals = NormalEstimator::estimate(points, options);
+    ASSERT_EQ(normals.size(), points.size());
+    for (std::size_t i = 0; i < points.size(); i++) {
+        QVector3D radial = (points[i] - (i < 4000 ? QVector3D(0, 0, 0) : QVector3D(5, 1, -3))).normalized();
+        EXPECT_GT(std::abs(QVector3D::dotProduct(normals[i], radial)), 0.95f) << "Point " << i << "\n";
+    }
+
+    std::vector<unsigned int> neighbors;
+    KDTree tree;
+    tree.build(points);
+    tree.knn(points, options.neighbors, neighbors);
+    EXPECT_EQ(NormalEstimator::orient(points, neighbors, options.neighbors, normals), 2u);
+    for (std::size_t i = 0; i < points.size(); i++) {
+        QVector3D radial = (points[i] - (i < 4000 ? QVector3D(0, 0, 0) : QVector3D(5, 1, -3))).normalized();
+        EXPECT_GT(QVector3D::dotProduct(normals[i], radial), 0.95f) << "Point " << i << "\n";
+    }
+}
+
+TEST(NormalEstimatorTest, PointCloudsAreLit) {
+    // a vertical wall, not a height field : the normals are along x, on the same side
+    std::ofstream file("./wall.txt");
+    file << 400 << "\n";
+    for (int z = 0; z < 20; z++) {
+        for (int y = 0; y < 20; y++) file << 0.001f * ((y * 7 + z * 3) % 5) << " " << y << " " << z << "\n";
+    }
+    file.close();
+
+    Mesh mesh;
+    ASSERT_EQ(mesh.loadPoints("./wall.txt"), MeshError::OK);
+    EXPECT_FALSE(mesh.hasPointNormals());
+    ASSERT_EQ(mesh.estimatePointNormals(), MeshError::OK);
+    EXPECT_TRUE(mesh.hasPointNormals());
+    float side = mesh.getVertices()[0].normal.x();
+    EXPECT_GT(std::abs(side), 0.99f);
+    for (const auto &v : mesh.getVertices()) EXPECT_GT(v.normal.x() * side, 0.99f);
+
+    // the triangulation takes the normals of its faces
+    ASSERT_EQ(mesh.triangulatePoints(), MeshError::OK);
+    EXPECT_FALSE(mesh.hasPointNormals());
+    EXPECT_EQ(mesh.estimatePointNormals(), MeshError::FORMAT);
+    std::remove("./wall.txt");
+}
+
+TEST(NormalEstimatorTest, EstimationRunsOnAJob) {
+    std::vector<QVector3D> points = makeSphere(3000, QVector3D(1, 2, 3), 2.0f, 3);
+    std::vector<QVector3D> expected = NormalEstimator::estimate(points);
+
+    NormalEstimationJob job(points);
+    while (!job.isFinished()) std::this_thread::yield();
+    EXPECT_EQ(job.takeNormals(), expected);
+    EXPECT_TRUE(job.takeNormals().empty());
+
+    // a cancelled estimation gives nothing, a job is cancelled when it is destroyed
+    std::atomic<bool> cancel(true);
+    NormalEstimationOptions options;
+    options.cancel = &cancel;
+    EXPECT_TRUE(NormalEstimator::estimate(points, options).empty());
+    { NormalEstimationJob stopped(makeSphere(200000, QVector3D(0, 0, 0), 1.0f, 4)); }
+
+    Mesh mesh;
+    EXPECT_EQ(mesh.setPointNormals(expected), MeshError::FORMAT);
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <set>
+#include "kdTree.h"
+#include "mesh.h"
+#include "pointFilter.h"
+
+TEST(PointFilterTest, DuplicatesAreRemovedInOrder) {
+    std::vector<QVector3D> points = {
+        QVector3D(1, 2, 3), QVector3D(0, 0, 0), QVector3D(1, 2, 3), QVector3D(-0.0f, 0, 0),
+        QVector3D(1, 2, 7), QVector3D(4, 5, 6), QVector3D(4.001f, 5, 6)
+    };
+
+    // x and y only, like the triangulation
+    std::vector<QVector3D> planar = points;
+    PointFilterStatistics statistics = PointFilter::filter(planar, PointFilterOptions());
+    EXPECT_EQ(statistics.pointsIn, 7u);
+    EXPECT_EQ(statistics.pointsOut, 4u);
+    EXPECT_EQ(planar, std::vector<QVector3D>({ QVector3D(1, 2, 3), QVector3D(0, 0, 0), QVector3D(4, 5, 6), QVector3D(4.001f, 5, 6) }));
+
+    PointFilterOptions options;
+    options.planar = false;
+    std::vector<QVector3D> spatial = points;
+    EXPECT_EQ(PointFilter::filter(spatial, options).pointsOut, 5u);
+    EXPECT_EQ(spatial[2], QVector3D(1, 2, 7));
+
+    // the near duplicates share a cell of epsilon
+    options.epsilon = 0.01f;
+    options.planar = true;
+    std::vector<QVector3D> near = { QVector3D(4.002f, 5.002f, 6), QVector3D(4.004f, 5.001f, 0), QVector3D(4.02f, 5.0f, 0) };
+    EXPECT_EQ(PointFilter::filter(near, options).pointsOut, 2u);
+    EXPECT_EQ(near[0], QVector3D(4.002f, 5.002f, 6));
+
+    // on both sides of a cell border, the first one is kept, a point farther than epsilon in the next cell stays
+    std::vector<QVector3D> border = { QVector3D(0.0099f, 0.5f, 0), QVector3D(0.0101f, 0.5f, 0), QVector3D(0.0299f, 0.5f, 0),
+                                      QVector3D(0.05f, 0.4999f, 0), QVector3D(0.05f, 0.5001f, 0) };
+    EXPECT_EQ(PointFilter::filter(border, options).pointsOut, 3u);
+    EXPECT_EQ(border, std::vector<QVector3D>({ QVector3D(0.0099f, 0.5f, 0), QVector3D(0.0299f, 0.5f, 0), QVector3D(0.05f, 0.4999f, 0) }));
+    options.planar = false;
+    std::vector<QVector3D> above = { QVector3D(0.005f, 0.005f, 0.0099999f), QVector3D(0.005f, 0.005f, 0.01f) };
+    EXPECT_EQ(PointFilter::filter(above, options).pointsOut, 1u);
+
+    // a cloud large enough for all the buckets, no 2 kept points are closer than epsilon
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> coordinate(0.0f, 1.0f);
+    std::vector<QVector3D> cloud(50000);
+    for (auto &p : cloud) p = QVector3D(coordinate(random), coordinate(random), coordinate(random));
+    options.epsilon = 0.02f;
+    PointFilter::filter(cloud, options);
+    KDTree tree;
+    tree.build(cloud);
+    std::vector<unsigned int> close;
+    for (const auto &p : cloud) {
+        tree.radius(p, options.epsilon * 0.999f, close);
+        EXPECT_EQ(close.size(), 1u);
+    }
+}
+
+TEST(PointFilterTest, VoxelDownsampling) {
+    // 100 x 100 points with a step of 0.01, 10 x 10 per voxel of 0.1
+    std::vector<QVector3D> grid;
+    for (int y = 0; y < 100; y++) {
+        for (int x = 0; x < 100; x++) grid.push_back(QVector3D(0.005f + 0.01f * x, 0.005f + 0.01f * y, float(x % 2)));
+    }
+
+    PointFilterOptions options;
+    options.voxelSize = 0.1f;
+    std::vector<QVector3D> centroids = grid;
+    ASSERT_EQ(PointFilter::filter(centroids, options).pointsOut, 100u);
+    EXPECT_NEAR(centroids[0].x(), 0.05f, 1e-4f);
+    EXPECT_NEAR(centroids[0].y(), 0.05f, 1e-4f);
+    EXPECT_NEAR(centroids[0].z(), 0.5f, 1e-4f);
+
+    options.voxelPoint = VoxelPoint::CLOSEST;
+    std::vector<QVector3D> closest = grid;
+    ASSERT_EQ(PointFilter::filter(closest, options).pointsOut, 100u);
+    std::set<std::pair<float, float>> inputs;
+    for (const auto &p : grid) inputs.insert({ p.x(), p.y() });
+    for (const auto &p : closest) {
+        EXPECT_TRUE(inputs.count({ p.x(), p.y() }));
+        EXPECT_LT(std::abs(p.x() - (std::floor(p.x() / 0.1f) + 0.5f) * 0.1f), 0.01f);
+    }
+
+    // a cloud large enough for all the buckets, the count matches the distinct cells
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f);
+    std::vector<QVector3D> cloud(200000);
+    for (auto &p : cloud) p = QVector3D(coordinate(random), coordinate(random), coordinate(random));
+    std::set<std::pair<long, long>> cells;
+    for (const auto &p : cloud) cells.insert({ long(std::floor(p.x())), long(std::floor(p.y())) });
+    options.voxelSize = 1.0f;
+    EXPECT_EQ(PointFilter::filter(cloud, options).pointsOut, cells.size());
+}
+
+TEST(PointFilterTest, LoadedCloudsAreFiltered) {
+    // a grid of 20 x 20 points where every point is written twice
+    std::ofstream file("./duplicated.txt");
+    file << 800 << "\n";
+    for (int copy = 0; copy < 2; copy++) {
+        for (int y = 0; y < 20; y++) {
+            for (int x = 0; x < 20; x++) file << x + 0.1f * (y % 3) << " " << y << " " << copy << "\n";
+        }
+    }
+    file.close();
+
+    Mesh mesh;
+    ASSERT_EQ(mesh.loadFile("./duplicated.txt"), MeshError::OK);
+    EXPECT_EQ(mesh.getPointFilterStatistics().pointsIn, 800u);
+    EXPECT_EQ(mesh.getPointFilterStatistics().pointsOut, 400u);
+    EXPECT_EQ(mesh.getVertices().size(), 400u);
+
+    PointFilterOptions options;
+    options.voxelSize = 2.0f;
+    Mesh coarse;
+    coarse.setPointFilter(options);
+    ASSERT_EQ(coarse.loadFile("./duplicated.txt"), MeshError::OK);
+    EXPECT_EQ(coarse.getPointFilterStatistics().pointsOut, 100u);
+    EXPECT_FALSE(coarse.getFaces().empty());
+    std::remove("./duplicated.txt");
+}
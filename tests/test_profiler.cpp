@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "profiler.h"
+
+TEST(ProfilerTest, ScopedTimersAreNested) {
+    Profiler::clear();
+    {
+        ScopedTimer outer("outer");
+        ScopedTimer inner("inner");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    ASSERT_TRUE(Profiler::saveChromeTrace("./profilerTrace.json"));
+
+    std::ifstream in("./profilerTrace.json");
+    std::stringstream content;
+    content << in.rdbuf();
+    std::string trace = content.str();
+    std::remove("./profilerTrace.json");
+
+    EXPECT_EQ(trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+    std::size_t inner = trace.find("\"name\":\"inner\""), outer = trace.find("\"name\":\"outer\"");
+    ASSERT_NE(inner, std::string::npos);
+    ASSERT_NE(outer, std::string::npos);
+    EXPECT_LT(inner, outer) << "The inner timer ends first\n";
+    EXPECT_NE(trace.find("\"ph\":\"X\""), std::string::npos);
+}
+
+TEST(ProfilerTest, DisabledRecordsNothing) {
+    Profiler::clear();
+    Profiler::setEnabled(false);
+    {
+        ScopedTimer timer("ignored");
+    }
+    Profiler::addFrame(1.0f, -1.0f, 10);
+    Profiler::setEnabled(true);
+
+    EXPECT_EQ(Profiler::getFrameStatistics().frames, 0u);
+    ASSERT_TRUE(Profiler::saveChromeTrace("./profilerTrace.json"));
+    std::ifstream in("./profilerTrace.json");
+    std::stringstream content;
+    content << in.rdbuf();
+    std::remove("./profilerTrace.json");
+    EXPECT_EQ(content.str().find("ignored"), std::string::npos);
+}
+
+TEST(ProfilerTest, FrameStatistics) {
+    Profiler::clear();
+    // 1 to 100 ms, the 95th percentile is 95 ms
+    for (int i = 100; i >= 1; i--) {
+        Profiler::addUpload(i);
+        Profiler::addFrame(float(i), i % 2 ? 2.0f : -1.0f, 1000 + i);
+    }
+
+    FrameStatistics stats = Profiler::getFrameStatistics();
+    EXPECT_EQ(stats.frames, 100u);
+    EXPECT_FLOAT_EQ(stats.frameMs, 50.5f);
+    EXPECT_FLOAT_EQ(stats.p95Ms, 95.0f);
+    EXPECT_FLOAT_EQ(stats.gpuMs, 2.0f);
+    EXPECT_EQ(stats.triangles, 1001);
+    EXPECT_EQ(stats.uploadedBytes, 1u);
+}
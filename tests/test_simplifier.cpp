@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "simplifier.h"
+#include "testMeshes.h"
+
+using namespace testMeshes;
+
+TEST(SimplifierTest, ReachesTargetAndStaysClosed) {
+    Mesh sphere = makeSphere(4);
+    ASSERT_EQ(sphere.getFaces().size(), 2048);
+
+    Simplifier simplifier(sphere);
+    Mesh simplified = simplifier.simplify(500);
+
+    EXPECT_LE(simplified.getFaces().size(), 500);
+    EXPECT_GE(simplified.getFaces().size(), 400) << "Too many faces collapsed\n";
+
+    for (const auto &f : simplified.getFaces()) {
+        for (auto vid : f.idVertices) EXPECT_LT(vid, simplified.getVertices().size());
+        ASSERT_EQ(f.idFaces.size(), 3);
+        for (auto neighbor : f.idFaces) {
+            EXPECT_NE(neighbor, Triangle::NO_NEIGHBOR) << "The simplified sphere has a hole\n";
+        }
+    }
+}
+
+TEST(SimplifierTest, KeepsTheShape) {
+    Mesh sphere = makeSphere(4);
+    Simplifier simplifier(sphere);
+    Mesh simplified = simplifier.simplify(300);
+
+    EXPECT_GT(simplifier.getError(), 0.0f);
+    for (const auto &v : simplified.getVertices()) {
+        EXPECT_NEAR(v.position.length(), 1.0f, 0.1f);
+    }
+}
+
+TEST(SimplifierTest, FlatGridHasNoError) {
+    Mesh grid = makeGrid(10);
+    Simplifier simplifier(grid);
+    Mesh simplified = simplifier.simplify(2);
+
+    EXPECT_LT(simplified.getFaces().size(), 20);
+    EXPECT_NEAR(simplifier.getError(), 0.0f, 1e-3f);
+    for (const auto &v : simplified.getVertices()) {
+        EXPECT_NEAR(v.position.z(), 0.0f, 1e-5f);
+        EXPECT_GE(v.position.x(), -1e-4f);
+        EXPECT_LE(v.position.x(), 10.0f + 1e-4f);
+    }
+}
+
+TEST(SimplifierTest, LodChainIsDecreasing) {
+    Mesh sphere = makeSphere(5);
+    auto lods = Simplifier::buildLodChain(sphere, { 0.5f, 0.25f, 0.125f });
+
+    ASSERT_EQ(lods.size(), 3);
+    std::size_t previousFaces = sphere.getFaces().size();
+    float previousError = 0.0f;
+    for (const auto &lod : lods) {
+        EXPECT_LT(lod.mesh.getFaces().size(), previousFaces);
+        EXPECT_GE(lod.error, previousError);
+        previousFaces = lod.mesh.getFaces().size();
+        previousError = lod.error;
+    }
+}
+
+TEST(SimplifierTest, ClusterProxy) {
+    Mesh sphere = makeSphere(5);
+    LevelOfDetail proxy = Simplifier::clusterVertices(sphere, 8);
+
+    EXPECT_GT(proxy.mesh.getFaces().size(), 0);
+    EXPECT_LT(proxy.mesh.getFaces().size(), sphere.getFaces().size() / 4);
+    EXPECT_NEAR(proxy.error, 2.0f / 8.0f * std::sqrt(3.0f), 1e-4f);
+    for (const auto &v : proxy.mesh.getVertices()) {
+        EXPECT_NEAR(v.position.length(), 1.0f, proxy.error);
+    }
+}
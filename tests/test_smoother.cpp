@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include "smoother.h"
+#include "testMeshes.h"
+
+namespace {
+
+// a unit sphere with its vertices moved along their normal
+Mesh makeNoisySphere() {
+    Mesh sphere = testMeshes::makeSphere(4);
+    std::vector<QVector3D> positions;
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+    for (const auto &v : sphere.getVertices()) positions.push_back(v.position * (1.0f + noise(random)));
+    sphere.setPositions(positions);
+    return sphere;
+}
+
+void radiusStatistics(const std::vector<QVector3D> &positions, float &mean, float &deviation) {
+    mean = 0.0f;
+    for (const auto &p : positions) mean += p.length();
+    mean /= positions.size();
+    deviation = 0.0f;
+    for (const auto &p : positions) deviation += (p.length() - mean) * (p.length() - mean);
+    deviation = std::sqrt(deviation / positions.size());
+}
+
+}
+
+TEST(SmootherTest, TaubinRemovesTheNoiseWithoutShrinking) {
+    Mesh sphere = makeNoisySphere();
+    std::vector<QVector3D> noisy;
+    for (const auto &v : sphere.getVertices()) noisy.push_back(v.position);
+    float noisyMean, noisyDeviation;
+    radiusStatistics(noisy, noisyMean, noisyDeviation);
+
+    SmoothingOptions options;
+    options.iterations = 20;
+    options.method = SmoothingMethod::LAPLACIAN;
+    Smoother laplacian(sphere);
+    EXPECT_EQ(laplacian.smooth(options), 20);
+    float laplacianMean, laplacianDeviation;
+    radiusStatistics(laplacian.getPositions(), laplacianMean, laplacianDeviation);
+
+    options.method = SmoothingMethod::TAUBIN;
+    Smoother taubin(sphere);
+    taubin.smooth(options);
+    float taubinMean, taubinDeviation;
+    radiusStatistics(taubin.getPositions(), taubinMean, taubinDeviation);
+
+    EXPECT_LT(laplacianDeviation, noisyDeviation / 2.5f);
+    EXPECT_LT(taubinDeviation, noisyDeviation / 2.5f);
+    EXPECT_LT(laplacianMean, noisyMean - 0.02f);
+    EXPECT_LT(std::abs(taubinMean - noisyMean), std::abs(laplacianMean - noisyMean) / 4.0f);
+
+    // the progress can stop the iterations
+    Smoother stopped(sphere);
+    EXPECT_EQ(stopped.smooth(options, [](int iteration) { return iteration < 3; }), 3);
+}
+
+TEST(SmootherTest, BoundaryAndJob) {
+    // a grid with a bumpy height, its border is kept only when asked
+    Mesh grid = testMeshes::makeGrid(40);
+    std::vector<QVector3D> positions;
+    for (const auto &v : grid.getVertices()) {
+        QVector3D p = v.position;
+        p.setZ(std::sin(p.x() * 1.7f) * std::cos(p.y() * 2.3f));
+        positions.push_back(p);
+    }
+    grid.setPositions(positions);
+
+    SmoothingOptions options;
+    options.iterations = 5;
+    Smoother kept(grid, true), moved(grid, false);
+    kept.smooth(options);
+    moved.smooth(options);
+    std::vector<QVector3D> keptPositions = kept.getPositions(), movedPositions = moved.getPositions();
+    int border = 0;
+    for (std::size_t v = 0; v < positions.size(); v++) {
+        bool onBorder = positions[v].x() == 0.0f || positions[v].y() == 0.0f || positions[v].x() == 40.0f || positions[v].y() == 40.0f;
+        EXPECT_EQ(kept.isFree(v), !onBorder) << "Vertex " << v << "\n";
+        if (!onBorder) continue;
+        border++;
+        EXPECT_EQ(keptPositions[v], positions[v]);
+        EXPECT_TRUE(moved.isFree(v));
+    }
+    EXPECT_EQ(border, 160);
+    EXPECT_NE(movedPositions, keptPositions);
+
+    // the thread publishes the same positions as a smoothing on the caller thread
+    options.iterations = 30;
+    SmoothingJob job(grid, options);
+    std::vector<QVector3D> published, normals;
+    int iteration = 0, lastIteration = 0;
+    while (true) {
+        bool finished = job.isFinished();
+        if (job.takePositions(published, normals, iteration)) {
+            EXPECT_GT(iteration, lastIteration);
+            lastIteration = iteration;
+        }
+        if (finished) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(lastIteration, 30);
+    Smoother direct(grid);
+    direct.smooth(options);
+    EXPECT_EQ(published, direct.getPositions());
+
+    // the normals of the thread are the ones the mesh would compute
+    Mesh smoothed = grid;
+    smoothed.setPositions(published, normals);
+    grid.setPositions(published);
+    for (std::size_t v = 0; v < normals.size(); v++) {
+        EXPECT_EQ(smoothed.getVertices()[v].normal, grid.getVertices()[v].normal) << "Vertex " << v << "\n";
+    }
+
+    // a job destroyed early stops after its current iteration
+    options.iterations = 1000000;
+    auto start = std::chrono::steady_clock::now();
+    {
+        SmoothingJob cancelled(grid, options);
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include "spatialSort.h"
+#include "testMeshes.h"
+
+using namespace testMeshes;
+
+TEST(SpatialSortTest, MortonInterleavesBits) {
+    EXPECT_EQ(SpatialSort::mortonCode(0, 0, 0), 0);
+    EXPECT_EQ(SpatialSort::mortonCode(0, 0, 1), 1);
+    EXPECT_EQ(SpatialSort::mortonCode(0, 1, 0), 2);
+    EXPECT_EQ(SpatialSort::mortonCode(1, 0, 0), 4);
+    EXPECT_EQ(SpatialSort::mortonCode(1023, 1023, 1023), (1u << 30) - 1);
+}
+
+TEST(SpatialSortTest, HilbertCurveIsContinuous) {
+    // the first 8^3 codes fill the cube touching the origin, one unit step at a time
+    std::vector<std::array<int, 3>> cells(512, { -1, -1, -1 });
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            for (int z = 0; z < 8; z++) {
+                unsigned int code = SpatialSort::hilbertCode(x, y, z);
+                ASSERT_LT(code, 512);
+                EXPECT_EQ(cells[code][0], -1) << "Two cells share the same code\n";
+                cells[code] = { x, y, z };
+            }
+        }
+    }
+
+    for (std::size_t i = 1; i < cells.size(); i++) {
+        int distance = std::abs(cells[i][0] - cells[i - 1][0]) + std::abs(cells[i][1] - cells[i - 1][1]) + std::abs(cells[i][2] - cells[i - 1][2]);
+        EXPECT_EQ(distance, 1) << "Jump between codes " << i - 1 << " and " << i << "\n";
+    }
+}
+
+TEST(SpatialSortTest, RadixSortIsStable) {
+    // large enough to be split between threads
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<unsigned int> dist(0, 5000);
+    std::vector<unsigned int> keys(200000);
+    for (auto &k : keys) k = dist(rng);
+
+    std::vector<unsigned int> expected(keys.size());
+    std::iota(expected.begin(), expected.end(), 0);
+    std::stable_sort(expected.begin(), expected.end(), [&](unsigned int a, unsigned int b) { return keys[a] < keys[b]; });
+
+    EXPECT_EQ(SpatialSort::sortByKey(keys), expected);
+}
+
+TEST(SpatialSortTest, ReorderKeepsTopology) {
+    Mesh mesh = makeSphere(3);
+    QVector3D sum;
+    for (const auto &v : mesh.getVertices()) sum += v.position;
+
+    mesh.spatialReorder(SpatialOrder::HILBERT);
+
+    QVector3D reorderedSum;
+    for (const auto &v : mesh.getVertices()) reorderedSum += v.position;
+    EXPECT_NEAR((sum - reorderedSum).length(), 0.0f, 1e-4f);
+
+    const auto &faces = mesh.getFaces();
+    for (std::size_t fi = 0; fi < faces.size(); ++fi) {
+        for (int e = 0; e < 3; ++e) {
+            unsigned int n = faces[fi].idFaces[e];
+            ASSERT_LT(n, faces.size());
+            int lb = faces[n].localIndex(faces[fi].idVertices[(e + 1) % 3]);
+            ASSERT_GE(lb, 0);
+            EXPECT_EQ(faces[n].idFaces[lb], fi);
+            EXPECT_EQ(faces[n].idVertices[(lb + 1) % 3], faces[fi].idVertices[e]);
+        }
+    }
+}
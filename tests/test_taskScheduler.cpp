@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include "parallel.h"
+#include "taskScheduler.h"
+#include "mesh.h"
+
+TEST(TaskSchedulerTest, ParallelForCoversTheRangeOnce) {
+    for (unsigned int threads : { 1u, 4u }) {
+        TaskScheduler::setThreadCount(threads);
+        ASSERT_EQ(parallelThreadCount(), threads);
+
+        std::vector<int> hits(100003, 0);
+        parallelFor(3, hits.size(), 1000, [&](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; i++) hits[i]++;
+        });
+        for (std::size_t i = 0; i < hits.size(); i++) ASSERT_EQ(hits[i], i < 3 ? 0 : 1) << "Index " << i << "\n";
+    }
+    TaskScheduler::setThreadCount(0);
+}
+
+TEST(TaskSchedulerTest, NestedGroupsAndExceptions) {
+    TaskScheduler::setThreadCount(3);
+    TaskScheduler::resetStatistics();
+
+    // every task waits for its own group, the waiting threads run the others
+    std::atomic<int> leaves(0);
+    TaskGroup outer;
+    for (int i = 0; i < 16; i++) {
+        outer.run([&]() {
+            TaskGroup inner;
+            for (int j = 0; j < 16; j++) inner.run([&]() { leaves++; });
+            inner.wait();
+        });
+    }
+    outer.wait();
+    EXPECT_EQ(leaves.load(), 256);
+
+    std::vector<WorkerStatistics> statistics = TaskScheduler::getStatistics();
+    ASSERT_EQ(statistics.size(), 3u);
+    std::uint64_t tasks = 0;
+    for (const auto &s : statistics) {
+        tasks += s.tasks;
+        EXPECT_GE(s.utilization, 0.0f);
+        EXPECT_LE(s.utilization, 1.0f);
+    }
+    EXPECT_EQ(tasks, 16u + 256u);
+
+    TaskGroup failing;
+    failing.run([]() { throw std::runtime_error("task"); });
+    failing.run([]() {});
+    EXPECT_THROW(failing.wait(), std::runtime_error);
+    EXPECT_NO_THROW(failing.wait());
+
+    TaskScheduler::setThreadCount(0);
+}
+
+TEST(TaskSchedulerTest, ParallelSewMatchesOneThread) {
+    // a grid large enough to be split, with a non-manifold fan on an edge
+    std::vector<Vertex> vertices;
+    std::vector<Triangle> faces;
+    const unsigned int side = 200;
+    for (unsigned int y = 0; y <= side; y++) {
+        for (unsigned int x = 0; x <= side; x++) vertices.emplace_back(QVector3D(x, y, 0.0f));
+    }
+    for (unsigned int y = 0; y < side; y++) {
+        for (unsigned int x = 0; x < side; x++) {
+            unsigned int a = y * (side + 1) + x;
+            faces.emplace_back(a, a + 1, a + side + 2);
+            faces.emplace_back(a, a + side + 2, a + side + 1);
+        }
+    }
+    vertices.emplace_back(QVector3D(0.5f, 0.5f, 1.0f));
+    faces.emplace_back(1, 0, vertices.size() - 1);
+    faces.emplace_back(1, 0, vertices.size() - 1);
+
+    TaskScheduler::setThreadCount(1);
+    Mesh serial(vertices, faces);
+    TaskScheduler::setThreadCount(4);
+    Mesh parallel(vertices, faces);
+    TaskScheduler::setThreadCount(0);
+
+    ASSERT_EQ(serial.getFaces().size(), parallel.getFaces().size());
+    for (std::size_t i = 0; i < serial.getFaces().size(); i++) {
+        ASSERT_EQ(serial.getFaces()[i].idFaces, parallel.getFaces()[i].idFaces) << "Face " << i << "\n";
+    }
+    for (std::size_t i = 0; i < serial.getVertices().size(); i++) {
+        ASSERT_EQ(serial.getVertices()[i].normal, parallel.getVertices()[i].normal) << "Vertex " << i << "\n";
+    }
+}
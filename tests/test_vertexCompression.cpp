@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include "vertexCompression.h"
+
+TEST(VertexCompressionTest, PackedVertexIsCompact) {
+    EXPECT_EQ(sizeof(PackedVertex), 16);
+    EXPECT_EQ(sizeof(PackedVertex) * 2, sizeof(Vertex));
+}
+
+TEST(VertexCompressionTest, PositionErrorBound) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(-50.0f, 120.0f);
+    std::vector<Vertex> vertices;
+    for (int i = 0; i < 10000; i++) vertices.push_back(Vertex(dist(rng), dist(rng) * 0.01f, dist(rng) * 3.0f));
+
+    Quantization quantization = VertexCompression::computeQuantization(vertices);
+    for (const auto &v : vertices) {
+        Vertex decoded = VertexCompression::unpack(VertexCompression::pack(v, quantization), quantization);
+        for (int axis = 0; axis < 3; axis++) {
+            // half a step, plus the float rounding of the decoding
+            float bound = 0.5f * quantization.scale[axis] + 1e-5f * std::abs(v.position[axis]) + 1e-6f;
+            EXPECT_LE(std::abs(decoded.position[axis] - v.position[axis]), bound);
+        }
+    }
+}
+
+TEST(VertexCompressionTest, FlatMeshKeepsItsPlane) {
+    std::vector<Vertex> vertices = { Vertex(0, 2, 0), Vertex(1, 2, 0), Vertex(0, 2, 1) };
+    Quantization quantization = VertexCompression::computeQuantization(vertices);
+    for (const auto &v : vertices) {
+        Vertex decoded = VertexCompression::unpack(VertexCompression::pack(v, quantization), quantization);
+        EXPECT_FLOAT_EQ(decoded.position.y(), 2.0f);
+    }
+}
+
+TEST(VertexCompressionTest, OctahedralNormalErrorBound) {
+    std::mt19937 rng(5);
+    std::normal_distribution<float> dist;
+    for (int i = 0; i < 10000; i++) {
+        QVector3D n = QVector3D(dist(rng), dist(rng), dist(rng)).normalized();
+        QVector3D decoded = VertexCompression::decodeOctahedral(VertexCompression::encodeOctahedral(n));
+        // about 1e-4 radian for 16 bits per component, the sine is measured since the cosine rounds to 1
+        EXPECT_GT(QVector3D::dotProduct(n, decoded), 0.0f);
+        EXPECT_LT(QVector3D::crossProduct(n, decoded).length(), 2e-4f);
+    }
+
+    // the poles and the folded edges
+    for (QVector3D n : { QVector3D(0, 0, 1), QVector3D(0, 0, -1), QVector3D(1, 0, 0), QVector3D(0, -1, 0), QVector3D(0.6f, 0, -0.8f) }) {
+        QVector3D decoded = VertexCompression::decodeOctahedral(VertexCompression::encodeOctahedral(n));
+        EXPECT_NEAR((decoded - n).length(), 0.0f, 1e-4f);
+    }
+}
+
+TEST(VertexCompressionTest, HalfFloatTexCoords) {
+    EXPECT_EQ(VertexCompression::floatToHalf(1.0f), 0x3C00);
+    EXPECT_EQ(VertexCompression::floatToHalf(-2.0f), 0xC000);
+    EXPECT_EQ(VertexCompression::floatToHalf(65504.0f), 0x7BFF);
+    EXPECT_EQ(VertexCompression::floatToHalf(1e6f), 0x7C00);
+    EXPECT_EQ(VertexCompression::floatToHalf(std::ldexp(1.0f, -24)), 0x0001);
+    EXPECT_FLOAT_EQ(VertexCompression::halfToFloat(0x3555), 0.333251953125f);
+
+    // relative error of half the 10 bits mantissa step
+    for (float f = -4.0f; f <= 4.0f; f += 0.0137f) {
+        float decoded = VertexCompression::halfToFloat(VertexCompression::floatToHalf(f));
+        EXPECT_LE(std::abs(decoded - f), std::ldexp(std::abs(f), -11) + std::ldexp(1.0f, -25));
+    }
+}
@@ -0,0 +1,36 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "chunkFile.h"
+#include "mesh.h"
+
+/**
+ * @brief Build the chunk file of a .off or .obj mesh, to be streamed by the viewer.
+ * Usage : MeshChunker input output.mvc [maxChunkFaces]
+ */
+int main(int argc, char *argv[]) {
+    if (argc < 3 || argc > 4) {
+        std::cerr << "Usage : " << argv[0] << " input.(off|obj) output.mvc [maxChunkFaces]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    unsigned int maxChunkFaces = argc == 4 ? std::strtoul(argv[3], nullptr, 10) : 2048;
+    if (maxChunkFaces == 0) {
+        std::cerr << "Invalid chunk size : " << argv[3] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int ok = ChunkFile::build(argv[1], argv[2], maxChunkFaces);
+    if (ok != MeshError::OK) {
+        std::cerr << "Failed to build " << argv[2] << " from " << argv[1] << " (error " << ok << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ChunkFile file;
+    if (file.open(argv[2]) == MeshError::OK) {
+        const ChunkFileHeader &header = file.getHeader();
+        std::cout << header.vertexCount << " vertices, " << header.faceCount << " faces in "
+                  << header.chunkCount << " chunks" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
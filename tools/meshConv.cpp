@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mesh.h"
+#include "meshAnalysis.h"
+#include "parallel.h"
+#include "simplifier.h"
+#include "taskScheduler.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char *ERROR_NAMES[] = { "OK", "FORMAT", "READ", "SAVE", "UNKNOWN" };
+const char *EXTENSIONS[] = { ".off", ".obj", ".txt" };
+
+/**
+ * @brief A file to convert, found on the command line, in a directory or in a list.
+ */
+struct Input {
+    fs::path path;
+    fs::path name; // path of the output in a directory, relative to the searched directory to keep its tree
+};
+
+/**
+ * @brief The conversion of every file, the stages run in this order : weld, subdivide, simplify, normals, reorder.
+ */
+struct Options {
+    std::vector<Input> inputs;
+    fs::path output;
+    std::string format;      // extension of the outputs, empty to keep the one of the output file
+    unsigned int jobs = 0;
+    bool recursive = false;
+    bool quiet = false;
+    bool weld = false;
+    float weldTolerance = 0.0f;
+    int loopLevels = 0;
+    int sqrt3Levels = 0;
+    float simplifyRatio = 1.0f;
+    bool normals = false;
+    SpatialOrder order = SpatialOrder::NONE;
+    bool cacheOrder = false;
+    bool statistics = false; // analyze the inputs as loaded, without an output only the analysis runs
+    bool doublePrecision = false; // load in double then move to the center of the box, far coordinates keep their precision
+    PointFilterOptions pointFilter; // applied to the .txt clouds before their triangulation
+};
+
+struct Conversion {
+    fs::path input;
+    fs::path output;
+    int error = MeshError::OK;
+    double seconds = 0.0;
+    std::uintmax_t bytes = 0;
+    std::size_t faces = 0;
+    std::string statistics;
+    PointFilterStatistics points;
+    std::array<double, 3> origin = {}; // removed from the positions with --double
+};
+
+void printUsage(const char *program) {
+    std::cerr << "Usage : " << program << " [options] inputs... [-o output]\n"
+              << "  inputs : .off, .obj or .txt files, directories, or @list files with one path per line\n"
+              << "  -o path          output file for one input, else output directory where the searched directories keep their tree\n"
+              << "  -f off|obj|txt   format of the outputs written in a directory\n"
+              << "  -j jobs          number of files converted at the same time, they share the threads of the machine\n"
+              << "  -r               search the directories recursively\n"
+              << "  -q               only print the summary, and the origins with --double\n"
+              << "  --stats          print the components, boundaries and defects of each input, -o is optional\n"
+              << "  --double         load .off and .txt inputs in double and write them around the center of their box, printed as the origin\n"
+              << "  --dedup=size     merge the points of .txt clouds in the same cell, not only the exact duplicates\n"
+              << "  --voxel=size[,closest]  keep the centroid, or the point closest to the center, of each voxel of .txt clouds\n"
+              << "  --weld[=size]    merge the vertices at the same position, or in the same cell\n"
+              << "  --loop=levels    refine with Loop subdivision, 4 times more faces per level\n"
+              << "  --sqrt3=levels   refine with sqrt(3) subdivision, 3 times more faces per level\n"
+              << "  --simplify=ratio keep this ratio of the faces, after the welding\n"
+              << "  --normals        compute the smooth normals again\n"
+              << "  --reorder=cache|morton|hilbert  reorder the faces and the vertices" << std::endl;
+}
+
+bool isMeshFile(const fs::path &path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return std::find(std::begin(EXTENSIONS), std::end(EXTENSIONS), extension) != std::end(EXTENSIONS);
+}
+
+// expands the directories and the @list files, a missing file is kept to be reported as READ
+void addInput(const std::string &argument, bool recursive, std::vector<Input> &inputs) {
+    if (!argument.empty() && argument[0] == '@') {
+        std::ifstream list(argument.substr(1));
+        if (!list.is_open()) {
+            std::cerr << "Can't open the list " << argument.substr(1) << std::endl;
+            return;
+        }
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty() && line[0] != '#') addInput(line, recursive, inputs);
+        }
+        return;
+    }
+
+    fs::path path(argument);
+    std::error_code error;
+    if (!fs::is_directory(path, error)) {
+        inputs.push_back({ path, path.filename() });
+        return;
+    }
+
+    std::vector<fs::path> found;
+    auto collect = [&](const fs::directory_entry &entry) {
+        if (entry.is_regular_file(error) && isMeshFile(entry.path())) found.push_back(entry.path());
+    };
+    if (recursive) {
+        for (const auto &entry : fs::recursive_directory_iterator(path, error)) collect(entry);
+    } else {
+        for (const auto &entry : fs::directory_iterator(path, error)) collect(entry);
+    }
+    std::sort(found.begin(), found.end());
+    for (const auto &file : found) inputs.push_back({ file, file.lexically_relative(path) });
+}
+
+bool parseArguments(int argc, char *argv[], Options &options) {
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        auto value = [&](const char *name) -> const char * {
+            if (i + 1 < argc) return argv[++i];
+            std::cerr << "Missing value after " << name << std::endl;
+            return nullptr;
+        };
+
+        if (argument == "-o" || argument == "-f" || argument == "-j") {
+            const char *v = value(argument.c_str());
+            if (!v) return false;
+            if (argument == "-o") options.output = v;
+            else if (argument == "-f") options.format = std::string(".") + v;
+            else options.jobs = std::strtoul(v, nullptr, 10);
+        } else if (argument == "-r") {
+            options.recursive = true;
+        } else if (argument == "-q") {
+            options.quiet = true;
+        } else if (argument == "--weld" || argument.rfind("--weld=", 0) == 0) {
+            options.weld = true;
+            if (argument.size() > 7) options.weldTolerance = std::strtof(argument.c_str() + 7, nullptr);
+        } else if (argument.rfind("--loop=", 0) == 0 || argument.rfind("--sqrt3=", 0) == 0) {
+            bool loop = argument[2] == 'l';
+            int levels = std::atoi(argument.c_str() + (loop ? 7 : 8));
+            if (levels < 1) {
+                std::cerr << "The subdivision levels must be at least 1" << std::endl;
+                return false;
+            }
+            if (loop) options.loopLevels = levels;
+            else options.sqrt3Levels = levels;
+        } else if (argument.rfind("--simplify=", 0) == 0) {
+            options.simplifyRatio = std::strtof(argument.c_str() + 11, nullptr);
+            if (options.simplifyRatio <= 0.0f || options.simplifyRatio > 1.0f) {
+                std::cerr << "The simplification ratio must be in ]0, 1]" << std::endl;
+                return false;
+            }
+        } else if (argument.rfind("--dedup=", 0) == 0) {
+            options.pointFilter.epsilon = std::strtof(argument.c_str() + 8, nullptr);
+            if (options.pointFilter.epsilon <= 0.0f) {
+                std::cerr << "The duplicate cell size must be positive" << std::endl;
+                return false;
+            }
+        } else if (argument.rfind("--voxel=", 0) == 0) {
+            char *rest = nullptr;
+            options.pointFilter.voxelSize = std::strtof(argument.c_str() + 8, &rest);
+            if (options.pointFilter.voxelSize <= 0.0f || (*rest != '\0' && std::string(rest) != ",closest")) {
+                std::cerr << "The voxel size must be positive, optionally followed by ,closest" << std::endl;
+                return false;
+            }
+            if (*rest != '\0') options.pointFilter.voxelPoint = VoxelPoint::CLOSEST;
+        } else if (argument == "--stats") {
+            options.statistics = true;
+        } else if (argument == "--double") {
+            options.doublePrecision = true;
+        } else if (argument == "--normals") {
+            options.normals = true;
+        } else if (argument.rfind("--reorder=", 0) == 0) {
+            std::string order = argument.substr(10);
+            if (order == "cache") options.cacheOrder = true;
+            else if (order == "morton") options.order = SpatialOrder::MORTON;
+            else if (order == "hilbert") options.order = SpatialOrder::HILBERT;
+            else {
+                std::cerr << "Unknown order : " << order << std::endl;
+                return false;
+            }
+        } else if (!argument.empty() && argument[0] == '-' && argument.size() > 1) {
+            std::cerr << "Unknown option : " << argument << std::endl;
+            return false;
+        } else {
+            inputs.push_back(argument);
+        }
+    }
+
+    for (const auto &input : inputs) addInput(input, options.recursive, options.inputs);
+    if (options.inputs.empty() || (options.output.empty() && !options.statistics)) return false;
+
+    if (!options.format.empty() && !isMeshFile(fs::path("x" + options.format))) {
+        std::cerr << "Unknown format : " << options.format.substr(1) << std::endl;
+        return false;
+    }
+    if (options.jobs == 0) options.jobs = parallelThreadCount();
+    return true;
+}
+
+void convert(const Options &options, Conversion &conversion) {
+    auto start = std::chrono::steady_clock::now();
+    std::error_code error;
+    conversion.bytes = fs::file_size(conversion.input, error);
+
+    Mesh mesh;
+    mesh.setPointFilter(options.pointFilter);
+    if (options.doublePrecision) {
+        // the center is removed in double, the float mesh then keeps the small steps of georeferenced coordinates
+        conversion.error = mesh.loadCentered(conversion.input.string().c_str(), conversion.origin);
+    } else {
+        conversion.error = mesh.loadFile(conversion.input.string().c_str());
+    }
+    conversion.points = mesh.getPointFilterStatistics();
+    if (conversion.error == MeshError::OK && options.statistics) {
+        conversion.statistics = MeshAnalysis::summary(MeshAnalysis::analyze(mesh));
+        conversion.faces = mesh.getFaces().size();
+    }
+    if (conversion.error == MeshError::OK && !conversion.output.empty()) {
+        if (options.weld) mesh.weld(options.weldTolerance);
+        mesh.subdivideLoop(options.loopLevels);
+        mesh.subdivideSqrt3(options.sqrt3Levels);
+        if (options.simplifyRatio < 1.0f && !mesh.getFaces().empty()) {
+            Simplifier simplifier(mesh);
+            mesh = simplifier.simplify(std::max<std::size_t>(1, mesh.getFaces().size() * options.simplifyRatio));
+        }
+        if (options.normals) mesh.computeNormals();
+        if (options.cacheOrder) mesh.optimizeIndices();
+        mesh.spatialReorder(options.order);
+
+        conversion.faces = mesh.getFaces().size();
+        fs::create_directories(conversion.output.parent_path(), error);
+        conversion.error = mesh.saveFile(conversion.output.string().c_str());
+    }
+
+    conversion.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+/**
+ * @brief Convert meshes between the .off, .obj and .txt formats on a pool of threads.
+ * Usage : meshconv [options] inputs... -o output, see printUsage.
+ * @return EXIT_FAILURE if a file fails.
+ */
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // a single input is written in the output file, else the outputs keep the input tree in the directory
+    std::error_code error;
+    bool toDirectory = !options.output.empty() && (options.inputs.size() > 1 || fs::is_directory(options.output, error) || options.output.extension().empty());
+    if (toDirectory && options.format.empty()) {
+        std::cerr << "The format of the outputs is needed (-f off|obj|txt)" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Conversion> conversions(options.inputs.size());
+    for (std::size_t i = 0; i < conversions.size(); i++) {
+        conversions[i].input = options.inputs[i].path;
+        if (options.output.empty()) continue;
+        conversions[i].output = toDirectory ? options.output / fs::path(options.inputs[i].name).replace_extension(options.format)
+                                            : options.output;
+    }
+
+    // 2 workers writing the same file would corrupt it, like x.off and x.obj or the same name in 2 directories
+    std::map<fs::path, fs::path> written;
+    for (const auto &c : conversions) {
+        if (c.output.empty()) continue;
+        auto [previous, added] = written.emplace(c.output.lexically_normal(), c.input);
+        if (!added) {
+            std::cerr << c.input.string() << " and " << previous->second.string() << " would both be written to " << c.output.string() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<std::size_t> next(0);
+    std::mutex printMutex;
+    std::vector<std::thread> workers;
+    unsigned int jobs = std::min<std::size_t>(options.jobs, conversions.size());
+    // the files run on their own threads, the kernels of each file share what is left of the machine,
+    // serially when there are as many files running as threads
+    if (jobs > 1) TaskScheduler::setThreadCount(std::max(1u, parallelThreadCount() / jobs));
+    for (unsigned int w = 0; w < jobs; w++) {
+        workers.emplace_back([&]() {
+            for (std::size_t i = next++; i < conversions.size(); i = next++) {
+                Conversion &c = conversions[i];
+                convert(options, c);
+                if (options.quiet) {
+                    // the output can't be placed back without its origin
+                    if (!options.doublePrecision || c.error != MeshError::OK) continue;
+                    std::lock_guard<std::mutex> lock(printMutex);
+                    std::cout << std::fixed << std::setprecision(6) << c.input.string()
+                              << "  (origin " << c.origin[0] << " " << c.origin[1] << " " << c.origin[2] << ")\n";
+                    continue;
+                }
+
+                std::lock_guard<std::mutex> lock(printMutex);
+                std::cout << std::fixed << std::setprecision(1) << std::setw(9) << c.seconds * 1000.0 << " ms  "
+                          << std::left << std::setw(7) << ERROR_NAMES[std::clamp(c.error, 0, int(MeshError::UNKNOWN))] << std::right
+                          << "  " << c.input.string();
+                if (c.error == MeshError::OK && !c.output.empty()) std::cout << " -> " << c.output.string();
+                if (c.points.pointsIn > 0) std::cout << "  (" << c.points.pointsIn << " -> " << c.points.pointsOut << " points)";
+                if (options.doublePrecision && c.error == MeshError::OK) {
+                    std::cout << std::setprecision(6) << "  (origin " << c.origin[0] << " " << c.origin[1] << " " << c.origin[2] << ")";
+                }
+                std::cout << "\n";
+                if (!c.statistics.empty()) std::cout << "           " << c.statistics << "\n";
+            }
+        });
+    }
+    for (auto &w : workers) w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::size_t converted = 0, faces = 0;
+    std::uintmax_t bytes = 0;
+    int failures[MeshError::UNKNOWN + 1] = {};
+    for (const auto &c : conversions) {
+        if (c.error == MeshError::OK) {
+            converted++;
+            faces += c.faces;
+            bytes += c.bytes;
+        } else {
+            failures[std::clamp(c.error, 1, int(MeshError::UNKNOWN))]++;
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(2) << converted << " / " << conversions.size()
+              << (options.output.empty() ? " files analyzed in " : " files converted in ") << seconds
+              << " s with " << jobs << " jobs : " << (seconds > 0.0 ? converted / seconds : 0.0) << " files/s, "
+              << (seconds > 0.0 ? faces / seconds : 0.0) << " faces/s, "
+              << (seconds > 0.0 ? bytes / seconds / (1 << 20) : 0.0) << " MB/s read" << std::endl;
+    for (int e = MeshError::FORMAT; e <= MeshError::UNKNOWN; e++) {
+        if (failures[e] > 0) std::cout << "  " << ERROR_NAMES[e] << " : " << failures[e] << " files" << std::endl;
+    }
+
+    return converted == conversions.size() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "generator.h"
+
+namespace {
+
+const std::uint64_t DEFAULT_SEED = 1;
+const float TERRAIN_AMPLITUDE = 0.25f;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Generate a shape of about size elements, triangles for the meshes and points for the clouds.
+ * @return False for an unknown shape.
+ */
+bool generate(const std::string &shape, std::size_t size, std::uint64_t seed, GeneratedMesh &mesh) {
+    if (shape == "icosphere") {
+        // each level splits the faces in 4, stop before the count overflows, Generator::icosphere clamps the levels anyway
+        unsigned int levels = 0;
+        std::uint64_t faces = 20;
+        while (faces < size && faces <= std::numeric_limits<std::uint64_t>::max() / 4) {
+            faces *= 4;
+            levels++;
+        }
+        mesh = Generator::icosphere(levels);
+    } else if (shape == "torus") {
+        // 2 * rings * sides triangles with rings = 2 * sides
+        unsigned int sides = std::max(3u, static_cast<unsigned int>(std::lround(std::sqrt(size / 4.0))));
+        mesh = Generator::torus(2 * sides, sides);
+    } else if (shape == "terrain") {
+        unsigned int cells = std::max(1u, static_cast<unsigned int>(std::lround(std::sqrt(size / 2.0))));
+        mesh = Generator::terrain(cells, TERRAIN_AMPLITUDE, seed);
+    } else if (shape == "uniform") {
+        mesh = Generator::pointCloud(size, CloudDistribution::UNIFORM, seed);
+    } else if (shape == "clustered") {
+        mesh = Generator::pointCloud(size, CloudDistribution::CLUSTERED, seed);
+    } else if (shape == "collinear") {
+        mesh = Generator::pointCloud(size, CloudDistribution::COLLINEAR, seed);
+    } else if (shape == "cocircular") {
+        mesh = Generator::pointCloud(size, CloudDistribution::COCIRCULAR, seed);
+    } else if (shape == "grid") {
+        mesh = Generator::pointCloud(size, CloudDistribution::GRID, seed);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+}
+
+/**
+ * @brief Write a synthetic mesh or point cloud, the same seed always gives the same file.
+ * Usage : MeshGenerator shape size output.(off|obj|txt) [seed]
+ */
+int main(int argc, char *argv[]) {
+    if (argc < 4 || argc > 5) {
+        std::cerr << "Usage : " << argv[0] << " shape size output.(off|obj|txt) [seed]\n"
+                  << "  shape : icosphere, torus, terrain (size in triangles)\n"
+                  << "          uniform, clustered, collinear, cocircular, grid (size in points)" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::size_t size = std::strtoull(argv[2], nullptr, 10);
+    std::uint64_t seed = argc == 5 ? std::strtoull(argv[4], nullptr, 10) : DEFAULT_SEED;
+    if (size == 0) {
+        std::cerr << "Invalid size : " << argv[2] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    GeneratedMesh mesh;
+    if (!generate(argv[1], size, seed, mesh)) {
+        std::cerr << "Unknown shape : " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+    double generation = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    int ok = Generator::save(mesh, argv[3]);
+    if (ok != MeshError::OK) {
+        std::cerr << "Failed to write " << argv[3] << " (error " << ok << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << mesh.positions.size() << " vertices, " << mesh.indices.size() / 3 << " faces, generated in "
+              << generation << " s, written in " << secondsSince(start) << " s" << std::endl;
+    return EXIT_SUCCESS;
+}
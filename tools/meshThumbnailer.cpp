@@ -0,0 +1,302 @@
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+#include <QDir>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QImage>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "camera.h"
+#include "mesh.h"
+#include "parallel.h"
+#include "shaders.h"
+
+namespace {
+
+const int DEFAULT_SIZE = 256;
+// larger framebuffers than this fail on most drivers
+const long MAX_SIZE = 16384;
+// more loaders than this only fill the memory, the render thread can't keep up
+const long MAX_LOADERS = 256;
+// meshes loaded ahead of the render thread, per loader
+const std::size_t QUEUE_PER_LOADER = 2;
+
+/**
+ * @brief Parse a count of the command line.
+ * @param text : The argument.
+ * @param max : The largest value accepted.
+ * @param value : Receives the count.
+ * @return False if the argument isn't a whole number in [1, max].
+ */
+bool parseCount(const char *text, long max, int &value) {
+    char *end;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || parsed < 1 || parsed > max) return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+/**
+ * @brief A mesh read by a loader thread, ready to be uploaded.
+ */
+struct LoadedMesh {
+    QString name;
+    int error;
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    QVector3D center;
+    float radius;
+};
+
+/**
+ * @brief The MeshQueue class, a bounded queue between the loader threads and the render thread.
+ */
+class MeshQueue
+{
+public:
+    explicit MeshQueue(std::size_t capacity) : capacity(capacity), producers(0) {}
+
+    void addProducer() {
+        std::lock_guard<std::mutex> lock(mutex);
+        producers++;
+    }
+
+    /**
+     * @brief Called by a loader thread once it has no more mesh, the queue closes with the last one.
+     */
+    void removeProducer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            producers--;
+        }
+        notEmpty.notify_all();
+    }
+
+    void push(LoadedMesh mesh) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [&]() { return meshes.size() < capacity; });
+        meshes.push_back(std::move(mesh));
+        lock.unlock();
+        notEmpty.notify_one();
+    }
+
+    /**
+     * @brief Wait for the next mesh.
+     * @param mesh : Receives the mesh.
+     * @return False once every loader is done and the queue is empty.
+     */
+    bool pop(LoadedMesh &mesh) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [&]() { return !meshes.empty() || producers == 0; });
+        if (meshes.empty()) return false;
+        mesh = std::move(meshes.front());
+        meshes.pop_front();
+        lock.unlock();
+        notFull.notify_one();
+        return true;
+    }
+
+protected:
+    std::size_t capacity;
+    int producers;
+    std::deque<LoadedMesh> meshes;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+};
+
+LoadedMesh loadMesh(const QFileInfo &file) {
+    LoadedMesh loaded;
+    loaded.name = file.fileName();
+
+    Mesh mesh;
+    loaded.error = mesh.loadFile(file.absoluteFilePath().toStdString().c_str());
+    if (loaded.error != MeshError::OK) return loaded;
+
+    // framed like the viewer does
+    if (mesh.getBoundingRadius() > 100.0f) mesh.normalize();
+    loaded.center = mesh.getCenter();
+    loaded.radius = mesh.getBoundingRadius();
+    loaded.vertices = mesh.getVertices();
+    loaded.indices = mesh.getIndices();
+    return loaded;
+}
+
+/**
+ * @brief The ThumbnailRenderer class, draws meshes with the viewer shaders in a framebuffer of an offscreen surface.
+ */
+class ThumbnailRenderer : protected QOpenGLFunctions_3_3_Core
+{
+public:
+    ThumbnailRenderer() : fbo(nullptr), shader(nullptr), VAO(0), VBO(0), EBO(0) {}
+
+    ~ThumbnailRenderer() {
+        if (!context.isValid()) return;
+        context.makeCurrent(&surface);
+        if (VAO) glDeleteVertexArrays(1, &VAO);
+        if (VBO) glDeleteBuffers(1, &VBO);
+        if (EBO) glDeleteBuffers(1, &EBO);
+        delete shader;
+        delete fbo;
+        context.doneCurrent();
+    }
+
+    bool initialize(int size) {
+        QSurfaceFormat format;
+        format.setVersion(3, 3);
+        format.setProfile(QSurfaceFormat::CoreProfile);
+        format.setDepthBufferSize(24);
+        context.setFormat(format);
+        if (!context.create()) return false;
+
+        surface.setFormat(context.format());
+        surface.create();
+        if (!surface.isValid() || !context.makeCurrent(&surface)) return false;
+        initializeOpenGLFunctions();
+
+        fbo = new QOpenGLFramebufferObject(size, size, QOpenGLFramebufferObject::CombinedDepthStencil);
+        shader = new QOpenGLShaderProgram();
+        shader->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader);
+        shader->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader);
+        if (!fbo->isValid() || !shader->link()) return false;
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glEnable(GL_DEPTH_TEST);
+        return true;
+    }
+
+    QImage render(const LoadedMesh &mesh) {
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(Vertex), mesh.vertices.data(), GL_STREAM_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+        glEnableVertexAttribArray(1);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STREAM_DRAW);
+
+        Camera camera;
+        camera.setAspect(fbo->width(), fbo->height());
+        camera.initialize(mesh.center, mesh.radius);
+        QMatrix4x4 model;
+
+        fbo->bind();
+        glViewport(0, 0, fbo->width(), fbo->height());
+        glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        shader->bind();
+        shader->setUniformValue("model", model);
+        shader->setUniformValue("view", camera.getView());
+        shader->setUniformValue("projection", camera.getProjection());
+        shader->setUniformValue("positionOffset", QVector3D(0.0f, 0.0f, 0.0f));
+        shader->setUniformValue("positionScale", QVector3D(1.0f, 1.0f, 1.0f));
+        shader->setUniformValue("octNormal", false);
+        shader->setUniformValue("shading", true);
+        glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, nullptr);
+        shader->release();
+
+        glBindVertexArray(0);
+        QImage image = fbo->toImage();
+        fbo->release();
+        return image;
+    }
+
+protected:
+    QOpenGLContext context;
+    QOffscreenSurface surface;
+    QOpenGLFramebufferObject *fbo;
+    QOpenGLShaderProgram *shader;
+    GLuint VAO;
+    GLuint VBO;
+    GLuint EBO;
+};
+
+}
+
+/**
+ * @brief Render a thumbnail of each mesh of a directory, without a window.
+ * The meshes are loaded by a pool of threads while the main thread renders them.
+ * Usage : MeshThumbnailer inputDirectory outputDirectory [size] [loaders]
+ */
+int main(int argc, char *argv[]) {
+    QGuiApplication app(argc, argv);
+    int size = DEFAULT_SIZE;
+    int loaders = std::max(1u, parallelThreadCount() - 1);
+    if (argc < 3 || argc > 5 || (argc >= 4 && !parseCount(argv[3], MAX_SIZE, size)) || (argc >= 5 && !parseCount(argv[4], MAX_LOADERS, loaders))) {
+        std::cerr << "Usage : " << argv[0] << " inputDirectory outputDirectory [size] [loaders]\n"
+                  << "  size : side of the thumbnails in pixels, from 1 to " << MAX_SIZE << ", " << DEFAULT_SIZE << " by default\n"
+                  << "  loaders : threads reading the meshes, from 1 to " << MAX_LOADERS << ", all the threads but one by default" << std::endl;
+        return EXIT_FAILURE;
+    }
+    unsigned int loaderCount = loaders;
+
+    QDir input(argv[1]);
+    QFileInfoList files = input.entryInfoList({ "*.off", "*.obj", "*.txt" }, QDir::Files, QDir::Name);
+    QDir output(argv[2]);
+    if (!input.exists() || !output.mkpath(".")) {
+        std::cerr << "Can't use the directories " << argv[1] << " and " << argv[2] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ThumbnailRenderer renderer;
+    if (!renderer.initialize(size)) {
+        std::cerr << "Can't create an OpenGL 3.3 offscreen context" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    MeshQueue queue(loaderCount * QUEUE_PER_LOADER);
+    std::atomic<int> next(0);
+    std::vector<std::thread> loaders;
+    for (unsigned int i = 0; i < loaderCount; i++) {
+        queue.addProducer();
+        loaders.emplace_back([&]() {
+            for (int f = next++; f < files.size(); f = next++) queue.push(loadMesh(files[f]));
+            queue.removeProducer();
+        });
+    }
+
+    int rendered = 0, failed = 0;
+    LoadedMesh mesh;
+    while (queue.pop(mesh)) {
+        if (mesh.error != MeshError::OK || mesh.indices.empty()) {
+            std::cerr << "Failed to load " << mesh.name.toStdString() << " (error " << mesh.error << ")" << std::endl;
+            failed++;
+            continue;
+        }
+
+        QImage image = renderer.render(mesh);
+        if (!image.save(output.filePath(mesh.name + ".png"))) {
+            std::cerr << "Failed to save the thumbnail of " << mesh.name.toStdString() << std::endl;
+            failed++;
+            continue;
+        }
+        rendered++;
+    }
+    for (auto &t : loaders) t.join();
+
+    double seconds = timer.nsecsElapsed() / 1e9;
+    std::cout << rendered << " thumbnails in " << seconds << " s, "
+              << (seconds > 0.0 ? rendered / seconds : 0.0) << " meshes/s";
+    if (failed > 0) std::cout << ", " << failed << " failed";
+    std::cout << std::endl;
+
+    return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}